@@ -15,24 +15,6 @@ See the Mulan PSL v2 for more details. */
 
 namespace common {
 
-int find_first_zero(char byte, int start) {
-    for (int i = start; i < 8; i++) {
-        if ((byte & (1 << i)) == 0) {
-            return i;
-        }
-    }
-    return -1;
-}
-
-int find_first_setted(char byte, int start) {
-    for (int i = start; i < 8; i++) {
-        if ((byte & (1 << i)) != 0) {
-            return i;
-        }
-    }
-    return -1;
-}
-
 Bitmap::Bitmap(char* bitmap, int size) : bitmap_(bitmap), size_(size) {}
 
 bool Bitmap::get_bit(int index) {
@@ -51,51 +33,74 @@ void Bitmap::clear_bit(int index) {
 }
 
 int Bitmap::next_unsetted_bit(int start) {
-    int ret           = -1;
-    int start_in_byte = start % 8;
-    for (int iter = start / 8,
-             end  = (size_ % 8 == 0 ? size_ / 8 : size_ / 8 + 1);
-         iter <= end; iter++) {
-        char byte = bitmap_[iter];
-        if (byte != -1) {
-            int index_in_byte = find_first_zero(byte, start_in_byte);
-            if (index_in_byte >= 0) {
-                ret = iter * 8 + index_in_byte;
-                break;
-            }
-
-            start_in_byte = 0;
-        }
+    if (start < 0 || start >= size_) {
+        return -1;
+    }
+    // 逐条遍历时下一位经常就是要找的，不用再读整个字
+    if (!get_bit(start)) {
+        return start;
     }
 
-    if (ret >= size_) {
-        ret = -1;
+    // 起始字里start之前的位当作已经置位，不参与查找
+    int      w    = start / 64;
+    uint64_t word = ~load_word(w) & word_mask(w) & (~0ULL << (start % 64));
+    for (int words = word_count();;) {
+        if (word != 0) {
+            return w * 64 + __builtin_ctzll(word);
+        }
+        if (++w >= words) {
+            return -1;
+        }
+        word = ~load_word(w) & word_mask(w);
     }
-    return ret;
 }
 
 int Bitmap::next_setted_bit(int start) {
-    int ret           = -1;
-    int start_in_byte = start % 8;
-    for (int iter = start / 8,
-             end  = (size_ % 8 == 0 ? size_ / 8 : size_ / 8 + 1);
-         iter <= end; iter++) {
-        char byte = bitmap_[iter];
-        if (byte != 0x00) {
-            int index_in_byte = find_first_setted(byte, start_in_byte);
-            if (index_in_byte >= 0) {
-                ret = iter * 8 + index_in_byte;
-                break;
-            }
+    if (start < 0 || start >= size_) {
+        return -1;
+    }
+    if (get_bit(start)) {
+        return start;
+    }
 
-            start_in_byte = 0;
+    int      w    = start / 64;
+    uint64_t word = load_word(w) & (~0ULL << (start % 64));
+    for (int words = word_count();;) {
+        if (word != 0) {
+            return w * 64 + __builtin_ctzll(word);
         }
+        if (++w >= words) {
+            return -1;
+        }
+        word = load_word(w);
+    }
+}
+
+int Bitmap::count_setted_bits() const {
+    int count = 0;
+    for (int w = 0, words = word_count(); w < words; w++) {
+        count += __builtin_popcountll(load_word(w));
+    }
+    return count;
+}
+
+int Bitmap::next_unsetted_bits(int start, int n, int indexes[]) const {
+    if (start < 0 || start >= size_) {
+        return 0;
     }
 
-    if (ret >= size_) {
-        ret = -1;
+    int found = 0;
+    for (int w = start / 64, words = word_count(); w < words && found < n; w++) {
+        uint64_t word = ~load_word(w) & word_mask(w);
+        if (w == start / 64) {
+            word &= ~0ULL << (start % 64);
+        }
+        while (word != 0 && found < n) {
+            indexes[found++] = w * 64 + __builtin_ctzll(word);
+            word &= word - 1;
+        }
     }
-    return ret;
+    return found;
 }
 
-} // namespace common
\ No newline at end of file
+} // namespace common
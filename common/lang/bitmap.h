@@ -14,8 +14,15 @@ See the Mulan PSL v2 for more details. */
 #ifndef __COMMON_LANG_BITMAP_H__
 #define __COMMON_LANG_BITMAP_H__
 
+#include <stdint.h>
+#include <string.h>
+
 namespace common {
 
+/**
+ * 位图，第i位是第i/8个字节的第i%8位。
+ * 查找时一次处理64位，用ctz/popcount指令代替逐位判断
+ */
 class Bitmap {
     public:
     Bitmap(char* bitmap, int size);
@@ -27,6 +34,62 @@ class Bitmap {
     int  next_unsetted_bit(int start);
     int  next_setted_bit(int start);
 
+    /**
+     * 为1的位的个数
+     */
+    int  count_setted_bits() const;
+
+    /**
+     * 从start开始按顺序找最多n个为0的位，下标依次放到indexes中
+     * @return 找到的个数
+     */
+    int  next_unsetted_bits(int start, int n, int indexes[]) const;
+
+    /**
+     * 按从小到大的顺序对每个为1的位调用func(index)。
+     * 每个64位字只读一次，func中可以修改位图，不影响这次遍历
+     */
+    template <class Func>
+    void for_each_setted_bit(Func func) const {
+        for (int w = 0, words = word_count(); w < words; w++) {
+            uint64_t word = load_word(w);
+            while (word != 0) {
+                func(w * 64 + __builtin_ctzll(word));
+                word &= word - 1;
+            }
+        }
+    }
+
+    private:
+    int      word_count() const { return (size_ + 63) / 64; }
+
+    /**
+     * 第w个64位字中有效的位，最后一个字可能只有一部分属于位图
+     */
+    uint64_t word_mask(int w) const {
+        const int tail = size_ - w * 64;
+        return tail >= 64 ? ~0ULL : (1ULL << tail) - 1;
+    }
+
+    /**
+     * 读出第w个64位字，第i位对应位图的第w * 64 + i位，超出size的位都是0。
+     * 位图没有对齐要求，末尾不足8个字节时只读剩下的字节
+     */
+    uint64_t load_word(int w) const {
+        const int bytes  = (size_ + 7) / 8;
+        const int offset = w * 8;
+        uint64_t  word   = 0;
+        if (offset + 8 <= bytes) {
+            memcpy(&word, bitmap_ + offset, 8);
+        } else {
+            memcpy(&word, bitmap_ + offset, bytes - offset);
+        }
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+        word = __builtin_bswap64(word);
+#endif
+        return word & word_mask(w);
+    }
+
     private:
     char* bitmap_;
     int   size_;
@@ -34,4 +97,4 @@ class Bitmap {
 
 } // namespace common
 
-#endif // __COMMON_LANG_BITMAP_H__
\ No newline at end of file
+#endif // __COMMON_LANG_BITMAP_H__
@@ -238,4 +238,44 @@ bool is_blank(const char* s) {
     return true;
 }
 
+bool str_to_bytes(const std::string& str, unsigned long long& bytes) {
+    std::string value = str;
+    if (value.empty()) {
+        return false;
+    }
+    strip(value);
+
+    size_t digits = 0;
+    while (digits < value.size() && isdigit(value[digits])) {
+        digits++;
+    }
+    if (digits == 0 || digits > 19) {
+        return false;
+    }
+
+    std::string unit = value.substr(digits);
+    if (!unit.empty()) {
+        strip(unit);
+        str_to_upper(unit);
+    }
+
+    unsigned long long multiple = 1;
+    if (unit == "K" || unit == "KB") {
+        multiple = 1ULL << 10;
+    } else if (unit == "M" || unit == "MB") {
+        multiple = 1ULL << 20;
+    } else if (unit == "G" || unit == "GB") {
+        multiple = 1ULL << 30;
+    } else if (!unit.empty() && unit != "B") {
+        return false;
+    }
+
+    unsigned long long number = strtoull(value.substr(0, digits).c_str(), nullptr, 10);
+    if (number > ~0ULL / multiple) {
+        return false;
+    }
+    bytes = number * multiple;
+    return true;
+}
+
 } // namespace common
@@ -157,5 +157,12 @@ template <class T> std::string get_type_name(const T& val) {
 
 bool is_blank(const char* s);
 
+/**
+ * 把"512MB"、"4g"、"65536"这样的容量字符串转换成字节数，
+ * 单位可以是K/KB、M/MB、G/GB(不区分大小写，按1024进位)，没有单位时就是字节
+ * @return 格式不对或者溢出时返回false
+ */
+bool str_to_bytes(const std::string& str, unsigned long long& bytes);
+
 } // namespace common
 #endif // __COMMON_LANG_STRING_H__
@@ -25,7 +25,7 @@ class Metric {
     virtual Snapshot* get_snapshot() { return snapshot_value_; }
 
     protected:
-    Snapshot* snapshot_value_;
+    Snapshot* snapshot_value_ = nullptr;
 };
 
 } // namespace common
@@ -14,6 +14,8 @@ See the Mulan PSL v2 for more details. */
 #ifndef __COMMON_METRICS_METRICS_REGISTRY_H__
 #define __COMMON_METRICS_METRICS_REGISTRY_H__
 
+#include <pthread.h>
+
 #include <list>
 #include <map>
 #include <string>
@@ -25,10 +27,14 @@ namespace common {
 
 class MetricsRegistry {
     public:
-    MetricsRegistry(){};
-    virtual ~MetricsRegistry(){};
-
-    void register_metric(const std::string& tag, Metric* metric);
+    MetricsRegistry() { pthread_mutex_init(&mutex, nullptr); };
+    virtual ~MetricsRegistry() { pthread_mutex_destroy(&mutex); };
+
+    /**
+     * 注册一个metric，tag已经被注册过时返回false。
+     * 注册、注销和snapshot/report可以在不同的线程中并发调用
+     */
+    bool register_metric(const std::string& tag, Metric* metric);
     void unregister(const std::string& tag);
 
     void snapshot();
@@ -40,6 +46,7 @@ class MetricsRegistry {
     protected:
     std::map<std::string, Metric*> metrics;
     std::list<Reporter*>           reporters;
+    pthread_mutex_t                mutex;
 };
 
 MetricsRegistry& get_metrics_registry();
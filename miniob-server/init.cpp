@@ -33,7 +33,9 @@ See the Mulan PSL v2 for more details. */
 #include <sql/parser/resolve_stage.h>
 #include <sql/plan_cache/plan_cache_stage.h>
 #include <sql/query_cache/query_cache_stage.h>
+#include <storage/default/bp_flush_stage.h>
 #include <storage/default/default_storage_stage.h>
+#include <storage/default/table_vacuum_stage.h>
 #include <storage/mem/mem_storage_stage.h>
 
 using namespace common;
@@ -155,6 +157,10 @@ int prepare_init_seda() {
         "DefaultStorageStage", &DefaultStorageStage::make_stage);
     static StageFactory mem_storage_factory("MemStorageStage",
                                             &MemStorageStage::make_stage);
+    static StageFactory bp_flush_factory("BufferPoolFlushStage",
+                                         &BufferPoolFlushStage::make_stage);
+    static StageFactory table_vacuum_factory("TableVacuumStage",
+                                             &TableVacuumStage::make_stage);
     return 0;
 }
 
@@ -19,7 +19,8 @@ Session& Session::default_session() {
     return session;
 }
 
-Session::Session(const Session& other) : current_db_(other.current_db_) {}
+Session::Session(const Session& other)
+    : current_db_(other.current_db_), scan_parallelism_(other.scan_parallelism_) {}
 
 Session::~Session() {
     delete transaction_;
@@ -16,6 +16,9 @@ See the Mulan PSL v2 for more details. */
 
 #include <string>
 
+// set scan_parallelism允许的最大值
+#define MAX_SCAN_PARALLELISM 64
+
 class Transaction;
 
 class Session {
@@ -38,11 +41,18 @@ class Session {
 
     Transaction*               current_transaction();
 
+    /**
+     * 全表扫描使用的并行度，默认是1，也就是不并行
+     */
+    int                scan_parallelism() const { return scan_parallelism_; }
+    void               set_scan_parallelism(int parallelism) { scan_parallelism_ = parallelism; }
+
     private:
     std::string current_db_;
     Transaction*        transaction_ = nullptr;
     bool        transaction_multi_operation_mode_ =
         false; // 当前事务的模式，是否多语句模式. 单语句模式自动提交
+    int         scan_parallelism_ = 1;
 };
 
 #endif // __OBSERVER_SESSION_SESSION_H__
\ No newline at end of file
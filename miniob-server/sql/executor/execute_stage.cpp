@@ -30,6 +30,7 @@ See the Mulan PSL v2 for more details. */
 #include <storage/common/condition_filter.h>
 #include <storage/common/table.h>
 #include <storage/default/default_handler.h>
+#include <storage/default/disk_buffer_pool.h>
 #include <storage/transaction/transaction.h>
 
 using namespace common;
@@ -139,7 +140,8 @@ void ExecuteStage::handle_request(common::StageEvent* event) {
     case SCF_DROP_TABLE:
     case SCF_CREATE_INDEX:
     case SCF_DROP_INDEX:
-    case SCF_LOAD_DATA: {
+    case SCF_LOAD_DATA:
+    case SCF_VACUUM: {
         StorageEvent* storage_event =
             new (std::nothrow) StorageEvent(exe_event);
         if (storage_event == nullptr) {
@@ -155,6 +157,16 @@ void ExecuteStage::handle_request(common::StageEvent* event) {
         session_event->set_response(strrc(rc));
         exe_event->done_immediate();
     } break;
+    case SCF_SHOW_BUFFER_POOL: {
+        session_event->set_response(theGlobalDiskBufferPool()->get_status());
+        exe_event->done_immediate();
+    } break;
+    case SCF_SET_VARIABLE: {
+        ResultCode rc = do_set_variable(session_event->get_client()->session,
+                                        sql->sstr.set_variable);
+        session_event->set_response(strrc(rc));
+        exe_event->done_immediate();
+    } break;
     case SCF_BEGIN: {
         session_event->get_client()->session->set_transaction_multi_operation_mode(
             true);
@@ -180,13 +192,17 @@ void ExecuteStage::handle_request(common::StageEvent* event) {
     case SCF_HELP: {
         const char* response =
             "show tables;\n"
+            "show buffer pool status;\n"
             "desc `table name`;\n"
             "create table `table name` (`column name` `column type`, ...);\n"
             "create index `index name` on `table` (`column`);\n"
             "insert into `table` values(`value1`,`value2`);\n"
             "update `table` set column=value [where `column`=`value`];\n"
             "delete from `table` [where `column`=`value`];\n"
-            "select [ * | `columns` ] from `table`;\n";
+            "select [ * | `columns` ] from `table`;\n"
+            "vacuum `table`;\n"
+            "set buffer_pool_size = `size` [ KB | MB | GB ];\n"
+            "set scan_parallelism = `workers`;\n";
         session_event->set_response(response);
         exe_event->done_immediate();
     } break;
@@ -203,6 +219,34 @@ void ExecuteStage::handle_request(common::StageEvent* event) {
     }
 }
 
+ResultCode ExecuteStage::do_set_variable(Session*           session,
+                                         const SetVariable& set_variable) {
+    std::string name = set_variable.name;
+    str_to_lower(name);
+    if (name == "scan_parallelism") {
+        // 只对当前会话生效
+        int parallelism = 0;
+        if (!str_to_val(std::string(set_variable.value), parallelism) ||
+            parallelism < 1 || parallelism > MAX_SCAN_PARALLELISM) {
+            LOG_WARN("Invalid scan parallelism %s", set_variable.value);
+            return ResultCode::INVALID_ARGUMENT;
+        }
+        session->set_scan_parallelism(parallelism);
+        return ResultCode::SUCCESS;
+    }
+    if (name != "buffer_pool_size") {
+        LOG_WARN("Unknown variable %s", set_variable.name);
+        return ResultCode::INVALID_ARGUMENT;
+    }
+
+    unsigned long long pool_size = 0;
+    if (!str_to_bytes(set_variable.value, pool_size)) {
+        LOG_WARN("Invalid buffer pool size %s", set_variable.value);
+        return ResultCode::INVALID_ARGUMENT;
+    }
+    return theGlobalDiskBufferPool()->resize(pool_size);
+}
+
 void end_transaction_if_need(Session* session, Transaction* transaction, bool all_right) {
     if (!session->is_transaction_multi_operation_mode()) {
         if (all_right) {
@@ -231,6 +275,7 @@ ResultCode ExecuteStage::do_select(const char* db, Query* sql,
         SelectExeNode* select_node = new SelectExeNode;
         rc = create_selection_executor(transaction, selects, db, table_name,
                                        *select_node);
+        select_node->set_parallelism(session->scan_parallelism());
         if (rc != ResultCode::SUCCESS) {
             delete select_node;
             for (SelectExeNode*& tmp_node : select_nodes) {
@@ -19,6 +19,7 @@ See the Mulan PSL v2 for more details. */
 #include <sql/parser/parse.h>
 
 class SessionEvent;
+class Session;
 
 class ExecuteStage : public common::Stage {
     public:
@@ -39,6 +40,11 @@ class ExecuteStage : public common::Stage {
     void handle_request(common::StageEvent* event);
     ResultCode   do_select(const char* db, Query* sql, SessionEvent* session_event);
 
+    /**
+     * 在线修改系统变量，目前支持 set buffer_pool_size = 512 MB
+     */
+    ResultCode   do_set_variable(Session* session, const SetVariable& set_variable);
+
     protected:
 
     private:
@@ -45,7 +45,28 @@ ResultCode SelectExeNode::execute(TupleSet& tuple_set) {
 
     tuple_set.clear();
     tuple_set.set_schema(tuple_schema_);
-    TupleRecordConverter converter(table_, tuple_set);
-    return table_->scan_record(transaction_, &condition_filter, -1, (void*)&converter,
-                               record_reader);
+    if (parallelism_ <= 1) {
+        TupleRecordConverter converter(table_, tuple_set);
+        return table_->scan_record(transaction_, &condition_filter, -1,
+                                   (void*)&converter, record_reader);
+    }
+
+    // 每个worker转换到自己的TupleSet中，扫描完再合并
+    std::vector<TupleSet>             tuple_sets(parallelism_);
+    std::vector<TupleRecordConverter> converters;
+    std::vector<void*>                contexts;
+    converters.reserve(parallelism_);
+    for (TupleSet& worker_tuple_set : tuple_sets) {
+        worker_tuple_set.set_schema(tuple_schema_);
+        converters.emplace_back(table_, worker_tuple_set);
+        contexts.push_back(&converters.back());
+    }
+
+    ResultCode rc = table_->scan_record_parallel(transaction_, &condition_filter,
+                                                 parallelism_, contexts.data(),
+                                                 record_reader);
+    for (TupleSet& worker_tuple_set : tuple_sets) {
+        tuple_set.append(std::move(worker_tuple_set));
+    }
+    return rc;
 }
\ No newline at end of file
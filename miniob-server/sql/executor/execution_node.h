@@ -39,8 +39,14 @@ class SelectExeNode : public ExecutionNode {
 
     ResultCode execute(TupleSet& tuple_set) override;
 
+    /**
+     * 全表扫描时使用的worker数，大于1时并行扫描
+     */
+    void       set_parallelism(int parallelism) { parallelism_ = parallelism; }
+
     private:
     Transaction*                                 transaction_ = nullptr;
+    int                                  parallelism_ = 1;
     Table*                               table_;
     TupleSchema                          tuple_schema_;
     std::vector<DefaultConditionFilter*> condition_filters_;
@@ -150,6 +150,18 @@ TupleSet& TupleSet::operator=(TupleSet&& other) {
 
 void TupleSet::add(Tuple&& tuple) { tuples_.emplace_back(std::move(tuple)); }
 
+void TupleSet::append(TupleSet&& other) {
+    if (tuples_.empty()) {
+        tuples_ = std::move(other.tuples_);
+    } else {
+        tuples_.reserve(tuples_.size() + other.tuples_.size());
+        for (Tuple& tuple : other.tuples_) {
+            tuples_.emplace_back(std::move(tuple));
+        }
+    }
+    other.tuples_.clear();
+}
+
 void TupleSet::clear() {
     tuples_.clear();
     schema_.clear();
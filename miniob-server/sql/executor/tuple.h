@@ -115,6 +115,11 @@ class TupleSet {
 
     void                      add(Tuple&& tuple);
 
+    /**
+     * 把other中的元组都移动到当前集合的末尾
+     */
+    void                      append(TupleSet&& other);
+
     void                      clear();
 
     bool                      is_empty() const;
@@ -136,24 +136,51 @@ void selects_destroy(Selects* selects) {
     selects->condition_num = 0;
 }
 
-void inserts_init(Inserts* inserts, const char* relation_name, Value values[],
-                  size_t value_num) {
-    assert(value_num <= sizeof(inserts->values) / sizeof(inserts->values[0]));
-
+void inserts_init(Inserts* inserts, const char* relation_name) {
     inserts->relation_name = strdup(relation_name);
+}
+
+int inserts_append_record(Inserts* inserts, Value values[], size_t value_num) {
+    if (inserts->record_num > 0 && value_num != inserts->value_num) {
+        for (size_t i = 0; i < value_num; i++) {
+            value_destroy(&values[i]);
+        }
+        return -1;
+    }
+
+    const size_t total = (inserts->record_num + 1) * value_num;
+    if (total > inserts->value_capacity) {
+        size_t capacity = inserts->value_capacity == 0 ? MAX_NUM
+                                                       : inserts->value_capacity * 2;
+        while (capacity < total) {
+            capacity *= 2;
+        }
+        inserts->values =
+            (Value*)realloc(inserts->values, sizeof(Value) * capacity);
+        inserts->value_capacity = capacity;
+    }
+
+    Value* record = inserts->values + inserts->record_num * value_num;
     for (size_t i = 0; i < value_num; i++) {
-        inserts->values[i] = values[i];
+        record[i] = values[i];
     }
     inserts->value_num = value_num;
+    inserts->record_num++;
+    return 0;
 }
+
 void inserts_destroy(Inserts* inserts) {
     free(inserts->relation_name);
     inserts->relation_name = nullptr;
 
-    for (size_t i = 0; i < inserts->value_num; i++) {
+    for (size_t i = 0; i < inserts->record_num * inserts->value_num; i++) {
         value_destroy(&inserts->values[i]);
     }
-    inserts->value_num = 0;
+    free(inserts->values);
+    inserts->values         = nullptr;
+    inserts->value_capacity = 0;
+    inserts->record_num     = 0;
+    inserts->value_num      = 0;
 }
 
 void deletes_init_relation(Deletes* deletes, const char* relation_name) {
@@ -292,6 +319,30 @@ void load_data_destroy(LoadData* load_data) {
     load_data->file_name     = nullptr;
 }
 
+void set_variable_init(SetVariable* set_variable, const char* name, int value,
+                       const char* unit) {
+    char buf[64];
+    snprintf(buf, sizeof(buf), "%d%s", value, unit == nullptr ? "" : unit);
+    set_variable->name  = strdup(name);
+    set_variable->value = strdup(buf);
+}
+
+void set_variable_destroy(SetVariable* set_variable) {
+    free(set_variable->name);
+    free(set_variable->value);
+    set_variable->name  = nullptr;
+    set_variable->value = nullptr;
+}
+
+void vacuum_table_init(VacuumTable* vacuum_table, const char* relation_name) {
+    vacuum_table->relation_name = strdup(relation_name);
+}
+
+void vacuum_table_destroy(VacuumTable* vacuum_table) {
+    free((char*)vacuum_table->relation_name);
+    vacuum_table->relation_name = nullptr;
+}
+
 void query_init(Query* query) {
     query->flag = SCF_ERROR;
     memset(&query->sstr, 0, sizeof(query->sstr));
@@ -338,6 +389,7 @@ void query_reset(Query* query) {
 
     } break;
     case SCF_SHOW_TABLES:
+    case SCF_SHOW_BUFFER_POOL:
         break;
 
     case SCF_DESC_TABLE: {
@@ -347,6 +399,12 @@ void query_reset(Query* query) {
     case SCF_LOAD_DATA: {
         load_data_destroy(&query->sstr.load_data);
     } break;
+    case SCF_SET_VARIABLE: {
+        set_variable_destroy(&query->sstr.set_variable);
+    } break;
+    case SCF_VACUUM: {
+        vacuum_table_destroy(&query->sstr.vacuum_table);
+    } break;
     case SCF_BEGIN:
     case SCF_COMMIT:
     case SCF_ROLLBACK:
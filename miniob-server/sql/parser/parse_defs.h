@@ -72,9 +72,11 @@ typedef struct {
 
 // struct of insert
 typedef struct {
-    char*  relation_name;   // Relation to insert into
-    size_t value_num;       // Length of values
-    Value  values[MAX_NUM]; // values to insert
+    char*  relation_name;  // Relation to insert into
+    size_t record_num;     // 插入的行数
+    size_t value_num;      // 每一行值的个数
+    Value* values;         // record_num * value_num个值，按行依次存放
+    size_t value_capacity; // values数组的容量
 } Inserts;
 
 // struct of delete
@@ -132,6 +134,17 @@ typedef struct {
     const char* file_name;
 } LoadData;
 
+// struct of set variable, 例如 set buffer_pool_size = 512 MB
+typedef struct {
+    char* name;  // 变量名
+    char* value; // 变量值，数字和单位拼在一起，例如"512MB"
+} SetVariable;
+
+// struct of vacuum table, 整理表的数据文件
+typedef struct {
+    const char* relation_name;
+} VacuumTable;
+
 union Queries {
     Selects     selection;
     Inserts     insertion;
@@ -143,6 +156,8 @@ union Queries {
     DropIndex   drop_index;
     DescTable   desc_table;
     LoadData    load_data;
+    SetVariable set_variable;
+    VacuumTable vacuum_table;
     char*       errors;
 };
 
@@ -159,11 +174,14 @@ enum SqlCommandFlag {
     SCF_DROP_INDEX,
     SCF_SYNC,
     SCF_SHOW_TABLES,
+    SCF_SHOW_BUFFER_POOL,
     SCF_DESC_TABLE,
     SCF_BEGIN,
     SCF_COMMIT,
     SCF_ROLLBACK,
     SCF_LOAD_DATA,
+    SCF_SET_VARIABLE,
+    SCF_VACUUM,
     SCF_HELP,
     SCF_EXIT
 };
@@ -202,8 +220,12 @@ void   selects_append_conditions(Selects* selects, Condition conditions[],
                                  size_t condition_num);
 void   selects_destroy(Selects* selects);
 
-void   inserts_init(Inserts* inserts, const char* relation_name, Value values[],
-                    size_t value_num);
+void   inserts_init(Inserts* inserts, const char* relation_name);
+/**
+ * 追加一行要插入的值，values的所有权转移给inserts。
+ * 每一行值的个数必须和第一行相同，否则释放values并返回-1
+ */
+int    inserts_append_record(Inserts* inserts, Value values[], size_t value_num);
 void   inserts_destroy(Inserts* inserts);
 
 void   deletes_init_relation(Deletes* deletes, const char* relation_name);
@@ -239,6 +261,13 @@ void   load_data_init(LoadData* load_data, const char* relation_name,
                       const char* file_name);
 void   load_data_destroy(LoadData* load_data);
 
+void   set_variable_init(SetVariable* set_variable, const char* name, int value,
+                         const char* unit);
+void   set_variable_destroy(SetVariable* set_variable);
+
+void   vacuum_table_init(VacuumTable* vacuum_table, const char* relation_name);
+void   vacuum_table_destroy(VacuumTable* vacuum_table);
+
 void   query_init(Query* query);
 Query* query_create(); // create and init
 void   query_reset(Query* query);
@@ -9,6 +9,7 @@
 #include<stdio.h>
 #include<stdlib.h>
 #include<string.h>
+#include<strings.h>
 
 typedef struct ParserContext {
   Query * ssql;
@@ -142,6 +143,7 @@ command:
 	| create_table
 	| drop_table
 	| show_tables
+	| show_buffer_pool
 	| desc_table
 	| create_index	
 	| drop_index
@@ -150,6 +152,8 @@ command:
 	| commit
 	| rollback
 	| load_data
+	| set_variable
+	| vacuum_table
 	| help
 	| exit
     ;
@@ -200,6 +204,21 @@ show_tables:
     }
     ;
 
+show_buffer_pool:	/*show buffer pool status，不增加关键字，免得这几个词不能再用作表名或列名*/
+    SHOW ID ID ID SEMICOLON {
+      int matched = strcasecmp($2, "buffer") == 0 && strcasecmp($3, "pool") == 0 &&
+                    strcasecmp($4, "status") == 0;
+      free($2);
+      free($3);
+      free($4);
+      if (!matched) {
+        yyerror(scanner, "unknown show command");
+        YYERROR;
+      }
+      CONTEXT->ssql->flag = SCF_SHOW_BUFFER_POOL;
+    }
+    ;
+
 desc_table:
     DESC ID SEMICOLON {
       CONTEXT->ssql->flag = SCF_DESC_TABLE;
@@ -278,22 +297,33 @@ ID_get:
 	;
 
 	
-insert:				/*insert   语句的语法解析树*/
-    INSERT INTO ID VALUES LBRACE value value_list RBRACE SEMICOLON 
+insert:				/*insert   语句的语法解析树，可以一次插入多行*/
+    INSERT INTO ID VALUES
 		{
-			// CONTEXT->values[CONTEXT->value_length++] = *$6;
-
+			// 先设置flag，解析失败时query_reset可以释放已经解析的行
 			CONTEXT->ssql->flag=SCF_INSERT;//"insert";
-			// CONTEXT->ssql->sstr.insertion.relation_name = $3;
-			// CONTEXT->ssql->sstr.insertion.value_num = CONTEXT->value_length;
-			// for(i = 0; i < CONTEXT->value_length; i++){
-			// 	CONTEXT->ssql->sstr.insertion.values[i] = CONTEXT->values[i];
-      // }
-			inserts_init(&CONTEXT->ssql->sstr.insertion, $3, CONTEXT->values, CONTEXT->value_length);
-
-      //临时变量清零
-      CONTEXT->value_length=0;
-    }
+			inserts_init(&CONTEXT->ssql->sstr.insertion, $3);
+		}
+		record_list SEMICOLON
+		;
+
+record_list:		/*左递归，行数再多解析栈也不会增长*/
+    record
+    | record_list COMMA record
+    ;
+record:
+    LBRACE value value_list RBRACE
+		{
+			int ret = inserts_append_record(&CONTEXT->ssql->sstr.insertion,
+					CONTEXT->values, CONTEXT->value_length);
+			//临时变量清零
+			CONTEXT->value_length=0;
+			if (ret != 0) {
+				yyerror(scanner, "values of records mismatch");
+				YYERROR;
+			}
+		}
+		;
 
 value_list:
     /* empty */
@@ -569,6 +599,35 @@ load_data:
 			load_data_init(&CONTEXT->ssql->sstr.load_data, $7, $4);
 		}
 		;
+
+set_variable:		/*set 变量 = 数值 [单位]，例如 set buffer_pool_size = 512 MB*/
+    SET ID EQ NUMBER SEMICOLON
+		{
+			CONTEXT->ssql->flag = SCF_SET_VARIABLE;
+			set_variable_init(&CONTEXT->ssql->sstr.set_variable, $2, $4, NULL);
+		}
+    | SET ID EQ NUMBER ID SEMICOLON
+		{
+			CONTEXT->ssql->flag = SCF_SET_VARIABLE;
+			set_variable_init(&CONTEXT->ssql->sstr.set_variable, $2, $4, $5);
+		}
+    ;
+
+vacuum_table:		/*vacuum 表名，整理表的数据文件。同样不增加关键字*/
+    ID ID SEMICOLON
+		{
+			int matched = strcasecmp($1, "vacuum") == 0;
+			free($1);
+			if (!matched) {
+				free($2);
+				yyerror(scanner, "unknown command");
+				YYERROR;
+			}
+			CONTEXT->ssql->flag = SCF_VACUUM;
+			vacuum_table_init(&CONTEXT->ssql->sstr.vacuum_table, $2);
+			free($2);
+		}
+    ;
 %%
 //_____________________________________________________________________
 extern void scan_string(const char *str, yyscan_t scanner);
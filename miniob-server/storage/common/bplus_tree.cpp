@@ -17,6 +17,12 @@ See the Mulan PSL v2 for more details. */
 #include <sql/parser/parse_defs.h>
 #include <storage/default/disk_buffer_pool.h>
 
+#include <errno.h>
+#include <string.h>
+
+#include <algorithm>
+#include <vector>
+
 #define FIRST_INDEX_PAGE 1
 
 int float_compare(float f1, float f2) {
@@ -65,11 +71,11 @@ int key_compare(AttrType attr_type, int attr_length, const char* first,
     return RID::compare(rid1, rid2);
 }
 
-int get_page_index_capacity(int attr_length) {
+int get_page_index_capacity(int page_size, int attr_length) {
 
-    int capacity =
-        ((int)BP_PAGE_DATA_SIZE - sizeof(IndexFileHeader) - sizeof(IndexNode)) /
-        (attr_length + 2 * sizeof(RID));
+    int capacity = (BP_PAGE_DATA_SIZE(page_size) - (int)sizeof(IndexFileHeader) -
+                    (int)sizeof(IndexNode)) /
+                   (attr_length + 2 * (int)sizeof(RID));
     // Here is some tricks
     // 1. reserver one pair of kV for insert operation
     // 2. make sure capacity % 2 == 0, otherwise it is likeyly to occur problem
@@ -91,16 +97,30 @@ ResultCode BplusTreeHandler::sync() {
     return disk_buffer_pool_->purge_all_pages(file_id_);
 }
 
+int choose_index_page_size(int attr_length) {
+    int page_size = BP_DEFAULT_PAGE_SIZE;
+    while (page_size < BP_MAX_PAGE_SIZE &&
+           get_page_index_capacity(page_size, attr_length) < BPLUS_TREE_MIN_ORDER) {
+        page_size *= 2;
+    }
+    return page_size;
+}
+
 ResultCode BplusTreeHandler::create(const char* file_name, AttrType attr_type,
-                            int attr_length) {
+                            int attr_length, int page_size) {
+    if (page_size == 0) {
+        page_size = choose_index_page_size(attr_length);
+    }
+
     DiskBufferPool* disk_buffer_pool = theGlobalDiskBufferPool();
-    ResultCode              rc               = disk_buffer_pool->create_file(file_name);
+    ResultCode              rc               = disk_buffer_pool->create_file(file_name, page_size);
     if (rc != ResultCode::SUCCESS) {
         LOG_WARN("Failed to create file. file name=%s, rc=%d:%s", file_name, rc,
                  strrc(rc));
         return rc;
     }
-    LOG_INFO("Successfully create index file:%s", file_name);
+    LOG_INFO("Successfully create index file:%s, page size=%d", file_name,
+             page_size);
 
     int file_id;
     rc = disk_buffer_pool->open_file(file_name, &file_id);
@@ -141,7 +161,7 @@ ResultCode BplusTreeHandler::create(const char* file_name, AttrType attr_type,
     file_header->attr_length     = attr_length;
     file_header->key_length      = attr_length + sizeof(RID);
     file_header->attr_type       = attr_type;
-    file_header->order           = get_page_index_capacity(attr_length);
+    file_header->order           = get_page_index_capacity(page_size, attr_length);
     file_header->root_page       = page_num;
 
     root_node_                   = get_index_node(pdata);
@@ -1052,6 +1072,454 @@ ResultCode BplusTreeHandler::insert_into_new_root(BPPageHandle& left_page_handle
     return ResultCode::SUCCESS;
 }
 
+ResultCode BplusTreeHandler::insert_entries(const char* const pkeys[],
+                                            const RID rids[], int num) {
+    std::vector<int> order(num);
+    for (int i = 0; i < num; i++) {
+        order[i] = i;
+    }
+    const AttrType attr_type   = file_header_.attr_type;
+    const int      attr_length = file_header_.attr_length;
+    std::sort(order.begin(), order.end(), [&](int a, int b) {
+        int result = attribute_comp(pkeys[a], pkeys[b], attr_type, attr_length);
+        if (result != 0) {
+            return result < 0;
+        }
+        return RID::compare(&rids[a], &rids[b]) < 0;
+    });
+
+    for (int i : order) {
+        ResultCode rc = insert_entry(pkeys[i], &rids[i]);
+        if (rc != ResultCode::SUCCESS) {
+            return rc;
+        }
+    }
+    return ResultCode::SUCCESS;
+}
+
+int BplusTreeHandler::BULK_LOAD_FILL_FACTOR = BPLUS_TREE_DEFAULT_FILL_FACTOR;
+
+/**
+ * 批量构建一层节点时，把count个元素(叶子上的索引项或者下一层的节点)分配到节点中。
+ * 每个节点放fill个，最后一个节点不够min_num个时和前一个节点合并，
+ * 合并后超过max_num个就平分成两个节点
+ */
+static void plan_bulk_load_nodes(int count, int fill, int min_num, int max_num,
+                                 std::vector<int>& sizes) {
+    sizes.clear();
+    for (; count > 0; count -= sizes.back()) {
+        sizes.push_back(std::min(fill, count));
+    }
+    if (sizes.size() > 1 && sizes.back() < min_num) {
+        int combined = sizes[sizes.size() - 2] + sizes.back();
+        sizes.pop_back();
+        sizes.pop_back();
+        if (combined <= max_num) {
+            sizes.push_back(combined);
+        } else {
+            sizes.push_back(combined / 2);
+            sizes.push_back(combined - combined / 2);
+        }
+    }
+}
+
+/**
+ * 按填充率计算每个节点放的元素个数，不少于min_num，不超过max_num
+ */
+static int bulk_load_node_fill(int max_num, int min_num, int fill_factor) {
+    return std::max(min_num, std::min(max_num, max_num * fill_factor / 100));
+}
+
+unsigned long long BplusTreeSorter::MEMORY_LIMIT = BPLUS_TREE_DEFAULT_SORT_MEMORY;
+
+BplusTreeSorter::BplusTreeSorter(AttrType attr_type, int attr_length)
+    : attr_type_(attr_type), attr_length_(attr_length),
+      key_length_(attr_length + (int)sizeof(RID)) {
+    // 内存中每个索引项还要占用一个排序用的下标
+    capacity_ = std::max(1ULL, MEMORY_LIMIT / (key_length_ + sizeof(uint32_t)));
+}
+
+BplusTreeSorter::~BplusTreeSorter() {
+    for (Run& run : runs_) {
+        if (run.file != nullptr) {
+            fclose(run.file);
+        }
+    }
+}
+
+ResultCode BplusTreeSorter::add(const char* pkey, const RID* rid) {
+    if (order_.size() >= capacity_) {
+        ResultCode rc = spill();
+        if (rc != ResultCode::SUCCESS) {
+            return rc;
+        }
+    }
+    order_.push_back((uint32_t)order_.size());
+    buffer_.insert(buffer_.end(), pkey, pkey + attr_length_);
+    buffer_.insert(buffer_.end(), (const char*)rid, (const char*)rid + sizeof(RID));
+    count_++;
+    return ResultCode::SUCCESS;
+}
+
+void BplusTreeSorter::sort_buffer() {
+    const char* keys = buffer_.data();
+    std::sort(order_.begin(), order_.end(), [&](uint32_t a, uint32_t b) {
+        return key_compare(attr_type_, attr_length_, keys + (size_t)a * key_length_,
+                           keys + (size_t)b * key_length_) < 0;
+    });
+}
+
+ResultCode BplusTreeSorter::spill() {
+    sort_buffer();
+    Run run;
+    run.file = tmpfile();
+    if (run.file == nullptr) {
+        LOG_ERROR("Failed to create temp file for sorting index entries, error:%s",
+                  strerror(errno));
+        return ResultCode::IOERR_GETTEMPPATH;
+    }
+    runs_.push_back(run);
+
+    for (uint32_t i : order_) {
+        if (fwrite(buffer_.data() + (size_t)i * key_length_, key_length_, 1, run.file) != 1) {
+            LOG_ERROR("Failed to write sorted index entries to temp file, error:%s",
+                      strerror(errno));
+            return ResultCode::IOERR_WRITE;
+        }
+    }
+    if (fflush(run.file) != 0 || fseek(run.file, 0, SEEK_SET) != 0) {
+        LOG_ERROR("Failed to flush sorted index entries to temp file, error:%s",
+                  strerror(errno));
+        return ResultCode::IOERR_WRITE;
+    }
+    buffer_.clear();
+    order_.clear();
+    return ResultCode::SUCCESS;
+}
+
+ResultCode BplusTreeSorter::read_run(Run& run, bool& eof) {
+    eof = false;
+    if (fread(run.key.data(), key_length_, 1, run.file) == 1) {
+        return ResultCode::SUCCESS;
+    }
+    if (ferror(run.file)) {
+        LOG_ERROR("Failed to read sorted index entries from temp file, error:%s",
+                  strerror(errno));
+        return ResultCode::IOERR_READ;
+    }
+    eof = true;
+    fclose(run.file);
+    run.file = nullptr;
+    return ResultCode::SUCCESS;
+}
+
+ResultCode BplusTreeSorter::finish() {
+    position_ = 0;
+    if (runs_.empty()) {
+        sort_buffer();
+        return ResultCode::SUCCESS;
+    }
+
+    // 剩下的索引项也写成一个有序段，归并时内存中只保留每个段当前的索引项
+    if (!order_.empty()) {
+        ResultCode rc = spill();
+        if (rc != ResultCode::SUCCESS) {
+            return rc;
+        }
+    }
+    std::vector<char>().swap(buffer_);
+    std::vector<uint32_t>().swap(order_);
+
+    current_.resize(key_length_);
+    heap_.clear();
+    for (size_t i = 0; i < runs_.size(); i++) {
+        bool eof;
+        runs_[i].key.resize(key_length_);
+        ResultCode rc = read_run(runs_[i], eof);
+        if (rc != ResultCode::SUCCESS) {
+            return rc;
+        }
+        if (!eof) {
+            heap_.push_back((int)i);
+        }
+    }
+    std::make_heap(heap_.begin(), heap_.end(), [this](int a, int b) {
+        return key_compare(attr_type_, attr_length_, runs_[a].key.data(),
+                           runs_[b].key.data()) > 0;
+    });
+    LOG_INFO("Merge %d sorted runs of %d index entries", (int)runs_.size(), count_);
+    return ResultCode::SUCCESS;
+}
+
+ResultCode BplusTreeSorter::next(const char*& key) {
+    if (runs_.empty()) {
+        if (position_ >= order_.size()) {
+            return ResultCode::RECORD_EOF;
+        }
+        key = buffer_.data() + (size_t)order_[position_++] * key_length_;
+        return ResultCode::SUCCESS;
+    }
+
+    if (heap_.empty()) {
+        return ResultCode::RECORD_EOF;
+    }
+    auto greater = [this](int a, int b) {
+        return key_compare(attr_type_, attr_length_, runs_[a].key.data(),
+                           runs_[b].key.data()) > 0;
+    };
+    std::pop_heap(heap_.begin(), heap_.end(), greater);
+    Run& run = runs_[heap_.back()];
+    current_.swap(run.key);
+    key = current_.data();
+
+    bool       eof;
+    ResultCode rc = read_run(run, eof);
+    if (rc != ResultCode::SUCCESS) {
+        return rc;
+    }
+    if (eof) {
+        heap_.pop_back();
+    } else {
+        std::push_heap(heap_.begin(), heap_.end(), greater);
+    }
+    return ResultCode::SUCCESS;
+}
+
+ResultCode BplusTreeHandler::bulk_load(const char* const pkeys[], const RID rids[],
+                                       int num) {
+    BplusTreeSorter sorter(file_header_.attr_type, file_header_.attr_length);
+    for (int i = 0; i < num; i++) {
+        ResultCode rc = sorter.add(pkeys[i], &rids[i]);
+        if (rc != ResultCode::SUCCESS) {
+            return rc;
+        }
+    }
+    return bulk_load(sorter);
+}
+
+ResultCode BplusTreeHandler::bulk_load(BplusTreeSorter& sorter) {
+    if (file_id_ < 0) {
+        LOG_WARN("Index isn't ready!");
+        return ResultCode::RECORD_CLOSED;
+    }
+    ResultCode rc = sorter.finish();
+    if (rc != ResultCode::SUCCESS) {
+        LOG_WARN("Failed to sort entries of index %d, rc=%d:%s", file_id_, rc, strrc(rc));
+        return rc;
+    }
+
+    if (!root_node_->is_leaf || root_node_->key_num != 0) {
+        LOG_INFO("Index %d isn't empty, insert entries one by one", file_id_);
+        const char* key;
+        while ((rc = sorter.next(key)) == ResultCode::SUCCESS) {
+            RID rid;
+            memcpy(&rid, key + file_header_.attr_length, sizeof(RID));
+            rc = insert_entry(key, &rid);
+            if (rc != ResultCode::SUCCESS) {
+                return rc;
+            }
+        }
+        return rc == ResultCode::RECORD_EOF ? ResultCode::SUCCESS : rc;
+    }
+    if (sorter.count() <= 0) {
+        return ResultCode::SUCCESS;
+    }
+
+    // 先写满叶子层，再逐层往上构建，直到只剩一个节点
+    std::vector<PageNum> pages;
+    std::vector<char>    min_keys;
+    std::vector<PageNum> new_pages;
+    rc = bulk_load_leaves(sorter, pages, min_keys, new_pages);
+    while (rc == ResultCode::SUCCESS && pages.size() > 1) {
+        rc = bulk_load_intern_level(pages, min_keys, new_pages);
+    }
+
+    BPPageHandle new_root_handle;
+    if (rc == ResultCode::SUCCESS && pages[0] != file_header_.root_page) {
+        rc = disk_buffer_pool_->get_this_page(file_id_, pages[0], &new_root_handle);
+        if (rc != ResultCode::SUCCESS) {
+            LOG_WARN("Failed to load new root page %d of index %d", pages[0], file_id_);
+        }
+    }
+    if (rc != ResultCode::SUCCESS) {
+        // 第一个叶子是原来的根节点，清空它，其它页面都释放掉
+        LOG_WARN("Failed to bulk load index %d, rc=%d:%s", file_id_, rc, strrc(rc));
+        root_node_->init_empty(file_header_);
+        disk_buffer_pool_->mark_dirty(&root_page_handle_);
+        for (PageNum page_num : new_pages) {
+            disk_buffer_pool_->dispose_page(file_id_, page_num);
+        }
+        return rc;
+    }
+
+    if (new_root_handle.open) {
+        char* pdata;
+        disk_buffer_pool_->get_data(&new_root_handle, &pdata);
+        swith_root(new_root_handle, get_index_node(pdata), pages[0]);
+        rc = write_file_header();
+    }
+    LOG_INFO("Successfully bulk load %d entries into index %d, pages=%d",
+             sorter.count(), file_id_, (int)new_pages.size() + 1);
+    return rc;
+}
+
+ResultCode BplusTreeHandler::bulk_load_leaves(BplusTreeSorter&      sorter,
+                                              std::vector<PageNum>& pages,
+                                              std::vector<char>&    min_keys,
+                                              std::vector<PageNum>& new_pages) {
+    const AttrType   attr_type   = file_header_.attr_type;
+    const int        attr_length = file_header_.attr_length;
+    const int        key_length  = file_header_.key_length;
+    const int        order       = file_header_.order;
+    std::vector<int> sizes;
+    plan_bulk_load_nodes(
+        sorter.count(),
+        bulk_load_node_fill(order, order / 2, BULK_LOAD_FILL_FACTOR), order / 2,
+        order, sizes);
+    pages.clear();
+    min_keys.resize(sizes.size() * key_length);
+
+    // 第一个叶子使用根节点的页面。上一个叶子在下一个叶子分配以后才能设置next_brother
+    ResultCode   rc        = ResultCode::SUCCESS;
+    BPPageHandle prev_handle;
+    IndexNode*   prev_leaf = nullptr;
+    const char*  prev_key  = nullptr;
+    for (size_t i = 0; i < sizes.size() && rc == ResultCode::SUCCESS; i++) {
+        BPPageHandle page_handle;
+        IndexNode*   leaf     = nullptr;
+        PageNum      page_num = file_header_.root_page;
+        char*        pdata;
+        if (i == 0) {
+            disk_buffer_pool_->get_data(&root_page_handle_, &pdata);
+            leaf = get_index_node(pdata);
+        } else {
+            rc = disk_buffer_pool_->allocate_page(file_id_, &page_handle);
+            if (rc != ResultCode::SUCCESS) {
+                LOG_WARN("Failed to allocate leaf page while bulk loading index %d",
+                         file_id_);
+                break;
+            }
+            disk_buffer_pool_->get_page_num(&page_handle, &page_num);
+            disk_buffer_pool_->get_data(&page_handle, &pdata);
+            new_pages.push_back(page_num);
+            leaf = get_index_node(pdata);
+            leaf->init_empty(file_header_);
+            leaf->prev_brother     = pages.back();
+            prev_leaf->next_brother = page_num;
+        }
+
+        // 索引项按顺序读出，和前一个索引项相同就是重复的。前一个叶子这时还没有unpin
+        int j = 0;
+        for (; j < sizes[i]; j++) {
+            const char* key;
+            rc = sorter.next(key);
+            if (rc != ResultCode::SUCCESS) {
+                LOG_WARN("Failed to read sorted entries of index %d, rc=%d:%s",
+                         file_id_, rc, strrc(rc));
+                break;
+            }
+            if (prev_key != nullptr &&
+                key_compare(attr_type, attr_length, prev_key, key) == 0) {
+                LOG_TRACE("Bulk load into %d occur duplicated key, rid:%s.", file_id_,
+                          ((const RID*)(key + attr_length))->to_string().c_str());
+                rc = ResultCode::RECORD_DUPLICATE_KEY;
+                break;
+            }
+            memcpy(leaf->keys + j * key_length, key, key_length);
+            memcpy(leaf->rids + j, key + attr_length, sizeof(RID));
+            prev_key = leaf->keys + j * key_length;
+        }
+        leaf->key_num = j;
+        memcpy(min_keys.data() + i * key_length, leaf->keys, key_length);
+        pages.push_back(page_num);
+
+        disk_buffer_pool_->mark_dirty(i == 0 ? &root_page_handle_ : &page_handle);
+        if (prev_handle.open) {
+            disk_buffer_pool_->unpin_page(&prev_handle);
+        }
+        prev_handle = page_handle;
+        prev_leaf   = leaf;
+    }
+
+    if (prev_handle.open) {
+        disk_buffer_pool_->unpin_page(&prev_handle);
+    }
+    return rc;
+}
+
+ResultCode BplusTreeHandler::bulk_load_intern_level(std::vector<PageNum>& pages,
+                                                    std::vector<char>&    min_keys,
+                                                    std::vector<PageNum>& new_pages) {
+    // 内部节点最多order个key，order + 1个孩子
+    const int        key_length = file_header_.key_length;
+    const int        order      = file_header_.order;
+    std::vector<int> sizes;
+    plan_bulk_load_nodes(
+        (int)pages.size(),
+        bulk_load_node_fill(order + 1, order / 2 + 1, BULK_LOAD_FILL_FACTOR),
+        order / 2 + 1, order + 1, sizes);
+
+    std::vector<PageNum> parent_pages;
+    std::vector<char>    parent_min_keys(sizes.size() * key_length);
+    int                  child = 0;
+    for (size_t i = 0; i < sizes.size(); i++) {
+        BPPageHandle page_handle;
+        ResultCode   rc = disk_buffer_pool_->allocate_page(file_id_, &page_handle);
+        if (rc != ResultCode::SUCCESS) {
+            LOG_WARN("Failed to allocate intern page while bulk loading index %d",
+                     file_id_);
+            return rc;
+        }
+        PageNum page_num;
+        char*   pdata;
+        disk_buffer_pool_->get_page_num(&page_handle, &page_num);
+        disk_buffer_pool_->get_data(&page_handle, &pdata);
+        new_pages.push_back(page_num);
+        IndexNode* node = get_index_node(pdata);
+        node->init_empty(file_header_);
+        node->is_leaf = false;
+
+        // keys[j - 1]是第j个孩子中最小的key
+        memcpy(parent_min_keys.data() + i * key_length,
+               min_keys.data() + (size_t)child * key_length, key_length);
+        for (int j = 0; j < sizes[i]; j++, child++) {
+            if (j > 0) {
+                memcpy(node->keys + (j - 1) * key_length,
+                       min_keys.data() + (size_t)child * key_length, key_length);
+            }
+            node->rids[j].page_num = pages[child];
+            node->rids[j].slot_num = EMPTY_RID_SLOT_NUM;
+        }
+        node->key_num = sizes[i] - 1;
+        change_children_parent(node->rids, sizes[i], page_num);
+        parent_pages.push_back(page_num);
+
+        disk_buffer_pool_->mark_dirty(&page_handle);
+        disk_buffer_pool_->unpin_page(&page_handle);
+    }
+
+    pages.swap(parent_pages);
+    min_keys.swap(parent_min_keys);
+    return ResultCode::SUCCESS;
+}
+
+ResultCode BplusTreeHandler::write_file_header() {
+    BPPageHandle page_handle;
+    ResultCode   rc =
+        disk_buffer_pool_->get_this_page(file_id_, FIRST_INDEX_PAGE, &page_handle);
+    if (rc != ResultCode::SUCCESS) {
+        LOG_WARN("Failed to load header page of index %d", file_id_);
+        return rc;
+    }
+    char* pdata;
+    disk_buffer_pool_->get_data(&page_handle, &pdata);
+    memcpy(pdata, &file_header_, sizeof(file_header_));
+    disk_buffer_pool_->mark_dirty(&page_handle);
+    disk_buffer_pool_->unpin_page(&page_handle);
+    header_dirty_ = false;
+    return ResultCode::SUCCESS;
+}
+
 ResultCode BplusTreeHandler::insert_entry(const char* pkey, const RID* rid) {
 
     if (file_id_ < 0) {
@@ -2219,9 +2687,10 @@ ResultCode BplusTreeHandler::find_first_index_satisfied(CompOp compop, const cha
                 }
             }
         }
+        // 这个叶子页面上没有满足条件的key，换到下一个页面前要先释放
         next = node->next_brother;
+        disk_buffer_pool_->unpin_page(&page_handle);
     }
-    disk_buffer_pool_->unpin_page(&page_handle);
 
     return ResultCode::RECORD_EOF;
 }
@@ -2289,6 +2758,11 @@ ResultCode BplusTreeScanner::open(CompOp comp_op, const char* value) {
         } else
             return rc;
     }
+    // 等值查询只会访问很少的叶子页面，不需要私有frame环
+    if (comp_op != EQUAL_TO) {
+        scan_ring_ = index_handler_.disk_buffer_pool_->create_scan_ring(
+            index_handler_.file_id_);
+    }
     num_fixed_pages_           = 1;
     next_index_of_page_handle_ = 0;
     pinned_page_count_         = 0;
@@ -2300,9 +2774,16 @@ ResultCode BplusTreeScanner::close() {
     if (!opened_) {
         return ResultCode::RECORD_SCANCLOSED;
     }
+    // 没有扫描到最后就关闭时，还有页面固定在缓冲池中
+    for (int i = 0; i < pinned_page_count_; i++) {
+        index_handler_.disk_buffer_pool_->unpin_page(page_handles_ + i);
+    }
+    pinned_page_count_ = 0;
     free((void*)value_);
     value_  = nullptr;
-    opened_ = false;
+    delete scan_ring_;
+    scan_ring_ = nullptr;
+    opened_    = false;
     return ResultCode::SUCCESS;
 }
 
@@ -2313,18 +2794,15 @@ ResultCode BplusTreeScanner::next_entry(RID* rid) {
     }
     rc = get_next_idx_in_memory(
         rid); // 和RM中一样，有可能有错误，一次只查当前页和当前页的下一页，有待确定
-    if (rc == ResultCode::RECORD_NO_MORE_IDX_IN_MEM) {
+    // 新读入的几个页面上也可能没有满足条件的索引项，继续读后面的页面
+    while (rc == ResultCode::RECORD_NO_MORE_IDX_IN_MEM) {
         rc = find_idx_pages();
         if (rc != ResultCode::SUCCESS) {
             return rc;
         }
-        return get_next_idx_in_memory(rid);
-    } else {
-        if (rc != ResultCode::SUCCESS) {
-            return rc;
-        }
+        rc = get_next_idx_in_memory(rid);
     }
-    return ResultCode::SUCCESS;
+    return rc;
 }
 
 ResultCode BplusTreeScanner::find_idx_pages() {
@@ -2348,7 +2826,8 @@ ResultCode BplusTreeScanner::find_idx_pages() {
         if (next_page_num_ <= 0)
             break;
         rc = index_handler_.disk_buffer_pool_->get_this_page(
-            index_handler_.file_id_, next_page_num_, page_handles_ + i);
+            index_handler_.file_id_, next_page_num_, page_handles_ + i,
+            scan_ring_);
         if (rc != ResultCode::SUCCESS) {
             return rc;
         }
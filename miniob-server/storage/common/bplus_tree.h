@@ -16,7 +16,9 @@ See the Mulan PSL v2 for more details. */
 #ifndef __OBSERVER_STORAGE_COMMON_INDEX_MANAGER_H_
 #define __OBSERVER_STORAGE_COMMON_INDEX_MANAGER_H_
 
+#include <stdio.h>
 #include <sstream>
+#include <vector>
 
 #include <storage/common/record_manager.h>
 #include <sql/parser/parse_defs.h>
@@ -47,6 +49,12 @@ struct IndexFileHeader {
 };
 
 #define RECORD_RESERVER_PAIR_NUM 2
+// 自动选择页面大小时，希望每个节点至少能放下的key个数
+#define BPLUS_TREE_MIN_ORDER 64
+// 批量构建索引时节点的默认填充率(百分比)，留一些空间给之后的插入
+#define BPLUS_TREE_DEFAULT_FILL_FACTOR 90
+// 批量构建索引时排序索引项默认使用的内存上限
+#define BPLUS_TREE_DEFAULT_SORT_MEMORY (64ULL * 1024 * 1024)
 struct IndexNode {
     bool    is_leaf;
     int     key_num;
@@ -115,13 +123,89 @@ struct IndexNode {
     }
 };
 
+/**
+ * 批量构建索引时给索引项排序，索引项和B+树中的key一样，是属性值后面跟着rid。
+ * 内存中放不下时把已经加入的索引项排好序写到临时文件中作为一个有序段，
+ * 全部加入以后多路归并这些有序段，按(key, rid)的顺序读出
+ */
+class BplusTreeSorter {
+    public:
+    BplusTreeSorter(AttrType attr_type, int attr_length);
+    ~BplusTreeSorter();
+
+    /**
+     * 加入一个索引项，超过内存上限时先把内存中的索引项写成一个有序段
+     */
+    ResultCode add(const char* pkey, const RID* rid);
+    /**
+     * 所有索引项都加入以后调用，准备按顺序读出
+     */
+    ResultCode finish();
+    /**
+     * 按顺序读出下一个索引项，key在下一次调用next之前有效
+     * @return RECORD_EOF 全部读完了
+     */
+    ResultCode next(const char*& key);
+
+    int count() const { return count_; }
+    /**
+     * 写到临时文件中的有序段个数
+     */
+    int run_count() const { return (int)runs_.size(); }
+
+    /**
+     * 设置排序时索引项最多占用的内存，单位是字节
+     */
+    static void set_memory_limit(unsigned long long memory_limit) {
+        if (memory_limit > 0) {
+            MEMORY_LIMIT = memory_limit;
+            LOG_INFO("Successfully set bulk load sort memory as %llu", memory_limit);
+        } else {
+            LOG_INFO("Invalid input argument memory_limit:%llu", memory_limit);
+        }
+    }
+
+    private:
+    /**
+     * 临时文件中的一个有序段，key是归并时这个段当前最小的索引项
+     */
+    struct Run {
+        FILE*             file = nullptr;
+        std::vector<char> key;
+    };
+
+    void       sort_buffer();
+    ResultCode spill();
+    ResultCode read_run(Run& run, bool& eof);
+
+    private:
+    AttrType              attr_type_;
+    int                   attr_length_;
+    int                   key_length_;
+    size_t                capacity_;
+    int                   count_ = 0;
+
+    std::vector<char>     buffer_;
+    std::vector<uint32_t> order_;
+    size_t                position_ = 0;
+
+    std::vector<Run>      runs_;
+    std::vector<int>      heap_;
+    std::vector<char>     current_;
+
+    static unsigned long long MEMORY_LIMIT;
+};
+
 class BplusTreeHandler {
     public:
     /**
      * 此函数创建一个名为fileName的索引。
-     * attrType描述被索引属性的类型，attrLength描述被索引属性的长度
+     * attrType描述被索引属性的类型，attrLength描述被索引属性的长度。
+     * page_size为0时按key的长度自动选择页面大小：从默认页面大小开始，
+     * 选择第一个能让节点放下BPLUS_TREE_MIN_ORDER个key的页面大小
      */
-    ResultCode create(const char* file_name, AttrType attr_type, int attr_length);
+    ResultCode create(const char* file_name, AttrType attr_type, int attr_length,
+                      int page_size = 0);
 
     /**
      * 打开名为fileName的索引文件。
@@ -142,6 +226,36 @@ class BplusTreeHandler {
      */
     ResultCode insert_entry(const char* pkey, const RID* rid);
 
+    /**
+     * 批量插入num个索引项，先按(key, rid)排序再逐个插入，
+     * 相邻的插入落在同一个叶子页面上，查找路径上的页面也都还在缓存中。
+     * 失败时已经插入的索引项不会被删除
+     */
+    ResultCode insert_entries(const char* const pkeys[], const RID rids[], int num);
+
+    /**
+     * 在空的索引上自底向上批量构建B+树：按sorter排好的(key, rid)顺序
+     * 写满叶子，再一层一层地构建内部节点，每个节点按填充率放满。
+     * 有重复的索引项时什么都不插入。索引不为空时按顺序逐个插入
+     */
+    ResultCode bulk_load(BplusTreeSorter& sorter);
+    /**
+     * 把num个索引项交给BplusTreeSorter排序后批量构建
+     */
+    ResultCode bulk_load(const char* const pkeys[], const RID rids[], int num);
+
+    /**
+     * 设置批量构建时节点的填充率(百分比)，节点至少也要半满
+     */
+    static void set_bulk_load_fill_factor(int fill_factor) {
+        if (fill_factor > 0 && fill_factor <= 100) {
+            BULK_LOAD_FILL_FACTOR = fill_factor;
+            LOG_INFO("Successfully set BULK_LOAD_FILL_FACTOR as %d", fill_factor);
+        } else {
+            LOG_INFO("Invalid input argument fill_factor:%d", fill_factor);
+        }
+    }
+
     /**
      * 从IndexHandle句柄对应的索引中删除一个值为（*pData，rid）的索引项
      * @return RECORD_INVALID_KEY 指定值不存在
@@ -227,6 +341,24 @@ class BplusTreeHandler {
                           PageNum root_page);
 
     void change_children_parent(RID* rid, int rid_len, PageNum new_parent_page);
+
+    /**
+     * 批量构建时写叶子层。pages和min_keys返回每个叶子的页面和最小的key，
+     * new_pages记录新分配的页面，失败时释放
+     */
+    ResultCode bulk_load_leaves(BplusTreeSorter& sorter, std::vector<PageNum>& pages,
+                                std::vector<char>&    min_keys,
+                                std::vector<PageNum>& new_pages);
+    /**
+     * 为pages中的节点构建上一层内部节点，pages和min_keys换成上一层的节点
+     */
+    ResultCode bulk_load_intern_level(std::vector<PageNum>& pages,
+                                      std::vector<char>&    min_keys,
+                                      std::vector<PageNum>& new_pages);
+    /**
+     * 把内存中的文件头(比如新的根节点页面)写回第一个页面
+     */
+    ResultCode write_file_header();
     ResultCode get_parent_changed_index(BPPageHandle& parent_handle, IndexNode*& parent,
                                 IndexNode* node, PageNum page_num,
                                 int& changed_index);
@@ -250,6 +382,8 @@ class BplusTreeHandler {
 
     common::MemPoolItem* mem_pool_item_ = nullptr;
 
+    static int           BULK_LOAD_FILL_FACTOR;
+
     private:
     friend class BplusTreeScanner;
     friend class BplusTreeTester;
@@ -300,6 +434,7 @@ class BplusTreeScanner {
     int next_index_of_page_handle_ = -1; // 当前被扫描页面的操作索引
     int index_in_node_             = -1; // 当前B+ Tree页面上的key index
     PageNum next_page_num_         = -1; // 下一个将要被读入的页面号
+    BPScanRing* scan_ring_         = nullptr; // 范围扫描时使用的私有frame环
 };
 
 class BplusTreeTester {
@@ -75,6 +75,8 @@ ResultCode BplusTreeIndex::close() {
         index_handler_.close();
         inited_ = false;
     }
+    delete bulk_load_sorter_;
+    bulk_load_sorter_ = nullptr;
     LOG_INFO("Successfully close index.");
     return ResultCode::SUCCESS;
 }
@@ -83,10 +85,36 @@ ResultCode BplusTreeIndex::insert_entry(const char* record, const RID* rid) {
     return index_handler_.insert_entry(record + field_meta_.offset(), rid);
 }
 
+ResultCode BplusTreeIndex::insert_entries(const char* const records[],
+                                          const RID rids[], int num) {
+    std::vector<const char*> keys(num);
+    for (int i = 0; i < num; i++) {
+        keys[i] = records[i] + field_meta_.offset();
+    }
+    return index_handler_.insert_entries(keys.data(), rids, num);
+}
+
 ResultCode BplusTreeIndex::delete_entry(const char* record, const RID* rid) {
     return index_handler_.delete_entry(record + field_meta_.offset(), rid);
 }
 
+ResultCode BplusTreeIndex::bulk_load_add(const char* record, const RID* rid) {
+    if (bulk_load_sorter_ == nullptr) {
+        bulk_load_sorter_ = new BplusTreeSorter(field_meta_.type(), field_meta_.len());
+    }
+    return bulk_load_sorter_->add(record + field_meta_.offset(), rid);
+}
+
+ResultCode BplusTreeIndex::bulk_load_finish() {
+    if (bulk_load_sorter_ == nullptr) {
+        return ResultCode::SUCCESS;
+    }
+    ResultCode rc = index_handler_.bulk_load(*bulk_load_sorter_);
+    delete bulk_load_sorter_;
+    bulk_load_sorter_ = nullptr;
+    return rc;
+}
+
 IndexScanner* BplusTreeIndex::create_scanner(CompOp      comp_op,
                                              const char* value) {
     BplusTreeScanner* bplus_tree_scanner = new BplusTreeScanner(index_handler_);
@@ -29,7 +29,11 @@ class BplusTreeIndex : public Index {
     ResultCode            close();
 
     ResultCode            insert_entry(const char* record, const RID* rid) override;
+    ResultCode            insert_entries(const char* const records[], const RID rids[],
+                                         int num) override;
     ResultCode            delete_entry(const char* record, const RID* rid) override;
+    ResultCode            bulk_load_add(const char* record, const RID* rid) override;
+    ResultCode            bulk_load_finish() override;
 
     IndexScanner* create_scanner(CompOp comp_op, const char* value) override;
 
@@ -38,6 +42,7 @@ class BplusTreeIndex : public Index {
     private:
     bool             inited_ = false;
     BplusTreeHandler index_handler_;
+    BplusTreeSorter* bulk_load_sorter_ = nullptr;
 };
 
 class BplusTreeIndexScanner : public IndexScanner {
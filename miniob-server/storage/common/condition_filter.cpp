@@ -140,27 +140,7 @@ bool DefaultConditionFilter::filter(const Record& rec) const {
         right_value = (char*)right_.value;
     }
 
-    int cmp_result = 0;
-    switch (attr_type_) {
-    case CHARS: { // 字符串都是定长的，直接比较
-        // 按照C字符串风格来定
-        cmp_result = strcmp(left_value, right_value);
-    } break;
-    case INTS: {
-        // 没有考虑大小端问题
-        // 对int和float，要考虑字节对齐问题,有些平台下直接转换可能会跪
-        int left   = *(int*)left_value;
-        int right  = *(int*)right_value;
-        cmp_result = left - right;
-    } break;
-    case FLOATS: {
-        float left  = *(float*)left_value;
-        float right = *(float*)right_value;
-        cmp_result  = (int)(left - right);
-    } break;
-    default: {
-    }
-    }
+    int cmp_result = compare(attr_type_, left_value, right_value);
 
     switch (comp_op_) {
     case EQUAL_TO:
@@ -184,6 +164,32 @@ bool DefaultConditionFilter::filter(const Record& rec) const {
     return cmp_result; // should not go here
 }
 
+int DefaultConditionFilter::compare(AttrType attr_type, const char* left_value,
+                                    const char* right_value) {
+    int cmp_result = 0;
+    switch (attr_type) {
+    case CHARS: { // 字符串都是定长的，直接比较
+        // 按照C字符串风格来定
+        cmp_result = strcmp(left_value, right_value);
+    } break;
+    case INTS: {
+        // 没有考虑大小端问题
+        // 对int和float，要考虑字节对齐问题,有些平台下直接转换可能会跪
+        int left   = *(int*)left_value;
+        int right  = *(int*)right_value;
+        cmp_result = left - right;
+    } break;
+    case FLOATS: {
+        float left  = *(float*)left_value;
+        float right = *(float*)right_value;
+        cmp_result  = (int)(left - right);
+    } break;
+    default: {
+    }
+    }
+    return cmp_result;
+}
+
 CompositeConditionFilter::~CompositeConditionFilter() {
     if (memory_owner_) {
         delete[] filters_;
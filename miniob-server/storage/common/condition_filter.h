@@ -50,6 +50,12 @@ class DefaultConditionFilter : public ConditionFilter {
 
     virtual bool filter(const Record& rec) const;
 
+    /**
+     * 按attr_type比较两个值，返回值的正负表示大小关系。
+     * 过滤记录和按区间跳过页面都用它，两边的结果才能一致
+     */
+    static int     compare(AttrType attr_type, const char* left, const char* right);
+
     public:
     const ConDesc& left() const { return left_; }
 
@@ -57,6 +63,8 @@ class DefaultConditionFilter : public ConditionFilter {
 
     CompOp         comp_op() const { return comp_op_; }
 
+    AttrType       attr_type() const { return attr_type_; }
+
     private:
     ConDesc  left_;
     ConDesc  right_;
@@ -17,6 +17,7 @@ See the Mulan PSL v2 for more details. */
 #include <sys/stat.h>
 #include <vector>
 
+#include <common/lang/mutex.h>
 #include <common/lang/string.h>
 #include <common/log/log.h>
 #include <common/os/path.h>
@@ -24,10 +25,13 @@ See the Mulan PSL v2 for more details. */
 #include <storage/common/table.h>
 #include <storage/common/table_meta.h>
 
+Db::Db() { MUTEX_INIT(&tables_mutex_, NULL); }
+
 Db::~Db() {
     for (auto& iter : opened_tables_) {
         delete iter.second;
     }
+    MUTEX_DESTROY(&tables_mutex_);
     LOG_INFO("Db has been closed: %s", name_.c_str());
 }
 
@@ -52,8 +56,10 @@ ResultCode Db::init(const char* name, const char* dbpath) {
 ResultCode Db::create_table(const char* table_name, int attribute_count,
                     const AttrInfo* attributes) {
     ResultCode rc = ResultCode::SUCCESS;
+    MUTEX_LOCK(&tables_mutex_);
     // check table_name
     if (opened_tables_.count(table_name) != 0) {
+        MUTEX_UNLOCK(&tables_mutex_);
         LOG_WARN("%s has been opened before.", table_name);
         return ResultCode::SCHEMA_TABLE_EXIST;
     }
@@ -64,12 +70,14 @@ ResultCode Db::create_table(const char* table_name, int attribute_count,
     rc = table->create(table_file_path.c_str(), table_name, path_.c_str(),
                        attribute_count, attributes);
     if (rc != ResultCode::SUCCESS) {
+        MUTEX_UNLOCK(&tables_mutex_);
         LOG_ERROR("Failed to create table %s.", table_name);
         delete table;
         return rc;
     }
 
     opened_tables_[table_name] = table;
+    MUTEX_UNLOCK(&tables_mutex_);
     LOG_INFO("Create table success. table name=%s", table_name);
     return ResultCode::SUCCESS;
 }
@@ -87,12 +95,15 @@ ResultCode Db::drop_table(const char* table_name) {
 }
 
 Table* Db::find_table(const char* table_name) const {
+    Table* table = nullptr;
+    MUTEX_LOCK(&tables_mutex_);
     std::unordered_map<std::string, Table*>::const_iterator iter =
         opened_tables_.find(table_name);
     if (iter != opened_tables_.end()) {
-        return iter->second;
+        table = iter->second;
     }
-    return nullptr;
+    MUTEX_UNLOCK(&tables_mutex_);
+    return table;
 }
 
 ResultCode Db::open_all_tables() {
@@ -133,15 +144,24 @@ ResultCode Db::open_all_tables() {
 const char* Db::name() const { return name_.c_str(); }
 
 void        Db::all_tables(std::vector<std::string>& table_names) const {
+    MUTEX_LOCK(&tables_mutex_);
     for (const auto& table_item : opened_tables_) {
         table_names.emplace_back(table_item.first);
     }
+    MUTEX_UNLOCK(&tables_mutex_);
 }
 
 ResultCode Db::sync() {
-    ResultCode rc = ResultCode::SUCCESS;
+    // 表不会被删除，拿到指针以后不用持有锁，刷盘期间不影响建表
+    std::vector<Table*> tables;
+    MUTEX_LOCK(&tables_mutex_);
     for (const auto& table_pair : opened_tables_) {
-        Table* table = table_pair.second;
+        tables.push_back(table_pair.second);
+    }
+    MUTEX_UNLOCK(&tables_mutex_);
+
+    ResultCode rc = ResultCode::SUCCESS;
+    for (Table* table : tables) {
         rc           = table->sync();
         if (rc != ResultCode::SUCCESS) {
             LOG_ERROR("Failed to flush table. table=%s.%s, rc=%d:%s",
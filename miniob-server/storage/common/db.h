@@ -14,6 +14,8 @@ See the Mulan PSL v2 for more details. */
 #ifndef __OBSERVER_STORAGE_COMMON_DB_H__
 #define __OBSERVER_STORAGE_COMMON_DB_H__
 
+#include <pthread.h>
+
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -25,7 +27,7 @@ class Table;
 
 class Db {
     public:
-    Db() = default;
+    Db();
     ~Db();
 
     ResultCode          init(const char* name, const char* dbpath);
@@ -50,6 +52,8 @@ class Db {
     std::string                             name_;
     std::string                             path_;
     std::unordered_map<std::string, Table*> opened_tables_;
+    // 保护opened_tables_。后台整理线程和执行SQL的线程会同时访问
+    mutable pthread_mutex_t                 tables_mutex_;
 };
 
 #endif // __OBSERVER_STORAGE_COMMON_DB_H__
\ No newline at end of file
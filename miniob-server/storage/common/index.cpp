@@ -17,4 +17,15 @@ ResultCode Index::init(const IndexMeta& index_meta, const FieldMeta& field_meta)
     index_meta_ = index_meta;
     field_meta_ = field_meta;
     return ResultCode::SUCCESS;
+}
+
+ResultCode Index::insert_entries(const char* const records[], const RID rids[],
+                                 int num) {
+    for (int i = 0; i < num; i++) {
+        ResultCode rc = insert_entry(records[i], &rids[i]);
+        if (rc != ResultCode::SUCCESS) {
+            return rc;
+        }
+    }
+    return ResultCode::SUCCESS;
 }
\ No newline at end of file
@@ -40,8 +40,22 @@ class Index {
     const IndexMeta&      index_meta() const { return index_meta_; }
 
     virtual ResultCode            insert_entry(const char* record, const RID* rid)  = 0;
+
+    /**
+     * 批量插入num条记录的索引项。默认逐条调用insert_entry，
+     * 失败时已经插入的索引项不会被删除
+     */
+    virtual ResultCode    insert_entries(const char* const records[], const RID rids[],
+                                         int num);
     virtual ResultCode            delete_entry(const char* record, const RID* rid)  = 0;
 
+    /**
+     * 创建索引时在空的索引上批量加载：先用bulk_load_add逐条加入记录的索引项，
+     * 再调用bulk_load_finish排序并构建索引
+     */
+    virtual ResultCode    bulk_load_add(const char* record, const RID* rid) = 0;
+    virtual ResultCode    bulk_load_finish()                                 = 0;
+
     virtual IndexScanner* create_scanner(CompOp comp_op, const char* value) = 0;
 
     virtual ResultCode            sync()                                            = 0;
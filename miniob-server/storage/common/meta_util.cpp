@@ -27,3 +27,7 @@ std::string table_index_file(const char* base_dir, const char* table_name,
     return std::string(base_dir) + common::FILE_PATH_SPLIT_STR + table_name +
            "-" + index_name + TABLE_INDEX_SUFFIX;
 }
+std::string table_zone_map_file(const char* base_dir, const char* table_name) {
+    return std::string(base_dir) + common::FILE_PATH_SPLIT_STR + table_name +
+           TABLE_ZONE_MAP_SUFFIX;
+}
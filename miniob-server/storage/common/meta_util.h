@@ -19,10 +19,12 @@ static const char* TABLE_META_SUFFIX       = ".table";
 static const char* TABLE_META_FILE_PATTERN = ".*\\.table$";
 static const char* TABLE_DATA_SUFFIX       = ".data";
 static const char* TABLE_INDEX_SUFFIX      = ".index";
+static const char* TABLE_ZONE_MAP_SUFFIX   = ".zone";
 
 std::string table_meta_file(const char* base_dir, const char* table_name);
 std::string table_data_file(const char* base_dir, const char* table_name);
 std::string table_index_file(const char* base_dir, const char* table_name,
                              const char* index_name);
+std::string table_zone_map_file(const char* base_dir, const char* table_name);
 
 #endif //__OBSERVER_STORAGE_COMMON_META_UTIL_H_
@@ -16,6 +16,8 @@ See the Mulan PSL v2 for more details. */
 #include <common/log/log.h>
 #include <result_code.h>
 
+#include <algorithm>
+
 using namespace common;
 
 int align8(int size) { return size / 8 * 8 + ((size % 8 == 0) ? 0 : 8); }
@@ -49,7 +51,7 @@ RecordPageHandler::RecordPageHandler()
 RecordPageHandler::~RecordPageHandler() { cleanup(); }
 
 ResultCode RecordPageHandler::init(DiskBufferPool& buffer_pool, int file_id,
-                           PageNum page_num) {
+                           PageNum page_num, BPScanRing* ring) {
     if (disk_buffer_pool_ != nullptr) {
         LOG_WARN("Disk buffer pool has been opened for file_id:page_num %d:%d.",
                  file_id, page_num);
@@ -57,7 +59,7 @@ ResultCode RecordPageHandler::init(DiskBufferPool& buffer_pool, int file_id,
     }
 
     ResultCode ret = ResultCode::SUCCESS;
-    if ((ret = buffer_pool.get_this_page(file_id, page_num, &page_handle_)) !=
+    if ((ret = buffer_pool.get_this_page(file_id, page_num, &page_handle_, ring)) !=
         ResultCode::SUCCESS) {
         LOG_ERROR("Failed to get page handle from disk buffer pool. "
                   "file_id:%d, ret=%d:%s",
@@ -81,6 +83,30 @@ ResultCode RecordPageHandler::init(DiskBufferPool& buffer_pool, int file_id,
     return ret;
 }
 
+ResultCode RecordPageHandler::init(DiskBufferPool& buffer_pool, int file_id,
+                                   const BPPageHandle& page_handle) {
+    if (disk_buffer_pool_ != nullptr) {
+        LOG_WARN("Disk buffer pool has been opened for file_id %d.", file_id);
+        return ResultCode::RECORD_OPENNED;
+    }
+
+    page_handle_ = page_handle;
+    char*      data;
+    ResultCode ret = buffer_pool.get_data(&page_handle_, &data);
+    if (ret != ResultCode::SUCCESS) {
+        LOG_ERROR("Failed to get page data. ret=%d:%s", ret, strrc(ret));
+        buffer_pool.unpin_page(&page_handle_);
+        return ret;
+    }
+
+    disk_buffer_pool_ = &buffer_pool;
+    file_id_          = file_id;
+
+    page_header_      = (PageHeader*)(data);
+    bitmap_           = data + page_fix_size();
+    return ret;
+}
+
 ResultCode RecordPageHandler::init_empty_page(DiskBufferPool& buffer_pool, int file_id,
                                       PageNum page_num, int record_size) {
     ResultCode ret = init(buffer_pool, file_id, page_num);
@@ -91,7 +117,7 @@ ResultCode RecordPageHandler::init_empty_page(DiskBufferPool& buffer_pool, int f
         return ret;
     }
 
-    int page_size            = sizeof(page_handle_.frame->page.data);
+    int page_size            = BP_PAGE_DATA_SIZE(page_handle_.frame->page_size);
     int record_phy_size      = align8(record_size);
     page_header_->record_num = 0;
     page_header_->record_capacity =
@@ -100,7 +126,7 @@ ResultCode RecordPageHandler::init_empty_page(DiskBufferPool& buffer_pool, int f
     page_header_->record_size      = record_phy_size;
     page_header_->first_record_offset =
         page_header_size(page_header_->record_capacity);
-    bitmap_ = page_handle_.frame->page.data + page_fix_size();
+    bitmap_ = page_handle_.frame->page->data + page_fix_size();
 
     memset(bitmap_, 0, page_bitmap_size(page_header_->record_capacity));
     disk_buffer_pool_->mark_dirty(&page_handle_);
@@ -112,8 +138,10 @@ ResultCode RecordPageHandler::cleanup() {
     if (disk_buffer_pool_ != nullptr) {
         disk_buffer_pool_->unpin_page(&page_handle_);
         disk_buffer_pool_ = nullptr;
-        // skip purge page,
-        //  skip reset page_header & bitmap
+        // skip purge page
+        // 页面已经unpin，可能随时被淘汰，不能再通过page_header_访问
+        page_header_ = nullptr;
+        bitmap_      = nullptr;
     }
 
     return ResultCode::SUCCESS;
@@ -123,7 +151,7 @@ ResultCode RecordPageHandler::insert_record(const char* data, RID* rid) {
 
     if (page_header_->record_num == page_header_->record_capacity) {
         LOG_WARN("Page is full, file_id:page_num %d:%d.", file_id_,
-                 page_handle_.frame->page.page_num);
+                 page_handle_.frame->page->page_num);
         return ResultCode::RECORD_NOMEM;
     }
 
@@ -149,12 +177,37 @@ ResultCode RecordPageHandler::insert_record(const char* data, RID* rid) {
     return ResultCode::SUCCESS;
 }
 
+ResultCode RecordPageHandler::insert_records(const char* data, int record_num,
+                                             RID* rids, int* inserted_num) {
+    Bitmap           bitmap(bitmap_, page_header_->record_capacity);
+    const PageNum    page_num = get_page_num();
+    std::vector<int> slots(std::min(
+        record_num, page_header_->record_capacity - page_header_->record_num));
+    // 一次找出需要的所有空闲slot
+    const int num = bitmap.next_unsetted_bits(0, (int)slots.size(), slots.data());
+    for (int i = 0; i < num; i++) {
+        bitmap.set_bit(slots[i]);
+        memcpy(get_record_data(slots[i]),
+               data + (size_t)i * page_header_->record_real_size,
+               page_header_->record_real_size);
+        rids[i].page_num = page_num;
+        rids[i].slot_num = slots[i];
+    }
+    page_header_->record_num += num;
+
+    if (num > 0) {
+        disk_buffer_pool_->mark_dirty(&page_handle_);
+    }
+    *inserted_num = num;
+    return ResultCode::SUCCESS;
+}
+
 ResultCode RecordPageHandler::update_record(const Record* rec) {
     if (rec->rid.slot_num >= page_header_->record_capacity) {
         LOG_ERROR("Invalid slot_num %d, exceed page's record capacity, "
                   "file_id:page_num %d:%d.",
                   rec->rid.slot_num, file_id_,
-                  page_handle_.frame->page.page_num);
+                  page_handle_.frame->page->page_num);
         return ResultCode::INVALID_ARGUMENT;
     }
 
@@ -162,7 +215,7 @@ ResultCode RecordPageHandler::update_record(const Record* rec) {
     if (!bitmap.get_bit(rec->rid.slot_num)) {
         LOG_ERROR("Invalid slot_num %d, slot is empty, file_id:page_num %d:%d.",
                   rec->rid.slot_num, file_id_,
-                  page_handle_.frame->page.page_num);
+                  page_handle_.frame->page->page_num);
         return ResultCode::RECORD_RECORD_NOT_EXIST;
     } else {
         char* record_data = get_record_data(rec->rid.slot_num);
@@ -179,7 +232,7 @@ ResultCode RecordPageHandler::delete_record(const RID* rid) {
     if (rid->slot_num >= page_header_->record_capacity) {
         LOG_ERROR("Invalid slot_num %d, exceed page's record capacity, "
                   "file_id:page_num %d:%d.",
-                  rid->slot_num, file_id_, page_handle_.frame->page.page_num);
+                  rid->slot_num, file_id_, page_handle_.frame->page->page_num);
         return ResultCode::INVALID_ARGUMENT;
     }
 
@@ -199,7 +252,7 @@ ResultCode RecordPageHandler::delete_record(const RID* rid) {
         return ResultCode::SUCCESS;
     } else {
         LOG_ERROR("Invalid slot_num %d, slot is empty, file_id:page_num %d:%d.",
-                  rid->slot_num, file_id_, page_handle_.frame->page.page_num);
+                  rid->slot_num, file_id_, page_handle_.frame->page->page_num);
         return ResultCode::RECORD_RECORD_NOT_EXIST;
     }
 }
@@ -208,14 +261,14 @@ ResultCode RecordPageHandler::get_record(const RID* rid, Record* rec) {
     if (rid->slot_num >= page_header_->record_capacity) {
         LOG_ERROR("Invalid slot_num:%d, exceed page's record capacity, "
                   "file_id:page_num %d:%d.",
-                  rid->slot_num, file_id_, page_handle_.frame->page.page_num);
+                  rid->slot_num, file_id_, page_handle_.frame->page->page_num);
         return ResultCode::RECORD_INVALIDRID;
     }
 
     Bitmap bitmap(bitmap_, page_header_->record_capacity);
     if (!bitmap.get_bit(rid->slot_num)) {
         LOG_ERROR("Invalid slot_num:%d, slot is empty, file_id:page_num %d:%d.",
-                  rid->slot_num, file_id_, page_handle_.frame->page.page_num);
+                  rid->slot_num, file_id_, page_handle_.frame->page->page_num);
         return ResultCode::RECORD_RECORD_NOT_EXIST;
     }
 
@@ -234,7 +287,7 @@ ResultCode RecordPageHandler::get_next_record(Record* rec) {
         LOG_ERROR("Invalid slot_num:%d, exceed page's record capacity, "
                   "file_id:page_num %d:%d.",
                   rec->rid.slot_num, file_id_,
-                  page_handle_.frame->page.page_num);
+                  page_handle_.frame->page->page_num);
         return ResultCode::RECORD_EOF;
     }
 
@@ -243,7 +296,7 @@ ResultCode RecordPageHandler::get_next_record(Record* rec) {
 
     if (index < 0) {
         LOG_WARN("There is no empty slot on page -- file_id:%d, page_num:%d.",
-                 file_id_, page_handle_.frame->page.page_num);
+                 file_id_, page_handle_.frame->page->page_num);
         return ResultCode::RECORD_EOF;
     }
 
@@ -253,17 +306,43 @@ ResultCode RecordPageHandler::get_next_record(Record* rec) {
     return ResultCode::SUCCESS;
 }
 
+void RecordPageHandler::get_batch(RecordBatch* batch,
+                                  std::vector<char>& bitmap) {
+    const int capacity = page_header_->record_capacity;
+    bitmap.resize((capacity + 7) / 8);
+    memcpy(bitmap.data(), bitmap_, bitmap.size());
+
+    batch->page_num    = get_page_num();
+    batch->slot_num    = capacity;
+    batch->record_size = page_header_->record_size;
+    batch->records =
+        page_handle_.frame->page->data + page_header_->first_record_offset;
+    batch->bitmap = bitmap.data();
+}
+
 PageNum RecordPageHandler::get_page_num() const {
     if (nullptr == page_header_) {
         return (PageNum)(-1);
     }
-    return page_handle_.frame->page.page_num;
+    return page_handle_.frame->page->page_num;
 }
 
 bool RecordPageHandler::is_full() const {
     return page_header_->record_num >= page_header_->record_capacity;
 }
 
+bool RecordPageHandler::is_free_space_map() const {
+    return get_page_num() == RECORD_FSM_PAGE_NUM &&
+           page_header_->record_capacity == 0 &&
+           ((const FsmPageHeader*)page_header_)->magic == RECORD_FSM_MAGIC;
+}
+
+int RecordPageHandler::get_record_num() const { return page_header_->record_num; }
+
+int RecordPageHandler::get_record_capacity() const {
+    return page_header_->record_capacity;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 
 RecordFileHandler::RecordFileHandler()
@@ -279,20 +358,160 @@ ResultCode RecordFileHandler::init(DiskBufferPool* buffer_pool, int file_id) {
     disk_buffer_pool_ = buffer_pool;
     file_id_          = file_id;
 
+    ResultCode ret = init_free_space_map();
+    if (ret != ResultCode::SUCCESS) {
+        LOG_ERROR("Failed to init free space map of %d, ret=%d:%s", file_id,
+                  ret, strrc(ret));
+        disk_buffer_pool_ = nullptr;
+        file_id_          = -1;
+        return ret;
+    }
+
     LOG_INFO("Successfully open %d.", file_id);
     return ResultCode::SUCCESS;
 }
 
 void RecordFileHandler::close() {
     if (disk_buffer_pool_ != nullptr) {
+        record_page_handler_.cleanup();
+        if (fsm_header_ != nullptr) {
+            disk_buffer_pool_->unpin_page(&fsm_handle_);
+            fsm_header_ = nullptr;
+            fsm_bitmap_ = nullptr;
+        }
         disk_buffer_pool_ = nullptr;
     }
 }
 
-ResultCode RecordFileHandler::insert_record(const char* data, int record_size,
-                                    RID* rid) {
+ResultCode RecordFileHandler::init_free_space_map() {
+    ResultCode ret        = ResultCode::SUCCESS;
+    int        page_count = 0;
+    int        page_size  = 0;
+    if ((ret = disk_buffer_pool_->get_page_count(file_id_, &page_count)) !=
+            ResultCode::SUCCESS ||
+        (ret = disk_buffer_pool_->get_page_size(file_id_, &page_size)) !=
+            ResultCode::SUCCESS) {
+        return ret;
+    }
+
+    char* data = nullptr;
+    if (page_count > RECORD_FSM_PAGE_NUM) {
+        ret = disk_buffer_pool_->get_this_page(file_id_, RECORD_FSM_PAGE_NUM,
+                                               &fsm_handle_);
+        if (ret != ResultCode::SUCCESS &&
+            ret != ResultCode::BUFFERPOOL_INVALID_PAGE_NUM) {
+            return ret;
+        }
+        if (ret == ResultCode::SUCCESS) {
+            disk_buffer_pool_->get_data(&fsm_handle_, &data);
+            if (((FsmPageHeader*)data)->magic != RECORD_FSM_MAGIC) {
+                LOG_INFO("File %d has no free space map, page 1 holds records.",
+                         file_id_);
+                disk_buffer_pool_->unpin_page(&fsm_handle_);
+                return ResultCode::SUCCESS;
+            }
+        }
+    }
+
+    bool fresh_map = data == nullptr;
+    if (fresh_map) {
+        // 第1页还没有分配或者已经被释放了，分配页面时总是先用页号最小的空闲页面
+        if ((ret = disk_buffer_pool_->allocate_page(file_id_, &fsm_handle_)) !=
+            ResultCode::SUCCESS) {
+            return ret;
+        }
+        disk_buffer_pool_->get_data(&fsm_handle_, &data);
+        memset(data, 0, BP_PAGE_DATA_SIZE(page_size));
+        FsmPageHeader* header = (FsmPageHeader*)data;
+        header->page_header.first_record_offset = sizeof(FsmPageHeader);
+        header->magic         = RECORD_FSM_MAGIC;
+        header->page_capacity =
+            (BP_PAGE_DATA_SIZE(page_size) - (int)sizeof(FsmPageHeader)) * 8;
+        disk_buffer_pool_->mark_dirty(&fsm_handle_);
+    }
+
+    if (fsm_handle_.frame->page->page_num != RECORD_FSM_PAGE_NUM) {
+        LOG_ERROR("Free space map of %d is on page %d.", file_id_,
+                  fsm_handle_.frame->page->page_num);
+        disk_buffer_pool_->unpin_page(&fsm_handle_);
+        return ResultCode::RECORD_INVALIDRID;
+    }
+    fsm_header_ = (FsmPageHeader*)data;
+    fsm_bitmap_ = data + sizeof(FsmPageHeader);
+    fsm_hint_   = 0;
+    if (fresh_map && page_count > RECORD_FSM_PAGE_NUM + 1) {
+        // 旧文件上新建的空闲空间表是空的，不填上的话已有页面的空闲slot就再也用不到了
+        ret = fill_free_space_map(page_count);
+        if (ret != ResultCode::SUCCESS) {
+            disk_buffer_pool_->unpin_page(&fsm_handle_);
+            fsm_header_ = nullptr;
+            fsm_bitmap_ = nullptr;
+            return ret;
+        }
+    }
+    return ResultCode::SUCCESS;
+}
+
+ResultCode RecordFileHandler::fill_free_space_map(int page_count) {
+    int free_pages = 0;
+    for (PageNum page_num = RECORD_FSM_PAGE_NUM + 1; page_num < page_count;
+         page_num++) {
+        RecordPageHandler page_handler;
+        ResultCode ret = page_handler.init(*disk_buffer_pool_, file_id_, page_num);
+        if (ret == ResultCode::BUFFERPOOL_INVALID_PAGE_NUM) {
+            continue;
+        }
+        if (ret != ResultCode::SUCCESS) {
+            LOG_ERROR("Failed to init record page handler. page number is "
+                      "%d. ret=%d:%s",
+                      page_num, ret, strrc(ret));
+            return ret;
+        }
+        if (!page_handler.is_full()) {
+            update_free_space(page_num, true);
+            free_pages++;
+        }
+    }
+    LOG_INFO("Fill free space map of %d, %d pages have free slots.", file_id_,
+             free_pages);
+    return ResultCode::SUCCESS;
+}
+
+ResultCode RecordFileHandler::find_free_page(bool* page_found) {
+    Bitmap bitmap(fsm_bitmap_, fsm_header_->page_capacity);
+    while (true) {
+        int page_num = bitmap.next_setted_bit(fsm_hint_);
+        if (page_num < 0 && fsm_hint_ > 0) {
+            page_num = bitmap.next_setted_bit(0);
+        }
+        if (page_num < 0) {
+            *page_found = false;
+            return ResultCode::SUCCESS;
+        }
+        fsm_hint_ = page_num;
+
+        record_page_handler_.cleanup();
+        ResultCode ret = record_page_handler_.init(*disk_buffer_pool_, file_id_,
+                                                   page_num);
+        if (ret != ResultCode::SUCCESS &&
+            ret != ResultCode::BUFFERPOOL_INVALID_PAGE_NUM) {
+            LOG_ERROR("Failed to init record page handler. page number is "
+                      "%d. ret=%d:%s",
+                      page_num, ret, strrc(ret));
+            return ret;
+        }
+        if (ret == ResultCode::SUCCESS && !record_page_handler_.is_full()) {
+            *page_found = true;
+            return ResultCode::SUCCESS;
+        }
+
+        // 空闲空间表过时了，页面已经满了或者已经被释放
+        update_free_space(page_num, false);
+    }
+}
+
+ResultCode RecordFileHandler::scan_free_page(bool* page_found) {
     ResultCode ret = ResultCode::SUCCESS;
-    // 找到没有填满的页面
     int page_count = 0;
     if ((ret = disk_buffer_pool_->get_page_count(file_id_, &page_count)) !=
         ResultCode::SUCCESS) {
@@ -301,28 +520,13 @@ ResultCode RecordFileHandler::insert_record(const char* data, int record_size,
         return ret;
     }
 
-    PageNum current_page_num = record_page_handler_.get_page_num();
-    if (current_page_num < 0) {
-        if (page_count >= 2) {
-            // 当前buffer pool 有页面时才尝试加载第一页
-            // 参考diskBufferPool，有效page的pageNum从1开始
-            if ((ret = record_page_handler_.init(*disk_buffer_pool_, file_id_,
-                                                 1)) != ResultCode::SUCCESS) {
-                LOG_ERROR(
-                    "Failed to init record page handler, file_id:%d, ret=%d",
-                    file_id_, ret);
-                return ret;
-            }
-            current_page_num = record_page_handler_.get_page_num();
-        } else {
-            current_page_num = 0;
-        }
-    }
+    // 从当前打开的页面开始查找
+    const PageNum start_page_num =
+        std::max(record_page_handler_.get_page_num(), 0);
 
-    bool page_found = false;
+    *page_found = false;
     for (int i = 0; i < page_count; i++) {
-        current_page_num =
-            (current_page_num + i) % page_count; // 从当前打开的页面开始查找
+        PageNum current_page_num = (start_page_num + i) % page_count;
         if (current_page_num == 0) {
             continue;
         }
@@ -336,13 +540,48 @@ ResultCode RecordFileHandler::insert_record(const char* data, int record_size,
                           current_page_num, ret, strrc(ret));
                 return ret;
             }
+            if (ret == ResultCode::BUFFERPOOL_INVALID_PAGE_NUM) {
+                continue;
+            }
         }
 
         if (!record_page_handler_.is_full()) {
-            page_found = true;
+            *page_found = true;
             break;
         }
     }
+    return ResultCode::SUCCESS;
+}
+
+void RecordFileHandler::update_free_space(PageNum page_num, bool has_free) {
+    if (fsm_header_ == nullptr || page_num >= fsm_header_->page_capacity) {
+        return;
+    }
+
+    Bitmap bitmap(fsm_bitmap_, fsm_header_->page_capacity);
+    if (bitmap.get_bit(page_num) == has_free) {
+        return;
+    }
+    if (has_free) {
+        bitmap.set_bit(page_num);
+    } else {
+        bitmap.clear_bit(page_num);
+    }
+    disk_buffer_pool_->mark_dirty(&fsm_handle_);
+}
+
+ResultCode RecordFileHandler::open_free_page(int record_size) {
+    ResultCode ret = ResultCode::SUCCESS;
+    // 优先使用当前打开的页面，满了再找别的没有填满的页面
+    bool page_found = record_page_handler_.get_page_num() >= 0 &&
+                      !record_page_handler_.is_full();
+    if (!page_found) {
+        ret = fsm_header_ != nullptr ? find_free_page(&page_found)
+                                     : scan_free_page(&page_found);
+        if (ret != ResultCode::SUCCESS) {
+            return ret;
+        }
+    }
 
     // 找不到就分配一个新的页面
     if (!page_found) {
@@ -355,7 +594,7 @@ ResultCode RecordFileHandler::insert_record(const char* data, int record_size,
             return ret;
         }
 
-        current_page_num = page_handle.frame->page.page_num;
+        PageNum current_page_num = page_handle.frame->page->page_num;
         record_page_handler_.cleanup();
         ret = record_page_handler_.init_empty_page(
             *disk_buffer_pool_, file_id_, current_page_num, record_size);
@@ -368,14 +607,62 @@ ResultCode RecordFileHandler::insert_record(const char* data, int record_size,
             return ret;
         }
 
-        //@@@ TODO, remove unpin page here
-        //    if (ResultCode::SUCCESS != disk_buffer_pool_->unpin_page(&page_handle)) {
-        //      LOG_ERROR("Failed to unpin page. file_id:%d", file_id_);
-        //    }
+        // record_page_handler_已经pin住了这个页面，分配时的pin要释放掉，
+        // 否则这个页面永远不能被淘汰
+        if (ResultCode::SUCCESS != disk_buffer_pool_->unpin_page(&page_handle)) {
+            LOG_ERROR("Failed to unpin page. file_id:%d", file_id_);
+        }
+        update_free_space(current_page_num, true);
+    }
+    return ResultCode::SUCCESS;
+}
+
+ResultCode RecordFileHandler::insert_record(const char* data, int record_size,
+                                    RID* rid) {
+    ResultCode ret = open_free_page(record_size);
+    if (ret != ResultCode::SUCCESS) {
+        return ret;
     }
 
     // 找到空闲位置
-    return record_page_handler_.insert_record(data, rid);
+    ret = record_page_handler_.insert_record(data, rid);
+    if (ret == ResultCode::SUCCESS && record_page_handler_.is_full()) {
+        update_free_space(record_page_handler_.get_page_num(), false);
+    }
+    return ret;
+}
+
+ResultCode RecordFileHandler::insert_records(const char* data, int record_num,
+                                             int record_size, RID* rids) {
+    ResultCode ret          = ResultCode::SUCCESS;
+    int        inserted_num = 0;
+    while (inserted_num < record_num) {
+        if ((ret = open_free_page(record_size)) != ResultCode::SUCCESS) {
+            break;
+        }
+
+        int page_inserted_num = 0;
+        ret = record_page_handler_.insert_records(
+            data + (size_t)inserted_num * record_size, record_num - inserted_num,
+            rids + inserted_num, &page_inserted_num);
+        if (ret != ResultCode::SUCCESS) {
+            break;
+        }
+        if (record_page_handler_.is_full()) {
+            update_free_space(record_page_handler_.get_page_num(), false);
+        }
+        inserted_num += page_inserted_num;
+    }
+
+    if (ret != ResultCode::SUCCESS) {
+        LOG_ERROR("Failed to insert records, file_id:%d, %d of %d inserted, "
+                  "ret=%d:%s",
+                  file_id_, inserted_num, record_num, ret, strrc(ret));
+        for (int i = 0; i < inserted_num; i++) {
+            delete_record(&rids[i]);
+        }
+    }
+    return ret;
 }
 
 ResultCode RecordFileHandler::update_record(const Record* rec) {
@@ -397,20 +684,26 @@ ResultCode RecordFileHandler::update_record(const Record* rec) {
 }
 
 ResultCode RecordFileHandler::delete_record(const RID* rid) {
-    if (record_page_handler_.get_page_num() == rid->page_num) {
-        return record_page_handler_.delete_record(rid);
+    ResultCode         ret = ResultCode::SUCCESS;
+    RecordPageHandler  page_handler;
+    RecordPageHandler* handler = &record_page_handler_;
+    if (record_page_handler_.get_page_num() != rid->page_num) {
+        if ((ret = page_handler.init(*disk_buffer_pool_, file_id_,
+                                     rid->page_num)) != ResultCode::SUCCESS) {
+            LOG_ERROR(
+                "Failed to init record page handler.page number=%d, file_id:%d",
+                rid->page_num, file_id_);
+            return ret;
+        }
+        handler = &page_handler;
     }
 
-    ResultCode                ret = ResultCode::SUCCESS;
-    RecordPageHandler page_handler;
-    if ((ret != page_handler.init(*disk_buffer_pool_, file_id_,
-                                  rid->page_num)) != ResultCode::SUCCESS) {
-        LOG_ERROR(
-            "Failed to init record page handler.page number=%d, file_id:%d",
-            rid->page_num, file_id_);
-        return ret;
+    ret = handler->delete_record(rid);
+    if (ret == ResultCode::SUCCESS) {
+        // 删掉最后一条记录后页面会被释放，handler也随之关闭
+        update_free_space(rid->page_num, handler->get_page_num() == rid->page_num);
     }
-    return page_handler.delete_record(rid);
+    return ret;
 }
 
 ResultCode RecordFileHandler::get_record(const RID* rid, Record* rec) {
@@ -426,8 +719,8 @@ ResultCode RecordFileHandler::get_record(const RID* rid, Record* rec) {
     }
 
     RecordPageHandler page_handler;
-    if ((ret != page_handler.init(*disk_buffer_pool_, file_id_,
-                                  rid->page_num)) != ResultCode::SUCCESS) {
+    if ((ret = page_handler.init(*disk_buffer_pool_, file_id_,
+                                 rid->page_num)) != ResultCode::SUCCESS) {
         LOG_ERROR(
             "Failed to init record page handler.page number=%d, file_id:%d",
             rid->page_num, file_id_);
@@ -437,31 +730,183 @@ ResultCode RecordFileHandler::get_record(const RID* rid, Record* rec) {
     return page_handler.get_record(rid, rec);
 }
 
+ResultCode RecordFileHandler::compact(
+    int max_pages,
+    ResultCode (*record_mover)(const Record* old_record, const RID& new_rid,
+                               void* context),
+    void* context, int* moved_pages) {
+    *moved_pages = 0;
+    // 当前插入的页面可能会被搬空释放
+    record_page_handler_.cleanup();
+
+    int        page_count = 0;
+    ResultCode ret = disk_buffer_pool_->get_page_count(file_id_, &page_count);
+    if (ret != ResultCode::SUCCESS) {
+        LOG_ERROR("Failed to get page count while compacting. file_id:%d", file_id_);
+        return ret;
+    }
+
+    // 先统计每个页面的记录数和空闲slot数，-1表示不是记录页面
+    std::vector<int> record_nums(page_count, -1);
+    std::vector<int> free_slots(page_count, 0);
+    long             free_before = 0; // 当前页面之前所有页面的空闲slot数
+    BPScanRing*      scan_ring   = disk_buffer_pool_->create_scan_ring(file_id_);
+    for (PageNum page_num = 1; page_num < page_count; page_num++) {
+        if (has_free_space_map() && page_num == RECORD_FSM_PAGE_NUM) {
+            continue;
+        }
+        RecordPageHandler page_handler;
+        ret = page_handler.init(*disk_buffer_pool_, file_id_, page_num, scan_ring);
+        if (ret == ResultCode::BUFFERPOOL_INVALID_PAGE_NUM) {
+            continue;
+        }
+        if (ret != ResultCode::SUCCESS) {
+            LOG_ERROR("Failed to init record page handler. page num=%d", page_num);
+            delete scan_ring;
+            return ret;
+        }
+        record_nums[page_num] = page_handler.get_record_num();
+        free_slots[page_num] =
+            page_handler.get_record_capacity() - page_handler.get_record_num();
+        free_before += free_slots[page_num];
+    }
+    delete scan_ring;
+
+    RecordPageHandler dest_handler;
+    PageNum           dest_page_num = 1;
+    std::vector<char> bitmap_data;
+    for (PageNum src_page_num = page_count - 1;
+         src_page_num > dest_page_num && (max_pages <= 0 || *moved_pages < max_pages);
+         src_page_num--) {
+        if (record_nums[src_page_num] < 0) {
+            continue;
+        }
+        free_before -= free_slots[src_page_num];
+        if (record_nums[src_page_num] > free_before) {
+            break;
+        }
+
+        RecordPageHandler src_handler;
+        ret = src_handler.init(*disk_buffer_pool_, file_id_, src_page_num);
+        if (ret != ResultCode::SUCCESS) {
+            LOG_ERROR("Failed to init record page handler. page num=%d",
+                      src_page_num);
+            break;
+        }
+
+        RecordBatch batch;
+        src_handler.get_batch(&batch, bitmap_data);
+        Bitmap bitmap(batch.bitmap, batch.slot_num);
+        for (int slot = bitmap.next_setted_bit(0); slot >= 0 && ret == ResultCode::SUCCESS;
+             slot = bitmap.next_setted_bit(slot + 1)) {
+            while (record_nums[dest_page_num] < 0 || free_slots[dest_page_num] == 0) {
+                dest_page_num++;
+            }
+            if (dest_handler.get_page_num() != dest_page_num) {
+                dest_handler.cleanup();
+                ret = dest_handler.init(*disk_buffer_pool_, file_id_, dest_page_num);
+                if (ret != ResultCode::SUCCESS) {
+                    LOG_ERROR("Failed to init record page handler. page num=%d",
+                              dest_page_num);
+                    break;
+                }
+            }
+
+            Record old_record;
+            RID    new_rid;
+            old_record.rid.page_num = src_page_num;
+            old_record.rid.slot_num = slot;
+            old_record.data         = batch.record(slot);
+            ret = dest_handler.insert_record(old_record.data, &new_rid);
+            if (ret != ResultCode::SUCCESS) {
+                LOG_ERROR("Failed to move record %d.%d. ret=%d:%s", src_page_num,
+                          slot, ret, strrc(ret));
+                break;
+            }
+
+            ret = record_mover(&old_record, new_rid, context);
+            if (ret != ResultCode::SUCCESS) {
+                LOG_WARN("Record mover failed, stop compacting. rid=%d.%d, "
+                         "ret=%d:%s",
+                         src_page_num, slot, ret, strrc(ret));
+                dest_handler.delete_record(&new_rid);
+                break;
+            }
+
+            free_slots[dest_page_num]--;
+            free_before--;
+            if (free_slots[dest_page_num] == 0) {
+                update_free_space(dest_page_num, false);
+            }
+            // 删掉最后一条记录后页面被释放
+            src_handler.delete_record(&old_record.rid);
+        }
+        if (ret != ResultCode::SUCCESS) {
+            break;
+        }
+        if (src_handler.get_page_num() == src_page_num) {
+            // 本来就没有记录的页面
+            src_handler.cleanup();
+            disk_buffer_pool_->dispose_page(file_id_, src_page_num);
+        }
+
+        record_nums[src_page_num] = -1;
+        update_free_space(src_page_num, false);
+        (*moved_pages)++;
+    }
+    dest_handler.cleanup();
+
+    if (*moved_pages > 0) {
+        LOG_INFO("Compact file %d, %d pages are freed", file_id_, *moved_pages);
+        disk_buffer_pool_->truncate_file(file_id_, nullptr);
+    }
+    return ret;
+}
+
+int RecordFileHandler::free_page_count() const {
+    if (fsm_header_ == nullptr) {
+        return -1;
+    }
+    Bitmap bitmap(fsm_bitmap_, fsm_header_->page_capacity);
+    return bitmap.count_setted_bits();
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 
 RecordFileScanner::RecordFileScanner()
     : disk_buffer_pool_(nullptr), file_id_(-1), condition_filter_(nullptr) {}
 
 ResultCode RecordFileScanner::open_scan(DiskBufferPool& buffer_pool, int file_id,
-                                ConditionFilter* condition_filter) {
+                                ConditionFilter* condition_filter,
+                                const PageFilter* page_filter) {
     close_scan();
 
     disk_buffer_pool_ = &buffer_pool;
     file_id_          = file_id;
 
     condition_filter_ = condition_filter;
+    page_filter_      = page_filter;
+    last_page_num_    = -1;
+    readahead_next_   = -1;
+    batch_page_num_   = 1;
+    batch_end_page_   = -1;
+    scan_ring_        = buffer_pool.create_scan_ring(file_id);
     return ResultCode::SUCCESS;
 }
 
 ResultCode RecordFileScanner::close_scan() {
     if (disk_buffer_pool_ != nullptr) {
+        record_page_handler_.cleanup();
         disk_buffer_pool_ = nullptr;
     }
 
     if (condition_filter_ != nullptr) {
         condition_filter_ = nullptr;
     }
+    page_filter_ = nullptr;
 
+    delete scan_ring_;
+    scan_ring_ = nullptr;
     return ResultCode::SUCCESS;
 }
 
@@ -498,16 +943,26 @@ ResultCode RecordFileScanner::get_next_record(Record* rec) {
 
         if (current_record.rid.page_num !=
             record_page_handler_.get_page_num()) {
+            if (page_filter_ != nullptr &&
+                !page_filter_->may_match(current_record.rid.page_num)) {
+                ret = ResultCode::RECORD_EOF;
+                current_record.rid.page_num++;
+                current_record.rid.slot_num = -1;
+                continue;
+            }
+            readahead(current_record.rid.page_num);
             record_page_handler_.cleanup();
             ret = record_page_handler_.init(*disk_buffer_pool_, file_id_,
-                                            current_record.rid.page_num);
+                                            current_record.rid.page_num,
+                                            scan_ring_);
             if (ret != ResultCode::SUCCESS && ret != ResultCode::BUFFERPOOL_INVALID_PAGE_NUM) {
                 LOG_ERROR("Failed to init record page handler. page num=%d",
                           current_record.rid.page_num);
                 return ret;
             }
 
-            if (ResultCode::BUFFERPOOL_INVALID_PAGE_NUM == ret) {
+            if (ResultCode::BUFFERPOOL_INVALID_PAGE_NUM == ret ||
+                record_page_handler_.is_free_space_map()) {
                 current_record.rid.page_num++;
                 current_record.rid.slot_num = -1;
                 continue;
@@ -533,3 +988,102 @@ ResultCode RecordFileScanner::get_next_record(Record* rec) {
     }
     return ret;
 }
+
+ResultCode RecordFileScanner::get_next_batch(RecordBatch* batch) {
+    if (nullptr == disk_buffer_pool_) {
+        LOG_ERROR("Scanner has been closed.");
+        return ResultCode::RECORD_CLOSED;
+    }
+
+    int        page_count = 0;
+    ResultCode ret = disk_buffer_pool_->get_page_count(file_id_, &page_count);
+    if (ret != ResultCode::SUCCESS) {
+        LOG_ERROR("Failed to get page count while getting next batch. file id=%d",
+                  file_id_);
+        return ResultCode::RECORD_EOF;
+    }
+
+    if (batch_end_page_ >= 0 && batch_end_page_ < page_count) {
+        page_count = batch_end_page_;
+    }
+    for (; batch_page_num_ < page_count; batch_page_num_++) {
+        if (page_filter_ != nullptr && !page_filter_->may_match(batch_page_num_)) {
+            continue;
+        }
+        readahead(batch_page_num_);
+        record_page_handler_.cleanup();
+        ret = record_page_handler_.init(*disk_buffer_pool_, file_id_,
+                                        batch_page_num_, scan_ring_);
+        if (ResultCode::BUFFERPOOL_INVALID_PAGE_NUM == ret) {
+            continue;
+        }
+        if (ret != ResultCode::SUCCESS) {
+            LOG_ERROR("Failed to init record page handler. page num=%d",
+                      batch_page_num_);
+            return ret;
+        }
+        if (record_page_handler_.is_free_space_map()) {
+            continue;
+        }
+
+        record_page_handler_.get_batch(batch, batch_bitmap_);
+        Bitmap bitmap(batch->bitmap, batch->slot_num);
+        if (condition_filter_ != nullptr) {
+            bitmap.for_each_setted_bit([&](int slot) {
+                Record record;
+                record.rid.page_num = batch_page_num_;
+                record.rid.slot_num = slot;
+                record.data         = batch->record(slot);
+                if (!condition_filter_->filter(record)) {
+                    bitmap.clear_bit(slot);
+                }
+            });
+        }
+
+        if (bitmap.next_setted_bit(0) >= 0) {
+            batch_page_num_++;
+            return ResultCode::SUCCESS;
+        }
+    }
+    return ResultCode::RECORD_EOF;
+}
+
+void RecordFileScanner::set_batch_range(PageNum start_page, PageNum end_page) {
+    batch_page_num_ = start_page;
+    batch_end_page_ = end_page;
+}
+
+void RecordFileScanner::readahead(PageNum page_num) {
+    const int readahead_pages = DiskBufferPool::get_readahead_pages();
+    // 有页面过滤时大部分页面可能会被跳过，不按顺序预读
+    if (readahead_pages <= 0 || page_filter_ != nullptr) {
+        return;
+    }
+
+    // 往回走说明重新开始了一次扫描
+    if (page_num <= last_page_num_) {
+        readahead_next_ = -1;
+    }
+    last_page_num_ = page_num;
+
+    if (page_num + readahead_pages / 2 < readahead_next_) {
+        return;
+    }
+
+    PageNum start = std::max(page_num, readahead_next_);
+    int     count = readahead_pages;
+    // 并行扫描时每个扫描器只负责一段页面，不要预读到别人的范围里
+    if (batch_end_page_ >= 0) {
+        count = std::min(count, batch_end_page_ - start);
+        if (count <= 0) {
+            return;
+        }
+    }
+    ResultCode rc = disk_buffer_pool_->prefetch_pages(file_id_, start,
+                                                      count, scan_ring_);
+    if (rc != ResultCode::SUCCESS) {
+        LOG_WARN("Failed to prefetch pages. file id=%d, start=%d, rc=%d:%s",
+                 file_id_, start, rc, strrc(rc));
+    }
+    readahead_next_ = start + count;
+}
@@ -15,6 +15,7 @@ See the Mulan PSL v2 for more details. */
 
 #include <storage/default/disk_buffer_pool.h>
 #include <sstream>
+#include <vector>
 
 typedef int SlotNum;
 
@@ -28,6 +29,26 @@ struct PageHeader {
     int first_record_offset; // 第一条记录的偏移量
 };
 
+// 记录文件的第1页是空闲空间表(free space map)
+#define RECORD_FSM_PAGE_NUM 1
+#define RECORD_FSM_MAGIC 0x4d534652
+
+// get_records一次向缓冲池批量获取的页面数
+#define RECORD_GET_BATCH_PAGES 16
+
+/**
+ * 空闲空间表页面的页头。
+ * 开头是一个容量为0的PageHeader，扫描记录时会当作没有记录的页面跳过。
+ * 页头之后是位图，第i位为1表示第i页还有空闲的slot。
+ * 空闲空间表只是插入时的提示，和数据页面不一致时以数据页面为准：
+ * 选中的页面已满或者已经释放时清掉对应的位，继续找下一个
+ */
+struct FsmPageHeader {
+    PageHeader page_header;
+    int        magic;         // RECORD_FSM_MAGIC，没有这个标记的是旧格式的文件
+    int        page_capacity; // 位图能表示的页面数
+};
+
 struct RID {
     PageNum page_num; // record's page number
     SlotNum slot_num; // record's slot number
@@ -68,16 +89,60 @@ struct Record {
     char* data; // record's data
 };
 
+/**
+ * 批量扫描时一次返回的一个页面上的记录。
+ * 记录数据直接指向缓冲池中pin住的页面，不做拷贝，
+ * 在扫描器取下一批或者关闭之前有效。
+ * bitmap是扫描器自己的一份拷贝，已经去掉了不满足扫描条件的记录，
+ * 使用者可以继续清掉不需要的位
+ */
+struct RecordBatch {
+    PageNum page_num    = -1;
+    int     slot_num    = 0;       // 页面的slot个数，也是bitmap的位数
+    int     record_size = 0;       // 每个slot占用的空间，相邻两条记录的间隔
+    char*   records     = nullptr; // 第0个slot的记录
+    char*   bitmap      = nullptr; // 第i位为1表示第i个slot的记录在这一批中
+
+    char*   record(SlotNum slot) const {
+        return records + (size_t)slot * record_size;
+    }
+};
+
+/**
+ * 扫描时按页面过滤。may_match返回false的页面上不会有满足条件的记录，
+ * 扫描器直接跳过，不读这个页面
+ */
+class PageFilter {
+    public:
+    virtual ~PageFilter() = default;
+
+    virtual bool may_match(PageNum page_num) const = 0;
+};
+
 class RecordPageHandler {
     public:
     RecordPageHandler();
     ~RecordPageHandler();
-    ResultCode init(DiskBufferPool& buffer_pool, int file_id, PageNum page_num);
+    ResultCode init(DiskBufferPool& buffer_pool, int file_id, PageNum page_num,
+                    BPScanRing* ring = nullptr);
+    /**
+     * 接管一个已经pin住的页面句柄，失败时页面会被unpin
+     */
+    ResultCode init(DiskBufferPool& buffer_pool, int file_id,
+                    const BPPageHandle& page_handle);
     ResultCode init_empty_page(DiskBufferPool& buffer_pool, int file_id,
                        PageNum page_num, int record_size);
     ResultCode cleanup();
 
     ResultCode insert_record(const char* data, RID* rid);
+
+    /**
+     * 把data中连续存放的record_num条记录尽量插入到当前页面，页面满了就停下。
+     * @param rids 返回插入的记录的标识符
+     * @param inserted_num 返回实际插入的记录数
+     */
+    ResultCode insert_records(const char* data, int record_num, RID* rids,
+                              int* inserted_num);
     ResultCode update_record(const Record* rec);
 
     template <class RecordUpdater>
@@ -98,13 +163,26 @@ class RecordPageHandler {
     ResultCode      get_first_record(Record* rec);
     ResultCode      get_next_record(Record* rec);
 
+    /**
+     * 把当前页面上所有记录的位置填到batch中，位图拷贝到bitmap，
+     * bitmap至少要有(record_capacity + 7) / 8个字节
+     */
+    void            get_batch(RecordBatch* batch, std::vector<char>& bitmap);
+
     PageNum get_page_num() const;
 
     bool    is_full() const;
 
+    /**
+     * 打开的是不是空闲空间表的页面。它没有记录，扫描时要整页跳过
+     */
+    bool    is_free_space_map() const;
+    int     get_record_num() const;
+    int     get_record_capacity() const;
+
     protected:
     char* get_record_data(SlotNum slot_num) {
-        return page_handle_.frame->page.data +
+        return page_handle_.frame->page->data +
                page_header_->first_record_offset +
                (page_header_->record_size * slot_num);
     }
@@ -146,6 +224,15 @@ class RecordFileHandler {
      */
     ResultCode insert_record(const char* data, int record_size, RID* rid);
 
+    /**
+     * 批量插入data中连续存放的record_num条记录，每条记录record_size个字节。
+     * 每个页面只pin一次，填满以后再换下一个页面。
+     * 插入失败时会删掉这次已经插入的记录
+     * @param rids 返回每条记录的标识符，至少要有record_num个元素
+     */
+    ResultCode insert_records(const char* data, int record_num, int record_size,
+                              RID* rids);
+
     /**
      * 获取指定文件中标识符为rid的记录内容到rec指向的记录结构中
      * @param rid
@@ -154,24 +241,150 @@ class RecordFileHandler {
      */
     ResultCode get_record(const RID* rid, Record* rec);
 
+    /**
+     * 依次读出rids中的rid_num条记录，rids要按RID::compare排好序。
+     * 同一个页面上的记录只pin一次页面，记录数据直接指向pin住的页面，
+     * 在reader返回之前有效。reader返回失败时停止读取。
+     * 每次最多RECORD_GET_BATCH_PAGES个页面通过get_pages一起获取，
+     * 未命中的页面一起提交读请求
+     */
+    template <class RecordReader>
+    ResultCode get_records(const RID rids[], int rid_num, RecordReader reader) {
+        ResultCode   rc = ResultCode::SUCCESS;
+        PageNum      page_nums[RECORD_GET_BATCH_PAGES];
+        BPPageHandle page_handles[RECORD_GET_BATCH_PAGES];
+        int          i = 0;
+        while (i < rid_num && rc == ResultCode::SUCCESS) {
+            // 收集接下来的一批不同的页号
+            int page_num_count = 0;
+            for (int j = i; j < rid_num; j++) {
+                if (page_num_count > 0 &&
+                    rids[j].page_num == page_nums[page_num_count - 1]) {
+                    continue;
+                }
+                if (page_num_count == RECORD_GET_BATCH_PAGES) {
+                    break;
+                }
+                page_nums[page_num_count++] = rids[j].page_num;
+            }
+            if ((rc = disk_buffer_pool_->get_pages(file_id_, page_nums, page_num_count,
+                                                   page_handles)) !=
+                ResultCode::SUCCESS) {
+                LOG_ERROR("Failed to get %d pages from page number=%d, file_id:%d",
+                          page_num_count, page_nums[0], file_id_);
+                break;
+            }
+
+            int page_index = 0;
+            while (page_index < page_num_count && rc == ResultCode::SUCCESS) {
+                RecordPageHandler page_handler;
+                if ((rc = page_handler.init(*disk_buffer_pool_, file_id_,
+                                            page_handles[page_index++])) !=
+                    ResultCode::SUCCESS) {
+                    LOG_ERROR("Failed to init record page handler.page number=%d, "
+                              "file_id:%d",
+                              page_nums[page_index - 1], file_id_);
+                    break;
+                }
+                for (; i < rid_num && rids[i].page_num == page_nums[page_index - 1] &&
+                       rc == ResultCode::SUCCESS;
+                     i++) {
+                    Record record;
+                    if ((rc = page_handler.get_record(&rids[i], &record)) ==
+                        ResultCode::SUCCESS) {
+                        rc = reader(&record);
+                    }
+                }
+                page_handler.cleanup();
+            }
+            // 提前停止时，还没有交给page_handler的页面要unpin
+            for (; page_index < page_num_count; page_index++) {
+                disk_buffer_pool_->unpin_page(&page_handles[page_index]);
+            }
+        }
+        return rc;
+    }
+
+    /**
+     * 整理数据文件，把后面页面上的记录搬到前面页面的空闲slot中，搬空的页面被释放。
+     * 从最后一个页面往前处理，前面页面的空闲slot放得下一个页面的所有记录时才搬这个页面，
+     * 放不下就停止。每搬一条记录调用一次record_mover，old_record还在原来的位置上，
+     * 记录已经复制到new_rid。record_mover返回失败时撤销这条记录的复制并停止整理。
+     * 文件末尾被释放的页面会被截掉
+     * @param max_pages 最多搬空的页面数，小于等于0时不限制
+     * @param moved_pages 返回搬空的页面数
+     */
+    ResultCode compact(int max_pages,
+                       ResultCode (*record_mover)(const Record* old_record,
+                                                  const RID& new_rid, void* context),
+                       void* context, int* moved_pages);
+
+    /**
+     * 空闲空间表中有空闲slot的页面数，没有空闲空间表时返回-1
+     */
+    int        free_page_count() const;
+
+    /**
+     * 文件是否有空闲空间表。旧格式的文件没有，插入时逐页查找空闲的slot
+     */
+    bool       has_free_space_map() const { return fsm_header_ != nullptr; }
+
     template <class RecordUpdater> // 改成普通模式, 不使用模板
     ResultCode update_record_in_place(const RID* rid, RecordUpdater updater) {
 
         ResultCode                rc = ResultCode::SUCCESS;
         RecordPageHandler page_handler;
-        if ((rc != page_handler.init(*disk_buffer_pool_, file_id_,
-                                     rid->page_num)) != ResultCode::SUCCESS) {
+        if ((rc = page_handler.init(*disk_buffer_pool_, file_id_,
+                                    rid->page_num)) != ResultCode::SUCCESS) {
             return rc;
         }
 
         return page_handler.update_record_in_place(rid, updater);
     }
 
+    private:
+    /**
+     * 新文件在第1页创建空闲空间表，已有的文件读出第1页中的空闲空间表。
+     * 空闲空间表的页面在文件关闭前一直pin着
+     */
+    ResultCode init_free_space_map();
+
+    /**
+     * 让record_page_handler_打开一个有空闲slot的页面，没有的话分配一个新的页面
+     */
+    ResultCode open_free_page(int record_size);
+
+    /**
+     * 在空闲空间表中找一个有空闲slot的页面，用record_page_handler_打开
+     */
+    ResultCode find_free_page(bool* page_found);
+
+    /**
+     * 没有空闲空间表时从头逐页查找有空闲slot的页面
+     */
+    ResultCode scan_free_page(bool* page_found);
+
+    /**
+     * 给已经有记录页面的文件新建空闲空间表时，逐页检查已有的页面，
+     * 把还有空闲slot的页面记到空闲空间表中
+     */
+    ResultCode fill_free_space_map(int page_count);
+
+    /**
+     * 在空闲空间表中记录page_num页是否还有空闲的slot
+     */
+    void       update_free_space(PageNum page_num, bool has_free);
+
     private:
     DiskBufferPool*   disk_buffer_pool_;
     int               file_id_; // 参考DiskBufferPool中的fileId
 
     RecordPageHandler record_page_handler_; // 目前只有insert record使用
+
+    BPPageHandle      fsm_handle_;
+    FsmPageHeader*    fsm_header_ = nullptr;
+    char*             fsm_bitmap_ = nullptr;
+    PageNum           fsm_hint_   = 0; // 上次找到的页面，下次从这里往后找
 };
 
 class RecordFileScanner {
@@ -189,10 +402,12 @@ class RecordFileScanner {
      * @param file_id
      * @param condition_num
      * @param conditions
+     * @param page_filter 可选的页面过滤器，用来整页跳过不可能满足条件的页面
      * @return
      */
     ResultCode open_scan(DiskBufferPool& buffer_pool, int file_id,
-                 ConditionFilter* condition_filter);
+                 ConditionFilter* condition_filter,
+                 const PageFilter* page_filter = nullptr);
 
     /**
      * 关闭一个文件扫描，释放相应的资源
@@ -211,12 +426,41 @@ class RecordFileScanner {
      */
     ResultCode get_next_record(Record* rec);
 
+    /**
+     * 批量扫描，每次返回下一个有满足条件的记录的页面，没有的话返回RECORD_EOF。
+     * 使用者在一个循环里按位图处理整个页面的记录，不需要每条记录调用一次扫描器。
+     * 不要和get_first_record/get_next_record交替使用
+     */
+    ResultCode get_next_batch(RecordBatch* batch);
+
+    /**
+     * 把批量扫描限制在[start_page, end_page)范围内的页面，从start_page重新开始。
+     * 并行扫描时每个worker用它扫描分到的一段页面
+     */
+    void       set_batch_range(PageNum start_page, PageNum end_page);
+
+    private:
+    /**
+     * 扫描要切换到page_num页面时调用。扫描是从前往后逐页进行的，
+     * 预读窗口用掉一半时，就把后面的页面成批预读进缓冲池
+     */
+    void readahead(PageNum page_num);
+
     private:
     DiskBufferPool*   disk_buffer_pool_;
     int               file_id_; // 参考DiskBufferPool中的fileId
 
     ConditionFilter*  condition_filter_;
+    const PageFilter* page_filter_ = nullptr;
     RecordPageHandler record_page_handler_;
+
+    PageNum           last_page_num_  = -1; // 上一次切换到的页面
+    PageNum           readahead_next_ = -1; // 还没有预读过的第一个页面
+    BPScanRing*       scan_ring_      = nullptr; // 大表扫描时使用的私有frame环
+
+    PageNum           batch_page_num_ = 1;  // 批量扫描下一个要读的页面
+    PageNum           batch_end_page_ = -1; // 批量扫描的结束页面，-1表示到文件末尾
+    std::vector<char> batch_bitmap_;        // 批量扫描返回的位图
 };
 
 #endif //__OBSERVER_STORAGE_COMMON_RECORD_MANAGER_H_
\ No newline at end of file
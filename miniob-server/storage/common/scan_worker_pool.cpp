@@ -0,0 +1,104 @@
+/* Copyright (c) 2021 Xie Meiyi(xiemeiyi@hust.edu.cn) and OceanBase and/or its
+affiliates. All rights reserved. miniob is licensed under Mulan PSL v2. You can
+use this software according to the terms and conditions of the Mulan PSL v2. You
+may obtain a copy of Mulan PSL v2 at: http://license.coscl.org.cn/MulanPSL2 THIS
+SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND, EITHER
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include <storage/common/scan_worker_pool.h>
+
+#include <algorithm>
+
+#include <common/lang/mutex.h>
+#include <common/log/log.h>
+
+int ScanWorkerPool::WORKER_NUM = SCAN_DEFAULT_WORKERS;
+
+ScanWorkerPool::ScanWorkerPool(int worker_num) {
+    MUTEX_INIT(&mutex_, NULL);
+    pthread_cond_init(&job_cond_, nullptr);
+    pthread_cond_init(&done_cond_, nullptr);
+    for (int i = 0; i < worker_num; i++) {
+        threads_.emplace_back(&ScanWorkerPool::work, this);
+    }
+}
+
+ScanWorkerPool::~ScanWorkerPool() {
+    MUTEX_LOCK(&mutex_);
+    stop_ = true;
+    pthread_cond_broadcast(&job_cond_);
+    MUTEX_UNLOCK(&mutex_);
+    for (std::thread& thread : threads_) {
+        thread.join();
+    }
+    pthread_cond_destroy(&done_cond_);
+    pthread_cond_destroy(&job_cond_);
+    MUTEX_DESTROY(&mutex_);
+}
+
+void ScanWorkerPool::set_worker_num(int worker_num) {
+    if (worker_num >= 0) {
+        WORKER_NUM = worker_num;
+        LOG_INFO("Successfully set scan worker num as %d", worker_num);
+    } else {
+        LOG_INFO("Invalid input argument worker_num:%d", worker_num);
+    }
+}
+
+void ScanWorkerPool::run(int parallelism, const std::function<void(int)>& task) {
+    Job job;
+    job.task    = &task;
+    int helpers = std::min(parallelism - 1, worker_num());
+    if (helpers > 0) {
+        MUTEX_LOCK(&mutex_);
+        jobs_.insert(jobs_.end(), helpers, &job);
+        pthread_cond_broadcast(&job_cond_);
+        MUTEX_UNLOCK(&mutex_);
+    }
+
+    task(0);
+    if (helpers <= 0) {
+        return;
+    }
+
+    // 撤回还在排队的任务，等已经开始的任务结束，之后job就不会再被访问了
+    MUTEX_LOCK(&mutex_);
+    jobs_.erase(std::remove(jobs_.begin(), jobs_.end(), &job), jobs_.end());
+    while (job.finished < job.started) {
+        pthread_cond_wait(&done_cond_, &mutex_);
+    }
+    MUTEX_UNLOCK(&mutex_);
+}
+
+void ScanWorkerPool::work() {
+    MUTEX_LOCK(&mutex_);
+    while (true) {
+        while (!stop_ && jobs_.empty()) {
+            pthread_cond_wait(&job_cond_, &mutex_);
+        }
+        if (stop_) {
+            break;
+        }
+
+        Job* job = jobs_.front();
+        jobs_.pop_front();
+        int index = ++job->started;
+        MUTEX_UNLOCK(&mutex_);
+
+        (*job->task)(index);
+
+        MUTEX_LOCK(&mutex_);
+        if (++job->finished == job->started) {
+            pthread_cond_broadcast(&done_cond_);
+        }
+    }
+    MUTEX_UNLOCK(&mutex_);
+}
+
+ScanWorkerPool* theGlobalScanWorkerPool() {
+    static ScanWorkerPool* instance = new ScanWorkerPool(ScanWorkerPool::WORKER_NUM);
+
+    return instance;
+}
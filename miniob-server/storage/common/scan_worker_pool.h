@@ -0,0 +1,78 @@
+/* Copyright (c) 2021 Xie Meiyi(xiemeiyi@hust.edu.cn) and OceanBase and/or its
+affiliates. All rights reserved. miniob is licensed under Mulan PSL v2. You can
+use this software according to the terms and conditions of the Mulan PSL v2. You
+may obtain a copy of Mulan PSL v2 at: http://license.coscl.org.cn/MulanPSL2 THIS
+SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND, EITHER
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#ifndef __OBSERVER_STORAGE_COMMON_SCAN_WORKER_POOL_H_
+#define __OBSERVER_STORAGE_COMMON_SCAN_WORKER_POOL_H_
+
+#include <pthread.h>
+
+#include <deque>
+#include <functional>
+#include <thread>
+#include <vector>
+
+// 并行扫描共用的worker线程个数的默认值
+#define SCAN_DEFAULT_WORKERS 8
+
+/**
+ * 所有会话的并行扫描共用的一组worker线程，线程个数固定，
+ * 这样并行扫描的会话再多，线程总数也不会超过上限，每次扫描也不用创建线程。
+ * 线程都在忙时提交的任务排队等待
+ */
+class ScanWorkerPool {
+    public:
+    ScanWorkerPool(int worker_num);
+    ~ScanWorkerPool();
+
+    /**
+     * 用parallelism个worker执行task(0)到task(parallelism - 1)，都结束以后返回。
+     * 调用者自己执行task(0)，其它的交给池中的线程，最多交出worker_num个。
+     * 调用者执行完task(0)时还在排队的任务被撤回，不再执行，
+     * 所以每个task都要从共享的工作中领取，直到领完为止
+     */
+    void run(int parallelism, const std::function<void(int)>& task);
+
+    int  worker_num() const { return (int)threads_.size(); }
+
+    /**
+     * 设置全局worker线程池的线程个数，要在第一次并行扫描之前设置
+     */
+    static void set_worker_num(int worker_num);
+
+    private:
+    /**
+     * 一次run提交的任务，started和finished是池中的线程开始和完成的个数
+     */
+    struct Job {
+        const std::function<void(int)>* task     = nullptr;
+        int                             started  = 0;
+        int                             finished = 0;
+    };
+
+    void work();
+
+    private:
+    pthread_mutex_t          mutex_;
+    pthread_cond_t           job_cond_;
+    pthread_cond_t           done_cond_;
+    std::deque<Job*>         jobs_;
+    bool                     stop_ = false;
+    std::vector<std::thread> threads_;
+
+    static int               WORKER_NUM;
+
+    friend ScanWorkerPool* theGlobalScanWorkerPool();
+};
+
+/**
+ * 全局的worker线程池，第一次使用时按设置的线程个数创建
+ */
+ScanWorkerPool* theGlobalScanWorkerPool();
+
+#endif //__OBSERVER_STORAGE_COMMON_SCAN_WORKER_POOL_H_
@@ -15,7 +15,11 @@ See the Mulan PSL v2 for more details. */
 #include <limits.h>
 #include <string.h>
 
+#include <atomic>
+#include <vector>
+
 #include <common/defs.h>
+#include <common/lang/bitmap.h>
 #include <common/lang/string.h>
 #include <common/log/log.h>
 #include <storage/common/bplus_tree_index.h>
@@ -23,16 +27,54 @@ See the Mulan PSL v2 for more details. */
 #include <storage/common/index.h>
 #include <storage/common/meta_util.h>
 #include <storage/common/record_manager.h>
+#include <storage/common/scan_worker_pool.h>
 #include <storage/common/table.h>
 #include <storage/common/table_meta.h>
+#include <storage/common/zone_map.h>
 #include <storage/default/disk_buffer_pool.h>
 #include <storage/transaction/transaction.h>
 
+// 并行扫描时worker每次领取的页面数
+static const int SCAN_MORSEL_PAGES = 16;
+// 通过索引扫描时每次从索引中取出的RID个数，排序后按页面读取记录
+static const int INDEX_SCAN_BATCH_RIDS = 4096;
+
+/**
+ * 整理数据文件时加写锁，其它操作加读锁
+ */
+class TableLockGuard {
+    public:
+    TableLockGuard(pthread_rwlock_t* lock, bool exclusive) : lock_(lock) {
+        if (exclusive) {
+            pthread_rwlock_wrlock(lock_);
+        } else {
+            pthread_rwlock_rdlock(lock_);
+        }
+    }
+    ~TableLockGuard() { pthread_rwlock_unlock(lock_); }
+
+    private:
+    pthread_rwlock_t* lock_;
+};
+
 Table::Table()
-    : data_buffer_pool_(nullptr), file_id_(-1), record_handler_(nullptr) {}
+    : data_buffer_pool_(nullptr), file_id_(-1), record_handler_(nullptr) {
+    pthread_rwlock_init(&rwlock_, nullptr);
+}
 
 Table::~Table() {
+    if (zone_map_ != nullptr) {
+        // 只有正常关闭时才保存，打开时没有这个文件就重新构建
+        if (record_handler_ != nullptr && !base_dir_.empty()) {
+            zone_map_->save(table_zone_map_file(base_dir_.c_str(), name()).c_str());
+        }
+        delete zone_map_;
+        zone_map_ = nullptr;
+    }
+
     if (record_handler_ != nullptr) {
+        // 释放一直固定着的空闲空间位图页，否则关闭文件时这个页面还留在缓冲池里
+        record_handler_->close();
         delete record_handler_;
         record_handler_ = nullptr;
     }
@@ -49,6 +91,7 @@ Table::~Table() {
     }
     indexes_.clear();
 
+    pthread_rwlock_destroy(&rwlock_);
     LOG_INFO("Table has been closed: %s", name());
 }
 
@@ -106,6 +149,9 @@ ResultCode Table::create(const char* path, const char* name, const char* base_di
     table_meta_.serialize(fs);
     fs.close();
 
+    // 同名的表以前留下的范围文件不能再用
+    ::remove(table_zone_map_file(base_dir, name).c_str());
+
     std::string data_file = table_data_file(base_dir, name);
     data_buffer_pool_     = theGlobalDiskBufferPool();
     rc                    = data_buffer_pool_->create_file(data_file.c_str());
@@ -254,6 +300,7 @@ ResultCode Table::insert_record(Transaction* transaction, Record* record) {
                   table_meta_.name(), rc, strrc(rc));
         return rc;
     }
+    zone_map_->update(record->rid.page_num, record->data);
 
     if (transaction != nullptr) {
         rc = transaction->insert_record(this, record);
@@ -289,6 +336,7 @@ ResultCode Table::insert_record(Transaction* transaction, Record* record) {
     return rc;
 }
 ResultCode Table::insert_record(Transaction* transaction, int value_num, const Value* values) {
+    TableLockGuard guard(&rwlock_, false);
     if (value_num <= 0 || nullptr == values) {
         LOG_ERROR("Invalid argument. table name: %s, value num=%d, values=%p",
                   name(), value_num, values);
@@ -314,7 +362,98 @@ const char*      Table::name() const { return table_meta_.name(); }
 
 const TableMeta& Table::table_meta() const { return table_meta_; }
 
+ResultCode Table::insert_records(Transaction* transaction, int record_num,
+                                 int value_num, const Value* values) {
+    TableLockGuard guard(&rwlock_, false);
+    if (record_num <= 0 || value_num <= 0 || nullptr == values) {
+        LOG_ERROR("Invalid argument. table name: %s, record num=%d, value "
+                  "num=%d, values=%p",
+                  name(), record_num, value_num, values);
+        return ResultCode::INVALID_ARGUMENT;
+    }
+
+    // 所有记录放在同一块缓冲区中，不再逐条申请内存
+    const int           record_size = table_meta_.record_size();
+    std::vector<char>   buffer((size_t)record_num * record_size);
+    std::vector<Record> records(record_num);
+    std::vector<RID>    rids(record_num);
+    std::vector<const char*> record_datas(record_num);
+    for (int i = 0; i < record_num; i++) {
+        char*      record_data = buffer.data() + (size_t)i * record_size;
+        ResultCode rc = fill_record(value_num, values + (size_t)i * value_num,
+                                    record_data);
+        if (rc != ResultCode::SUCCESS) {
+            LOG_ERROR("Failed to create record %d. rc=%d:%s", i, rc, strrc(rc));
+            return rc;
+        }
+        records[i].data = record_data;
+        record_datas[i] = record_data;
+        if (transaction != nullptr) {
+            transaction->init_transaction_info(this, records[i]);
+        }
+    }
+
+    ResultCode rc = record_handler_->insert_records(buffer.data(), record_num,
+                                                    record_size, rids.data());
+    if (rc != ResultCode::SUCCESS) {
+        LOG_ERROR("Insert records failed. table name=%s, rc=%d:%s",
+                  table_meta_.name(), rc, strrc(rc));
+        return rc;
+    }
+    for (int i = 0; i < record_num; i++) {
+        zone_map_->update(rids[i].page_num, record_datas[i]);
+    }
+
+    rc = insert_entries_of_indexes(record_datas.data(), rids.data(), record_num);
+    // logged_num只统计成功记入事务的记录，失败的那一条没有记下来，不用撤销
+    int logged_num = 0;
+    while (rc == ResultCode::SUCCESS && transaction != nullptr &&
+           logged_num < record_num) {
+        records[logged_num].rid = rids[logged_num];
+        rc = transaction->insert_record(this, &records[logged_num]);
+        if (rc != ResultCode::SUCCESS) {
+            LOG_ERROR("Failed to log operation(insertion) to transaction");
+            break;
+        }
+        logged_num++;
+    }
+    if (rc == ResultCode::SUCCESS) {
+        return rc;
+    }
+
+    // 撤销整批记录：事务中已经记下的插入操作、索引项和记录数据
+    for (int i = 0; i < logged_num; i++) {
+        transaction->delete_record(this, &records[i]);
+    }
+    for (int i = 0; i < record_num; i++) {
+        ResultCode rc2 = delete_entry_of_indexes(record_datas[i], rids[i], false);
+        if (rc2 != ResultCode::SUCCESS) {
+            LOG_ERROR("Failed to rollback index data when insert records "
+                      "failed. table name=%s, rc=%d:%s",
+                      name(), rc2, strrc(rc2));
+        }
+        rc2 = record_handler_->delete_record(&rids[i]);
+        if (rc2 != ResultCode::SUCCESS) {
+            LOG_PANIC("Failed to rollback record data when insert records "
+                      "failed. table name=%s, rc=%d:%s",
+                      name(), rc2, strrc(rc2));
+        }
+    }
+    return rc;
+}
+
 ResultCode Table::make_record(int value_num, const Value* values, char*& record_out) {
+    char*      record = new char[table_meta_.record_size()];
+    ResultCode rc     = fill_record(value_num, values, record);
+    if (rc != ResultCode::SUCCESS) {
+        delete[] record;
+        return rc;
+    }
+    record_out = record;
+    return ResultCode::SUCCESS;
+}
+
+ResultCode Table::fill_record(int value_num, const Value* values, char* record) {
     // 检查字段类型是否一致
     if (value_num + table_meta_.sys_field_num() != table_meta_.field_num()) {
         LOG_WARN("Input values don't match the table's schema, table name:%s",
@@ -337,17 +476,12 @@ ResultCode Table::make_record(int value_num, const Value* values, char*& record_
     }
 
     // 复制所有字段的值
-    int   record_size = table_meta_.record_size();
-    char* record      = new char[record_size];
-
     for (int i = 0; i < value_num; i++) {
         const FieldMeta* field =
             table_meta_.field(i + normal_field_start_index);
         const Value& value = values[i];
         memcpy(record + field->offset(), value.data, field->len());
     }
-
-    record_out = record;
     return ResultCode::SUCCESS;
 }
 
@@ -377,6 +511,32 @@ ResultCode Table::init_record_handler(const char* base_dir) {
     }
 
     file_id_ = data_buffer_pool_file_id;
+    return init_zone_map(base_dir);
+}
+
+static ResultCode zone_map_batch_reader(const RecordBatch& batch, void* context) {
+    ZoneMap*       zone_map = (ZoneMap*)context;
+    common::Bitmap bitmap(batch.bitmap, batch.slot_num);
+    bitmap.for_each_setted_bit(
+        [&](int slot) { zone_map->update(batch.page_num, batch.record(slot)); });
+    return ResultCode::SUCCESS;
+}
+
+ResultCode Table::init_zone_map(const char* base_dir) {
+    zone_map_ = new ZoneMap();
+    zone_map_->init(table_meta_);
+
+    std::string zone_map_file = table_zone_map_file(base_dir, table_meta_.name());
+    if (zone_map_->load(zone_map_file.c_str()) == ResultCode::SUCCESS) {
+        return ResultCode::SUCCESS;
+    }
+
+    // 新建的表，或者上次没有正常关闭，扫描数据文件重新构建
+    ResultCode rc = scan_record_batch(nullptr, nullptr, zone_map_, zone_map_batch_reader);
+    if (rc != ResultCode::SUCCESS) {
+        LOG_ERROR("Failed to build zone map. table=%s, rc=%d:%s",
+                  table_meta_.name(), rc, strrc(rc));
+    }
     return rc;
 }
 
@@ -408,6 +568,7 @@ static ResultCode scan_record_reader_adapter(Record* record, void* context) {
 ResultCode Table::scan_record(Transaction* transaction, ConditionFilter* filter, int limit,
                       void* context,
                       void (*record_reader)(const char* data, void* context)) {
+    TableLockGuard guard(&rwlock_, false);
     RecordReaderScanAdapter adapter(record_reader, context);
     return scan_record(transaction, filter, limit, (void*)&adapter,
                        scan_record_reader_adapter);
@@ -435,8 +596,11 @@ ResultCode Table::scan_record(Transaction* transaction, ConditionFilter* filter,
     }
 
     ResultCode                rc = ResultCode::SUCCESS;
+    ZoneMapFilter     zone_map_filter;
     RecordFileScanner scanner;
-    rc = scanner.open_scan(*data_buffer_pool_, file_id_, filter);
+    rc = scanner.open_scan(*data_buffer_pool_, file_id_, filter,
+                           zone_map_filter.init(*zone_map_, filter) ? &zone_map_filter
+                                                                   : nullptr);
     if (rc != ResultCode::SUCCESS) {
         LOG_ERROR("failed to open scanner. file id=%d. rc=%d:%s", file_id_, rc,
                   strrc(rc));
@@ -467,43 +631,189 @@ ResultCode Table::scan_record(Transaction* transaction, ConditionFilter* filter,
     return rc;
 }
 
-ResultCode Table::scan_record_by_index(Transaction* transaction, IndexScanner* scanner,
-                               ConditionFilter* filter, int limit,
-                               void* context,
-                               ResultCode (*record_reader)(Record*, void*)) {
-    ResultCode     rc = ResultCode::SUCCESS;
-    RID    rid;
-    Record record;
-    int    record_count = 0;
-    while (record_count < limit) {
-        rc = scanner->next_entry(&rid);
+ResultCode Table::scan_record_batch(Transaction* transaction, ConditionFilter* filter,
+                                  void* context,
+                                  ResultCode (*batch_reader)(const RecordBatch& batch,
+                                                             void* context)) {
+    TableLockGuard guard(&rwlock_, false);
+    if (nullptr == batch_reader) {
+        return ResultCode::INVALID_ARGUMENT;
+    }
+
+    ZoneMapFilter     zone_map_filter;
+    RecordFileScanner scanner;
+    ResultCode        rc = scanner.open_scan(
+        *data_buffer_pool_, file_id_, filter,
+        zone_map_filter.init(*zone_map_, filter) ? &zone_map_filter : nullptr);
+    if (rc != ResultCode::SUCCESS) {
+        LOG_ERROR("failed to open scanner. file id=%d. rc=%d:%s", file_id_, rc,
+                  strrc(rc));
+        return rc;
+    }
+
+    RecordBatch batch;
+    while (ResultCode::SUCCESS == (rc = scanner.get_next_batch(&batch))) {
+        filter_invisible_records(transaction, batch);
+        rc = batch_reader(batch, context);
         if (rc != ResultCode::SUCCESS) {
-            if (ResultCode::RECORD_EOF == rc) {
-                rc = ResultCode::SUCCESS;
+            break;
+        }
+    }
+
+    if (ResultCode::RECORD_EOF == rc) {
+        rc = ResultCode::SUCCESS;
+    } else {
+        LOG_ERROR("failed to scan record batch. file id=%d, rc=%d:%s", file_id_,
+                  rc, strrc(rc));
+    }
+    scanner.close_scan();
+    return rc;
+}
+
+ResultCode Table::scan_record_parallel(Transaction* transaction, ConditionFilter* filter,
+                                     int parallelism, void* contexts[],
+                                     void (*record_reader)(const char* data,
+                                                           void* context)) {
+    TableLockGuard guard(&rwlock_, false);
+    if (nullptr == record_reader || parallelism <= 0) {
+        return ResultCode::INVALID_ARGUMENT;
+    }
+
+    // 走索引的扫描读到的记录很少，没有必要并行
+    IndexScanner* index_scanner = find_index_for_scan(filter);
+    if (index_scanner != nullptr || parallelism == 1) {
+        RecordReaderScanAdapter adapter(record_reader, contexts[0]);
+        if (index_scanner != nullptr) {
+            return scan_record_by_index(transaction, index_scanner, filter, INT_MAX,
+                                        (void*)&adapter, scan_record_reader_adapter);
+        }
+        return scan_record(transaction, filter, -1, (void*)&adapter,
+                           scan_record_reader_adapter);
+    }
+
+    int        page_count = 0;
+    ResultCode rc = data_buffer_pool_->get_page_count(file_id_, &page_count);
+    if (rc != ResultCode::SUCCESS) {
+        LOG_ERROR("Failed to get page count. file id=%d, rc=%d:%s", file_id_, rc,
+                  strrc(rc));
+        return rc;
+    }
+
+    // 每个worker每次领一个morsel，扫描完再领下一个，扫得快的worker多干活
+    ZoneMapFilter           zone_map_filter;
+    const PageFilter*       page_filter =
+        zone_map_filter.init(*zone_map_, filter) ? &zone_map_filter : nullptr;
+    std::atomic<PageNum>    next_page(1);
+    std::atomic<ResultCode> result(ResultCode::SUCCESS);
+    auto                    worker = [&](int index) {
+        void*             context = contexts[index];
+        RecordFileScanner scanner;
+        ResultCode        ret =
+            scanner.open_scan(*data_buffer_pool_, file_id_, filter, page_filter);
+        while (ResultCode::SUCCESS == ret && ResultCode::SUCCESS == result) {
+            PageNum start_page = next_page.fetch_add(SCAN_MORSEL_PAGES);
+            if (start_page >= page_count) {
                 break;
             }
-            LOG_ERROR("Failed to scan table by index. rc=%d:%s", rc, strrc(rc));
-            break;
+
+            scanner.set_batch_range(start_page, start_page + SCAN_MORSEL_PAGES);
+            RecordBatch batch;
+            while (ResultCode::SUCCESS == (ret = scanner.get_next_batch(&batch))) {
+                filter_invisible_records(transaction, batch);
+                common::Bitmap bitmap(batch.bitmap, batch.slot_num);
+                bitmap.for_each_setted_bit(
+                    [&](int slot) { record_reader(batch.record(slot), context); });
+            }
+            if (ResultCode::RECORD_EOF == ret) {
+                ret = ResultCode::SUCCESS;
+            }
         }
+        scanner.close_scan();
 
-        rc = record_handler_->get_record(&rid, &record);
-        if (rc != ResultCode::SUCCESS) {
-            LOG_ERROR("Failed to fetch record of rid=%d:%d, rc=%d:%s",
-                      rid.page_num, rid.slot_num, rc, strrc(rc));
-            break;
+        if (ret != ResultCode::SUCCESS) {
+            LOG_ERROR("Failed to scan table in parallel. file id=%d, rc=%d:%s",
+                      file_id_, ret, strrc(ret));
+            result = ret;
         }
+    };
 
-        if ((transaction == nullptr || transaction->is_visible(this, &record)) &&
-            (filter == nullptr || filter->filter(record))) {
-            rc = record_reader(&record, context);
+    // worker来自所有会话共用的线程池，调用者自己也是一个worker
+    theGlobalScanWorkerPool()->run(parallelism, worker);
+    return result;
+}
+
+void Table::filter_invisible_records(Transaction* transaction,
+                                     const RecordBatch& batch) {
+    if (nullptr == transaction) {
+        return;
+    }
+
+    common::Bitmap bitmap(batch.bitmap, batch.slot_num);
+    bitmap.for_each_setted_bit([&](int slot) {
+        Record record;
+        record.rid.page_num = batch.page_num;
+        record.rid.slot_num = slot;
+        record.data         = batch.record(slot);
+        if (!transaction->is_visible(this, &record)) {
+            bitmap.clear_bit(slot);
+        }
+    });
+}
+
+ResultCode Table::scan_record_by_index(Transaction* transaction, IndexScanner* scanner,
+                               ConditionFilter* filter, int limit,
+                               void* context,
+                               ResultCode (*record_reader)(Record*, void*)) {
+    // 索引中的RID按key排序，在数据文件中是随机分布的。
+    // 先取出一批RID按页面排序，每个页面只读一次，避免反复pin同一个页面。
+    // limit限制的是交给record_reader的记录数，不可见或者不满足条件的记录不算
+    ResultCode       rc = ResultCode::SUCCESS;
+    std::vector<RID> rids;
+    rids.reserve(INDEX_SCAN_BATCH_RIDS);
+    int  record_count = 0;
+    bool scan_end     = false;
+    while (ResultCode::SUCCESS == rc && !scan_end) {
+        rids.clear();
+        RID rid;
+        while ((int)rids.size() < INDEX_SCAN_BATCH_RIDS) {
+            rc = scanner->next_entry(&rid);
             if (rc != ResultCode::SUCCESS) {
-                LOG_TRACE("Record reader break the table scanning. rc=%d:%s",
-                          rc, strrc(rc));
                 break;
             }
+            rids.push_back(rid);
+        }
+        if (ResultCode::RECORD_EOF == rc) {
+            rc       = ResultCode::SUCCESS;
+            scan_end = true;
+        } else if (rc != ResultCode::SUCCESS) {
+            LOG_ERROR("Failed to scan table by index. rc=%d:%s", rc, strrc(rc));
+            break;
         }
 
-        record_count++;
+        std::sort(rids.begin(), rids.end(), [](const RID& rid1, const RID& rid2) {
+            return RID::compare(&rid1, &rid2) < 0;
+        });
+        rc = record_handler_->get_records(
+            rids.data(), (int)rids.size(), [&](Record* record) {
+                if ((transaction != nullptr && !transaction->is_visible(this, record)) ||
+                    (filter != nullptr && !filter->filter(*record))) {
+                    return ResultCode::SUCCESS;
+                }
+                ResultCode ret = record_reader(record, context);
+                if (ret != ResultCode::SUCCESS) {
+                    LOG_TRACE("Record reader break the table scanning. rc=%d:%s",
+                              ret, strrc(ret));
+                    return ret;
+                }
+                if (++record_count >= limit) {
+                    return ResultCode::RECORD_EOF; // 已经够了，停止读取
+                }
+                return ResultCode::SUCCESS;
+            });
+        if (ResultCode::RECORD_EOF == rc) {
+            rc       = ResultCode::SUCCESS;
+            scan_end = true;
+        }
     }
 
     scanner->destroy();
@@ -512,23 +822,38 @@ ResultCode Table::scan_record_by_index(Transaction* transaction, IndexScanner* s
 
 class IndexInserter {
     public:
-    explicit IndexInserter(Index* index) : index_(index) {}
-
-    ResultCode insert_index(const Record* record) {
-        return index_->insert_entry(record->data, &record->rid);
+    IndexInserter(Index* index) : index_(index) {}
+
+    /**
+     * 扫描时把每条记录的索引项交给索引排序，扫描完以后一次性构建索引
+     */
+    ResultCode collect_keys(const RecordBatch& batch) {
+        ResultCode     rc = ResultCode::SUCCESS;
+        common::Bitmap bitmap(batch.bitmap, batch.slot_num);
+        bitmap.for_each_setted_bit([&](int slot) {
+            if (rc == ResultCode::SUCCESS) {
+                RID rid{batch.page_num, slot};
+                rc = index_->bulk_load_add(batch.record(slot), &rid);
+            }
+        });
+        return rc;
     }
 
+    ResultCode build_index() { return index_->bulk_load_finish(); }
+
     private:
     Index* index_;
 };
 
-static ResultCode insert_index_record_reader_adapter(Record* record, void* context) {
+static ResultCode insert_index_batch_reader_adapter(const RecordBatch& batch,
+                                                    void* context) {
     IndexInserter& inserter = *(IndexInserter*)context;
-    return inserter.insert_index(record);
+    return inserter.collect_keys(batch);
 }
 
 ResultCode Table::create_index(Transaction* transaction, const char* index_name,
                        const char* attribute_name) {
+    TableLockGuard guard(&rwlock_, false);
     if (common::is_blank(index_name) || common::is_blank(attribute_name)) {
         LOG_INFO("Invalid input arguments, table name is %s, index_name is "
                  "blank or attribute_name is blank",
@@ -572,10 +897,13 @@ ResultCode Table::create_index(Transaction* transaction, const char* index_name,
         return rc;
     }
 
-    // 遍历当前的所有数据，插入这个索引
+    // 遍历当前的所有数据，排好序后自底向上构建这个索引
     IndexInserter index_inserter(index);
-    rc = scan_record(transaction, nullptr, -1, &index_inserter,
-                     insert_index_record_reader_adapter);
+    rc = scan_record_batch(transaction, nullptr, &index_inserter,
+                           insert_index_batch_reader_adapter);
+    if (rc == ResultCode::SUCCESS) {
+        rc = index_inserter.build_index();
+    }
     if (rc != ResultCode::SUCCESS) {
         // rollback
         delete index;
@@ -629,10 +957,167 @@ ResultCode Table::create_index(Transaction* transaction, const char* index_name,
     return rc;
 }
 
+class RecordUpdater {
+    public:
+    RecordUpdater(Table& table, Transaction* transaction, const FieldMeta& field,
+                  const char* value)
+        : table_(table), transaction_(transaction), field_(field), value_(value) {}
+
+    void add_record(const Record* record) { rids_.push_back(record->rid); }
+
+    /**
+     * 扫描结束以后再修改记录，避免修改了索引字段以后又被索引扫描读到
+     */
+    ResultCode update_records() {
+        for (const RID& rid : rids_) {
+            ResultCode rc = table_.update_record(transaction_, rid, field_, value_);
+            if (rc != ResultCode::SUCCESS) {
+                return rc;
+            }
+            updated_count_++;
+        }
+        return ResultCode::SUCCESS;
+    }
+
+    int updated_count() const { return updated_count_; }
+
+    private:
+    Table&           table_;
+    Transaction*     transaction_;
+    const FieldMeta& field_;
+    const char*      value_;
+    std::vector<RID> rids_;
+    int              updated_count_ = 0;
+};
+
+static ResultCode record_reader_update_adapter(Record* record, void* context) {
+    RecordUpdater& record_updater = *(RecordUpdater*)context;
+    record_updater.add_record(record);
+    return ResultCode::SUCCESS;
+}
+
 ResultCode Table::update_record(Transaction* transaction, const char* attribute_name,
                         const Value* value, int condition_num,
                         const Condition conditions[], int* updated_count) {
-    return ResultCode::GENERIC_ERROR;
+    TableLockGuard guard(&rwlock_, false);
+    if (nullptr == attribute_name || nullptr == value) {
+        LOG_ERROR("Invalid argument. table name: %s, attribute name=%p, value=%p",
+                  name(), attribute_name, value);
+        return ResultCode::INVALID_ARGUMENT;
+    }
+
+    const FieldMeta* field = table_meta_.field(attribute_name);
+    if (nullptr == field || field == table_meta_.transaction_field()) {
+        LOG_WARN("No such field. table name=%s, field name=%s", name(),
+                 attribute_name);
+        return ResultCode::SCHEMA_FIELD_NOT_EXIST;
+    }
+    if (field->type() != value->type) {
+        LOG_ERROR("Invalid value type. table name =%s, field name=%s, "
+                  "type=%d, but given=%d",
+                  name(), field->name(), field->type(), value->type);
+        return ResultCode::SCHEMA_FIELD_TYPE_MISMATCH;
+    }
+
+    // 字符串可能比字段短，按字段长度补0
+    std::vector<char> field_value(field->len(), 0);
+    if (CHARS == field->type()) {
+        strncpy(field_value.data(), (const char*)value->data, field->len());
+    } else {
+        memcpy(field_value.data(), value->data, field->len());
+    }
+
+    CompositeConditionFilter condition_filter;
+    ResultCode rc = condition_filter.init(*this, conditions, condition_num);
+    if (rc != ResultCode::SUCCESS) {
+        return rc;
+    }
+
+    RecordUpdater updater(*this, transaction, *field, field_value.data());
+    rc = scan_record(transaction, &condition_filter, -1, &updater,
+                     record_reader_update_adapter);
+    if (rc == ResultCode::SUCCESS) {
+        rc = updater.update_records();
+    }
+    if (updated_count != nullptr) {
+        *updated_count = updater.updated_count();
+    }
+    return rc;
+}
+
+ResultCode Table::update_record(Transaction* transaction, const RID& rid,
+                                const FieldMeta& field, const char* value) {
+    const int record_size = table_meta_.record_size();
+    return record_handler_->update_record_in_place(&rid, [&](Record& record) {
+        char* field_data = record.data + field.offset();
+        if (0 == memcmp(field_data, value, field.len())) {
+            return ResultCode::SUCCESS;
+        }
+
+        std::vector<char> new_record(record.data, record.data + record_size);
+        memcpy(new_record.data() + field.offset(), value, field.len());
+        ResultCode rc = update_entry_of_indexes(record.data, new_record.data(),
+                                                rid, field.name());
+        if (rc != ResultCode::SUCCESS) {
+            LOG_ERROR("Failed to update indexes of record (rid=%d.%d). rc=%d:%s",
+                      rid.page_num, rid.slot_num, rc, strrc(rc));
+            return rc;
+        }
+
+        if (transaction != nullptr) {
+            rc = transaction->update_record(this, &record);
+            if (rc != ResultCode::SUCCESS) {
+                LOG_ERROR("Failed to log update of record (rid=%d.%d). rc=%d:%s",
+                          rid.page_num, rid.slot_num, rc, strrc(rc));
+                update_entry_of_indexes(new_record.data(), record.data, rid,
+                                        field.name());
+                return rc;
+            }
+        }
+
+        memcpy(field_data, value, field.len());
+        zone_map_->update(rid.page_num, record.data);
+        return ResultCode::SUCCESS;
+    });
+}
+
+ResultCode Table::rollback_update(Transaction* transaction, const RID& rid,
+                                  const char* old_record) {
+    return record_handler_->update_record_in_place(&rid, [&](Record& record) {
+        // 只有值变化了的字段需要把索引改回去
+        for (int i = table_meta_.sys_field_num(); i < table_meta_.field_num(); i++) {
+            const FieldMeta* field = table_meta_.field(i);
+            if (0 == memcmp(record.data + field->offset(),
+                            old_record + field->offset(), field->len())) {
+                continue;
+            }
+            ResultCode rc = update_entry_of_indexes(record.data, old_record,
+                                                    rid, field->name());
+            if (rc != ResultCode::SUCCESS) {
+                LOG_ERROR("Failed to rollback indexes of record (rid=%d.%d). "
+                          "rc=%d:%s",
+                          rid.page_num, rid.slot_num, rc, strrc(rc));
+                return rc;
+            }
+        }
+
+        // 只恢复用户字段。事务字段上可能是后来别的事务的删除标记，不能覆盖
+        for (int i = table_meta_.sys_field_num(); i < table_meta_.field_num(); i++) {
+            const FieldMeta* field = table_meta_.field(i);
+            memcpy(record.data + field->offset(), old_record + field->offset(),
+                   field->len());
+        }
+        transaction->clear_update_mark(this, record);
+        zone_map_->update(rid.page_num, record.data);
+        return ResultCode::SUCCESS;
+    });
+}
+
+ResultCode Table::commit_update(Transaction* transaction, const RID& rid) {
+    return record_handler_->update_record_in_place(&rid, [&](Record& record) {
+        transaction->clear_update_mark(this, record);
+        return ResultCode::SUCCESS;
+    });
 }
 
 class RecordDeleter {
@@ -662,6 +1147,7 @@ static ResultCode record_reader_delete_adapter(Record* record, void* context) {
 }
 
 ResultCode Table::delete_record(Transaction* transaction, ConditionFilter* filter, int* deleted_count) {
+    TableLockGuard guard(&rwlock_, false);
     RecordDeleter deleter(*this, transaction);
     ResultCode            rc =
         scan_record(transaction, filter, -1, &deleter, record_reader_delete_adapter);
@@ -722,6 +1208,88 @@ ResultCode Table::rollback_delete(Transaction* transaction, const RID& rid) {
     return transaction->rollback_delete(this, record); // update record in place
 }
 
+class RecordMover {
+    public:
+    explicit RecordMover(Table& table) : table_(table) {}
+
+    /**
+     * 记录从old_record->rid搬到new_rid以后，把索引项指向新的位置
+     */
+    ResultCode move_record(const Record* old_record, const RID& new_rid) {
+        std::vector<Index*>& indexes = table_.indexes_;
+        for (size_t i = 0; i < indexes.size(); i++) {
+            ResultCode rc = move_entry(indexes[i], old_record->data,
+                                       old_record->rid, new_rid);
+            if (rc != ResultCode::SUCCESS) {
+                LOG_ERROR("Failed to move index entry of record (rid=%d.%d). "
+                          "rc=%d:%s",
+                          old_record->rid.page_num, old_record->rid.slot_num,
+                          rc, strrc(rc));
+                for (size_t j = 0; j < i; j++) {
+                    move_entry(indexes[j], old_record->data, new_rid,
+                               old_record->rid);
+                }
+                return rc;
+            }
+        }
+        table_.zone_map_->update(new_rid.page_num, old_record->data);
+        return ResultCode::SUCCESS;
+    }
+
+    private:
+    static ResultCode move_entry(Index* index, const char* record,
+                                 const RID& from, const RID& to) {
+        ResultCode rc = index->delete_entry(record, &from);
+        if (rc != ResultCode::SUCCESS) {
+            return rc;
+        }
+        rc = index->insert_entry(record, &to);
+        if (rc != ResultCode::SUCCESS) {
+            index->insert_entry(record, &from);
+        }
+        return rc;
+    }
+
+    private:
+    Table& table_;
+};
+
+static ResultCode record_mover_adapter(const Record* old_record,
+                                       const RID& new_rid, void* context) {
+    RecordMover& record_mover = *(RecordMover*)context;
+    return record_mover.move_record(old_record, new_rid);
+}
+
+ResultCode Table::vacuum(int max_pages, int* moved_pages) {
+    TableLockGuard guard(&rwlock_, true);
+    *moved_pages = 0;
+    if (pending_transactions_.load() > 0) {
+        LOG_INFO("Table %s has pending transactions, skip vacuum", name());
+        return ResultCode::LOCKED;
+    }
+
+    RecordMover mover(*this);
+    ResultCode  rc = record_handler_->compact(max_pages, record_mover_adapter,
+                                              &mover, moved_pages);
+    if (rc != ResultCode::SUCCESS) {
+        LOG_WARN("Failed to vacuum table %s. rc=%d:%s", name(), rc, strrc(rc));
+    }
+
+    // 达到上限时可能还没有整理完，下次还要继续
+    const bool finished = max_pages <= 0 || *moved_pages < max_pages;
+    vacuum_free_pages_ = finished ? record_handler_->free_page_count() : -1;
+    return rc;
+}
+
+bool Table::need_vacuum() const {
+    const int free_pages = record_handler_->free_page_count();
+    return free_pages > 1 && free_pages != vacuum_free_pages_;
+}
+
+void Table::add_pending_transaction() { pending_transactions_++; }
+
+void Table::remove_pending_transaction() { pending_transactions_--; }
+
 ResultCode Table::insert_entry_of_indexes(const char* record, const RID& rid) {
     ResultCode rc = ResultCode::SUCCESS;
     for (Index* index : indexes_) {
@@ -733,6 +1301,48 @@ ResultCode Table::insert_entry_of_indexes(const char* record, const RID& rid) {
     return rc;
 }
 
+ResultCode Table::insert_entries_of_indexes(const char* const records[],
+                                            const RID rids[], int num) {
+    ResultCode rc = ResultCode::SUCCESS;
+    for (Index* index : indexes_) {
+        rc = index->insert_entries(records, rids, num);
+        if (rc != ResultCode::SUCCESS) {
+            break;
+        }
+    }
+    return rc;
+}
+
+ResultCode Table::update_entry_of_indexes(const char* old_record,
+                                          const char* new_record, const RID& rid,
+                                          const char* field_name) {
+    for (size_t i = 0; i < indexes_.size(); i++) {
+        Index* index = indexes_[i];
+        if (0 != strcmp(index->index_meta().field(), field_name)) {
+            continue;
+        }
+
+        ResultCode rc = index->delete_entry(old_record, &rid);
+        if (rc == ResultCode::SUCCESS) {
+            rc = index->insert_entry(new_record, &rid);
+            if (rc != ResultCode::SUCCESS) {
+                index->insert_entry(old_record, &rid);
+            }
+        }
+        if (rc != ResultCode::SUCCESS) {
+            for (size_t j = 0; j < i; j++) {
+                Index* updated_index = indexes_[j];
+                if (0 == strcmp(updated_index->index_meta().field(), field_name)) {
+                    updated_index->delete_entry(new_record, &rid);
+                    updated_index->insert_entry(old_record, &rid);
+                }
+            }
+            return rc;
+        }
+    }
+    return ResultCode::SUCCESS;
+}
+
 ResultCode Table::delete_entry_of_indexes(const char* record, const RID& rid,
                                   bool error_on_not_exists) {
     ResultCode rc = ResultCode::SUCCESS;
@@ -14,6 +14,10 @@ See the Mulan PSL v2 for more details. */
 #ifndef __OBSERVER_STORAGE_COMMON_TABLE_H__
 #define __OBSERVER_STORAGE_COMMON_TABLE_H__
 
+#include <pthread.h>
+
+#include <atomic>
+
 #include <storage/common/table_meta.h>
 
 class DiskBufferPool;
@@ -21,11 +25,13 @@ class RecordFileHandler;
 class ConditionFilter;
 class DefaultConditionFilter;
 struct Record;
+struct RecordBatch;
 struct RID;
 class Index;
 class IndexScanner;
 class RecordDeleter;
 class Transaction;
+class ZoneMap;
 
 class Table {
     public:
@@ -51,6 +57,19 @@ class Table {
     ResultCode open(const char* meta_file, const char* base_dir);
     ResultCode destroy(const char* dir);
     ResultCode insert_record(Transaction* transaction, int value_num, const Value* values);
+
+    /**
+     * 批量插入record_num行记录，values中按行依次存放，每行value_num个值。
+     * 记录在一块连续的缓冲区中构造，一个页面填满后才换下一个页面，
+     * 索引项按key的顺序插入。任何一行失败时整批都不会插入
+     */
+    ResultCode insert_records(Transaction* transaction, int record_num, int value_num,
+                              const Value* values);
+
+    /**
+     * 把满足条件的记录的一个字段改成value，直接修改页面上的记录，不移动记录的位置。
+     * 只维护这个字段上的索引。有事务时保存修改前的数据，回滚时恢复
+     */
     ResultCode update_record(Transaction* transaction, const char* attribute_name, const Value* value,
                      int condition_num, const Condition conditions[],
                      int* updated_count);
@@ -59,9 +78,49 @@ class Table {
     ResultCode scan_record(Transaction* transaction, ConditionFilter* filter, int limit, void* context,
                    void (*record_reader)(const char* data, void* context));
 
+    /**
+     * 批量扫描表中的记录，每个页面调用一次batch_reader。
+     * batch中只包含满足filter并且对事务可见的记录，记录数据直接指向缓冲池的页面。
+     * batch_reader返回失败时扫描停止
+     */
+    ResultCode scan_record_batch(Transaction* transaction, ConditionFilter* filter, void* context,
+                         ResultCode (*batch_reader)(const RecordBatch& batch, void* context));
+
+    /**
+     * 并行扫描表中的记录。数据文件的页面分成若干morsel，
+     * parallelism个worker各自领取morsel并过滤，worker i读到的记录交给contexts[i]，
+     * 由调用者合并结果，记录的顺序和串行扫描不同。worker来自共用的ScanWorkerPool，
+     * 线程池忙时实际参与的worker可能少于parallelism个。
+     * 能使用索引或者parallelism为1时，只用contexts[0]串行扫描
+     */
+    ResultCode scan_record_parallel(Transaction* transaction, ConditionFilter* filter,
+                            int parallelism, void* contexts[],
+                            void (*record_reader)(const char* data, void* context));
+
     ResultCode create_index(Transaction* transaction, const char* index_name,
                     const char* attribute_name);
 
+    /**
+     * 整理数据文件，把后面页面上的记录搬到前面页面的空闲位置，释放搬空的页面，
+     * 同时修改被搬动记录的索引项。整理时其它操作都要等待。
+     * 还有没结束的事务修改过这个表时不整理，返回LOCKED
+     * @param max_pages 最多搬空的页面数，小于等于0时不限制
+     * @param moved_pages 返回搬空的页面数
+     */
+    ResultCode vacuum(int max_pages, int* moved_pages);
+
+    /**
+     * 有空闲空间的页面和上次整理以后不一样了，后台整理时用来跳过没有变化的表
+     */
+    bool       need_vacuum() const;
+
+    /**
+     * 事务第一次修改这个表时调用add_pending_transaction，提交或回滚以后调用
+     * remove_pending_transaction。事务中记录了修改过的记录的位置，这期间不能搬动记录
+     */
+    void       add_pending_transaction();
+    void       remove_pending_transaction();
+
     public:
     const char*      name() const;
 
@@ -72,33 +131,68 @@ class Table {
     public:
     ResultCode commit_insert(Transaction* transaction, const RID& rid);
     ResultCode commit_delete(Transaction* transaction, const RID& rid);
+    ResultCode commit_update(Transaction* transaction, const RID& rid);
     ResultCode rollback_insert(Transaction* transaction, const RID& rid);
     ResultCode rollback_delete(Transaction* transaction, const RID& rid);
+    ResultCode rollback_update(Transaction* transaction, const RID& rid,
+                               const char* old_record);
 
     private:
     ResultCode scan_record(Transaction* transaction, ConditionFilter* filter, int limit, void* context,
                    ResultCode (*record_reader)(Record* record, void* context));
+
+    /**
+     * 从索引中分批取出RID，每批按页面排序后读取记录，每个页面只读一次。
+     * 记录按在数据文件中的位置返回，不是索引的顺序
+     */
     ResultCode scan_record_by_index(Transaction* transaction, IndexScanner* scanner,
                             ConditionFilter* filter, int limit, void* context,
                             ResultCode (*record_reader)(Record* record, void* context));
     IndexScanner* find_index_for_scan(const ConditionFilter* filter);
     IndexScanner* find_index_for_scan(const DefaultConditionFilter& filter);
 
+    /**
+     * 清掉batch中对事务不可见的记录
+     */
+    void          filter_invisible_records(Transaction* transaction, const RecordBatch& batch);
+
     ResultCode            insert_record(Transaction* transaction, Record* record);
     ResultCode            delete_record(Transaction* transaction, Record* record);
+    ResultCode            update_record(Transaction* transaction, const RID& rid,
+                                        const FieldMeta& field, const char* value);
 
     private:
     friend class RecordUpdater;
     friend class RecordDeleter;
+    friend class RecordMover;
 
     ResultCode insert_entry_of_indexes(const char* record, const RID& rid);
+    ResultCode insert_entries_of_indexes(const char* const records[],
+                                         const RID rids[], int num);
+    /**
+     * 字段field_name的值从old_record改成new_record时，修改这个字段上的索引。
+     * 失败时已经修改的索引会改回去
+     */
+    ResultCode update_entry_of_indexes(const char* old_record, const char* new_record,
+                                       const RID& rid, const char* field_name);
     ResultCode delete_entry_of_indexes(const char* record, const RID& rid,
                                bool error_on_not_exists);
 
     private:
     ResultCode init_record_handler(const char* base_dir);
+
+    /**
+     * 加载页面的最小值最大值，没有保存的文件时扫描数据文件构建
+     */
+    ResultCode init_zone_map(const char* base_dir);
+
     ResultCode make_record(int value_num, const Value* values, char*& record_out);
 
+    /**
+     * 把values中的值填到record中，record至少有record_size个字节
+     */
+    ResultCode fill_record(int value_num, const Value* values, char* record);
+
     private:
     Index* find_index(const char* index_name) const;
 
@@ -108,7 +202,12 @@ class Table {
     DiskBufferPool*     data_buffer_pool_; /// 数据文件关联的buffer pool
     int                 file_id_;
     RecordFileHandler*  record_handler_; /// 记录操作
+    ZoneMap*            zone_map_ = nullptr; /// 每个页面上字段的取值范围，扫描时跳过页面
     std::vector<Index*> indexes_;
+
+    pthread_rwlock_t    rwlock_; /// 整理数据文件时加写锁，其它操作加读锁
+    std::atomic<int>    pending_transactions_{0};
+    std::atomic<int>    vacuum_free_pages_{-1}; /// 上次整理以后有空闲空间的页面数
 };
 
 #endif // __OBSERVER_STORAGE_COMMON_TABLE_H__
\ No newline at end of file
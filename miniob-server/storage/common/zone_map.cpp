@@ -0,0 +1,258 @@
+/* Copyright (c) 2021 Xie Meiyi(xiemeiyi@hust.edu.cn) and OceanBase and/or its
+affiliates. All rights reserved. miniob is licensed under Mulan PSL v2. You can
+use this software according to the terms and conditions of the Mulan PSL v2. You
+may obtain a copy of Mulan PSL v2 at: http://license.coscl.org.cn/MulanPSL2 THIS
+SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND, EITHER
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include <storage/common/zone_map.h>
+
+#include <errno.h>
+#include <string.h>
+
+#include <fstream>
+
+#include <common/lang/mutex.h>
+#include <common/log/log.h>
+#include <storage/common/condition_filter.h>
+
+struct ZoneMapFileHeader {
+    int magic;
+    int entry_size;
+    int page_count;
+};
+
+ZoneMap::ZoneMap() { MUTEX_INIT(&mutex_, NULL); }
+
+ZoneMap::~ZoneMap() { MUTEX_DESTROY(&mutex_); }
+
+void ZoneMap::init(const TableMeta& table_meta) {
+    columns_.clear();
+    entries_.clear();
+    entry_size_ = 1;
+    for (int i = table_meta.sys_field_num(); i < table_meta.field_num(); i++) {
+        const FieldMeta* field = table_meta.field(i);
+        if (field->type() != INTS && field->type() != FLOATS &&
+            field->type() != CHARS) {
+            continue;
+        }
+
+        Column column;
+        column.type     = field->type();
+        column.offset   = field->offset();
+        column.len      = field->len();
+        column.min_pos  = entry_size_;
+        column.zone_len = field->type() == CHARS ? field->len() + 1 : field->len();
+        entry_size_ += column.zone_len * 2;
+        columns_.push_back(column);
+    }
+}
+
+ResultCode ZoneMap::load(const char* file_name) {
+    std::fstream fs;
+    fs.open(file_name, std::ios_base::in | std::ios_base::binary);
+    if (!fs.is_open()) {
+        LOG_INFO("No zone map file %s, errmsg=%s", file_name, strerror(errno));
+        return ResultCode::IOERR;
+    }
+
+    ZoneMapFileHeader header;
+    fs.read((char*)&header, sizeof(header));
+    if (!fs || header.magic != ZONE_MAP_MAGIC ||
+        header.entry_size != entry_size_ || header.page_count < 0) {
+        LOG_WARN("Invalid zone map file %s", file_name);
+        return ResultCode::GENERIC_ERROR;
+    }
+
+    std::vector<char> entries((size_t)header.page_count * entry_size_);
+    fs.read(entries.data(), entries.size());
+    if (!fs) {
+        LOG_WARN("Failed to read zone map file %s", file_name);
+        return ResultCode::IOERR;
+    }
+    fs.close();
+
+    MUTEX_LOCK(&mutex_);
+    entries_.swap(entries);
+    MUTEX_UNLOCK(&mutex_);
+
+    // 内存中的范围以后会变化，文件只在正常关闭时重新写出
+    ::remove(file_name);
+    return ResultCode::SUCCESS;
+}
+
+ResultCode ZoneMap::save(const char* file_name) {
+    std::fstream fs;
+    fs.open(file_name,
+            std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+    if (!fs.is_open()) {
+        LOG_ERROR("Failed to open zone map file %s for write, errmsg=%s",
+                  file_name, strerror(errno));
+        return ResultCode::IOERR;
+    }
+
+    MUTEX_LOCK(&mutex_);
+    ZoneMapFileHeader header;
+    header.magic      = ZONE_MAP_MAGIC;
+    header.entry_size = entry_size_;
+    header.page_count = (int)(entries_.size() / entry_size_);
+    fs.write((const char*)&header, sizeof(header));
+    fs.write(entries_.data(), entries_.size());
+    MUTEX_UNLOCK(&mutex_);
+
+    fs.close();
+    if (!fs) {
+        LOG_ERROR("Failed to write zone map file %s", file_name);
+        ::remove(file_name);
+        return ResultCode::IOERR;
+    }
+    return ResultCode::SUCCESS;
+}
+
+void ZoneMap::update(PageNum page_num, const char* record) {
+    MUTEX_LOCK(&mutex_);
+    if ((size_t)page_num >= entries_.size() / entry_size_) {
+        entries_.resize((size_t)(page_num + 1) * entry_size_, 0);
+    }
+
+    char*      zone  = entry(page_num);
+    const bool first = zone[0] == 0;
+    zone[0]          = 1;
+    for (const Column& column : columns_) {
+        char*       min   = zone + column.min_pos;
+        char*       max   = min + column.zone_len;
+        const char* value = record + column.offset;
+        if (first || DefaultConditionFilter::compare(column.type, value, min) < 0) {
+            memcpy(min, value, column.len);
+        }
+        if (first || DefaultConditionFilter::compare(column.type, value, max) > 0) {
+            memcpy(max, value, column.len);
+        }
+    }
+    MUTEX_UNLOCK(&mutex_);
+}
+
+int ZoneMap::column_of_offset(int offset) const {
+    for (size_t i = 0; i < columns_.size(); i++) {
+        if (columns_[i].offset == offset) {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+bool ZoneMap::may_match(PageNum page_num, int column_index, CompOp comp_op,
+                        const char* value) {
+    const Column& column = columns_[column_index];
+    MUTEX_LOCK(&mutex_);
+    // 从来没有插入过记录的页面
+    if ((size_t)page_num >= entries_.size() / entry_size_ ||
+        entry(page_num)[0] == 0) {
+        MUTEX_UNLOCK(&mutex_);
+        return false;
+    }
+
+    const char* min = entry(page_num) + column.min_pos;
+    const char* max = min + column.zone_len;
+    // 比较结果随字段的值单调变化，页面上的值和value比较的结果都在[low, high]中
+    const int   low  = DefaultConditionFilter::compare(column.type, min, value);
+    const int   high = DefaultConditionFilter::compare(column.type, max, value);
+    MUTEX_UNLOCK(&mutex_);
+
+    switch (comp_op) {
+    case EQUAL_TO:
+        return low <= 0 && high >= 0;
+    case NOT_EQUAL:
+        return low != 0 || high != 0;
+    case LESS_THAN:
+        return low < 0;
+    case LESS_EQUAL:
+        return low <= 0;
+    case GREAT_THAN:
+        return high > 0;
+    case GREAT_EQUAL:
+        return high >= 0;
+    default:
+        return true;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool ZoneMapFilter::init(ZoneMap& zone_map, const ConditionFilter* filter) {
+    zone_map_ = &zone_map;
+    predicates_.clear();
+    add_predicates(filter);
+    return !predicates_.empty();
+}
+
+void ZoneMapFilter::add_predicates(const ConditionFilter* filter) {
+    if (nullptr == filter) {
+        return;
+    }
+
+    const CompositeConditionFilter* composite_condition_filter =
+        dynamic_cast<const CompositeConditionFilter*>(filter);
+    if (composite_condition_filter != nullptr) {
+        // 组合的条件之间是与的关系，每个条件都要满足
+        for (int i = 0; i < composite_condition_filter->filter_num(); i++) {
+            add_predicates(&composite_condition_filter->filter(i));
+        }
+        return;
+    }
+
+    const DefaultConditionFilter* default_condition_filter =
+        dynamic_cast<const DefaultConditionFilter*>(filter);
+    if (nullptr == default_condition_filter) {
+        return;
+    }
+
+    const ConDesc& left    = default_condition_filter->left();
+    const ConDesc& right   = default_condition_filter->right();
+    CompOp         comp_op = default_condition_filter->comp_op();
+    Predicate      predicate;
+    if (left.is_attr && !right.is_attr) {
+        predicate.column = zone_map_->column_of_offset(left.attr_offset);
+        predicate.value  = (const char*)right.value;
+    } else if (!left.is_attr && right.is_attr) {
+        predicate.column = zone_map_->column_of_offset(right.attr_offset);
+        predicate.value  = (const char*)left.value;
+        // 值在左边时把比较符号反过来
+        switch (comp_op) {
+        case LESS_THAN:
+            comp_op = GREAT_THAN;
+            break;
+        case LESS_EQUAL:
+            comp_op = GREAT_EQUAL;
+            break;
+        case GREAT_THAN:
+            comp_op = LESS_THAN;
+            break;
+        case GREAT_EQUAL:
+            comp_op = LESS_EQUAL;
+            break;
+        default:
+            break;
+        }
+    } else {
+        return;
+    }
+
+    if (predicate.column < 0 || comp_op == NO_OP) {
+        return;
+    }
+    predicate.comp_op = comp_op;
+    predicates_.push_back(predicate);
+}
+
+bool ZoneMapFilter::may_match(PageNum page_num) const {
+    for (const Predicate& predicate : predicates_) {
+        if (!zone_map_->may_match(page_num, predicate.column, predicate.comp_op,
+                                  predicate.value)) {
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,107 @@
+/* Copyright (c) 2021 Xie Meiyi(xiemeiyi@hust.edu.cn) and OceanBase and/or its
+affiliates. All rights reserved. miniob is licensed under Mulan PSL v2. You can
+use this software according to the terms and conditions of the Mulan PSL v2. You
+may obtain a copy of Mulan PSL v2 at: http://license.coscl.org.cn/MulanPSL2 THIS
+SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND, EITHER
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#ifndef __OBSERVER_STORAGE_COMMON_ZONE_MAP_H_
+#define __OBSERVER_STORAGE_COMMON_ZONE_MAP_H_
+
+#include <pthread.h>
+
+#include <vector>
+
+#include <storage/common/record_manager.h>
+#include <storage/common/table_meta.h>
+
+#define ZONE_MAP_MAGIC 0x50414d5a
+
+/**
+ * 数据文件每个页面上每个字段的最小值和最大值。
+ * 插入和修改记录时扩大页面的范围，删除记录时不收缩，
+ * 范围只会比实际的大，用来跳过页面总是安全的。
+ * 表正常关闭时保存到数据文件旁边的.zone文件，打开时加载后就删除这个文件，
+ * 这样异常退出以后不会用到过期的范围，而是扫描数据文件重新构建
+ */
+class ZoneMap {
+    public:
+    ZoneMap();
+    ~ZoneMap();
+
+    /**
+     * 按表结构初始化，所有页面都还没有记录。只记录用户字段
+     */
+    void       init(const TableMeta& table_meta);
+
+    /**
+     * 从文件加载，文件不存在或者和表结构不匹配时返回失败，调用者需要重新构建
+     */
+    ResultCode load(const char* file_name);
+    ResultCode save(const char* file_name);
+
+    /**
+     * 记录插入或者修改到page_num页以后调用
+     */
+    void       update(PageNum page_num, const char* record);
+
+    /**
+     * 字段在记录中的偏移量对应的列，不记录范围的字段返回-1
+     */
+    int        column_of_offset(int offset) const;
+
+    /**
+     * page_num页上column列的值有没有可能满足 "值 comp_op value"
+     */
+    bool       may_match(PageNum page_num, int column, CompOp comp_op,
+                         const char* value);
+
+    private:
+    struct Column {
+        AttrType type;
+        int      offset;   // 在记录中的偏移量
+        int      len;      // 在记录中的长度
+        int      min_pos;  // 最小值在页面范围中的位置，最大值紧随其后
+        int      zone_len; // 范围中保存一个值的长度，字符串多留一个结束符
+    };
+
+    char* entry(PageNum page_num) {
+        return entries_.data() + (size_t)page_num * entry_size_;
+    }
+
+    private:
+    pthread_mutex_t     mutex_;
+    std::vector<Column> columns_;
+    int                 entry_size_ = 0; // 每个页面范围的大小，第一个字节表示有没有记录
+    std::vector<char>   entries_;        // 按页号依次存放的页面范围
+};
+
+/**
+ * 用ZoneMap跳过页面的过滤器，只使用字段和值比较的条件，其它条件由记录过滤器处理
+ */
+class ZoneMapFilter : public PageFilter {
+    public:
+    /**
+     * @return filter中有没有可以用来跳过页面的条件
+     */
+    bool init(ZoneMap& zone_map, const ConditionFilter* filter);
+
+    bool may_match(PageNum page_num) const override;
+
+    private:
+    struct Predicate {
+        int         column;
+        CompOp      comp_op; // 已经换成 "字段 comp_op 值" 的方向
+        const char* value;
+    };
+
+    void add_predicates(const ConditionFilter* filter);
+
+    private:
+    ZoneMap*               zone_map_ = nullptr;
+    std::vector<Predicate> predicates_;
+};
+
+#endif //__OBSERVER_STORAGE_COMMON_ZONE_MAP_H_
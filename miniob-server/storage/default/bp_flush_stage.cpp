@@ -0,0 +1,151 @@
+/* Copyright (c) 2021 Xie Meiyi(xiemeiyi@hust.edu.cn) and OceanBase and/or its
+affiliates. All rights reserved. miniob is licensed under Mulan PSL v2. You can
+use this software according to the terms and conditions of the Mulan PSL v2. You
+may obtain a copy of Mulan PSL v2 at: http://license.coscl.org.cn/MulanPSL2 THIS
+SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND, EITHER
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include <string>
+
+#include <storage/default/bp_flush_stage.h>
+
+#include <common/conf/ini.h>
+#include <common/lang/string.h>
+#include <common/log/log.h>
+#include <common/seda/timer_stage.h>
+#include <storage/default/disk_buffer_pool.h>
+
+using namespace common;
+
+const char* CONF_BP_FLUSH_INTERVAL  = "FlushIntervalMs";
+const char* CONF_BP_CLEAN_RESERVE   = "CleanReserve";
+const char* CONF_BP_FLUSH_MAX_PAGES = "FlushMaxPages";
+const char* CONF_BP_WARMUP_DUMP_INTERVAL = "WarmupDumpIntervalMs";
+
+//! Constructor
+BufferPoolFlushStage::BufferPoolFlushStage(const char* tag) : Stage(tag) {}
+
+//! Destructor
+BufferPoolFlushStage::~BufferPoolFlushStage() {}
+
+//! Parse properties, instantiate a stage object
+Stage* BufferPoolFlushStage::make_stage(const std::string& tag) {
+    BufferPoolFlushStage* stage =
+        new (std::nothrow) BufferPoolFlushStage(tag.c_str());
+    if (stage == nullptr) {
+        LOG_ERROR("new BufferPoolFlushStage failed");
+        return nullptr;
+    }
+    stage->set_properties();
+    return stage;
+}
+
+//! Set properties for this object set in stage specific properties
+bool BufferPoolFlushStage::set_properties() {
+    std::string                        stage_name_str(stage_name_);
+    std::map<std::string, std::string> section =
+        get_properties()->get(stage_name_str);
+
+    auto it = section.find(CONF_BP_FLUSH_INTERVAL);
+    if (it != section.end()) {
+        str_to_val(it->second, flush_interval_ms_);
+    }
+    it = section.find(CONF_BP_CLEAN_RESERVE);
+    if (it != section.end()) {
+        str_to_val(it->second, clean_reserve_);
+    }
+    it = section.find(CONF_BP_FLUSH_MAX_PAGES);
+    if (it != section.end()) {
+        str_to_val(it->second, flush_max_pages_);
+    }
+    it = section.find(CONF_BP_WARMUP_DUMP_INTERVAL);
+    if (it != section.end()) {
+        str_to_val(it->second, warmup_dump_interval_ms_);
+    }
+
+    if (flush_interval_ms_ <= 0) {
+        LOG_WARN("Invalid flush interval %d, use 100ms", flush_interval_ms_);
+        flush_interval_ms_ = 100;
+    }
+    LOG_INFO("Buffer pool flusher: interval=%dms, clean reserve=%d, max pages=%d, "
+             "warm-up dump interval=%dms",
+             flush_interval_ms_, clean_reserve_, flush_max_pages_,
+             warmup_dump_interval_ms_);
+    return true;
+}
+
+//! Initialize stage params and validate outputs
+bool BufferPoolFlushStage::initialize() {
+    LOG_TRACE("Enter");
+
+    std::list<Stage*>::iterator stgp = next_stage_list_.begin();
+    timer_stage_                     = *(stgp++);
+
+    BufferPoolFlushEvent* flush_event = new BufferPoolFlushEvent();
+    add_event(flush_event);
+
+    LOG_TRACE("Exit");
+    return true;
+}
+
+//! Cleanup after disconnection
+void BufferPoolFlushStage::cleanup() {
+    LOG_TRACE("Enter");
+
+    LOG_TRACE("Exit");
+}
+
+void BufferPoolFlushStage::handle_event(StageEvent* event) {
+    LOG_TRACE("Enter\n");
+
+    CompletionCallback* cb = new (std::nothrow) CompletionCallback(this, nullptr);
+    if (cb == nullptr) {
+        LOG_ERROR("Failed to new callback");
+        event->done();
+        return;
+    }
+
+    TimerRegisterEvent* tm_event = new (std::nothrow) TimerRegisterEvent(
+        event, (u64_t)flush_interval_ms_ * (USEC_PER_SEC / 1000));
+    if (tm_event == nullptr) {
+        LOG_ERROR("Failed to new TimerRegisterEvent");
+        delete cb;
+        event->done();
+        return;
+    }
+
+    event->push_callback(cb);
+    timer_stage_->add_event(tm_event);
+
+    LOG_TRACE("Exit\n");
+}
+
+void BufferPoolFlushStage::callback_event(StageEvent*      event,
+                                          CallbackContext* context) {
+    LOG_TRACE("Enter\n");
+
+    int        flushed_num = 0;
+    ResultCode rc          = theGlobalDiskBufferPool()->flush_dirty_pages(
+        clean_reserve_, flush_max_pages_, &flushed_num);
+    if (rc != ResultCode::SUCCESS) {
+        LOG_WARN("Failed to flush dirty pages in background. rc=%d:%s", rc,
+                 strrc(rc));
+    }
+
+    // 定期保存预热快照，进程异常退出时也有一份不太旧的快照
+    const std::string& warmup_file = DiskBufferPool::get_warmup_file();
+    if (warmup_dump_interval_ms_ > 0 && !warmup_file.empty()) {
+        since_warmup_dump_ms_ += flush_interval_ms_;
+        if (since_warmup_dump_ms_ >= warmup_dump_interval_ms_) {
+            since_warmup_dump_ms_ = 0;
+            theGlobalDiskBufferPool()->dump_resident_pages(warmup_file.c_str());
+        }
+    }
+
+    // do it again.
+    add_event(event);
+
+    LOG_TRACE("Exit\n");
+}
@@ -0,0 +1,59 @@
+/* Copyright (c) 2021 Xie Meiyi(xiemeiyi@hust.edu.cn) and OceanBase and/or its
+affiliates. All rights reserved. miniob is licensed under Mulan PSL v2. You can
+use this software according to the terms and conditions of the Mulan PSL v2. You
+may obtain a copy of Mulan PSL v2 at: http://license.coscl.org.cn/MulanPSL2 THIS
+SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND, EITHER
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#ifndef __OBSERVER_STORAGE_DEFAULT_BP_FLUSH_STAGE_H__
+#define __OBSERVER_STORAGE_DEFAULT_BP_FLUSH_STAGE_H__
+
+#include <common/seda/stage.h>
+#include <common/seda/stage_event.h>
+
+/**
+ * 后台刷脏页的定时事件
+ */
+class BufferPoolFlushEvent : public common::StageEvent {
+    public:
+    BufferPoolFlushEvent() {}
+    ~BufferPoolFlushEvent() {}
+};
+
+/**
+ * 借助TimerStage周期性地把缓冲池中未pin的脏页写回磁盘，
+ * 保证缓冲池里总有一定数量的干净frame，查询线程淘汰页面时不用同步写盘。
+ * 配置了预热快照文件时，也顺便定期保存快照
+ */
+class BufferPoolFlushStage : public common::Stage {
+    public:
+    ~BufferPoolFlushStage();
+    static Stage* make_stage(const std::string& tag);
+
+    protected:
+    // common function
+    BufferPoolFlushStage(const char* tag);
+    bool set_properties() override;
+
+    bool initialize() override;
+    void cleanup() override;
+    void handle_event(common::StageEvent* event) override;
+    void callback_event(common::StageEvent*      event,
+                        common::CallbackContext* context) override;
+
+    private:
+    Stage* timer_stage_             = nullptr;
+    // 每隔 @flush_interval_ms_ 毫秒刷一次
+    int    flush_interval_ms_       = 100;
+    // 希望缓冲池中保留的干净frame个数
+    int    clean_reserve_           = 64;
+    // 每一轮最多写回的页面数
+    int    flush_max_pages_         = 256;
+    // 每隔 @warmup_dump_interval_ms_ 毫秒保存一次预热快照，0表示只在退出时保存
+    int    warmup_dump_interval_ms_ = 60000;
+    int    since_warmup_dump_ms_    = 0;
+};
+
+#endif //__OBSERVER_STORAGE_DEFAULT_BP_FLUSH_STAGE_H__
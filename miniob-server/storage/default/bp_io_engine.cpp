@@ -0,0 +1,314 @@
+/* Copyright (c) 2021 Xie Meiyi(xiemeiyi@hust.edu.cn) and OceanBase and/or its
+affiliates. All rights reserved. miniob is licensed under Mulan PSL v2. You can
+use this software according to the terms and conditions of the Mulan PSL v2. You
+may obtain a copy of Mulan PSL v2 at: http://license.coscl.org.cn/MulanPSL2 THIS
+SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND, EITHER
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include <storage/default/bp_io_engine.h>
+
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+#include <algorithm>
+
+#include <common/lang/mutex.h>
+#include <common/log/log.h>
+
+// 不依赖liburing，直接通过系统调用使用io_uring
+#if defined(__linux__) && __has_include(<linux/io_uring.h>) && \
+    defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter)
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#define BP_HAVE_IO_URING 1
+#endif
+
+BPIoEngine* BPIoEngine::create(const std::string& name) {
+    if (name == BP_IO_ENGINE_URING) {
+        BPUringIoEngine* engine = new BPUringIoEngine();
+        if (engine->init()) {
+            return engine;
+        }
+        delete engine;
+        LOG_WARN("io_uring is not available, fall back to %s io engine",
+                 BP_IO_ENGINE_SYNC);
+    } else if (name != BP_IO_ENGINE_SYNC) {
+        LOG_ERROR("Unknown buffer pool io engine: %s, use %s", name.c_str(),
+                  BP_IO_ENGINE_SYNC);
+    }
+    return new BPSyncIoEngine();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+static ssize_t sync_io(BPIoRequest& request) {
+    ssize_t ret;
+    if (request.iov != nullptr) {
+        if (request.write) {
+            ret = pwritev(request.file_desc, request.iov, request.iov_num,
+                          request.offset);
+        } else {
+            ret = preadv(request.file_desc, request.iov, request.iov_num,
+                         request.offset);
+        }
+    } else if (request.write) {
+        ret = pwrite(request.file_desc, request.buf, request.size, request.offset);
+    } else {
+        ret = pread(request.file_desc, request.buf, request.size, request.offset);
+    }
+    return ret < 0 ? -errno : ret;
+}
+
+void BPSyncIoEngine::submit_and_wait(BPIoRequest* requests, int num) {
+    for (int i = 0; i < num; i++) {
+        requests[i].result = sync_io(requests[i]);
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+#ifdef BP_HAVE_IO_URING
+
+/**
+ * 一个io_uring实例以及映射到用户态的提交队列和完成队列
+ */
+class BPUringRing {
+    public:
+    ~BPUringRing();
+
+    bool     init(unsigned entries);
+    unsigned entries() const { return sq_entries_; }
+
+    /**
+     * 提交num(不超过entries)个请求并等待全部完成，出错时返回false，
+     * 这个ring也就不能再用了
+     */
+    bool     submit_and_wait(BPIoRequest* requests, int num);
+
+    private:
+    int                  ring_fd_    = -1;
+    void*                sq_ptr_     = MAP_FAILED;
+    size_t               sq_size_    = 0;
+    void*                cq_ptr_     = MAP_FAILED;
+    size_t               cq_size_    = 0;
+    struct io_uring_sqe* sqes_       = (struct io_uring_sqe*)MAP_FAILED;
+    size_t               sqes_size_  = 0;
+    unsigned             sq_entries_ = 0;
+
+    unsigned*            sq_tail_    = nullptr;
+    unsigned*            sq_mask_    = nullptr;
+    unsigned*            sq_array_   = nullptr;
+    unsigned*            cq_head_    = nullptr;
+    unsigned*            cq_tail_    = nullptr;
+    unsigned*            cq_mask_    = nullptr;
+    struct io_uring_cqe* cqes_       = nullptr;
+};
+
+BPUringRing::~BPUringRing() {
+    if (sqes_ != MAP_FAILED) {
+        munmap(sqes_, sqes_size_);
+    }
+    if (cq_ptr_ != MAP_FAILED && cq_ptr_ != sq_ptr_) {
+        munmap(cq_ptr_, cq_size_);
+    }
+    if (sq_ptr_ != MAP_FAILED) {
+        munmap(sq_ptr_, sq_size_);
+    }
+    if (ring_fd_ >= 0) {
+        close(ring_fd_);
+    }
+}
+
+bool BPUringRing::init(unsigned entries) {
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    ring_fd_ = (int)syscall(__NR_io_uring_setup, entries, &params);
+    if (ring_fd_ < 0) {
+        LOG_WARN("Failed to setup io_uring, due to %s", strerror(errno));
+        return false;
+    }
+
+    sq_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cq_size_ = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        sq_size_ = cq_size_ = std::max(sq_size_, cq_size_);
+    }
+
+    sq_ptr_ = mmap(nullptr, sq_size_, PROT_READ | PROT_WRITE,
+                   MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQ_RING);
+    if (sq_ptr_ == MAP_FAILED) {
+        LOG_WARN("Failed to mmap io_uring sq ring, due to %s", strerror(errno));
+        return false;
+    }
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        cq_ptr_ = sq_ptr_;
+    } else {
+        cq_ptr_ = mmap(nullptr, cq_size_, PROT_READ | PROT_WRITE,
+                       MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_CQ_RING);
+        if (cq_ptr_ == MAP_FAILED) {
+            LOG_WARN("Failed to mmap io_uring cq ring, due to %s",
+                     strerror(errno));
+            return false;
+        }
+    }
+
+    sqes_size_ = params.sq_entries * sizeof(struct io_uring_sqe);
+    sqes_      = (struct io_uring_sqe*)mmap(
+        nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+        ring_fd_, IORING_OFF_SQES);
+    if (sqes_ == MAP_FAILED) {
+        LOG_WARN("Failed to mmap io_uring sqes, due to %s", strerror(errno));
+        return false;
+    }
+
+    char* sq    = (char*)sq_ptr_;
+    char* cq    = (char*)cq_ptr_;
+    sq_entries_ = params.sq_entries;
+    sq_tail_    = (unsigned*)(sq + params.sq_off.tail);
+    sq_mask_    = (unsigned*)(sq + params.sq_off.ring_mask);
+    sq_array_   = (unsigned*)(sq + params.sq_off.array);
+    cq_head_    = (unsigned*)(cq + params.cq_off.head);
+    cq_tail_    = (unsigned*)(cq + params.cq_off.tail);
+    cq_mask_    = (unsigned*)(cq + params.cq_off.ring_mask);
+    cqes_       = (struct io_uring_cqe*)(cq + params.cq_off.cqes);
+    return true;
+}
+
+bool BPUringRing::submit_and_wait(BPIoRequest* requests, int num) {
+    // 一个ring只有一个线程在用，提交队列的tail只有自己会改
+    unsigned tail = *sq_tail_;
+    for (int i = 0; i < num; i++) {
+        unsigned             index = tail & *sq_mask_;
+        struct io_uring_sqe* sqe   = &sqes_[index];
+        memset(sqe, 0, sizeof(*sqe));
+        if (requests[i].iov != nullptr) {
+            sqe->opcode = requests[i].write ? IORING_OP_WRITEV : IORING_OP_READV;
+            sqe->addr   = (unsigned long)requests[i].iov;
+            sqe->len    = (unsigned)requests[i].iov_num;
+        } else {
+            sqe->opcode = requests[i].write ? IORING_OP_WRITE : IORING_OP_READ;
+            sqe->addr   = (unsigned long)requests[i].buf;
+            sqe->len    = (unsigned)requests[i].size;
+        }
+        sqe->fd         = requests[i].file_desc;
+        sqe->off        = (unsigned long long)requests[i].offset;
+        sqe->user_data  = (unsigned long long)i;
+        sq_array_[index] = index;
+        tail++;
+    }
+    __atomic_store_n(sq_tail_, tail, __ATOMIC_RELEASE);
+
+    int to_submit = num;
+    int completed = 0;
+    while (completed < num) {
+        int ret = (int)syscall(__NR_io_uring_enter, ring_fd_, to_submit,
+                               num - completed, IORING_ENTER_GETEVENTS,
+                               nullptr, 0);
+        if (ret < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            LOG_ERROR("Failed to enter io_uring, due to %s", strerror(errno));
+            return false;
+        }
+        to_submit -= std::min(ret, to_submit);
+
+        unsigned head     = *cq_head_;
+        unsigned cq_tail  = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+        while (head != cq_tail) {
+            struct io_uring_cqe* cqe = &cqes_[head & *cq_mask_];
+            requests[cqe->user_data].result = cqe->res;
+            head++;
+            completed++;
+        }
+        __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+    }
+
+    // 老内核不认识IORING_OP_READ/WRITE，这些请求改用同步方式
+    for (int i = 0; i < num; i++) {
+        if (requests[i].result == -EINVAL || requests[i].result == -EOPNOTSUPP) {
+            requests[i].result = sync_io(requests[i]);
+        }
+    }
+    return true;
+}
+
+#else
+
+class BPUringRing {
+    public:
+    bool     init(unsigned entries) { return false; }
+    unsigned entries() const { return 0; }
+    bool     submit_and_wait(BPIoRequest* requests, int num) { return false; }
+};
+
+#endif
+
+BPUringIoEngine::BPUringIoEngine(unsigned entries) : entries_(entries) {
+    MUTEX_INIT(&mutex_, nullptr);
+}
+
+BPUringIoEngine::~BPUringIoEngine() {
+    for (BPUringRing* ring : free_rings_) {
+        delete ring;
+    }
+    free_rings_.clear();
+    MUTEX_DESTROY(&mutex_);
+}
+
+bool BPUringIoEngine::init() {
+    BPUringRing* ring = new BPUringRing();
+    if (!ring->init(entries_)) {
+        delete ring;
+        return false;
+    }
+    release_ring(ring);
+    LOG_INFO("io_uring io engine is ready, entries=%u", ring->entries());
+    return true;
+}
+
+BPUringRing* BPUringIoEngine::acquire_ring() {
+    BPUringRing* ring = nullptr;
+    MUTEX_LOCK(&mutex_);
+    if (!free_rings_.empty()) {
+        ring = free_rings_.back();
+        free_rings_.pop_back();
+    }
+    MUTEX_UNLOCK(&mutex_);
+
+    if (ring == nullptr) {
+        ring = new BPUringRing();
+        if (!ring->init(entries_)) {
+            delete ring;
+            ring = nullptr;
+        }
+    }
+    return ring;
+}
+
+void BPUringIoEngine::release_ring(BPUringRing* ring) {
+    MUTEX_LOCK(&mutex_);
+    free_rings_.push_back(ring);
+    MUTEX_UNLOCK(&mutex_);
+}
+
+void BPUringIoEngine::submit_and_wait(BPIoRequest* requests, int num) {
+    BPUringRing* ring = acquire_ring();
+    if (ring == nullptr) {
+        BPSyncIoEngine().submit_and_wait(requests, num);
+        return;
+    }
+
+    for (int begin = 0; begin < num; begin += ring->entries()) {
+        int batch = std::min(num - begin, (int)ring->entries());
+        if (!ring->submit_and_wait(requests + begin, batch)) {
+            // ring已经不可用了，剩下的请求(包括这一批)都同步执行
+            delete ring;
+            BPSyncIoEngine().submit_and_wait(requests + begin, num - begin);
+            return;
+        }
+    }
+    release_ring(ring);
+}
@@ -0,0 +1,104 @@
+/* Copyright (c) 2021 Xie Meiyi(xiemeiyi@hust.edu.cn) and OceanBase and/or its
+affiliates. All rights reserved. miniob is licensed under Mulan PSL v2. You can
+use this software according to the terms and conditions of the Mulan PSL v2. You
+may obtain a copy of Mulan PSL v2 at: http://license.coscl.org.cn/MulanPSL2 THIS
+SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND, EITHER
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#ifndef __OBSERVER_STORAGE_DEFAULT_BP_IO_ENGINE_H_
+#define __OBSERVER_STORAGE_DEFAULT_BP_IO_ENGINE_H_
+
+#include <pthread.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+
+#include <string>
+#include <vector>
+
+
+#define BP_IO_ENGINE_SYNC "sync"
+#define BP_IO_ENGINE_URING "io_uring"
+#define BP_IO_URING_ENTRIES 64
+
+/**
+ * 一次页面读写请求。
+ * iov不为空时是一次向量读写(preadv/pwritev)，数据在iov_num个缓冲区中，
+ * 不使用buf，size是所有缓冲区的总大小
+ */
+struct BPIoRequest {
+    int                 file_desc;
+    bool                write;
+    void*               buf;
+    size_t              size;
+    off_t               offset;
+    // 完成后实际读写的字节数，出错时为-errno
+    ssize_t             result;
+    const struct iovec* iov     = nullptr;
+    int                 iov_num = 0;
+};
+
+/**
+ * 缓冲池的I/O引擎。一批请求一起提交，全部完成后才返回，
+ * 这样一个线程可以同时等待多个页面的读写。实现需要是线程安全的
+ */
+class BPIoEngine {
+    public:
+    virtual ~BPIoEngine() = default;
+
+    /**
+     * 执行requests中的num个请求，等待它们全部完成。每个请求的结果放在result中
+     */
+    virtual void        submit_and_wait(BPIoRequest* requests, int num) = 0;
+
+    virtual const char* name() const = 0;
+
+    /**
+     * 根据名字创建I/O引擎。io_uring不可用(没有编译进来、内核不支持或者被禁止)时
+     * 退回到同步引擎，所以总是返回一个可用的引擎
+     * @param name sync 或 io_uring
+     */
+    static BPIoEngine*  create(const std::string& name);
+};
+
+/**
+ * 用pread/pwrite(向量请求用preadv/pwritev)逐个执行请求
+ */
+class BPSyncIoEngine : public BPIoEngine {
+    public:
+    void        submit_and_wait(BPIoRequest* requests, int num) override;
+    const char* name() const override { return BP_IO_ENGINE_SYNC; }
+};
+
+class BPUringRing;
+
+/**
+ * 基于io_uring的I/O引擎，一批请求用一次io_uring_enter提交并等待。
+ * 每个ring同一时间只给一个线程使用，并发提交的线程各自从空闲列表中拿一个ring，
+ * 不够时再创建新的
+ */
+class BPUringIoEngine : public BPIoEngine {
+    public:
+    explicit BPUringIoEngine(unsigned entries = BP_IO_URING_ENTRIES);
+    ~BPUringIoEngine();
+
+    /**
+     * 创建第一个ring，用来检查当前环境是否支持io_uring
+     */
+    bool        init();
+
+    void        submit_and_wait(BPIoRequest* requests, int num) override;
+    const char* name() const override { return BP_IO_ENGINE_URING; }
+
+    private:
+    BPUringRing* acquire_ring();
+    void         release_ring(BPUringRing* ring);
+
+    private:
+    unsigned                  entries_;
+    pthread_mutex_t           mutex_;
+    std::vector<BPUringRing*> free_rings_;
+};
+
+#endif //__OBSERVER_STORAGE_DEFAULT_BP_IO_ENGINE_H_
@@ -0,0 +1,144 @@
+/* Copyright (c) 2021 Xie Meiyi(xiemeiyi@hust.edu.cn) and OceanBase and/or its
+affiliates. All rights reserved. miniob is licensed under Mulan PSL v2. You can
+use this software according to the terms and conditions of the Mulan PSL v2. You
+may obtain a copy of Mulan PSL v2 at: http://license.coscl.org.cn/MulanPSL2 THIS
+SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND, EITHER
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include <storage/default/bp_page_arena.h>
+
+#include <errno.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#include <algorithm>
+
+#include <common/log/log.h>
+
+/**
+ * 多映射一个大页的大小，再把首尾不对齐的部分还回去，得到按大页对齐的地址
+ */
+static char* mmap_aligned(size_t size) {
+    const size_t map_size = size + BP_HUGE_PAGE_SIZE;
+    char* addr = (char*)mmap(nullptr, map_size, PROT_READ | PROT_WRITE,
+                             MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (addr == (char*)MAP_FAILED) {
+        LOG_ERROR("Failed to mmap %lu bytes for page arena, due to %s",
+                  (unsigned long)map_size, strerror(errno));
+        return nullptr;
+    }
+
+    char* base = (char*)(((unsigned long)addr + BP_HUGE_PAGE_SIZE - 1) &
+                         ~(BP_HUGE_PAGE_SIZE - 1));
+    if (base > addr) {
+        munmap(addr, base - addr);
+    }
+    if (addr + map_size > base + size) {
+        munmap(base + size, addr + map_size - (base + size));
+    }
+    return base;
+}
+
+BPPageArena* BPPageArena::create(size_t size, const std::string& huge_page,
+                                 int min_block, int max_block) {
+    if (huge_page == BP_HUGE_PAGE_OFF || size == 0) {
+        return nullptr;
+    }
+    if (huge_page != BP_HUGE_PAGE_THP && huge_page != BP_HUGE_PAGE_HUGETLB) {
+        LOG_ERROR("Unknown buffer pool huge page mode: %s, use %s",
+                  huge_page.c_str(), BP_HUGE_PAGE_OFF);
+        return nullptr;
+    }
+
+    size = (size + BP_HUGE_PAGE_SIZE - 1) & ~(BP_HUGE_PAGE_SIZE - 1);
+    char* base    = nullptr;
+    bool  hugetlb = false;
+#ifdef MAP_HUGETLB
+    if (huge_page == BP_HUGE_PAGE_HUGETLB) {
+        base = (char*)mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                           MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (base == (char*)MAP_FAILED) {
+            LOG_WARN("Failed to mmap %lu bytes of hugetlb pages, due to %s, "
+                     "fall back to %s",
+                     (unsigned long)size, strerror(errno), BP_HUGE_PAGE_THP);
+            base = nullptr;
+        } else {
+            hugetlb = true;
+        }
+    }
+#endif
+
+    if (base == nullptr) {
+        base = mmap_aligned(size);
+        if (base == nullptr) {
+            return nullptr;
+        }
+#ifdef MADV_HUGEPAGE
+        if (madvise(base, size, MADV_HUGEPAGE) != 0) {
+            LOG_WARN("Failed to madvise transparent huge pages, due to %s",
+                     strerror(errno));
+        }
+#endif
+    }
+    return new BPPageArena(base, size, hugetlb, min_block, max_block);
+}
+
+BPPageArena::BPPageArena(char* base, size_t size, bool hugetlb, int min_block,
+                         int max_block)
+    : base_(base), size_(size), hugetlb_(hugetlb), min_block_(min_block) {
+    max_order_ = order_of(max_block);
+    free_blocks_.resize(max_order_ + 1);
+    for (size_t offset = 0; offset + max_block <= size; offset += max_block) {
+        free_blocks_[max_order_].insert(base_ + offset);
+    }
+}
+
+BPPageArena::~BPPageArena() {
+    munmap(base_, size_);
+}
+
+int BPPageArena::order_of(int size) const {
+    int order = 0;
+    while (block_size(order) < (size_t)size) {
+        order++;
+    }
+    return order;
+}
+
+void* BPPageArena::alloc(int size) {
+    const int order = order_of(size);
+    int       from  = order;
+    while (from <= max_order_ && free_blocks_[from].empty()) {
+        from++;
+    }
+    if (from > max_order_) {
+        return nullptr;
+    }
+
+    char* block = *free_blocks_[from].begin();
+    free_blocks_[from].erase(free_blocks_[from].begin());
+    // 大块一分为二，后一半放回低一阶的空闲集合，直到大小合适
+    while (from > order) {
+        from--;
+        free_blocks_[from].insert(block + block_size(from));
+    }
+    return block;
+}
+
+void BPPageArena::free(void* ptr, int size) {
+    char* block = (char*)ptr;
+    int   order = order_of(size);
+    while (order < max_order_) {
+        char* buddy = base_ + ((block - base_) ^ block_size(order));
+        auto  iter  = free_blocks_[order].find(buddy);
+        if (iter == free_blocks_[order].end()) {
+            break;
+        }
+        free_blocks_[order].erase(iter);
+        block = std::min(block, buddy);
+        order++;
+    }
+    free_blocks_[order].insert(block);
+}
@@ -0,0 +1,85 @@
+/* Copyright (c) 2021 Xie Meiyi(xiemeiyi@hust.edu.cn) and OceanBase and/or its
+affiliates. All rights reserved. miniob is licensed under Mulan PSL v2. You can
+use this software according to the terms and conditions of the Mulan PSL v2. You
+may obtain a copy of Mulan PSL v2 at: http://license.coscl.org.cn/MulanPSL2 THIS
+SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND, EITHER
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#ifndef __OBSERVER_STORAGE_DEFAULT_BP_PAGE_ARENA_H_
+#define __OBSERVER_STORAGE_DEFAULT_BP_PAGE_ARENA_H_
+
+#include <stddef.h>
+
+#include <set>
+#include <string>
+#include <vector>
+
+#define BP_HUGE_PAGE_OFF "off"
+#define BP_HUGE_PAGE_THP "thp"
+#define BP_HUGE_PAGE_HUGETLB "hugetlb"
+// x86-64和aarch64默认的大页大小，arena的起始地址和大小都按它对齐
+#define BP_HUGE_PAGE_SIZE (2UL << 20)
+
+/**
+ * 页面缓冲区使用的一整块mmap内存。
+ * 用大页映射时，多GB的缓冲池只需要很少的TLB项。
+ * 内部是一个伙伴分配器，块大小是min_block到max_block之间2的幂，
+ * 每个块都按自己的大小对齐，可以直接用于O_DIRECT读写。
+ * 不是线程安全的，由所属的分片在latch保护下使用
+ */
+class BPPageArena {
+    public:
+    ~BPPageArena();
+
+    /**
+     * 创建一个至少size字节的arena
+     * @param huge_page off、thp 或 hugetlb。thp通过madvise使用透明大页，
+     *                  hugetlb使用预留的大页，申请不到时退回thp
+     * @return huge_page是off或者mmap失败时返回nullptr，调用者改用普通的堆内存
+     */
+    static BPPageArena* create(size_t size, const std::string& huge_page,
+                               int min_block, int max_block);
+
+    /**
+     * 分配一个size字节的块，size必须是min_block到max_block之间2的幂。
+     * arena用完时返回nullptr
+     */
+    void*               alloc(int size);
+
+    /**
+     * 归还alloc分配的块，size需要和分配时相同。空闲的伙伴块会合并起来
+     */
+    void                free(void* ptr, int size);
+
+    bool                contains(const void* ptr) const {
+        return (const char*)ptr >= base_ && (const char*)ptr < base_ + size_;
+    }
+
+    size_t              size() const { return size_; }
+
+    /**
+     * 实际使用的是不是hugetlb大页
+     */
+    bool                hugetlb() const { return hugetlb_; }
+
+    private:
+    BPPageArena(char* base, size_t size, bool hugetlb, int min_block,
+                int max_block);
+
+    int                 order_of(int size) const;
+    size_t              block_size(int order) const { return (size_t)min_block_ << order; }
+
+    private:
+    char*                        base_;
+    size_t                       size_;
+    bool                         hugetlb_;
+    int                          min_block_;
+    int                          max_order_;
+    // 下标是块的阶，块大小是min_block << 阶。用有序集合是为了合并时能找到伙伴，
+    // 并且优先分配低地址的块
+    std::vector<std::set<char*>> free_blocks_;
+};
+
+#endif //__OBSERVER_STORAGE_DEFAULT_BP_PAGE_ARENA_H_
@@ -0,0 +1,159 @@
+/* Copyright (c) 2021 Xie Meiyi(xiemeiyi@hust.edu.cn) and OceanBase and/or its
+affiliates. All rights reserved. miniob is licensed under Mulan PSL v2. You can
+use this software according to the terms and conditions of the Mulan PSL v2. You
+may obtain a copy of Mulan PSL v2 at: http://license.coscl.org.cn/MulanPSL2 THIS
+SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND, EITHER
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include <storage/default/bp_replacer.h>
+
+#include <common/log/log.h>
+
+BPReplacer* BPReplacer::create(const std::string& name, int k) {
+    if (name == BP_REPLACER_CLOCK) {
+        return new BPClockReplacer();
+    }
+    if (name == BP_REPLACER_LRU_K) {
+        if (k <= 0) {
+            LOG_WARN("Invalid k %d of lru-k replacer, use %d", k,
+                     BP_REPLACER_DEFAULT_K);
+            k = BP_REPLACER_DEFAULT_K;
+        }
+        return new BPLruKReplacer(k);
+    }
+    LOG_ERROR("Unknown buffer pool replacer: %s", name.c_str());
+    return nullptr;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+BPClockReplacer::BPClockReplacer() : hand_(ring_.end()) {}
+
+void BPClockReplacer::insert(Frame* frame) {
+    if (entries_.find(frame) != entries_.end()) {
+        access(frame);
+        return;
+    }
+
+    // 插入到时钟指针之前，指针要转一圈才会再次扫到它
+    auto pos = ring_.insert(hand_, frame);
+    entries_[frame] = Entry{pos, true};
+}
+
+void BPClockReplacer::access(Frame* frame) {
+    auto it = entries_.find(frame);
+    if (it != entries_.end()) {
+        it->second.referenced = true;
+    }
+}
+
+void BPClockReplacer::remove(Frame* frame) {
+    auto it = entries_.find(frame);
+    if (it == entries_.end()) {
+        return;
+    }
+
+    if (hand_ == it->second.pos) {
+        ++hand_;
+    }
+    ring_.erase(it->second.pos);
+    entries_.erase(it);
+}
+
+Frame* BPClockReplacer::victim() {
+    // 最多扫两圈：第一圈清除引用位，第二圈一定能找到可以淘汰的frame
+    const size_t max_steps = ring_.size() * 2;
+    for (size_t i = 0; i < max_steps; i++) {
+        if (hand_ == ring_.end()) {
+            hand_ = ring_.begin();
+        }
+
+        Frame* frame = *hand_;
+        Entry& entry = entries_[frame];
+        ++hand_;
+
+        if (!frame->can_purge()) {
+            continue;
+        }
+        if (entry.referenced) {
+            entry.referenced = false;
+            continue;
+        }
+        return frame;
+    }
+    return nullptr;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+BPLruKReplacer::BPLruKReplacer(int k) : k_(k) {}
+
+BPLruKReplacer::EvictKey BPLruKReplacer::evict_key(Frame*       frame,
+                                                   const Entry& entry) const {
+    // history.front() 是最近k次访问中最早的一次
+    return EvictKey((int)entry.history.size() >= k_, entry.history.front(), frame);
+}
+
+void BPLruKReplacer::insert(Frame* frame) {
+    bool inserted = entries_.emplace(frame, Entry()).second;
+    access(frame);
+    if (inserted && frame->can_purge()) {
+        unpin(frame);
+    }
+}
+
+void BPLruKReplacer::access(Frame* frame) {
+    auto it = entries_.find(frame);
+    if (it == entries_.end()) {
+        return;
+    }
+
+    // 访问时间变了，在有序集合中的位置也要跟着变
+    Entry& entry = it->second;
+    if (entry.evictable) {
+        evictable_.erase(evict_key(frame, entry));
+    }
+    entry.history.push_back(++clock_);
+    if ((int)entry.history.size() > k_) {
+        entry.history.pop_front();
+    }
+    if (entry.evictable) {
+        evictable_.insert(evict_key(frame, entry));
+    }
+}
+
+void BPLruKReplacer::remove(Frame* frame) {
+    auto it = entries_.find(frame);
+    if (it == entries_.end()) {
+        return;
+    }
+    if (it->second.evictable) {
+        evictable_.erase(evict_key(frame, it->second));
+    }
+    entries_.erase(it);
+}
+
+void BPLruKReplacer::pin(Frame* frame) {
+    auto it = entries_.find(frame);
+    if (it == entries_.end() || !it->second.evictable) {
+        return;
+    }
+    evictable_.erase(evict_key(frame, it->second));
+    it->second.evictable = false;
+}
+
+void BPLruKReplacer::unpin(Frame* frame) {
+    auto it = entries_.find(frame);
+    if (it == entries_.end() || it->second.evictable) {
+        return;
+    }
+    it->second.evictable = true;
+    evictable_.insert(evict_key(frame, it->second));
+}
+
+Frame* BPLruKReplacer::victim() {
+    if (evictable_.empty()) {
+        return nullptr;
+    }
+    return std::get<2>(*evictable_.begin());
+}
@@ -0,0 +1,138 @@
+/* Copyright (c) 2021 Xie Meiyi(xiemeiyi@hust.edu.cn) and OceanBase and/or its
+affiliates. All rights reserved. miniob is licensed under Mulan PSL v2. You can
+use this software according to the terms and conditions of the Mulan PSL v2. You
+may obtain a copy of Mulan PSL v2 at: http://license.coscl.org.cn/MulanPSL2 THIS
+SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND, EITHER
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#ifndef __OBSERVER_STORAGE_DEFAULT_BP_REPLACER_H_
+#define __OBSERVER_STORAGE_DEFAULT_BP_REPLACER_H_
+
+#include <deque>
+#include <list>
+#include <set>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+
+#include <storage/default/disk_buffer_pool.h>
+
+#define BP_REPLACER_CLOCK "clock"
+#define BP_REPLACER_LRU_K "lru-k"
+#define BP_REPLACER_DEFAULT_K 2
+
+/**
+ * 缓冲池的页面置换策略。
+ * 所有接口都由BPManager在持有自身锁的情况下调用，实现不需要再加锁
+ */
+class BPReplacer {
+    public:
+    virtual ~BPReplacer() = default;
+
+    /**
+     * frame开始缓存一个页面
+     */
+    virtual void   insert(Frame* frame) = 0;
+
+    /**
+     * frame缓存的页面被访问了一次
+     */
+    virtual void   access(Frame* frame) = 0;
+
+    /**
+     * frame不再缓存页面
+     */
+    virtual void   remove(Frame* frame) = 0;
+
+    /**
+     * frame的pin_count从0变成1，不能再被淘汰
+     */
+    virtual void   pin(Frame* frame) {}
+
+    /**
+     * frame的pin_count降到了0，又可以被淘汰了
+     */
+    virtual void   unpin(Frame* frame) {}
+
+    /**
+     * 选择一个可以淘汰(没有被pin住)的frame，没有的话返回nullptr。
+     * 被选中的frame不会从策略中删除，直到调用remove
+     */
+    virtual Frame* victim() = 0;
+
+    virtual const char* name() const = 0;
+
+    /**
+     * 根据名字创建置换策略，不认识的名字返回nullptr
+     * @param name clock 或 lru-k
+     * @param k    lru-k 策略使用的k值
+     */
+    static BPReplacer*  create(const std::string& name, int k);
+};
+
+/**
+ * CLOCK(second chance)。每次访问设置引用位，时钟指针扫过时清除引用位，
+ * 淘汰第一个引用位已经清除且没有被pin住的frame
+ */
+class BPClockReplacer : public BPReplacer {
+    public:
+    BPClockReplacer();
+
+    void        insert(Frame* frame) override;
+    void        access(Frame* frame) override;
+    void        remove(Frame* frame) override;
+    Frame*      victim() override;
+    const char* name() const override { return BP_REPLACER_CLOCK; }
+
+    private:
+    struct Entry {
+        std::list<Frame*>::iterator pos;
+        bool                        referenced;
+    };
+
+    std::list<Frame*>                  ring_;
+    std::list<Frame*>::iterator        hand_;
+    std::unordered_map<Frame*, Entry>  entries_;
+};
+
+/**
+ * LRU-K。淘汰倒数第k次访问时间最早的frame；访问次数不足k次的frame
+ * 认为距离无穷大，优先淘汰，它们之间按最早一次访问时间排序。
+ * 大表扫描只访问页面一次，因此不会把访问过多次的索引页面挤出去。
+ * 可以淘汰的frame按淘汰顺序放在有序集合中，victim的时间复杂度是O(log n)
+ */
+class BPLruKReplacer : public BPReplacer {
+    public:
+    explicit BPLruKReplacer(int k);
+
+    void        insert(Frame* frame) override;
+    void        access(Frame* frame) override;
+    void        remove(Frame* frame) override;
+    void        pin(Frame* frame) override;
+    void        unpin(Frame* frame) override;
+    Frame*      victim() override;
+    const char* name() const override { return BP_REPLACER_LRU_K; }
+
+    int         k() const { return k_; }
+
+    private:
+    struct Entry {
+        std::deque<unsigned long> history;           // 最近k次访问的时间
+        bool                      evictable = false; // 是否在evictable_中
+    };
+
+    // (是否访问满k次, 最近k次访问中最早的一次, frame)，按淘汰顺序排列
+    typedef std::tuple<bool, unsigned long, Frame*> EvictKey;
+
+    EvictKey    evict_key(Frame* frame, const Entry& entry) const;
+
+    private:
+    int                                k_;
+    unsigned long                      clock_ = 0;
+    std::unordered_map<Frame*, Entry> entries_;
+    std::set<EvictKey>                 evictable_;
+};
+
+#endif //__OBSERVER_STORAGE_DEFAULT_BP_REPLACER_H_
@@ -155,6 +155,16 @@ ResultCode DefaultHandler::insert_record(Transaction* transaction, const char* d
 
     return table->insert_record(transaction, value_num, values);
 }
+ResultCode DefaultHandler::insert_records(Transaction* transaction, const char* dbname,
+                                  const char* relation_name, int record_num,
+                                  int value_num, const Value* values) {
+    Table* table = find_table(dbname, relation_name);
+    if (nullptr == table) {
+        return ResultCode::SCHEMA_TABLE_NOT_EXIST;
+    }
+
+    return table->insert_records(transaction, record_num, value_num, values);
+}
 ResultCode DefaultHandler::delete_record(Transaction* transaction, const char* dbname,
                                  const char* relation_name, int condition_num,
                                  const Condition* conditions,
@@ -186,6 +196,16 @@ ResultCode DefaultHandler::update_record(Transaction* transaction, const char* d
                                 conditions, updated_count);
 }
 
+ResultCode DefaultHandler::vacuum_table(const char* dbname, const char* relation_name,
+                                        int* moved_pages) {
+    Table* table = find_table(dbname, relation_name);
+    if (nullptr == table) {
+        return ResultCode::SCHEMA_TABLE_NOT_EXIST;
+    }
+
+    return table->vacuum(0, moved_pages);
+}
+
 Db* DefaultHandler::find_db(const char* dbname) const {
     std::map<std::string, Db*>::const_iterator iter = opened_dbs_.find(dbname);
     if (iter == opened_dbs_.end()) {
@@ -221,4 +241,32 @@ ResultCode DefaultHandler::sync() {
         }
     }
     return rc;
-}
\ No newline at end of file
+}
+
+ResultCode DefaultHandler::vacuum(int max_pages, int* moved_pages) {
+    *moved_pages = 0;
+    for (const auto& db_pair : opened_dbs_) {
+        Db*                      db = db_pair.second;
+        std::vector<std::string> table_names;
+        db->all_tables(table_names);
+        for (const std::string& table_name : table_names) {
+            Table* table = db->find_table(table_name.c_str());
+            if (table == nullptr || !table->need_vacuum()) {
+                continue;
+            }
+
+            int        moved = 0;
+            ResultCode rc    = table->vacuum(max_pages, &moved);
+            if (rc == ResultCode::LOCKED) {
+                continue; // 等事务结束以后再整理
+            }
+            if (rc != ResultCode::SUCCESS) {
+                LOG_ERROR("Failed to vacuum table. db=%s, table=%s, rc=%d:%s",
+                          db->name(), table_name.c_str(), rc, strrc(rc));
+                return rc;
+            }
+            *moved_pages += moved;
+        }
+    }
+    return ResultCode::SUCCESS;
+}
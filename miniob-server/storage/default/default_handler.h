@@ -127,6 +127,13 @@ class DefaultHandler {
     ResultCode insert_record(Transaction* transaction, const char* dbname, const char* relation_name,
                      int value_num, const Value* values);
 
+    /**
+     * 在一个事务中批量插入record_num行，values按行依次存放，每行value_num个值。
+     * 任何一行插入失败时，整批都不会插入
+     */
+    ResultCode insert_records(Transaction* transaction, const char* dbname, const char* relation_name,
+                      int record_num, int value_num, const Value* values);
+
     /**
      * 该函数用来删除relName表中所有满足指定条件的元组以及该元组对应的索引项。
      * 如果没有指定条件，则此方法删除relName关系中所有元组。
@@ -157,12 +164,27 @@ class DefaultHandler {
                      int condition_num, const Condition* conditions,
                      int* updated_count);
 
+    /**
+     * 整理relName表的数据文件，把记录集中到前面的页面，释放空出来的页面
+     * @param relName
+     * @param moved_pages 返回搬空的页面数
+     * @return
+     */
+    ResultCode vacuum_table(const char* dbname, const char* relation_name, int* moved_pages);
+
     public:
     Db*    find_db(const char* dbname) const;
     Table* find_table(const char* dbname, const char* table_name) const;
 
     ResultCode     sync();
 
+    /**
+     * 后台整理所有打开的表，跳过上次整理以后没有变化的表和还有事务没有结束的表
+     * @param max_pages 每个表最多搬空的页面数
+     * @param moved_pages 返回一共搬空的页面数
+     */
+    ResultCode     vacuum(int max_pages, int* moved_pages);
+
     public:
     static DefaultHandler& get_default();
 
@@ -28,10 +28,13 @@ See the Mulan PSL v2 for more details. */
 #include <event/storage_event.h>
 #include <result_code.h>
 #include <session/session.h>
+#include <storage/common/bplus_tree.h>
 #include <storage/common/condition_filter.h>
+#include <storage/common/scan_worker_pool.h>
 #include <storage/common/table.h>
 #include <storage/common/table_meta.h>
 #include <storage/default/default_handler.h>
+#include <storage/default/bp_replacer.h>
 #include <storage/transaction/transaction.h>
 
 using namespace common;
@@ -40,9 +43,26 @@ const std::string DefaultStorageStage::QUERY_METRIC_TAG =
     "DefaultStorageStage.query";
 const char* CONF_BASE_DIR     = "BaseDir";
 const char* CONF_SYSTEM_DB    = "SystemDb";
+const char* CONF_BP_SIZE      = "BufferPoolSize";
+const char* CONF_BP_REPLACER  = "BufferPoolReplacer";
+const char* CONF_BP_LRU_K     = "BufferPoolLruK";
+const char* CONF_BP_SHARDS    = "BufferPoolShards";
+const char* CONF_BP_IO_ENGINE = "BufferPoolIoEngine";
+const char* CONF_BP_HUGE_PAGE = "BufferPoolHugePage";
+const char* CONF_BP_DIRECT_IO = "BufferPoolDirectIo";
+const char* CONF_BP_WARMUP_FILE    = "BufferPoolWarmupFile";
+const char* CONF_BP_WARMUP_THREADS = "BufferPoolWarmupThreads";
+const char* CONF_BP_READAHEAD = "BufferPoolReadAhead";
+const char* CONF_BP_SCAN_RING = "BufferPoolScanRing";
+const char* CONF_INDEX_FILL_FACTOR = "IndexBulkLoadFillFactor";
+const char* CONF_INDEX_SORT_MEMORY = "IndexBulkLoadSortMemory";
+const char* CONF_SCAN_WORKERS      = "ScanWorkers";
 
 const char* DEFAULT_SYSTEM_DB = "sys";
 
+// load data时每次批量插入的行数
+const int LOAD_DATA_BATCH_SIZE = 256;
+
 //! Constructor
 DefaultStorageStage::DefaultStorageStage(const char* tag)
     : Stage(tag), handler_(nullptr) {}
@@ -88,6 +108,107 @@ bool DefaultStorageStage::set_properties() {
         LOG_INFO("Use %s as system db", sys_db);
     }
 
+    iter = section.find(CONF_BP_SIZE);
+    if (iter != section.end()) {
+        unsigned long long pool_size = 0;
+        if (common::str_to_bytes(iter->second, pool_size)) {
+            DiskBufferPool::set_pool_size(pool_size);
+        } else {
+            LOG_ERROR("Invalid %s: %s", CONF_BP_SIZE, iter->second.c_str());
+        }
+    }
+
+    // 打开数据库之前设置好buffer pool的页面置换策略
+    iter = section.find(CONF_BP_REPLACER);
+    if (iter != section.end()) {
+        std::string replacer = iter->second;
+        common::strip(replacer);
+
+        int  lru_k  = BP_REPLACER_DEFAULT_K;
+        auto k_iter = section.find(CONF_BP_LRU_K);
+        if (k_iter != section.end()) {
+            common::str_to_val(k_iter->second, lru_k);
+        }
+        DiskBufferPool::set_replacer(replacer.c_str(), lru_k);
+    }
+
+    iter = section.find(CONF_BP_SHARDS);
+    if (iter != section.end()) {
+        int shard_num = BP_DEFAULT_SHARD_NUM;
+        common::str_to_val(iter->second, shard_num);
+        DiskBufferPool::set_shard_num(shard_num);
+    }
+
+    iter = section.find(CONF_BP_IO_ENGINE);
+    if (iter != section.end()) {
+        std::string io_engine = iter->second;
+        common::strip(io_engine);
+        DiskBufferPool::set_io_engine(io_engine.c_str());
+    }
+
+    iter = section.find(CONF_BP_HUGE_PAGE);
+    if (iter != section.end()) {
+        std::string huge_page = iter->second;
+        common::strip(huge_page);
+        DiskBufferPool::set_huge_page(huge_page.c_str());
+    }
+
+    iter = section.find(CONF_BP_DIRECT_IO);
+    if (iter != section.end()) {
+        std::string direct_io = iter->second;
+        common::strip(direct_io);
+        DiskBufferPool::set_direct_io(direct_io.compare("true") == 0);
+    }
+
+    // 预热快照的路径是相对于BaseDir的
+    iter = section.find(CONF_BP_WARMUP_FILE);
+    if (iter != section.end()) {
+        std::string warmup_file = iter->second;
+        common::strip(warmup_file);
+        if (!warmup_file.empty() && warmup_file[0] != '/') {
+            warmup_file = std::string(base_dir) + "/" + warmup_file;
+        }
+        DiskBufferPool::set_warmup_file(warmup_file.c_str());
+    }
+
+    iter = section.find(CONF_BP_READAHEAD);
+    if (iter != section.end()) {
+        int readahead_pages = BP_DEFAULT_READAHEAD_PAGES;
+        common::str_to_val(iter->second, readahead_pages);
+        DiskBufferPool::set_readahead_pages(readahead_pages);
+    }
+
+    iter = section.find(CONF_BP_SCAN_RING);
+    if (iter != section.end()) {
+        int scan_ring_pages = BP_DEFAULT_SCAN_RING_PAGES;
+        common::str_to_val(iter->second, scan_ring_pages);
+        DiskBufferPool::set_scan_ring_pages(scan_ring_pages);
+    }
+
+    iter = section.find(CONF_INDEX_FILL_FACTOR);
+    if (iter != section.end()) {
+        int fill_factor = BPLUS_TREE_DEFAULT_FILL_FACTOR;
+        common::str_to_val(iter->second, fill_factor);
+        BplusTreeHandler::set_bulk_load_fill_factor(fill_factor);
+    }
+
+    iter = section.find(CONF_INDEX_SORT_MEMORY);
+    if (iter != section.end()) {
+        unsigned long long sort_memory = 0;
+        if (common::str_to_bytes(iter->second, sort_memory)) {
+            BplusTreeSorter::set_memory_limit(sort_memory);
+        } else {
+            LOG_ERROR("Invalid %s: %s", CONF_INDEX_SORT_MEMORY, iter->second.c_str());
+        }
+    }
+
+    iter = section.find(CONF_SCAN_WORKERS);
+    if (iter != section.end()) {
+        int scan_workers = SCAN_DEFAULT_WORKERS;
+        common::str_to_val(iter->second, scan_workers);
+        ScanWorkerPool::set_worker_num(scan_workers);
+    }
+
     handler_ = &DefaultHandler::get_default();
     if (ResultCode::SUCCESS != handler_->init(base_dir)) {
         LOG_ERROR("Failed to init default handler");
@@ -109,6 +230,23 @@ bool DefaultStorageStage::set_properties() {
     Session& default_session = Session::default_session();
     default_session.set_current_db(sys_db);
 
+    // 在开始接受连接之前，按上次保存的快照把热页面读回缓冲池
+    const std::string& warmup_file = DiskBufferPool::get_warmup_file();
+    if (!warmup_file.empty()) {
+        int warmup_threads = BP_DEFAULT_WARMUP_THREADS;
+        iter               = section.find(CONF_BP_WARMUP_THREADS);
+        if (iter != section.end()) {
+            common::str_to_val(iter->second, warmup_threads);
+        }
+
+        int        loaded_num = 0;
+        ResultCode rc         = theGlobalDiskBufferPool()->load_resident_pages(
+            warmup_file.c_str(), warmup_threads, &loaded_num);
+        if (rc != ResultCode::SUCCESS) {
+            LOG_WARN("Failed to warm up buffer pool. rc=%d:%s", rc, strrc(rc));
+        }
+    }
+
     LOG_INFO("Open system db success: %s", sys_db);
     return true;
 }
@@ -129,6 +267,12 @@ bool DefaultStorageStage::initialize() {
 void DefaultStorageStage::cleanup() {
     LOG_TRACE("Enter");
 
+    // 正常退出时保存缓冲池中的页面，下次启动时预热
+    const std::string& warmup_file = DiskBufferPool::get_warmup_file();
+    if (handler_ && !warmup_file.empty()) {
+        theGlobalDiskBufferPool()->dump_resident_pages(warmup_file.c_str());
+    }
+
     if (handler_) {
         handler_->destroy();
         handler_ = nullptr;
@@ -167,8 +311,10 @@ void DefaultStorageStage::handle_event(StageEvent* event) {
     case SCF_INSERT: { // insert into
         const Inserts& inserts    = sql->sstr.insertion;
         const char*    table_name = inserts.relation_name;
-        rc = handler_->insert_record(current_transaction, current_db, table_name,
-                                     inserts.value_num, inserts.values);
+        // 多行的insert语句作为一个批量操作插入，一起成功或失败
+        rc = handler_->insert_records(current_transaction, current_db, table_name,
+                                      inserts.record_num, inserts.value_num,
+                                      inserts.values);
         snprintf(response, sizeof(response), "%s\n",
                  rc == ResultCode::SUCCESS ? "SUCCESS" : "FAILURE");
     } break;
@@ -193,6 +339,13 @@ void DefaultStorageStage::handle_event(StageEvent* event) {
         snprintf(response, sizeof(response), "%s\n",
                  rc == ResultCode::SUCCESS ? "SUCCESS" : "FAILURE");
     } break;
+    case SCF_VACUUM: {
+        const char* table_name  = sql->sstr.vacuum_table.relation_name;
+        int         moved_pages = 0;
+        rc = handler_->vacuum_table(current_db, table_name, &moved_pages);
+        snprintf(response, sizeof(response), "%s\n",
+                 rc == ResultCode::SUCCESS ? "SUCCESS" : "FAILURE");
+    } break;
     case SCF_CREATE_TABLE: { // create table
         const CreateTable& create_table = sql->sstr.create_table;
         rc = handler_->create_table(current_db, create_table.relation_name,
@@ -291,21 +444,20 @@ void DefaultStorageStage::callback_event(StageEvent*      event,
 }
 
 /**
- * 从文件中导入数据时使用。尝试向表中插入解析后的一行数据。
+ * 从文件中导入数据时使用。把一行数据解析成Table::insert_records使用的值。
  * @param table  要导入的表
  * @param file_values 从文件中读取到的一行数据，使用分隔符拆分后的几个字段值
- * @param record_values Table::insert_record使用的参数，为了防止频繁的申请内存
+ * @param record_values 返回解析出来的值，有field_num个。失败时已经解析的值会被释放
  * @param errmsg 如果出现错误，通过这个参数返回错误信息
  * @return 成功返回RC::SUCCESS
  */
-ResultCode insert_record_from_file(Table* table, std::vector<std::string>& file_values,
-                           std::vector<Value>& record_values,
-                           std::stringstream&  errmsg) {
+ResultCode parse_record_from_file(Table* table, std::vector<std::string>& file_values,
+                                  Value* record_values, int field_num,
+                                  std::stringstream& errmsg) {
 
-    const int field_num     = record_values.size();
     const int sys_field_num = table->table_meta().sys_field_num();
 
-    if (file_values.size() < record_values.size()) {
+    if ((int)file_values.size() < field_num) {
         return ResultCode::SCHEMA_FIELD_MISSING;
     }
 
@@ -359,15 +511,27 @@ ResultCode insert_record_from_file(Table* table, std::vector<std::string>& file_
             rc = ResultCode::SCHEMA_FIELD_TYPE_MISMATCH;
         } break;
         }
-    }
-
-    if (ResultCode::SUCCESS == rc) {
-        rc = table->insert_record(nullptr, field_num, record_values.data());
         if (rc != ResultCode::SUCCESS) {
-            errmsg << "insert failed.";
+            for (int j = 0; j < i; j++) {
+                value_destroy(&record_values[j]);
+            }
         }
     }
-    for (int i = 0; i < field_num; i++) {
+    return rc;
+}
+
+/**
+ * 把已经解析好的record_num行数据一起插入到表中，然后释放这些值
+ */
+static ResultCode insert_records_from_file(Table* table, int record_num,
+                                           std::vector<Value>& record_values,
+                                           int field_num) {
+    if (record_num == 0) {
+        return ResultCode::SUCCESS;
+    }
+    ResultCode rc = table->insert_records(nullptr, record_num, field_num,
+                                          record_values.data());
+    for (int i = 0; i < record_num * field_num; i++) {
         value_destroy(&record_values[i]);
     }
     return rc;
@@ -398,7 +562,10 @@ std::string DefaultStorageStage::load_data(const char* db_name,
     const int sys_field_num = table->table_meta().sys_field_num();
     const int field_num     = table->table_meta().field_num() - sys_field_num;
 
-    std::vector<Value>       record_values(field_num);
+    // 解析好的行攒够一批再一起插入
+    std::vector<Value>       record_values((size_t)LOAD_DATA_BATCH_SIZE * field_num);
+    int                      batch_num        = 0;
+    int                      batch_first_line = 0;
     std::string              line;
     std::vector<std::string> file_values;
     const std::string        delim("|");
@@ -415,17 +582,47 @@ std::string DefaultStorageStage::load_data(const char* db_name,
         file_values.clear();
         common::split_string(line, delim, file_values);
         std::stringstream errmsg;
-        rc = insert_record_from_file(table, file_values, record_values, errmsg);
+        rc = parse_record_from_file(table, file_values,
+                                    &record_values[(size_t)batch_num * field_num],
+                                    field_num, errmsg);
         if (rc != ResultCode::SUCCESS) {
             result_string << "Line:" << line_num
                           << " insert record failed:" << errmsg.str()
                           << ". error:" << strrc(rc) << std::endl;
+            break;
+        }
+        if (batch_num == 0) {
+            batch_first_line = line_num;
+        }
+        if (++batch_num < LOAD_DATA_BATCH_SIZE) {
+            continue;
+        }
+
+        rc = insert_records_from_file(table, batch_num, record_values, field_num);
+        if (rc != ResultCode::SUCCESS) {
+            result_string << "Line:" << batch_first_line << "-" << line_num
+                          << " insert records failed. error:" << strrc(rc)
+                          << std::endl;
         } else {
-            insertion_count++;
+            insertion_count += batch_num;
         }
+        batch_num = 0;
     }
     fs.close();
 
+    // 出错之前解析好的行也要插入
+    ResultCode tmp = insert_records_from_file(table, batch_num, record_values, field_num);
+    if (tmp != ResultCode::SUCCESS) {
+        result_string << "Line:" << batch_first_line << "-" << line_num
+                      << " insert records failed. error:" << strrc(tmp)
+                      << std::endl;
+        if (rc == ResultCode::SUCCESS) {
+            rc = tmp;
+        }
+    } else {
+        insertion_count += batch_num;
+    }
+
     struct timespec end_time;
     clock_gettime(CLOCK_MONOTONIC, &end_time);
     long cost_nano = (end_time.tv_sec - begin_time.tv_sec) * 1000000000L +
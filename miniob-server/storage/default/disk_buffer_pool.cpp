@@ -11,16 +11,37 @@ See the Mulan PSL v2 for more details. */
 // Created by Meiyi & Longda on 2021/4/13.
 //
 #include <storage/default/disk_buffer_pool.h>
+#include <storage/default/bp_io_engine.h>
+#include <storage/default/bp_page_arena.h>
+#include <storage/default/bp_replacer.h>
 #include <errno.h>
 #include <string.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <thread>
 
 #include <common/lang/mutex.h>
 #include <common/log/log.h>
+#include <common/metrics/metrics_registry.h>
 #include <common/os/os.h>
 
 using namespace common;
 
-int           DiskBufferPool::POOL_NUM = MAX_OPEN_FILE / 4;
+unsigned long long DiskBufferPool::POOL_SIZE = BP_DEFAULT_POOL_SIZE;
+int           DiskBufferPool::SHARD_NUM = BP_DEFAULT_SHARD_NUM;
+std::string   DiskBufferPool::REPLACER = BP_REPLACER_CLOCK;
+int           DiskBufferPool::LRU_K    = BP_REPLACER_DEFAULT_K;
+int           DiskBufferPool::READAHEAD_PAGES = BP_DEFAULT_READAHEAD_PAGES;
+int           DiskBufferPool::SCAN_RING_PAGES = BP_DEFAULT_SCAN_RING_PAGES;
+std::string   DiskBufferPool::IO_ENGINE = BP_IO_ENGINE_SYNC;
+std::string   DiskBufferPool::HUGE_PAGE = BP_HUGE_PAGE_OFF;
+bool          DiskBufferPool::DIRECT_IO = false;
+std::string   DiskBufferPool::WARMUP_FILE;
 
 unsigned long current_time() {
     struct timespec tp;
@@ -28,6 +49,115 @@ unsigned long current_time() {
     return tp.tv_sec * 1000 * 1000 * 1000UL + tp.tv_nsec;
 }
 
+/**
+ * 从start(current_time()的返回值)到现在经过的微秒数
+ */
+static long elapsed_us(unsigned long start) {
+    return (long)((current_time() - start) / 1000);
+}
+
+/**
+ * 被pin住的frame数，做snapshot时现数一遍
+ */
+class BPPinnedGauge : public Gauge {
+    public:
+    BPPinnedGauge(DiskBufferPool* bp, int file_desc)
+        : bp_(bp), file_desc_(file_desc) {}
+    virtual ~BPPinnedGauge() { delete snapshot_value_; }
+
+    void snapshot() {
+        std::map<int, BPFrameCounts> counts;
+        bp_->count_frames(counts);
+        long pinned = counts[file_desc_].pinned;
+        if (snapshot_value_ == nullptr) {
+            snapshot_value_ = new SnapshotBasic<long>();
+        }
+        ((SnapshotBasic<long>*)snapshot_value_)->setValue(pinned);
+    }
+
+    private:
+    DiskBufferPool* bp_;
+    int             file_desc_;
+};
+
+BPStats::BPStats(const std::string& prefix, DiskBufferPool* bp, int file_desc)
+    : pinned_gauge_(new BPPinnedGauge(bp, file_desc)) {
+    const std::pair<const char*, Metric*> metrics[] = {
+        {"hit", &hit_meter_},
+        {"miss", &miss_meter_},
+        {"evict", &evict_meter_},
+        {"read_us", &read_timer_},
+        {"write_us", &write_timer_},
+        {"pinned", pinned_gauge_},
+    };
+    // 同一进程中有多个缓冲池时(比如单元测试)，只有第一个能注册上
+    MetricsRegistry& metrics_registry = get_metrics_registry();
+    for (const auto& metric : metrics) {
+        std::string tag = prefix + "." + metric.first;
+        if (metrics_registry.register_metric(tag, metric.second)) {
+            tags_.push_back(tag);
+        }
+    }
+}
+
+BPStats::~BPStats() {
+    MetricsRegistry& metrics_registry = get_metrics_registry();
+    for (const std::string& tag : tags_) {
+        metrics_registry.unregister(tag);
+    }
+    delete pinned_gauge_;
+}
+
+/**
+ * 在作用域内持有一个pthread mutex
+ */
+class MutexGuard {
+    public:
+    explicit MutexGuard(pthread_mutex_t* mutex) : mutex_(mutex) {
+        MUTEX_LOCK(mutex_);
+    }
+    ~MutexGuard() { MUTEX_UNLOCK(mutex_); }
+
+    private:
+    pthread_mutex_t* mutex_;
+};
+
+/**
+ * 按BP_PAGE_ALIGN对齐的临时缓冲区，O_DIRECT要求读写的内存地址也是对齐的
+ */
+class AlignedBuffer {
+    public:
+    explicit AlignedBuffer(size_t size) {
+        if (posix_memalign(&data_, BP_PAGE_ALIGN, size) != 0) {
+            data_ = nullptr;
+        }
+    }
+    ~AlignedBuffer() { ::free(data_); }
+
+    char* data() const { return (char*)data_; }
+
+    private:
+    void* data_ = nullptr;
+};
+
+/**
+ * 打开数据文件。开启了DIRECT_IO时带上O_DIRECT，
+ * 文件系统不支持O_DIRECT(比如一些内存文件系统)时退回普通的缓冲I/O
+ */
+static int open_data_file(const char* file_name, bool direct_io) {
+#ifdef O_DIRECT
+    if (direct_io) {
+        int fd = open(file_name, O_RDWR | O_DIRECT);
+        if (fd >= 0 || errno != EINVAL) {
+            return fd;
+        }
+        LOG_WARN("Failed to open %s with O_DIRECT, fall back to buffered io.",
+                 file_name);
+    }
+#endif
+    return open(file_name, O_RDWR);
+}
+
 BPFileHandle::BPFileHandle() { memset((void*)this, 0, sizeof(*this)); }
 
 BPFileHandle::~BPFileHandle() {
@@ -37,40 +167,197 @@ BPFileHandle::~BPFileHandle() {
     }
 }
 
-BPManager::BPManager(const char* name) : MemPoolSimple<Frame>(name) {}
+BPManager::BPManager(const char* name)
+    : MemPoolSimple<Frame>(name), replacer_(new BPClockReplacer()) {
+    pthread_cond_init(&io_cond_, nullptr);
+}
+
+BPManager::~BPManager() {
+    // 基类析构时frame里不能再有arena中的页面缓冲区
+    cleanup();
+    pthread_cond_destroy(&io_cond_);
+    delete replacer_;
+    replacer_ = nullptr;
+    delete arena_;
+    arena_ = nullptr;
+}
 
-static bool match_purge(void* item, void* arg) {
-    Frame* frame = (Frame*)item;
-    return frame->can_purge();
+void BPManager::set_replacer(BPReplacer* replacer) {
+    MUTEX_LOCK(&this->mutex);
+    for (auto& iter : page_table_) {
+        replacer->insert(iter.second);
+    }
+    delete replacer_;
+    replacer_ = replacer;
+    MUTEX_UNLOCK(&this->mutex);
 }
 
-Frame* BPManager::begin_purge() {
-    return MemPoolSimple<Frame>::find(match_purge, nullptr);
+void BPManager::access(Frame* frame) {
+    MUTEX_LOCK(&this->mutex);
+    replacer_->access(frame);
+    MUTEX_UNLOCK(&this->mutex);
 }
 
-struct MatchFilePage {
-    MatchFilePage(int file_desc, PageNum page_num) {
-        this->file_desc = file_desc;
-        this->page_num  = page_num;
+void BPManager::pin(Frame* frame) {
+    MUTEX_LOCK(&this->mutex);
+    if (frame->pin_count++ == 0) {
+        replacer_->pin(frame);
     }
-    int     file_desc;
-    PageNum page_num;
-};
+    MUTEX_UNLOCK(&this->mutex);
+}
 
-static bool match_file_page(void* item, void* arg) {
-    Frame*         frame     = (Frame*)item;
-    MatchFilePage* file_page = (MatchFilePage*)arg;
+bool BPManager::unpin(Frame* frame) {
+    MUTEX_LOCK(&this->mutex);
+    bool unpinned = --frame->pin_count == 0;
+    if (unpinned) {
+        replacer_->unpin(frame);
+    }
+    MUTEX_UNLOCK(&this->mutex);
+    return unpinned;
+}
 
-    if (frame->file_desc == file_page->file_desc &&
-        frame->page.page_num == file_page->page_num)
+Frame* BPManager::begin_purge() {
+    MUTEX_LOCK(&this->mutex);
+    Frame* frame = replacer_->victim();
+    MUTEX_UNLOCK(&this->mutex);
+    return frame;
+}
+
+Frame* BPManager::alloc(int file_desc, PageNum page_num, int page_size) {
+    MUTEX_LOCK(&this->mutex);
+    Frame* frame = MemPoolSimple<Frame>::alloc();
+    if (frame != nullptr) {
+        if (reserve_page(frame, page_size)) {
+            bind(frame, file_desc, page_num);
+        } else {
+            MemPoolSimple<Frame>::free(frame);
+            frame = nullptr;
+        }
+    }
+    MUTEX_UNLOCK(&this->mutex);
+    return frame;
+}
+
+bool BPManager::reserve_page(Frame* frame, int page_size) {
+    if (frame->page != nullptr && frame->page_size == page_size) {
         return true;
+    }
 
-    return false;
+    MUTEX_LOCK(&this->mutex);
+    void* page = alloc_page_buffer(page_size);
+    if (page != nullptr) {
+        free_page_buffer(frame);
+        frame->page      = (Page*)page;
+        frame->page_size = page_size;
+        page_bytes_ += page_size;
+    }
+    MUTEX_UNLOCK(&this->mutex);
+    return page != nullptr;
+}
+
+void* BPManager::alloc_page_buffer(int page_size) {
+    if (arena_ != nullptr) {
+        void* page = arena_->alloc(page_size);
+        if (page != nullptr) {
+            return page;
+        }
+    }
+
+    void* page = nullptr;
+    if (posix_memalign(&page, BP_PAGE_ALIGN, page_size) != 0) {
+        LOG_ERROR("Failed to alloc page buffer of %d bytes.", page_size);
+        return nullptr;
+    }
+    return page;
+}
+
+void BPManager::free_page_buffer(Frame* frame) {
+    if (frame->page == nullptr) {
+        return;
+    }
+
+    if (arena_ != nullptr && arena_->contains(frame->page)) {
+        arena_->free(frame->page, frame->page_size);
+    } else {
+        ::free(frame->page);
+    }
+    page_bytes_ -= frame->page_size;
+    frame->page      = nullptr;
+    frame->page_size = 0;
+}
+
+void BPManager::free(Frame* frame) {
+    MUTEX_LOCK(&this->mutex);
+    unbind(frame);
+    free_page_buffer(frame);
+    MemPoolSimple<Frame>::free(frame);
+    MUTEX_UNLOCK(&this->mutex);
+}
+
+void BPManager::set_capacity(size_t capacity) {
+    MUTEX_LOCK(&this->mutex);
+    capacity_ = capacity;
+
+    // 每个页面至少BP_MIN_PAGE_SIZE，预算全部用来放最小的页面时也不缺frame
+    const size_t frame_num = capacity / BP_MIN_PAGE_SIZE;
+    this->dynamic          = true;
+    while ((size_t)this->size < frame_num) {
+        if (extend() < 0) {
+            break;
+        }
+    }
+    this->dynamic = false;
+    MUTEX_UNLOCK(&this->mutex);
+}
+
+void BPManager::cleanup() {
+    MUTEX_LOCK(&this->mutex);
+    for (auto& iter : page_table_) {
+        replacer_->remove(iter.second);
+    }
+    page_table_.clear();
+    for (Frame* frame : used) {
+        free_page_buffer(frame);
+    }
+    MemPoolSimple<Frame>::cleanup();
+    MUTEX_UNLOCK(&this->mutex);
+}
+
+void BPManager::bind(Frame* frame, int file_desc, PageNum page_num) {
+    MUTEX_LOCK(&this->mutex);
+    unbind(frame);
+    frame->file_desc     = file_desc;
+    frame->page->page_num = page_num;
+    frame->io_pending     = false;
+    frame->io_failed      = false;
+    page_table_[BPFrameId{file_desc, page_num}] = frame;
+    replacer_->insert(frame);
+    MUTEX_UNLOCK(&this->mutex);
+}
+
+void BPManager::unbind(Frame* frame) {
+    if (frame->page == nullptr) {
+        return;
+    }
+
+    MUTEX_LOCK(&this->mutex);
+    auto it = page_table_.find(BPFrameId{frame->file_desc, frame->page->page_num});
+    if (it != page_table_.end() && it->second == frame) {
+        page_table_.erase(it);
+        replacer_->remove(frame);
+    }
+    MUTEX_UNLOCK(&this->mutex);
 }
 
 Frame* BPManager::get(int file_desc, PageNum page_num) {
-    MatchFilePage file_page(file_desc, page_num);
-    return MemPoolSimple<Frame>::find(match_file_page, &file_page);
+    Frame* frame = nullptr;
+    MUTEX_LOCK(&this->mutex);
+    auto it = page_table_.find(BPFrameId{file_desc, page_num});
+    if (it != page_table_.end()) {
+        frame = it->second;
+    }
+    MUTEX_UNLOCK(&this->mutex);
+    return frame;
 }
 
 static bool match_file(void* item, void* arg) {
@@ -87,14 +374,95 @@ std::list<Frame*> BPManager::find_list(int file_desc) {
     return find_all(match_file, &file_desc);
 }
 
+int BPManager::clean_count() {
+    MUTEX_LOCK(&this->mutex);
+    int count = 0;
+    if (capacity_ > page_bytes_) {
+        count = (int)((capacity_ - page_bytes_) / BP_DEFAULT_PAGE_SIZE);
+    }
+    for (auto& iter : page_table_) {
+        Frame* frame = iter.second;
+        if (frame->pin_count == 0 && !frame->dirty) {
+            count++;
+        }
+    }
+    MUTEX_UNLOCK(&this->mutex);
+    return count;
+}
+
+void BPManager::find_resident(std::vector<BPFrameId>& frame_ids) {
+    MUTEX_LOCK(&this->mutex);
+    for (auto& iter : page_table_) {
+        frame_ids.push_back(iter.first);
+    }
+    MUTEX_UNLOCK(&this->mutex);
+}
+
+void BPManager::count_frames(std::map<int, BPFrameCounts>& counts) {
+    MUTEX_LOCK(&this->mutex);
+    for (auto& iter : page_table_) {
+        Frame*         frame = iter.second;
+        BPFrameCounts& total = counts[-1];
+        BPFrameCounts& file  = counts[frame->file_desc];
+        total.resident++, file.resident++;
+        if (frame->pin_count > 0) {
+            total.pinned++, file.pinned++;
+        }
+        if (frame->dirty) {
+            total.dirty++, file.dirty++;
+        }
+    }
+    MUTEX_UNLOCK(&this->mutex);
+}
+
+void BPManager::find_dirty(std::vector<Frame*>& frames) {
+    MUTEX_LOCK(&this->mutex);
+    for (auto& iter : page_table_) {
+        Frame* frame = iter.second;
+        if (frame->pin_count == 0 && frame->dirty) {
+            frames.push_back(frame);
+        }
+    }
+    MUTEX_UNLOCK(&this->mutex);
+}
+
 DiskBufferPool* theGlobalDiskBufferPool() {
     static DiskBufferPool* instance = DiskBufferPool::mk_instance();
 
     return instance;
 }
 
-DiskBufferPool::DiskBufferPool() : bp_manager_("BPManager") {
-    bp_manager_.init(false, DiskBufferPool::POOL_NUM, BP_BUFFER_SIZE);
+DiskBufferPool::DiskBufferPool() {
+    pthread_mutexattr_t mutexatr;
+    pthread_mutexattr_init(&mutexatr);
+    pthread_mutexattr_settype(&mutexatr, PTHREAD_MUTEX_RECURSIVE);
+    MUTEX_INIT(&file_mutex_, &mutexatr);
+    MUTEX_INIT(&stats_mutex_, NULL);
+    MUTEX_INIT(&flush_mutex_, NULL);
+    pool_stats_ = new BPStats(BP_METRIC_TAG, this, -1);
+
+    // 所有分片平分 POOL_SIZE 字节的预算，每个分片至少要放得下一个最大的页面
+    const unsigned long long pool_size = DiskBufferPool::POOL_SIZE;
+    const int shard_num = (int)std::min<unsigned long long>(
+        DiskBufferPool::SHARD_NUM, std::max(1ULL, pool_size / BP_MAX_PAGE_SIZE));
+    for (int i = 0; i < shard_num; i++) {
+        BPManager* bp_manager = new BPManager("BPManager");
+        bp_manager->init(false, 1, BP_BUFFER_SIZE);
+        bp_manager->set_capacity(pool_size / shard_num);
+        bp_manager->set_page_arena(BPPageArena::create(
+            pool_size / shard_num, HUGE_PAGE, BP_MIN_PAGE_SIZE, BP_MAX_PAGE_SIZE));
+
+        BPReplacer* replacer = BPReplacer::create(REPLACER, LRU_K);
+        if (replacer != nullptr) {
+            bp_manager->set_replacer(replacer);
+        }
+        bp_managers_.push_back(bp_manager);
+    }
+    io_engine_ = BPIoEngine::create(IO_ENGINE);
+    LOG_INFO("Buffer pool has %llu bytes in %d shards, uses %s replacer, %s io engine "
+             "and %s huge page",
+             pool_size, shard_num, bp_managers_[0]->get_replacer()->name(),
+             io_engine_->name(), HUGE_PAGE.c_str());
 };
 
 DiskBufferPool::~DiskBufferPool() {
@@ -108,11 +476,37 @@ DiskBufferPool::~DiskBufferPool() {
         open_list_[i] = nullptr;
     }
 
-    bp_manager_.cleanup();
+    LOG_INFO("Buffer pool statistics. replacer=%s, hit=%lu, miss=%lu, "
+             "evict=%lu, writeback=%lu, prefetch=%lu",
+             bp_managers_[0]->get_replacer()->name(), get_hit_count(),
+             get_miss_count(), get_evict_count(), get_write_count(),
+             get_prefetch_count());
+    delete pool_stats_;
+    pool_stats_ = nullptr;
+    for (BPManager* bp_manager : bp_managers_) {
+        bp_manager->cleanup();
+        delete bp_manager;
+    }
+    bp_managers_.clear();
+
+    delete io_engine_;
+    io_engine_ = nullptr;
+    ::free(flush_buffer_);
+    flush_buffer_ = nullptr;
+
+    MUTEX_DESTROY(&flush_mutex_);
+    MUTEX_DESTROY(&stats_mutex_);
+    MUTEX_DESTROY(&file_mutex_);
     LOG_INFO("Exit");
 }
 
-ResultCode DiskBufferPool::create_file(const char* file_name) {
+ResultCode DiskBufferPool::create_file(const char* file_name, int page_size) {
+    if (!is_valid_page_size(page_size)) {
+        LOG_ERROR("Failed to create %s, due to invalid page size %d.", file_name,
+                  page_size);
+        return ResultCode::INVALID_ARGUMENT;
+    }
+
     int fd = open(file_name, O_RDWR | O_CREAT | O_EXCL, S_IREAD | S_IWRITE);
     if (fd < 0) {
         LOG_ERROR("Failed to create %s, due to %s.", file_name,
@@ -125,22 +519,29 @@ ResultCode DiskBufferPool::create_file(const char* file_name) {
     /**
      * Here don't care about the failure
      */
-    fd = open(file_name, O_RDWR);
+    fd = open_data_file(file_name, DIRECT_IO);
     if (fd < 0) {
         LOG_ERROR("Failed to open for readwrite %s, due to %s.", file_name,
                   strerror(errno));
         return ResultCode::IOERR_ACCESS;
     }
 
-    Page page;
-    memset(&page, 0, sizeof(Page));
+    AlignedBuffer buffer(page_size);
+    if (buffer.data() == nullptr) {
+        LOG_ERROR("Failed to alloc header buffer for %s.", file_name);
+        close(fd);
+        return ResultCode::NOMEM;
+    }
+    memset(buffer.data(), 0, page_size);
+    Page* page = (Page*)buffer.data();
 
     BPFileSubHeader* fileSubHeader;
-    fileSubHeader                  = (BPFileSubHeader*)page.data;
+    fileSubHeader                  = (BPFileSubHeader*)page->data;
     fileSubHeader->allocated_pages = 1;
     fileSubHeader->page_count      = 1;
+    fileSubHeader->page_size       = page_size;
 
-    char* bitmap                   = page.data + (int)BP_FILE_SUB_HDR_SIZE;
+    char* bitmap                   = page->data + (int)BP_FILE_SUB_HDR_SIZE;
     bitmap[0] |= 0x01;
     if (lseek(fd, 0, SEEK_SET) == -1) {
         LOG_ERROR("Failed to seek file %s to position 0, due to %s .",
@@ -149,7 +550,7 @@ ResultCode DiskBufferPool::create_file(const char* file_name) {
         return ResultCode::IOERR_SEEK;
     }
 
-    if (write(fd, (char*)&page, sizeof(Page)) != sizeof(Page)) {
+    if (write(fd, buffer.data(), page_size) != page_size) {
         LOG_ERROR("Failed to write header to file %s, due to %s.", file_name,
                   strerror(errno));
         close(fd);
@@ -162,6 +563,8 @@ ResultCode DiskBufferPool::create_file(const char* file_name) {
 }
 
 ResultCode DiskBufferPool::open_file(const char* file_name, int* file_id) {
+    MutexGuard file_guard(&file_mutex_);
+
     int fd, i, size = 0, empty_id = -1;
     // This part isn't gentle, the better method is using LRU queue.
     for (i = 0; i < MAX_OPEN_FILE; i++) {
@@ -185,13 +588,32 @@ ResultCode DiskBufferPool::open_file(const char* file_name, int* file_id) {
         return ResultCode::BUFFERPOOL_OPEN_TOO_MANY_FILES;
     }
 
-    if ((fd = open(file_name, O_RDWR)) < 0) {
+    if ((fd = open_data_file(file_name, DIRECT_IO)) < 0) {
         LOG_ERROR("Failed to open file %s, because %s.", file_name,
                   strerror(errno));
         return ResultCode::IOERR_ACCESS;
     }
     LOG_INFO("Successfully open file %s.", file_name);
 
+    // 先读出文件头中的页面大小，才知道整个文件头页面有多大。
+    // 页面至少有BP_MIN_PAGE_SIZE，按这个大小对齐读，O_DIRECT也能用
+    BPFileSubHeader sub_header;
+    AlignedBuffer   header(BP_MIN_PAGE_SIZE);
+    if (header.data() == nullptr ||
+        pread(fd, header.data(), BP_MIN_PAGE_SIZE, 0) != BP_MIN_PAGE_SIZE) {
+        LOG_ERROR("Failed to read header of %s, due to %s.", file_name,
+                  strerror(errno));
+        close(fd);
+        return ResultCode::IOERR_READ;
+    }
+    memcpy(&sub_header, ((Page*)header.data())->data, sizeof(sub_header));
+    if (!is_valid_page_size(sub_header.page_size)) {
+        LOG_ERROR("Failed to open file %s, due to invalid page size %d.",
+                  file_name, sub_header.page_size);
+        close(fd);
+        return ResultCode::BUFFERPOOL_FILEERR;
+    }
+
     BPFileHandle* file_handle = new (std::nothrow) BPFileHandle();
     if (file_handle == nullptr) {
         LOG_ERROR("Failed to alloc memory of BPFileHandle for %s.", file_name);
@@ -203,28 +625,48 @@ ResultCode DiskBufferPool::open_file(const char* file_name, int* file_id) {
     file_handle->bopen     = true;
     file_handle->file_name = strdup(file_name);
     file_handle->file_desc = fd;
-    if ((tmp = allocate_page(&file_handle->hdr_frame)) != ResultCode::SUCCESS) {
-        LOG_ERROR("Failed to allocate block for %s's BPFileHandle.", file_name);
-        delete file_handle;
-        close(fd);
-        return tmp;
+    file_handle->page_size = sub_header.page_size;
+    file_handle->max_page_count =
+        (BP_PAGE_DATA_SIZE(sub_header.page_size) - (int)BP_FILE_SUB_HDR_SIZE) * 8;
+    file_handle->stats = new BPStats(
+        std::string(BP_METRIC_TAG) + ".file" + std::to_string(empty_id), this, fd);
+    MUTEX_LOCK(&stats_mutex_);
+    file_stats_[fd] = file_handle->stats;
+    MUTEX_UNLOCK(&stats_mutex_);
+
+    // 注销统计项要拿MetricsRegistry的锁，而做snapshot时是先拿它再锁分片，
+    // 所以出错时要先释放分片的latch再remove_file_stats
+    {
+        BPManager&                  bp_manager = shard_of(fd, 0);
+        std::unique_lock<BPManager> shard_guard(bp_manager);
+        Frame*                      frame      = nullptr;
+        if ((tmp = allocate_page(bp_manager, file_handle->page_size, &frame)) ==
+            ResultCode::SUCCESS) {
+            bp_manager.bind(frame, fd, 0);
+            frame->dirty      = false;
+            frame->acc_time   = current_time();
+            frame->io_pending = true;
+            bp_manager.pin(frame);
+
+            shard_guard.unlock();
+            tmp = load_page(0, file_handle, frame);
+            shard_guard.lock();
+            finish_load(bp_manager, frame, 0, tmp == ResultCode::SUCCESS);
+            if (tmp == ResultCode::SUCCESS) {
+                file_handle->hdr_frame = frame;
+            }
+        }
     }
-    file_handle->hdr_frame->dirty     = false;
-    file_handle->hdr_frame->file_desc = fd;
-    file_handle->hdr_frame->pin_count = 1;
-    file_handle->hdr_frame->acc_time  = current_time();
-    if ((tmp = load_page(0, file_handle, file_handle->hdr_frame)) !=
-        ResultCode::SUCCESS) {
-        LOG_ERROR("Failed to load first page of %s, due to %s.", file_name,
-                  strerror(errno));
-        file_handle->hdr_frame->pin_count = 0;
-        purge_page(file_handle->hdr_frame);
+    if (tmp != ResultCode::SUCCESS) {
+        LOG_ERROR("Failed to load first page of %s, rc=%d:%s.", file_name, tmp,
+                  strrc(tmp));
+        remove_file_stats(file_handle);
         close(fd);
         delete file_handle;
         return tmp;
     }
 
-    file_handle->hdr_page = &(file_handle->hdr_frame->page);
+    file_handle->hdr_page = file_handle->hdr_frame->page;
     file_handle->bitmap   = file_handle->hdr_page->data + BP_FILE_SUB_HDR_SIZE;
     file_handle->file_sub_header =
         (BPFileSubHeader*)file_handle->hdr_page->data;
@@ -237,6 +679,8 @@ ResultCode DiskBufferPool::open_file(const char* file_name, int* file_id) {
 }
 
 ResultCode DiskBufferPool::close_file(int file_id) {
+    MutexGuard file_guard(&file_mutex_);
+
     ResultCode tmp;
     if ((tmp = check_file_id(file_id)) != ResultCode::SUCCESS) {
         LOG_ERROR("Failed to close file, due to invalid fileId %d", file_id);
@@ -244,9 +688,14 @@ ResultCode DiskBufferPool::close_file(int file_id) {
     }
 
     BPFileHandle* file_handle = open_list_[file_id];
-    file_handle->hdr_frame->pin_count--;
+    BPManager&    hdr_manager = shard_of(file_handle->hdr_frame);
+    {
+        std::lock_guard<BPManager> shard_guard(hdr_manager);
+        hdr_manager.unpin(file_handle->hdr_frame);
+    }
     if ((tmp = purge_all_pages(file_handle)) != ResultCode::SUCCESS) {
-        file_handle->hdr_frame->pin_count++;
+        std::lock_guard<BPManager> shard_guard(hdr_manager);
+        hdr_manager.pin(file_handle->hdr_frame);
         LOG_ERROR(
             "Failed to close file %d:%s, due to failed to purge all pages.",
             file_id, file_handle->file_name);
@@ -254,6 +703,7 @@ ResultCode DiskBufferPool::close_file(int file_id) {
     }
 
     disposed_pages.erase(file_handle->file_desc);
+    remove_file_stats(file_handle);
 
     if (close(file_handle->file_desc) < 0) {
         LOG_ERROR("Failed to close fileId:%d, fileName:%s, error:%s", file_id,
@@ -267,57 +717,413 @@ ResultCode DiskBufferPool::close_file(int file_id) {
 }
 
 ResultCode DiskBufferPool::get_this_page(int file_id, PageNum page_num,
-                                 BPPageHandle* page_handle) {
-    ResultCode tmp;
-    if ((tmp = check_file_id(file_id)) != ResultCode::SUCCESS) {
-        LOG_ERROR("Failed to load page %d, due to invalid fileId %d", page_num,
-                  file_id);
-        return tmp;
-    }
+                                 BPPageHandle* page_handle, BPScanRing* ring) {
+    ResultCode    tmp;
+    BPFileHandle* file_handle = nullptr;
+    {
+        MutexGuard file_guard(&file_mutex_);
+        if ((tmp = check_file_id(file_id)) != ResultCode::SUCCESS) {
+            LOG_ERROR("Failed to load page %d, due to invalid fileId %d",
+                      page_num, file_id);
+            return tmp;
+        }
 
-    BPFileHandle* file_handle = open_list_[file_id];
-    if ((tmp = check_page_num(page_num, file_handle)) != ResultCode::SUCCESS) {
-        LOG_ERROR("Failed to load page %s:%d, due to invalid pageNum.",
-                  file_handle->file_name, page_num);
-        return tmp;
+        file_handle = open_list_[file_id];
+        if ((tmp = check_page_num(page_num, file_handle)) !=
+            ResultCode::SUCCESS) {
+            LOG_ERROR("Failed to load page %s:%d, due to invalid pageNum.",
+                      file_handle->file_name, page_num);
+            return tmp;
+        }
     }
 
-    Frame* used_match_frame = bp_manager_.get(file_handle->file_desc, page_num);
-    if (used_match_frame != nullptr) {
-        page_handle->frame = used_match_frame;
-        page_handle->frame->pin_count++;
-        page_handle->frame->acc_time = current_time();
-        page_handle->open            = true;
+    const int file_desc = file_handle->file_desc;
+    BPManager&                   bp_manager = shard_of(file_desc, page_num);
+    std::unique_lock<BPManager> shard_guard(bp_manager);
+
+    Frame* frame = bp_manager.get(file_desc, page_num);
+    if (frame == nullptr) {
+        pool_stats_->miss();
+        file_handle->stats->miss();
+
+        if ((tmp = flush_victim(shard_guard, file_handle->page_size)) !=
+            ResultCode::SUCCESS) {
+            LOG_ERROR("Failed to load page %s:%d, due to failed to flush victim.",
+                      file_handle->file_name, page_num);
+            return tmp;
+        }
+        // 写盘期间没有持有latch，别的线程可能已经开始读这个页面了
+        frame = bp_manager.get(file_desc, page_num);
+    } else {
+        pool_stats_->hit();
+        file_handle->stats->hit();
+    }
 
-        bp_manager_.mark_modified(used_match_frame);
+    if (frame != nullptr) {
+        bp_manager.pin(frame);
+        frame->acc_time = current_time();
+        bp_manager.access(frame);
+        if ((tmp = wait_for_load(bp_manager, frame)) != ResultCode::SUCCESS) {
+            LOG_ERROR("Failed to load page %s:%d, due to failed to read data.",
+                      file_handle->file_name, page_num);
+            return tmp;
+        }
 
+        page_handle->frame = frame;
+        page_handle->open  = true;
         return ResultCode::SUCCESS;
     }
 
     // Allocate one page and load the data into this page
-    if ((tmp = allocate_page(&(page_handle->frame))) != ResultCode::SUCCESS) {
+    if ((tmp = allocate_page(bp_manager, file_handle->page_size, &frame, ring)) !=
+        ResultCode::SUCCESS) {
         LOG_ERROR("Failed to load page %s:%d, due to failed to alloc page.",
                   file_handle->file_name, page_num);
         return tmp;
     }
-    page_handle->frame->dirty     = false;
-    page_handle->frame->file_desc = file_handle->file_desc;
-    page_handle->frame->pin_count = 1;
-    page_handle->frame->acc_time  = current_time();
-    if ((tmp = load_page(page_num, file_handle, page_handle->frame)) !=
-        ResultCode::SUCCESS) {
+    bp_manager.bind(frame, file_desc, page_num);
+    add_to_ring(ring, bp_manager, frame);
+    frame->dirty      = false;
+    frame->acc_time   = current_time();
+    frame->io_pending = true;
+    bp_manager.pin(frame);
+
+    // 读盘期间释放latch，同一分片上其它页面的访问不用等待。
+    // 这个frame已经登记在页表中，访问同一个页面的线程会pin住它等待读完
+    shard_guard.unlock();
+    tmp = load_page(page_num, file_handle, frame);
+    shard_guard.lock();
+
+    finish_load(bp_manager, frame, page_num, tmp == ResultCode::SUCCESS);
+    if (tmp != ResultCode::SUCCESS) {
         LOG_ERROR("Failed to load page %s:%d", file_handle->file_name,
                   page_num);
-        page_handle->frame->pin_count = 0;
-        purge_page(page_handle->frame);
         return tmp;
     }
 
-    page_handle->open = true;
+    page_handle->frame = frame;
+    page_handle->open  = true;
     return ResultCode::SUCCESS;
 }
 
+ResultCode DiskBufferPool::flush_victim(std::unique_lock<BPManager>& shard_guard,
+                                        int                          page_size) {
+    BPManager& bp_manager = *shard_guard.mutex();
+    if (bp_manager.has_room(page_size)) {
+        return ResultCode::SUCCESS;
+    }
+    Frame* victim = bp_manager.begin_purge();
+    if (victim == nullptr || !victim->dirty) {
+        return ResultCode::SUCCESS;
+    }
+
+    // pin住防止写盘期间被别的线程淘汰。先清除dirty，写盘期间页面又被修改的话会重新标记
+    bp_manager.pin(victim);
+    victim->dirty = false;
+    shard_guard.unlock();
+    ResultCode rc = write_page(victim);
+    shard_guard.lock();
+    if (rc != ResultCode::SUCCESS) {
+        LOG_ERROR("Failed to flush victim page %d of %d.",
+                  victim->page->page_num, victim->file_desc);
+        victim->dirty = true;
+    }
+    if (bp_manager.unpin(victim) && victim->dirty) {
+        dirty_version_++;
+    }
+    return rc;
+}
+
+void DiskBufferPool::finish_load(BPManager& bp_manager, Frame* frame,
+                                 PageNum page_num, bool success) {
+    // 页表和分片都以page_num作为frame的标识，读取失败时也不能被破坏
+    frame->page->page_num = page_num;
+    frame->io_pending     = false;
+    if (!success) {
+        // 等待的线程看到io_failed后自己unpin，最后一个unpin的负责释放frame
+        frame->io_failed = true;
+        bp_manager.unbind(frame);
+        bp_manager.notify_io();
+        if (bp_manager.unpin(frame)) {
+            bp_manager.free(frame);
+        }
+        return;
+    }
+    bp_manager.notify_io();
+}
+
+ResultCode DiskBufferPool::wait_for_load(BPManager& bp_manager, Frame* frame) {
+    while (frame->io_pending) {
+        bp_manager.wait_io();
+    }
+    if (frame->io_failed) {
+        if (bp_manager.unpin(frame)) {
+            bp_manager.free(frame);
+        }
+        return ResultCode::IOERR_READ;
+    }
+    return ResultCode::SUCCESS;
+}
+
+ResultCode DiskBufferPool::get_pages(int file_id, const PageNum* page_nums, int num,
+                                     BPPageHandle* page_handles) {
+    ResultCode    rc;
+    BPFileHandle* file_handle = nullptr;
+    {
+        MutexGuard file_guard(&file_mutex_);
+        if ((rc = check_file_id(file_id)) != ResultCode::SUCCESS) {
+            LOG_ERROR("Failed to load pages, due to invalid fileId %d", file_id);
+            return rc;
+        }
+
+        file_handle = open_list_[file_id];
+        for (int i = 0; i < num; i++) {
+            if ((rc = check_page_num(page_nums[i], file_handle)) !=
+                ResultCode::SUCCESS) {
+                LOG_ERROR("Failed to load page %s:%d, due to invalid pageNum.",
+                          file_handle->file_name, page_nums[i]);
+                return rc;
+            }
+        }
+    }
+    const int file_desc = file_handle->file_desc;
+    const int page_size = file_handle->page_size;
+
+    for (int i = 0; i < num; i++) {
+        page_handles[i].open  = false;
+        page_handles[i].frame = nullptr;
+    }
+
+    // 未命中的页面先登记到页表并标记io_pending，释放latch以后再一起读盘。
+    // 同时访问这些页面的线程会pin住frame等待读完，同一分片上的其它页面不受影响
+    std::vector<BPIoRequest> requests;
+    std::vector<int>         request_pages;
+    std::vector<int>         hit_pages;
+    rc = ResultCode::SUCCESS;
+    for (int i = 0; i < num; i++) {
+        BPManager&                  bp_manager = shard_of(file_desc, page_nums[i]);
+        std::unique_lock<BPManager> shard_guard(bp_manager);
+        Frame*                      frame      = bp_manager.get(file_desc, page_nums[i]);
+        if (frame == nullptr) {
+            pool_stats_->miss();
+            file_handle->stats->miss();
+            if ((rc = flush_victim(shard_guard, page_size)) != ResultCode::SUCCESS) {
+                LOG_ERROR("Failed to load page %s:%d, due to failed to flush victim.",
+                          file_handle->file_name, page_nums[i]);
+                break;
+            }
+            frame = bp_manager.get(file_desc, page_nums[i]);
+        } else {
+            pool_stats_->hit();
+            file_handle->stats->hit();
+        }
+
+        if (frame != nullptr) {
+            // 可能是别的线程(或者本次调用)正在读入的页面，自己的请求提交以后再等
+            bp_manager.pin(frame);
+            frame->acc_time = current_time();
+            bp_manager.access(frame);
+            page_handles[i].frame = frame;
+            page_handles[i].open  = true;
+            hit_pages.push_back(i);
+            continue;
+        }
+
+        if ((rc = allocate_page(bp_manager, page_size, &frame)) !=
+            ResultCode::SUCCESS) {
+            LOG_ERROR("Failed to load page %s:%d, due to failed to alloc page.",
+                      file_handle->file_name, page_nums[i]);
+            break;
+        }
+        bp_manager.bind(frame, file_desc, page_nums[i]);
+        frame->dirty      = false;
+        frame->acc_time   = current_time();
+        frame->io_pending = true;
+        bp_manager.pin(frame);
+        page_handles[i].frame = frame;
+        page_handles[i].open  = true;
+
+        requests.push_back(BPIoRequest{file_desc, false, frame->page,
+                                       (size_t)page_size,
+                                       (off_t)page_nums[i] * (off_t)page_size, 0});
+        request_pages.push_back(i);
+    }
+
+    // 未命中的页面一起提交，等待全部读完。前面出错时不再读盘，登记的frame都按读取失败处理
+    if (!requests.empty() && rc == ResultCode::SUCCESS) {
+        const unsigned long start = current_time();
+        io_engine_->submit_and_wait(requests.data(), (int)requests.size());
+        const long us = elapsed_us(start);
+        pool_stats_->read((int)requests.size(), us);
+        file_handle->stats->read((int)requests.size(), us);
+    }
+    for (size_t r = 0; r < requests.size(); r++) {
+        const int  i          = request_pages[r];
+        Frame*     frame      = page_handles[i].frame;
+        BPManager& bp_manager = shard_of(frame);
+        const bool success    = requests[r].result == (ssize_t)page_size;
+        if (!success && rc == ResultCode::SUCCESS) {
+            LOG_ERROR("Failed to load page %s:%d, due to failed to read data:%s.",
+                      file_handle->file_name, page_nums[i],
+                      requests[r].result < 0 ? strerror(-requests[r].result)
+                                             : "short read");
+            rc = ResultCode::IOERR_READ;
+        }
+
+        std::lock_guard<BPManager> shard_guard(bp_manager);
+        finish_load(bp_manager, frame, page_nums[i], success);
+        if (!success) {
+            // finish_load已经unpin了，句柄不能再用
+            page_handles[i].open  = false;
+            page_handles[i].frame = nullptr;
+        }
+    }
+
+    // 自己的页面都读完了，再等别的线程正在读的页面
+    for (int i : hit_pages) {
+        Frame*                     frame      = page_handles[i].frame;
+        BPManager&                 bp_manager = shard_of(frame);
+        std::lock_guard<BPManager> shard_guard(bp_manager);
+        if (wait_for_load(bp_manager, frame) != ResultCode::SUCCESS) {
+            LOG_ERROR("Failed to load page %s:%d, due to failed to read data.",
+                      file_handle->file_name, page_nums[i]);
+            rc                    = ResultCode::IOERR_READ;
+            page_handles[i].open  = false;
+            page_handles[i].frame = nullptr;
+        }
+    }
+
+    if (rc != ResultCode::SUCCESS) {
+        for (int i = 0; i < num; i++) {
+            if (page_handles[i].open) {
+                unpin_page(&page_handles[i]);
+            }
+            page_handles[i].frame = nullptr;
+        }
+        return rc;
+    }
+    return ResultCode::SUCCESS;
+}
+
+ResultCode DiskBufferPool::prefetch_pages(int file_id, PageNum start_page,
+                                          int count, BPScanRing* ring) {
+    ResultCode           rc;
+    BPFileHandle*        file_handle = nullptr;
+    std::vector<PageNum> page_nums;
+    {
+        MutexGuard file_guard(&file_mutex_);
+        if ((rc = check_file_id(file_id)) != ResultCode::SUCCESS) {
+            LOG_ERROR("Failed to prefetch pages, due to invalid fileId %d",
+                      file_id);
+            return rc;
+        }
+
+        file_handle = open_list_[file_id];
+        for (PageNum page_num = std::max(start_page, 1);
+             page_num < start_page + count &&
+             page_num < file_handle->file_sub_header->page_count;
+             page_num++) {
+            if (file_handle->bitmap[page_num / 8] & (1 << (page_num % 8))) {
+                page_nums.push_back(page_num);
+            }
+        }
+    }
+    if (page_nums.empty()) {
+        return ResultCode::SUCCESS;
+    }
+    const int file_desc = file_handle->file_desc;
+    const int page_size = file_handle->page_size;
+
+    // 没有缓存的页面放到新分配的frame中，登记到页表并标记io_pending，
+    // 页号连续的一段是一个向量读请求。读盘期间不持有分片的latch
+    std::vector<std::vector<Frame*>> runs;
+    for (PageNum page_num : page_nums) {
+        BPManager& bp_manager = shard_of(file_desc, page_num);
+        Frame*     frame      = nullptr;
+        {
+            std::lock_guard<BPManager> shard_guard(bp_manager);
+            if (bp_manager.get(file_desc, page_num) != nullptr ||
+                allocate_page(bp_manager, page_size, &frame, ring) !=
+                    ResultCode::SUCCESS) {
+                continue;
+            }
+            bp_manager.bind(frame, file_desc, page_num);
+            add_to_ring(ring, bp_manager, frame);
+            frame->dirty      = false;
+            frame->acc_time   = current_time();
+            frame->io_pending = true;
+            bp_manager.pin(frame);
+        }
+
+        if (runs.empty() || (int)runs.back().size() >= BP_READAHEAD_MAX_PAGES ||
+            page_num != runs.back().back()->page->page_num + 1) {
+            runs.emplace_back();
+        }
+        runs.back().push_back(frame);
+    }
+
+    if (!runs.empty()) {
+        read_runs(runs);
+    }
+    return ResultCode::SUCCESS;
+}
+
+void DiskBufferPool::read_runs(std::vector<std::vector<Frame*>>& runs) {
+    std::vector<std::vector<struct iovec>> iovs(runs.size());
+    std::vector<BPIoRequest>               requests;
+    std::vector<PageNum>                   first_pages;
+    for (size_t r = 0; r < runs.size(); r++) {
+        std::vector<Frame*>& frames    = runs[r];
+        const int            page_size = frames[0]->page_size;
+        for (Frame* frame : frames) {
+            iovs[r].push_back(iovec{frame->page, (size_t)page_size});
+        }
+        // 读盘会覆盖页面中的page_num，先记下来
+        first_pages.push_back(frames[0]->page->page_num);
+        requests.push_back(BPIoRequest{frames[0]->file_desc, false, nullptr,
+                                       (size_t)page_size * frames.size(),
+                                       (off_t)first_pages[r] * page_size, 0,
+                                       iovs[r].data(), (int)frames.size()});
+    }
+
+    const unsigned long start = current_time();
+    io_engine_->submit_and_wait(requests.data(), (int)requests.size());
+    const long us = elapsed_us(start);
+
+    for (size_t r = 0; r < runs.size(); r++) {
+        std::vector<Frame*>& frames    = runs[r];
+        const int            file_desc = requests[r].file_desc;
+        const int            page_size = frames[0]->page_size;
+        record(file_desc, [&](BPStats& stats) { stats.read((int)frames.size(), us); });
+        ssize_t ret = requests[r].result;
+        if (ret < 0) {
+            LOG_WARN("Failed to prefetch %d pages from %d of %d, due to %s",
+                     (int)frames.size(), first_pages[r], file_desc, strerror(-ret));
+            ret = 0;
+        }
+
+        for (size_t i = 0; i < frames.size(); i++) {
+            Frame*                     frame      = frames[i];
+            BPManager&                 bp_manager = shard_of(frame);
+            std::lock_guard<BPManager> shard_guard(bp_manager);
+            // 没有读全的页面直接丢掉，以后按需再读
+            const bool success = (size_t)ret >= (i + 1) * page_size;
+            finish_load(bp_manager, frame, first_pages[r] + (PageNum)i, success);
+            if (!success) {
+                continue;
+            }
+            prefetch_count_++;
+            // 读盘期间别的线程可能pin住并修改了页面
+            if (bp_manager.unpin(frame) && frame->dirty) {
+                dirty_version_++;
+            }
+        }
+    }
+}
+
 ResultCode DiskBufferPool::allocate_page(int file_id, BPPageHandle* page_handle) {
+    MutexGuard file_guard(&file_mutex_);
+
     ResultCode tmp;
     if ((tmp = check_file_id(file_id)) != ResultCode::SUCCESS) {
         LOG_ERROR("Failed to alloc page, due to invalid fileId %d", file_id);
@@ -342,13 +1148,23 @@ ResultCode DiskBufferPool::allocate_page(int file_id, BPPageHandle* page_handle)
         }
     }
 
-    if ((tmp = allocate_page(&(page_handle->frame))) != ResultCode::SUCCESS) {
+    PageNum page_num = file_handle->file_sub_header->page_count;
+    if (page_num >= file_handle->max_page_count) {
+        LOG_ERROR("Failed to allocate page %s, due to the file is full. "
+                  "page size=%d, page count=%d",
+                  file_handle->file_name, file_handle->page_size, page_num);
+        return ResultCode::BUFFERPOOL_NOBUF;
+    }
+
+    BPManager&                 bp_manager = shard_of(file_handle->file_desc, page_num);
+    std::lock_guard<BPManager> shard_guard(bp_manager);
+    if ((tmp = allocate_page(bp_manager, file_handle->page_size,
+                             &(page_handle->frame))) != ResultCode::SUCCESS) {
         LOG_ERROR("Failed to allocate page %s, due to no free page.",
                   file_handle->file_name);
         return tmp;
     }
 
-    PageNum page_num = file_handle->file_sub_header->page_count;
     file_handle->file_sub_header->allocated_pages++;
     file_handle->file_sub_header->page_count++;
 
@@ -358,12 +1174,10 @@ ResultCode DiskBufferPool::allocate_page(int file_id, BPPageHandle* page_handle)
     file_handle->hdr_frame->dirty = true;
 
     page_handle->frame->dirty     = false;
-    page_handle->frame->file_desc = file_handle->file_desc;
-    page_handle->frame->pin_count = 1;
     page_handle->frame->acc_time  = current_time();
-    memset(&(page_handle->frame->page), 0, sizeof(Page));
-    page_handle->frame->page.page_num =
-        file_handle->file_sub_header->page_count - 1;
+    memset(page_handle->frame->page, 0, file_handle->page_size);
+    bp_manager.bind(page_handle->frame, file_handle->file_desc, page_num);
+    bp_manager.pin(page_handle->frame);
 
     // Use flush operation to extension file
     if ((tmp = flush_page(page_handle->frame)) != ResultCode::SUCCESS) {
@@ -380,14 +1194,14 @@ ResultCode DiskBufferPool::allocate_page(int file_id, BPPageHandle* page_handle)
 ResultCode DiskBufferPool::get_page_num(BPPageHandle* page_handle, PageNum* page_num) {
     if (!page_handle->open)
         return ResultCode::BUFFERPOOL_CLOSED;
-    *page_num = page_handle->frame->page.page_num;
+    *page_num = page_handle->frame->page->page_num;
     return ResultCode::SUCCESS;
 }
 
 ResultCode DiskBufferPool::get_data(BPPageHandle* page_handle, char** data) {
     if (!page_handle->open)
         return ResultCode::BUFFERPOOL_CLOSED;
-    *data = page_handle->frame->page.data;
+    *data = page_handle->frame->page->data;
     return ResultCode::SUCCESS;
 }
 
@@ -398,12 +1212,22 @@ ResultCode DiskBufferPool::mark_dirty(BPPageHandle* page_handle) {
 
 ResultCode DiskBufferPool::unpin_page(BPPageHandle* page_handle) {
     page_handle->open = false;
-    if (--page_handle->frame->pin_count == 0) {
-        int  file_desc = page_handle->frame->file_desc;
-        auto it        = disposed_pages.find(file_desc);
+
+    BPManager& bp_manager = shard_of(page_handle->frame);
+    bp_manager.lock();
+    int     file_desc     = page_handle->frame->file_desc;
+    PageNum page_num      = page_handle->frame->page->page_num;
+    bool    unpinned      = bp_manager.unpin(page_handle->frame);
+    if (unpinned && page_handle->frame->dirty) {
+        dirty_version_++;
+    }
+    bp_manager.unlock();
+
+    if (unpinned) {
+        MutexGuard file_guard(&file_mutex_);
+        auto       it = disposed_pages.find(file_desc);
         if (it != disposed_pages.end()) {
             BPDisposedPages& disposed_page = it->second;
-            PageNum          page_num      = page_handle->frame->page.page_num;
             auto             pages_it      = disposed_page.pages.find(page_num);
             if (pages_it != disposed_page.pages.end()) {
                 LOG_INFO("Dispose file_id:%d, page:%d", disposed_page.file_id,
@@ -426,6 +1250,8 @@ ResultCode DiskBufferPool::unpin_page(BPPageHandle* page_handle) {
  * @return
  */
 ResultCode DiskBufferPool::dispose_page(int file_id, PageNum page_num) {
+    MutexGuard file_guard(&file_mutex_);
+
     ResultCode rc;
     if ((rc = check_file_id(file_id)) != ResultCode::SUCCESS) {
         LOG_ERROR("Failed to alloc page, due to invalid fileId %d", file_id);
@@ -467,7 +1293,45 @@ ResultCode DiskBufferPool::dispose_page(int file_id, PageNum page_num) {
     return ResultCode::SUCCESS;
 }
 
+ResultCode DiskBufferPool::truncate_file(int file_id, int* page_count) {
+    MutexGuard file_guard(&file_mutex_);
+
+    ResultCode rc;
+    if ((rc = check_file_id(file_id)) != ResultCode::SUCCESS) {
+        LOG_ERROR("Failed to truncate file, due to invalid fileId %d", file_id);
+        return rc;
+    }
+
+    BPFileHandle* file_handle = open_list_[file_id];
+    PageNum       old_count   = file_handle->file_sub_header->page_count;
+    PageNum       new_count   = old_count;
+    // 第0页是文件头，一直都在
+    while (new_count > 1 &&
+           (file_handle->bitmap[(new_count - 1) / 8] & (1 << ((new_count - 1) % 8))) == 0) {
+        new_count--;
+    }
+
+    if (new_count < old_count) {
+        file_handle->file_sub_header->page_count = new_count;
+        file_handle->hdr_frame->dirty            = true;
+        if (ftruncate(file_handle->file_desc,
+                      (off_t)new_count * file_handle->page_size) != 0) {
+            LOG_WARN("Failed to truncate file %s to %d pages. errmsg=%s",
+                     file_handle->file_name, new_count, strerror(errno));
+        }
+        LOG_INFO("Truncate file %s from %d pages to %d pages",
+                 file_handle->file_name, old_count, new_count);
+    }
+
+    if (page_count != nullptr) {
+        *page_count = new_count;
+    }
+    return ResultCode::SUCCESS;
+}
+
 ResultCode DiskBufferPool::purge_page(int file_id, PageNum page_num) {
+    MutexGuard file_guard(&file_mutex_);
+
     ResultCode rc;
     if ((rc = check_file_id(file_id)) != ResultCode::SUCCESS) {
         LOG_ERROR("Failed to alloc page, due to invalid fileId %d", file_id);
@@ -477,10 +1341,13 @@ ResultCode DiskBufferPool::purge_page(int file_id, PageNum page_num) {
     return purge_page(file_handle, page_num);
 }
 
+/**
+ * 调用者需要持有frame所在分片的latch
+ */
 ResultCode DiskBufferPool::purge_page(Frame* buf) {
     if (buf->pin_count > 0) {
         LOG_INFO("Begin to free page %d of %d, but it's pinned, pin_count:%d.",
-                 buf->page.page_num, buf->file_desc, buf->pin_count);
+                 buf->page->page_num, buf->file_desc, buf->pin_count);
         return ResultCode::LOCKED_UNLOCK;
     }
 
@@ -488,14 +1355,14 @@ ResultCode DiskBufferPool::purge_page(Frame* buf) {
         ResultCode rc = flush_page(buf);
         if (rc != ResultCode::SUCCESS) {
             LOG_WARN("Failed to flush page %d of %d during purge page.",
-                     buf->page.page_num, buf->file_desc);
+                     buf->page->page_num, buf->file_desc);
             return rc;
         }
     }
 
     LOG_DEBUG("Successfully purge frame =%p, page %d of %d", buf,
-              buf->page.page_num, buf->file_desc);
-    bp_manager_.free(buf);
+              buf->page->page_num, buf->file_desc);
+    shard_of(buf).free(buf);
     return ResultCode::SUCCESS;
 }
 
@@ -507,7 +1374,10 @@ ResultCode DiskBufferPool::purge_page(Frame* buf) {
  * @return
  */
 ResultCode DiskBufferPool::purge_page(BPFileHandle* file_handle, PageNum page_num) {
-    Frame* used_frame = bp_manager_.get(file_handle->file_desc, page_num);
+    BPManager&                 bp_manager = shard_of(file_handle->file_desc, page_num);
+    std::lock_guard<BPManager> shard_guard(bp_manager);
+
+    Frame* used_frame = bp_manager.get(file_handle->file_desc, page_num);
     if (used_frame != nullptr) {
         return purge_page(used_frame);
     }
@@ -516,6 +1386,8 @@ ResultCode DiskBufferPool::purge_page(BPFileHandle* file_handle, PageNum page_nu
 }
 
 ResultCode DiskBufferPool::purge_all_pages(int file_id) {
+    MutexGuard file_guard(&file_mutex_);
+
     ResultCode rc = check_file_id(file_id);
     if (rc != ResultCode::SUCCESS) {
         LOG_ERROR("Failed to flush pages due to invalid file_id %d", file_id);
@@ -527,24 +1399,70 @@ ResultCode DiskBufferPool::purge_all_pages(int file_id) {
 }
 
 ResultCode DiskBufferPool::purge_all_pages(BPFileHandle* file_handle) {
-    std::list<Frame*> used = bp_manager_.find_list(file_handle->file_desc);
-    for (std::list<Frame*>::iterator it = used.begin(); it != used.end();
-         ++it) {
-        Frame* frame = *it;
-        if (frame->pin_count > 0) {
-            LOG_WARN("The page has been pinned, file_id:%d, pagenum:%d",
-                     frame->file_desc, frame->page.page_num);
-            continue;
+    // 逐个分片pin住这个文件的脏页并清除dirty，释放latch以后再排序合并写盘，
+    // 写盘期间别的文件的页面访问不受影响。写盘期间页面又被修改的话会重新标记dirty
+    std::vector<Frame*> dirty;
+    for (BPManager* bp_manager : bp_managers_) {
+        std::lock_guard<BPManager> shard_guard(*bp_manager);
+        for (Frame* frame : bp_manager->find_list(file_handle->file_desc)) {
+            if (frame->pin_count == 0 && frame->dirty) {
+                bp_manager->pin(frame);
+                frame->dirty = false;
+                dirty.push_back(frame);
+            }
         }
-        if (frame->dirty) {
-            ResultCode rc = flush_page(frame);
-            if (rc != ResultCode::SUCCESS) {
-                LOG_ERROR("Failed to flush all pages' of %s.",
+    }
+
+    std::sort(dirty.begin(), dirty.end(), [](Frame* a, Frame* b) {
+        return a->page->page_num < b->page->page_num;
+    });
+    std::vector<Frame*> failed;
+    ResultCode          rc = ResultCode::SUCCESS;
+    if (!dirty.empty() && (rc = flush_pages(dirty, failed)) != ResultCode::SUCCESS) {
+        LOG_ERROR("Failed to flush all pages' of %s.", file_handle->file_name);
+    }
+    std::sort(failed.begin(), failed.end());
+    for (Frame* frame : dirty) {
+        BPManager&                 bp_manager = shard_of(frame);
+        std::lock_guard<BPManager> shard_guard(bp_manager);
+        if (std::binary_search(failed.begin(), failed.end(), frame)) {
+            frame->dirty = true;
+        }
+        if (bp_manager.unpin(frame) && frame->dirty) {
+            dirty_version_++;
+        }
+    }
+    if (rc != ResultCode::SUCCESS) {
+        return rc;
+    }
+
+    // 写盘期间又变脏的页面很少，直接在latch下写回。全部写成功以后才释放页面，
+    // 失败时和上面一样什么都不释放
+    for (BPManager* bp_manager : bp_managers_) {
+        std::lock_guard<BPManager> shard_guard(*bp_manager);
+        for (Frame* frame : bp_manager->find_list(file_handle->file_desc)) {
+            if (frame->pin_count == 0 && frame->dirty &&
+                (rc = flush_page(frame)) != ResultCode::SUCCESS) {
+                LOG_ERROR("Failed to flush page %d of %s.", frame->page->page_num,
+                          file_handle->file_name);
+                return rc;
+            }
+        }
+    }
+    for (BPManager* bp_manager : bp_managers_) {
+        std::lock_guard<BPManager> shard_guard(*bp_manager);
+        for (Frame* frame : bp_manager->find_list(file_handle->file_desc)) {
+            if (frame->pin_count > 0) {
+                LOG_WARN("The page has been pinned, file_id:%d, pagenum:%d",
+                         frame->file_desc, frame->page->page_num);
+                continue;
+            }
+            if ((rc = purge_page(frame)) != ResultCode::SUCCESS) {
+                LOG_ERROR("Failed to purge page %d of %s.", frame->page->page_num,
                           file_handle->file_name);
                 return rc;
             }
         }
-        bp_manager_.free(frame);
     }
     return ResultCode::SUCCESS;
 }
@@ -552,54 +1470,641 @@ ResultCode DiskBufferPool::purge_all_pages(BPFileHandle* file_handle) {
 ResultCode DiskBufferPool::flush_page(Frame* frame) {
     // The better way is use mmap the block into memory,
     // so it is easier to flush data to file.
-
-    s64_t offset = ((s64_t)frame->page.page_num) * sizeof(Page);
-    if (lseek(frame->file_desc, offset, SEEK_SET) == offset - 1) {
-        LOG_ERROR("Failed to flush page %lld of %d due to failed to seek %s.",
-                  offset, frame->file_desc, strerror(errno));
-        return ResultCode::IOERR_SEEK;
+    ResultCode rc = write_page(frame);
+    if (rc != ResultCode::SUCCESS) {
+        return rc;
     }
+    frame->dirty = false;
+    LOG_DEBUG("Flush block. file desc=%d, page num=%d", frame->file_desc,
+              frame->page->page_num);
+    return ResultCode::SUCCESS;
+}
 
-    if (write(frame->file_desc, &(frame->page), sizeof(Page)) != sizeof(Page)) {
+ResultCode DiskBufferPool::write_page(Frame* frame) {
+    s64_t       offset = ((s64_t)frame->page->page_num) * frame->page_size;
+    BPIoRequest request{frame->file_desc, true, frame->page,
+                        (size_t)frame->page_size, (off_t)offset, 0};
+    const unsigned long start = current_time();
+    io_engine_->submit_and_wait(&request, 1);
+    if (request.result != frame->page_size) {
         LOG_ERROR("Failed to flush page %lld of %d due to %s.", offset,
-                  frame->file_desc, strerror(errno));
+                  frame->file_desc,
+                  request.result < 0 ? strerror(-request.result) : "short write");
         return ResultCode::IOERR_WRITE;
     }
-    frame->dirty = false;
-    LOG_DEBUG("Flush block. file desc=%d, page num=%d", frame->file_desc,
-              frame->page.page_num);
-
+    const long us = elapsed_us(start);
+    record(frame->file_desc, [&](BPStats& stats) { stats.write(1, us); });
     return ResultCode::SUCCESS;
 }
 
-ResultCode DiskBufferPool::allocate_page(Frame** buffer) {
-    Frame* frame = bp_manager_.alloc();
-    if (frame != nullptr) {
-        *buffer = frame;
+ResultCode DiskBufferPool::flush_pages(const std::vector<Frame*>& frames,
+                                       std::vector<Frame*>&       failed) {
+    // 每一段页号连续的页面是一个向量写请求，所有请求一起提交给I/O引擎
+    std::vector<struct iovec> iov(frames.size());
+    std::vector<BPIoRequest>  requests;
+    std::vector<size_t>       run_begins;
+
+    size_t begin = 0;
+    while (begin < frames.size()) {
+        size_t end = begin + 1;
+        while (end < frames.size() && end - begin < BP_FLUSH_MAX_BATCH &&
+               frames[end]->page->page_num == frames[end - 1]->page->page_num + 1) {
+            end++;
+        }
+
+        const int page_size = frames[begin]->page_size;
+        for (size_t i = begin; i < end; i++) {
+            iov[i].iov_base = frames[i]->page;
+            iov[i].iov_len  = page_size;
+        }
+        requests.push_back(BPIoRequest{
+            frames[begin]->file_desc, true, nullptr, (size_t)page_size * (end - begin),
+            (off_t)frames[begin]->page->page_num * page_size, 0, &iov[begin],
+            (int)(end - begin)});
+        run_begins.push_back(begin);
+
+        begin = end;
+    }
+    if (requests.empty()) {
         return ResultCode::SUCCESS;
     }
 
-    frame = bp_manager_.begin_purge();
-    if (frame == nullptr) {
-        LOG_ERROR("All pages have been used and pinned.");
+    const unsigned long start = current_time();
+    io_engine_->submit_and_wait(requests.data(), (int)requests.size());
+    const long us = elapsed_us(start);
+
+    ResultCode rc = ResultCode::SUCCESS;
+    for (size_t r = 0; r < requests.size(); r++) {
+        const BPIoRequest& request = requests[r];
+        if (request.result != (ssize_t)request.size) {
+            LOG_ERROR("Failed to flush %d pages from %lld of %d due to %s.",
+                      request.iov_num, (long long)request.offset, request.file_desc,
+                      request.result < 0 ? strerror(-request.result)
+                                         : "short write");
+            rc = ResultCode::IOERR_WRITE;
+            failed.insert(failed.end(), frames.begin() + run_begins[r],
+                          frames.begin() + run_begins[r] + request.iov_num);
+            continue;
+        }
+        record(request.file_desc,
+               [&](BPStats& stats) { stats.write(request.iov_num, us); });
+        LOG_DEBUG("Flush %d blocks. file desc=%d, first page num=%d",
+                  request.iov_num, request.file_desc,
+                  frames[run_begins[r]]->page->page_num);
+    }
+    return rc;
+}
+
+static bool frame_id_less(const BPFrameId& a, const BPFrameId& b) {
+    if (a.file_desc != b.file_desc) {
+        return a.file_desc < b.file_desc;
+    }
+    return a.page_num < b.page_num;
+}
+
+ResultCode DiskBufferPool::flush_dirty_pages(int clean_reserve, int max_pages,
+                                             int* flushed_num) {
+    *flushed_num = 0;
+
+    MutexGuard flush_guard(&flush_mutex_);
+    // 先读版本号再检查各个分片，检查期间新出现的脏页会让下一轮重新检查
+    const unsigned long version = dirty_version_.load();
+    if (version == clean_version_) {
+        return ResultCode::SUCCESS;
+    }
+
+    // 淘汰发生在分片内部，所以干净frame的保留量也按分片计算
+    const int shard_num     = (int)bp_managers_.size();
+    const int shard_reserve = (clean_reserve + shard_num - 1) / shard_num;
+
+    std::vector<BPFrameId> candidates;
+    std::vector<Frame*>    dirty_frames;
+    bool                   found_dirty = false;
+    for (BPManager* bp_manager : bp_managers_) {
+        std::lock_guard<BPManager> shard_guard(*bp_manager);
+
+        dirty_frames.clear();
+        bp_manager->find_dirty(dirty_frames);
+        if (dirty_frames.empty()) {
+            continue;
+        }
+        found_dirty = true;
+
+        int need = shard_reserve - bp_manager->clean_count();
+        if (need <= 0) {
+            continue;
+        }
+
+        std::vector<BPFrameId> shard_candidates;
+        for (Frame* frame : dirty_frames) {
+            shard_candidates.push_back(
+                BPFrameId{frame->file_desc, frame->page->page_num});
+        }
+        std::sort(shard_candidates.begin(), shard_candidates.end(),
+                  frame_id_less);
+        if ((int)shard_candidates.size() > need) {
+            shard_candidates.resize(need);
+        }
+        candidates.insert(candidates.end(), shard_candidates.begin(),
+                          shard_candidates.end());
+    }
+
+    std::sort(candidates.begin(), candidates.end(), frame_id_less);
+    if ((int)candidates.size() > max_pages) {
+        candidates.resize(max_pages);
+    }
+
+    if (!found_dirty) {
+        clean_version_ = version;
+    }
+    if (candidates.empty()) {
+        return ResultCode::SUCCESS;
+    }
+
+    // 一批最多BP_FLUSH_MAX_BATCH个页面，缓冲区对齐后O_DIRECT也能直接写
+    if (flush_buffer_ == nullptr &&
+        posix_memalign((void**)&flush_buffer_, BP_PAGE_ALIGN,
+                       (size_t)BP_FLUSH_MAX_BATCH * BP_MAX_PAGE_SIZE) != 0) {
+        flush_buffer_ = nullptr;
+        LOG_ERROR("Failed to alloc buffer for background flush.");
         return ResultCode::NOMEM;
     }
+    ResultCode          rc     = ResultCode::SUCCESS;
+    char* const         buffer = flush_buffer_;
+    std::vector<Frame*> batch;
+    for (const BPFrameId& candidate : candidates) {
+        if (!batch.empty()) {
+            Frame* last = batch.back();
+            if (candidate.file_desc != last->file_desc ||
+                candidate.page_num != last->page->page_num + 1 ||
+                (int)batch.size() >= BP_FLUSH_MAX_BATCH) {
+                ResultCode tmp = flush_batch(batch, buffer);
+                if (tmp == ResultCode::SUCCESS) {
+                    *flushed_num += (int)batch.size();
+                } else {
+                    rc = tmp;
+                }
+                batch.clear();
+            }
+        }
+
+        // 拿到分片latch后重新确认一遍，期间页面可能被淘汰、pin住或者已经写回了
+        BPManager&                 bp_manager = shard_of(candidate.file_desc, candidate.page_num);
+        std::lock_guard<BPManager> shard_guard(bp_manager);
+        Frame* frame = bp_manager.get(candidate.file_desc, candidate.page_num);
+        if (frame == nullptr || frame->pin_count > 0 || !frame->dirty) {
+            continue;
+        }
+
+        // pin住frame，防止写盘期间被淘汰后又从磁盘读到旧数据
+        bp_manager.pin(frame);
+        memcpy(buffer + batch.size() * frame->page_size, frame->page,
+               frame->page_size);
+        frame->dirty = false;
+        batch.push_back(frame);
+    }
+    if (!batch.empty()) {
+        ResultCode tmp = flush_batch(batch, buffer);
+        if (tmp == ResultCode::SUCCESS) {
+            *flushed_num += (int)batch.size();
+        } else {
+            rc = tmp;
+        }
+    }
+
+    if (*flushed_num > 0) {
+        LOG_DEBUG("Background flush %d dirty pages", *flushed_num);
+    }
+    return rc;
+}
+
+ResultCode DiskBufferPool::flush_batch(std::vector<Frame*>& frames,
+                                       const char*          buffer) {
+    const int    file_desc = frames[0]->file_desc;
+    const size_t size      = (size_t)frames[0]->page_size * frames.size();
+    s64_t        offset    = ((s64_t)frames[0]->page->page_num) * frames[0]->page_size;
+
+    ResultCode  rc = ResultCode::SUCCESS;
+    BPIoRequest request{file_desc, true, (void*)buffer, size, (off_t)offset, 0};
+    const unsigned long start = current_time();
+    io_engine_->submit_and_wait(&request, 1);
+    if (request.result != (ssize_t)size) {
+        LOG_ERROR("Failed to flush %d pages from %lld of %d due to %s.",
+                  (int)frames.size(), offset, file_desc,
+                  request.result < 0 ? strerror(-request.result) : "short write");
+        rc = ResultCode::IOERR_WRITE;
+    } else {
+        const long us = elapsed_us(start);
+        record(file_desc, [&](BPStats& stats) { stats.write((int)frames.size(), us); });
+    }
 
-    if (frame->dirty) {
-        ResultCode rc = flush_page(frame);
+    for (Frame* frame : frames) {
         if (rc != ResultCode::SUCCESS) {
-            LOG_ERROR(
-                "Failed to aclloc block due to failed to flush old block.");
-            return rc;
+            // 前台线程在latch下修改dirty，这里也要拿latch
+            std::lock_guard<BPManager> shard_guard(shard_of(frame));
+            frame->dirty = true;
+        }
+        BPPageHandle page_handle;
+        page_handle.open  = true;
+        page_handle.frame = frame;
+        unpin_page(&page_handle);
+    }
+    return rc;
+}
+
+ResultCode DiskBufferPool::dump_resident_pages(const char* path) {
+    std::map<std::string, std::vector<PageNum>> files;
+    {
+        MutexGuard                           file_guard(&file_mutex_);
+        std::unordered_map<int, const char*> file_names;
+        for (BPFileHandle* file_handle : open_list_) {
+            if (file_handle != nullptr) {
+                file_names[file_handle->file_desc] = file_handle->file_name;
+            }
+        }
+
+        std::vector<BPFrameId> frame_ids;
+        for (BPManager* bp_manager : bp_managers_) {
+            bp_manager->find_resident(frame_ids);
+        }
+        for (const BPFrameId& frame_id : frame_ids) {
+            // 文件头页面在打开文件时就会读进来
+            auto iter = file_names.find(frame_id.file_desc);
+            if (iter != file_names.end() && frame_id.page_num != 0) {
+                files[iter->second].push_back(frame_id.page_num);
+            }
+        }
+    }
+
+    const std::string tmp_path = std::string(path) + ".tmp";
+    std::ofstream     out(tmp_path, std::ios::out | std::ios::trunc);
+    if (!out) {
+        LOG_ERROR("Failed to open warm-up file %s, due to %s.", tmp_path.c_str(),
+                  strerror(errno));
+        return ResultCode::IOERR_ACCESS;
+    }
+
+    size_t page_num = 0;
+    for (auto& iter : files) {
+        std::vector<PageNum>& page_nums = iter.second;
+        std::sort(page_nums.begin(), page_nums.end());
+        out << iter.first << '\n';
+        for (size_t i = 0; i < page_nums.size(); i++) {
+            out << (i == 0 ? "" : " ") << page_nums[i];
+        }
+        out << '\n';
+        page_num += page_nums.size();
+    }
+    out.close();
+    if (!out || rename(tmp_path.c_str(), path) != 0) {
+        LOG_ERROR("Failed to write warm-up file %s, due to %s.", path,
+                  strerror(errno));
+        ::remove(tmp_path.c_str());
+        return ResultCode::IOERR_WRITE;
+    }
+    LOG_INFO("Dump %lu resident pages of %lu files to %s.", page_num,
+             files.size(), path);
+    return ResultCode::SUCCESS;
+}
+
+ResultCode DiskBufferPool::load_resident_pages(const char* path, int thread_num,
+                                               int* loaded_num) {
+    *loaded_num = 0;
+    std::ifstream in(path);
+    if (!in) {
+        LOG_INFO("There is no warm-up file %s, skip warming up.", path);
+        return ResultCode::SUCCESS;
+    }
+
+    // 每一段是同一个文件中页号连续的一串页面，用一次向量读请求读上来
+    struct Run {
+        int     file_id;
+        PageNum start_page;
+        int     count;
+        int     page_size;
+    };
+    std::vector<Run> runs;
+    std::string      file_name;
+    std::string      line;
+    while (std::getline(in, file_name) && std::getline(in, line)) {
+        int file_id   = -1;
+        int page_size = 0;
+        {
+            MutexGuard file_guard(&file_mutex_);
+            for (int i = 0; i < MAX_OPEN_FILE; i++) {
+                if (open_list_[i] != nullptr &&
+                    file_name == open_list_[i]->file_name) {
+                    file_id   = i;
+                    page_size = open_list_[i]->page_size;
+                    break;
+                }
+            }
+        }
+        if (file_id < 0) {
+            LOG_INFO("Skip warming up %s, which is not opened.", file_name.c_str());
+            continue;
+        }
+
+        std::vector<PageNum> page_nums;
+        std::istringstream   page_stream(line);
+        PageNum              page_num;
+        while (page_stream >> page_num) {
+            page_nums.push_back(page_num);
+        }
+        std::sort(page_nums.begin(), page_nums.end());
+        page_nums.erase(std::unique(page_nums.begin(), page_nums.end()),
+                        page_nums.end());
+        for (PageNum page_num : page_nums) {
+            if (!runs.empty() && runs.back().file_id == file_id &&
+                runs.back().start_page + runs.back().count == page_num &&
+                runs.back().count < BP_READAHEAD_MAX_PAGES) {
+                runs.back().count++;
+            } else {
+                runs.push_back(Run{file_id, page_num, 1, page_size});
+            }
+        }
+    }
+
+    unsigned long long pool_size = 0;
+    for (BPManager* bp_manager : bp_managers_) {
+        pool_size += bp_manager->capacity();
+    }
+
+    const unsigned long       prefetch_count = get_prefetch_count();
+    std::atomic<size_t>       next_run(0);
+    std::atomic<bool>         full(false);
+    auto                      worker = [&]() {
+        for (size_t i = next_run++; i < runs.size() && !full; i = next_run++) {
+            const Run& run = runs[i];
+            if (get_used_bytes() + (unsigned long long)run.count * run.page_size >
+                pool_size) {
+                full = true;
+                break;
+            }
+            prefetch_pages(run.file_id, run.start_page, run.count);
         }
+    };
+
+    std::vector<std::thread> threads;
+    for (int i = 1; i < thread_num; i++) {
+        threads.emplace_back(worker);
     }
+    worker();
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    *loaded_num = (int)(get_prefetch_count() - prefetch_count);
+    LOG_INFO("Warm up buffer pool with %d pages from %s.", *loaded_num, path);
+    return ResultCode::SUCCESS;
+}
 
-    bp_manager_.mark_modified(frame);
+BPScanRing* DiskBufferPool::create_scan_ring(int file_id) {
+    if (SCAN_RING_PAGES <= 0) {
+        return nullptr;
+    }
+
+    int page_count = 0;
+    if (get_page_count(file_id, &page_count) != ResultCode::SUCCESS) {
+        return nullptr;
+    }
+
+    int page_size = 0;
+    if (get_page_size(file_id, &page_size) != ResultCode::SUCCESS) {
+        return nullptr;
+    }
+
+    unsigned long long pool_size = 0;
+    for (BPManager* bp_manager : bp_managers_) {
+        pool_size += bp_manager->capacity();
+    }
+    if ((unsigned long long)page_count * page_size <= pool_size / 4) {
+        return nullptr;
+    }
+
+    // 环至少要能装下两个预读窗口，否则预读上来的页面还没用到就被环重用了
+    const int shard_num  = (int)bp_managers_.size();
+    const int ring_pages = std::max(SCAN_RING_PAGES, READAHEAD_PAGES * 2);
+    return new BPScanRing(std::max(1, (ring_pages + shard_num - 1) / shard_num));
+}
+
+void DiskBufferPool::add_to_ring(BPScanRing* ring, BPManager& bp_manager,
+                                 Frame* frame) {
+    if (ring != nullptr) {
+        ring->slots_[&bp_manager].push_back(
+            BPScanRing::Slot{frame, frame->file_desc, frame->page->page_num});
+    }
+}
+
+ResultCode DiskBufferPool::allocate_page(BPManager& bp_manager, int page_size,
+                                         Frame** buffer, BPScanRing* ring) {
+    Frame* frame = nullptr;
+    if (ring != nullptr) {
+        // 只重用还缓存着环读入的页面的frame。已经被换出的从环里去掉；
+        // 还被pin住的(通常是扫描自己正在读的页面)放回环尾，以后再重用
+        std::deque<BPScanRing::Slot>& slots = ring->slots_[&bp_manager];
+        for (size_t tries = slots.size();
+             tries > 0 && (int)slots.size() >= ring->capacity_per_shard();
+             tries--) {
+            BPScanRing::Slot slot = slots.front();
+            slots.pop_front();
+
+            Frame* candidate = slot.frame;
+            if (bp_manager.get(slot.file_desc, slot.page_num) != candidate) {
+                continue;
+            }
+            if (candidate->pin_count > 0) {
+                slots.push_back(slot);
+                continue;
+            }
+            if (candidate->dirty) {
+                ResultCode rc = flush_page(candidate);
+                if (rc != ResultCode::SUCCESS) {
+                    LOG_ERROR("Failed to reuse frame of scan ring, due to "
+                              "failed to flush old block.");
+                    return rc;
+                }
+            }
+            frame = candidate;
+            break;
+        }
+    }
+
+    // 预算已经用完时直接重用被淘汰的frame，省得先分配再释放缓冲区
+    if (frame == nullptr && !bp_manager.has_room(page_size)) {
+        frame = bp_manager.begin_purge();
+        if (frame != nullptr && frame->dirty) {
+            ResultCode rc = flush_page(frame);
+            if (rc != ResultCode::SUCCESS) {
+                LOG_ERROR(
+                    "Failed to aclloc block due to failed to flush old block.");
+                return rc;
+            }
+        }
+    }
+
+    if (frame == nullptr) {
+        frame = bp_manager.alloc();
+    }
+
+    if (frame == nullptr) {
+        frame = bp_manager.begin_purge();
+        if (frame == nullptr) {
+            LOG_ERROR("All pages have been used and pinned.");
+            return ResultCode::NOMEM;
+        }
+
+        if (frame->dirty) {
+            ResultCode rc = flush_page(frame);
+            if (rc != ResultCode::SUCCESS) {
+                LOG_ERROR(
+                    "Failed to aclloc block due to failed to flush old block.");
+                return rc;
+            }
+        }
+    }
+
+    // 从页表中拿走的frame里放的是被淘汰的页面
+    if (frame->page != nullptr &&
+        bp_manager.get(frame->file_desc, frame->page->page_num) == frame) {
+        record(frame->file_desc, [](BPStats& stats) { stats.evict(); });
+    }
+    bp_manager.unbind(frame);
+
+    // 页面大小和frame里原来的页面不同时，要换一个缓冲区
+    if (!bp_manager.reserve_page(frame, page_size)) {
+        bp_manager.free(frame);
+        return ResultCode::NOMEM;
+    }
+
+    // frame已经不在页表里了，淘汰时不会选中它自己
+    ResultCode rc = evict_to_capacity(bp_manager);
+    if (rc != ResultCode::SUCCESS) {
+        bp_manager.free(frame);
+        return rc;
+    }
 
     *buffer = frame;
     return ResultCode::SUCCESS;
 }
 
+ResultCode DiskBufferPool::evict_to_capacity(BPManager& bp_manager) {
+    while (bp_manager.over_capacity()) {
+        Frame* victim = bp_manager.begin_purge();
+        if (victim == nullptr) {
+            LOG_ERROR("All pages have been used and pinned.");
+            return ResultCode::NOMEM;
+        }
+
+        if (victim->dirty) {
+            ResultCode rc = flush_page(victim);
+            if (rc != ResultCode::SUCCESS) {
+                LOG_ERROR("Failed to evict page due to failed to flush it.");
+                return rc;
+            }
+        }
+        record(victim->file_desc, [](BPStats& stats) { stats.evict(); });
+        bp_manager.free(victim);
+    }
+    return ResultCode::SUCCESS;
+}
+
+ResultCode DiskBufferPool::resize(unsigned long long pool_size) {
+    const int shard_num = (int)bp_managers_.size();
+    if (pool_size / shard_num < BP_MAX_PAGE_SIZE) {
+        LOG_ERROR("Failed to resize buffer pool to %llu bytes, every shard "
+                  "should hold at least %d bytes.",
+                  pool_size, BP_MAX_PAGE_SIZE);
+        return ResultCode::INVALID_ARGUMENT;
+    }
+
+    ResultCode rc = ResultCode::SUCCESS;
+    for (BPManager* bp_manager : bp_managers_) {
+        std::lock_guard<BPManager> shard_guard(*bp_manager);
+        bp_manager->set_capacity(pool_size / shard_num);
+        ResultCode tmp = evict_to_capacity(*bp_manager);
+        if (tmp != ResultCode::SUCCESS) {
+            rc = tmp;
+        }
+    }
+    POOL_SIZE = pool_size;
+    LOG_INFO("Resize buffer pool to %llu bytes, %llu bytes in use.", pool_size,
+             get_used_bytes());
+    return rc;
+}
+
+unsigned long long DiskBufferPool::get_used_bytes() {
+    unsigned long long used_bytes = 0;
+    for (BPManager* bp_manager : bp_managers_) {
+        std::lock_guard<BPManager> shard_guard(*bp_manager);
+        used_bytes += bp_manager->page_bytes();
+    }
+    return used_bytes;
+}
+
+template <typename F>
+void DiskBufferPool::record(int file_desc, F update) {
+    update(*pool_stats_);
+    MUTEX_LOCK(&stats_mutex_);
+    auto iter = file_stats_.find(file_desc);
+    if (iter != file_stats_.end()) {
+        update(*iter->second);
+    }
+    MUTEX_UNLOCK(&stats_mutex_);
+}
+
+void DiskBufferPool::remove_file_stats(BPFileHandle* file_handle) {
+    MUTEX_LOCK(&stats_mutex_);
+    file_stats_.erase(file_handle->file_desc);
+    MUTEX_UNLOCK(&stats_mutex_);
+    delete file_handle->stats;
+    file_handle->stats = nullptr;
+}
+
+void DiskBufferPool::count_frames(std::map<int, BPFrameCounts>& counts) {
+    for (BPManager* bp_manager : bp_managers_) {
+        bp_manager->count_frames(counts);
+    }
+}
+
+std::string DiskBufferPool::get_status() {
+    std::map<int, BPFrameCounts> counts;
+    count_frames(counts);
+
+    std::stringstream ss;
+    ss << "pool_size: " << POOL_SIZE << ", used_bytes: " << get_used_bytes()
+       << ", shards: " << bp_managers_.size() << ", prefetch: "
+       << get_prefetch_count() << std::endl;
+    ss << "file | resident | pinned | dirty | hit | miss | evict | read | "
+          "read_avg_us | writeback | write_avg_us"
+       << std::endl;
+
+    auto print_row = [&ss](const std::string& name, const BPFrameCounts& frames,
+                           const BPStats& stats) {
+        const unsigned long read_count  = stats.read_count;
+        const unsigned long write_count = stats.write_count;
+        ss << name << " | " << frames.resident << " | " << frames.pinned
+           << " | " << frames.dirty << " | " << stats.hit_count << " | "
+           << stats.miss_count << " | " << stats.evict_count << " | "
+           << read_count << " | "
+           << (read_count == 0 ? 0 : stats.read_us / read_count) << " | "
+           << write_count << " | "
+           << (write_count == 0 ? 0 : stats.write_us / write_count)
+           << std::endl;
+    };
+
+    print_row("total", counts[-1], *pool_stats_);
+    MutexGuard file_guard(&file_mutex_);
+    for (int i = 0; i < MAX_OPEN_FILE; i++) {
+        BPFileHandle* file_handle = open_list_[i];
+        if (file_handle != nullptr) {
+            print_row(std::to_string(i) + ":" + file_handle->file_name,
+                      counts[file_handle->file_desc], *file_handle->stats);
+        }
+    }
+    return ss.str();
+}
+
 ResultCode DiskBufferPool::check_file_id(int file_id) {
     if (file_id < 0 || file_id >= MAX_OPEN_FILE) {
         LOG_ERROR("Invalid fileId:%d.", file_id);
@@ -613,6 +2118,8 @@ ResultCode DiskBufferPool::check_file_id(int file_id) {
 }
 
 ResultCode DiskBufferPool::get_page_count(int file_id, int* page_count) {
+    MutexGuard file_guard(&file_mutex_);
+
     ResultCode rc = ResultCode::SUCCESS;
     if ((rc = check_file_id(file_id)) != ResultCode::SUCCESS) {
         return rc;
@@ -621,6 +2128,17 @@ ResultCode DiskBufferPool::get_page_count(int file_id, int* page_count) {
     return ResultCode::SUCCESS;
 }
 
+ResultCode DiskBufferPool::get_page_size(int file_id, int* page_size) {
+    MutexGuard file_guard(&file_mutex_);
+
+    ResultCode rc = ResultCode::SUCCESS;
+    if ((rc = check_file_id(file_id)) != ResultCode::SUCCESS) {
+        return rc;
+    }
+    *page_size = open_list_[file_id]->page_size;
+    return ResultCode::SUCCESS;
+}
+
 ResultCode DiskBufferPool::check_page_num(PageNum page_num, BPFileHandle* file_handle) {
     if (page_num >= file_handle->file_sub_header->page_count) {
         LOG_ERROR("Invalid pageNum:%d, file's name:%s", page_num,
@@ -637,18 +2155,23 @@ ResultCode DiskBufferPool::check_page_num(PageNum page_num, BPFileHandle* file_h
 
 ResultCode DiskBufferPool::load_page(PageNum page_num, BPFileHandle* file_handle,
                              Frame* frame) {
-    s64_t offset = ((s64_t)page_num) * sizeof(Page);
-    if (lseek(file_handle->file_desc, offset, SEEK_SET) == -1) {
-        LOG_ERROR("Failed to load page %s:%d, due to failed to lseek:%s.",
-                  file_handle->file_name, page_num, strerror(errno));
-
-        return ResultCode::IOERR_SEEK;
-    }
-    if (read(file_handle->file_desc, &(frame->page), sizeof(Page)) !=
-        sizeof(Page)) {
+    const int   page_size = file_handle->page_size;
+    s64_t       offset    = ((s64_t)page_num) * page_size;
+    BPIoRequest request{file_handle->file_desc, false, frame->page,
+                        (size_t)page_size, (off_t)offset, 0};
+    const unsigned long start = current_time();
+    io_engine_->submit_and_wait(&request, 1);
+    const long us = elapsed_us(start);
+    pool_stats_->read(1, us);
+    file_handle->stats->read(1, us);
+    if (request.result != page_size) {
         LOG_ERROR("Failed to load page %s:%d, due to failed to read data:%s.",
-                  file_handle->file_name, page_num, strerror(errno));
+                  file_handle->file_name, page_num,
+                  request.result < 0 ? strerror(-request.result) : "short read");
+        // 页表和分片都以page_num作为frame的标识，读取失败时也不能被破坏
+        frame->page->page_num = page_num;
         return ResultCode::IOERR_READ;
     }
+    frame->page->page_num = page_num;
     return ResultCode::SUCCESS;
 }
@@ -22,28 +22,59 @@ See the Mulan PSL v2 for more details. */
 #include <sys/stat.h>
 #include <time.h>
 
+#include <atomic>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
 #include <result_code.h>
+#include <common/metrics/metrics.h>
 #include <common/mm/mem_pool.h>
 
 typedef int PageNum;
 
 //
 #define BP_INVALID_PAGE_NUM (-1)
-#define BP_PAGE_SIZE (1 << 13)
-#define BP_PAGE_DATA_SIZE (BP_PAGE_SIZE - sizeof(PageNum))
+// 页面大小是文件的属性，创建文件时确定，取值为4KiB到64KiB之间2的幂
+#define BP_MIN_PAGE_SIZE (1 << 12)
+#define BP_MAX_PAGE_SIZE (1 << 16)
+#define BP_DEFAULT_PAGE_SIZE (1 << 13)
+#define BP_PAGE_DATA_SIZE(page_size) ((page_size) - (int)sizeof(PageNum))
 #define BP_FILE_SUB_HDR_SIZE (sizeof(BPFileSubHeader))
+// 页面缓冲区的对齐粒度
+#define BP_PAGE_ALIGN 4096
 #define BP_BUFFER_SIZE 256
+// 缓冲池默认的内存预算，页面缓冲区加起来不超过这个字节数
+#define BP_DEFAULT_POOL_SIZE \
+    ((unsigned long long)(MAX_OPEN_FILE / 4) * BP_BUFFER_SIZE * BP_DEFAULT_PAGE_SIZE)
+#define BP_DEFAULT_SHARD_NUM 8
+// 刷脏页时一次写最多合并的相邻页面数
+#define BP_FLUSH_MAX_BATCH 32
+// 顺序扫描时默认预读的页面数，0表示不预读
+#define BP_DEFAULT_READAHEAD_PAGES 32
+// 预读时一次读最多合并的相邻页面数
+#define BP_READAHEAD_MAX_PAGES 64
+// 大表扫描使用的私有frame环的默认大小，0表示不使用
+#define BP_DEFAULT_SCAN_RING_PAGES 64
+// 启动时按快照预热缓冲池的默认线程数
+#define BP_DEFAULT_WARMUP_THREADS 4
+// 注册到MetricsRegistry中的统计项的tag前缀，每个文件的统计项再加上.file<file_id>
+#define BP_METRIC_TAG "DiskBufferPool"
 #define MAX_OPEN_FILE 1024
 
+// 磁盘和内存中的页面布局，整个页面的大小是所在文件的page_size
 typedef struct {
     PageNum page_num;
-    char    data[BP_PAGE_DATA_SIZE];
+    char    data[];
 } Page;
-// sizeof(Page) should be equal to BP_PAGE_SIZE
 
 typedef struct {
     PageNum page_count;
     int     allocated_pages;
+    int     page_size;
 } BPFileSubHeader;
 
 typedef struct {
@@ -52,11 +83,18 @@ typedef struct {
 } BPDisposedPages;
 
 typedef struct Frame_ {
-    bool          dirty;
-    unsigned int  pin_count;
-    unsigned long acc_time;
-    int           file_desc;
-    Page          page;
+    Frame_() = default;
+    Frame_(const Frame_&) = delete;
+    ~Frame_() { ::free(page); }
+
+    bool          dirty     = false;
+    unsigned int  pin_count = 0;
+    unsigned long acc_time  = 0;
+    int           file_desc = -1;
+    int           page_size = 0;       // page缓冲区的大小，等于所在文件的页面大小
+    Page*         page      = nullptr; // 第一次使用或者页面大小变化时才分配
+    bool          io_pending = false;  // 已经登记到页表，页面还在从磁盘读入
+    bool          io_failed  = false;  // 读盘失败，已经从页表中删除
 
     bool          can_purge() { return pin_count <= 0; }
 } Frame;
@@ -68,6 +106,60 @@ typedef struct BPPageHandle {
     Frame* frame;
 } BPPageHandle;
 
+class DiskBufferPool;
+class BPPinnedGauge;
+
+/**
+ * 缓冲池中某个文件(或者所有文件)的页面状态
+ */
+struct BPFrameCounts {
+    int resident = 0; // 缓存着的页面数
+    int pinned   = 0; // 被pin住的页面数
+    int dirty    = 0; // 脏页数
+};
+
+/**
+ * 缓冲池的统计项，整个缓冲池一份，每个打开的文件一份。
+ * 累计值供show buffer pool status使用，同时以prefix为前缀把
+ * Meter/SimpleTimer/Gauge注册到MetricsRegistry中，由MetricsStage定期输出
+ */
+class BPStats {
+    public:
+    /**
+     * @param file_desc 统计pin住的frame时只看这个文件，-1表示所有文件
+     */
+    BPStats(const std::string& prefix, DiskBufferPool* bp, int file_desc);
+    ~BPStats();
+
+    void hit() { hit_count++, hit_meter_.inc(); }
+    void miss() { miss_count++, miss_meter_.inc(); }
+    void evict() { evict_count++, evict_meter_.inc(); }
+    void read(int pages, long us) {
+        read_count += pages, read_us += us, read_timer_.update(us);
+    }
+    void write(int pages, long us) {
+        write_count += pages, write_us += us, write_timer_.update(us);
+    }
+
+    public:
+    std::atomic<unsigned long> hit_count{0};
+    std::atomic<unsigned long> miss_count{0};
+    std::atomic<unsigned long> evict_count{0};
+    std::atomic<unsigned long> read_count{0};  // 从磁盘读的页面数
+    std::atomic<unsigned long> read_us{0};     // 读盘的总耗时，微秒
+    std::atomic<unsigned long> write_count{0}; // 写回磁盘的页面数
+    std::atomic<unsigned long> write_us{0};    // 写盘的总耗时，微秒
+
+    private:
+    std::vector<std::string>   tags_; // 注册成功的tag，析构时注销
+    common::Meter              hit_meter_;
+    common::Meter              miss_meter_;
+    common::Meter              evict_meter_;
+    common::SimpleTimer        read_timer_;
+    common::SimpleTimer        write_timer_;
+    BPPinnedGauge*             pinned_gauge_;
+};
+
 class BPFileHandle {
     public:
     BPFileHandle();
@@ -81,40 +173,410 @@ class BPFileHandle {
     Page*            hdr_page;
     char*            bitmap;
     BPFileSubHeader* file_sub_header;
+    int              page_size;
+    PageNum          max_page_count; // 文件头中的位图最多能管理的页面数
+    BPStats*         stats;
+};
+
+struct BPFrameId {
+    int     file_desc;
+    PageNum page_num;
+
+    bool    operator==(const BPFrameId& other) const {
+        return file_desc == other.file_desc && page_num == other.page_num;
+    }
+};
+
+class BPFrameIdDigest {
+    public:
+    size_t operator()(const BPFrameId& frame_id) const {
+        return ((size_t)(frame_id.file_desc) << 32) |
+               (unsigned int)frame_id.page_num;
+    }
 };
 
+class BPReplacer;
+class BPIoEngine;
+class BPPageArena;
+
 class BPManager : public common::MemPoolSimple<Frame> {
     public:
     BPManager(const char* tag);
+    ~BPManager();
+
+    /**
+     * 替换页面置换策略，当前缓存的页面都会登记到新的策略中。
+     * BPManager接管replacer的生命周期
+     */
+    void              set_replacer(BPReplacer* replacer);
+    BPReplacer*       get_replacer() const { return replacer_; }
+
+    /**
+     * 页面缓冲区优先从arena中分配，arena用完时再用普通的堆内存。
+     * 需要在分配页面之前设置，BPManager接管arena的生命周期
+     */
+    void              set_page_arena(BPPageArena* arena) { arena_ = arena; }
+    BPPageArena*      get_page_arena() const { return arena_; }
+
+    /**
+     * 分片的latch。frame的pin_count、页表和置换策略都由它保护
+     */
+    void              lock() { MUTEX_LOCK(&this->mutex); }
+    void              unlock() { MUTEX_UNLOCK(&this->mutex); }
+
+    using common::MemPoolSimple<Frame>::alloc;
+
+    /**
+     * 分配一个frame，并以(file_desc, page_num)登记到页表中
+     */
+    Frame*            alloc(int file_desc, PageNum page_num,
+                            int page_size = BP_DEFAULT_PAGE_SIZE);
+
+    /**
+     * 保证frame的页面缓冲区大小是page_size，大小不同时重新分配。
+     * frame不能登记在页表中
+     */
+    bool              reserve_page(Frame* frame, int page_size);
+
+    /**
+     * 归还frame时同时释放它的页面缓冲区，空闲frame不占用内存预算
+     */
+    void              free(Frame* frame) override;
+
+    /**
+     * 设置分片的内存预算(字节)。frame本身很小，按最小页面大小准备足够的frame，
+     * 真正限制内存的是页面缓冲区的总大小。
+     * 预算变小时不会马上淘汰页面，由调用者负责淘汰到预算以内
+     */
+    void              set_capacity(size_t capacity);
+    size_t            capacity() const { return capacity_; }
+
+    /**
+     * 当前所有页面缓冲区的总字节数
+     */
+    size_t            page_bytes() const { return page_bytes_; }
+
+    /**
+     * 再放一个page_size大小的页面是否不会超出预算
+     */
+    bool              has_room(int page_size) const {
+        return page_bytes_ + page_size <= capacity_;
+    }
+    bool              over_capacity() const { return page_bytes_ > capacity_; }
+
+    void              cleanup() override;
+
+    /**
+     * 将frame重新登记为(file_desc, page_num)，原来的登记项会被删除
+     */
+    void              bind(Frame* frame, int file_desc, PageNum page_num);
+
+    /**
+     * 从页表中删除frame的登记项，frame本身仍然处于使用状态
+     */
+    void              unbind(Frame* frame);
 
+    /**
+     * 通过页表查找已经缓存的页面，时间复杂度O(1)
+     */
     Frame*            get(int file_desc, PageNum page_num);
 
+    /**
+     * 通知置换策略frame被访问了一次
+     */
+    void              access(Frame* frame);
+
+    /**
+     * 等待别的线程读完页面。调用者持有分片的latch，等待期间会释放
+     */
+    void              wait_io() { pthread_cond_wait(&io_cond_, &this->mutex); }
+
+    /**
+     * 页面读完了，唤醒所有等待的线程。调用者需要持有分片的latch
+     */
+    void              notify_io() { pthread_cond_broadcast(&io_cond_); }
+
+    /**
+     * pin_count加1，从0变成1时通知置换策略frame不能再被淘汰
+     */
+    void              pin(Frame* frame);
+
+    /**
+     * pin_count减1，降到0时通知置换策略frame可以被淘汰了。
+     * 返回pin_count是否降到了0
+     */
+    bool              unpin(Frame* frame);
+
     std::list<Frame*> find_list(int file_desc);
 
+    /**
+     * 不需要写磁盘就能直接使用的frame个数，即剩余预算能放下的默认大小页面数
+     * 加上未pin的干净frame
+     */
+    int               clean_count();
+
+    /**
+     * 找出页表中登记的所有页面
+     */
+    void              find_resident(std::vector<BPFrameId>& frame_ids);
+
+    /**
+     * 按文件统计页表中的页面，file_desc为-1的一项是所有文件的总数
+     */
+    void              count_frames(std::map<int, BPFrameCounts>& counts);
+
+    /**
+     * 找出所有未pin的脏frame
+     */
+    void              find_dirty(std::vector<Frame*>& frames);
+
+    /**
+     * 由置换策略选出一个可以淘汰的frame
+     */
     Frame*            begin_purge();
+
+    private:
+    void*             alloc_page_buffer(int page_size);
+    void              free_page_buffer(Frame* frame);
+
+    private:
+    std::unordered_map<BPFrameId, Frame*, BPFrameIdDigest> page_table_;
+    BPReplacer*                                            replacer_;
+    pthread_cond_t                                         io_cond_;
+    BPPageArena*                                           arena_      = nullptr;
+    size_t                                                 capacity_   = 0;
+    size_t                                                 page_bytes_ = 0;
+};
+
+/**
+ * 大表扫描使用的私有frame环。
+ * 扫描未命中时不再让置换策略从整个缓冲池中挑选牺牲者，
+ * 而是重复使用自己之前读入、并且已经没人使用的frame，
+ * 这样一次大扫描最多只占用环大小的frame，不会把点查询依赖的热页面都挤出去。
+ * frame属于某个分片，所以每个分片有自己的一段环
+ */
+class BPScanRing {
+    public:
+    BPScanRing(int capacity_per_shard) : capacity_per_shard_(capacity_per_shard) {}
+
+    int  capacity_per_shard() const { return capacity_per_shard_; }
+
+    private:
+    friend class DiskBufferPool;
+
+    struct Slot {
+        Frame*  frame;
+        int     file_desc;
+        PageNum page_num;
+    };
+
+    int                                              capacity_per_shard_;
+    std::unordered_map<BPManager*, std::deque<Slot>> slots_;
 };
 
 class DiskBufferPool {
     public:
     static DiskBufferPool* mk_instance() { return new DiskBufferPool(); }
 
+    /**
+     * 按BP_BUFFER_SIZE个默认大小页面为一个单位设置缓冲池的大小，
+     * 等价于set_pool_size(pool_num * BP_BUFFER_SIZE * BP_DEFAULT_PAGE_SIZE)
+     */
     static void            set_pool_num(int pool_num) {
         if (pool_num > 0) {
-            POOL_NUM = pool_num;
-            LOG_INFO("Successfully set POOL_NUM as %d", pool_num);
+            set_pool_size((unsigned long long)pool_num * BP_BUFFER_SIZE *
+                          BP_DEFAULT_PAGE_SIZE);
         } else {
             LOG_INFO("Invalid input argument pool_num:%d", pool_num);
         }
     }
 
-    static const int get_pool_num() { return POOL_NUM; }
+    static const int get_pool_num() {
+        return (int)(POOL_SIZE / ((unsigned long long)BP_BUFFER_SIZE * BP_DEFAULT_PAGE_SIZE));
+    }
+
+    /**
+     * 设置缓冲池的内存预算(字节)，需要在创建DiskBufferPool之前调用。
+     * 创建之后用resize调整
+     */
+    static void      set_pool_size(unsigned long long pool_size) {
+        if (pool_size >= BP_MAX_PAGE_SIZE) {
+            POOL_SIZE = pool_size;
+            LOG_INFO("Successfully set POOL_SIZE as %llu", pool_size);
+        } else {
+            LOG_INFO("Invalid input argument pool_size:%llu", pool_size);
+        }
+    }
+
+    static const unsigned long long get_pool_size() { return POOL_SIZE; }
+
+    /**
+     * 设置缓冲池的分片个数，需要在创建DiskBufferPool之前调用。
+     * 页面按(file_desc, page_num)散列到分片上，每个分片有自己的latch、
+     * 空闲frame列表和置换策略
+     */
+    static void      set_shard_num(int shard_num) {
+        if (shard_num > 0) {
+            SHARD_NUM = shard_num;
+            LOG_INFO("Successfully set SHARD_NUM as %d", shard_num);
+        } else {
+            LOG_INFO("Invalid input argument shard_num:%d", shard_num);
+        }
+    }
+
+    static const int get_shard_num() { return SHARD_NUM; }
+
+    /**
+     * 设置页面置换策略，需要在创建DiskBufferPool之前调用
+     * @param replacer clock 或 lru-k
+     * @param k        lru-k 使用的k值
+     */
+    static void      set_replacer(const char* replacer, int k) {
+        REPLACER = replacer;
+        LRU_K    = k;
+        LOG_INFO("Set buffer pool replacer as %s, k=%d", replacer, k);
+    }
+
+    static const std::string& get_replacer() { return REPLACER; }
+
+    /**
+     * 设置I/O引擎，需要在创建DiskBufferPool之前调用。缓冲池的页面读写都经过它
+     * @param io_engine sync 或 io_uring，io_uring不可用时退回sync
+     */
+    static void      set_io_engine(const char* io_engine) {
+        IO_ENGINE = io_engine;
+        LOG_INFO("Set buffer pool io engine as %s", io_engine);
+    }
+
+    static const std::string& get_io_engine() { return IO_ENGINE; }
+
+    /**
+     * 设置页面缓冲区是否使用大页，需要在创建DiskBufferPool之前调用
+     * @param huge_page off、thp 或 hugetlb。使用大页时每个分片的页面缓冲区
+     *                  来自一整块按大页对齐的mmap内存
+     */
+    static void      set_huge_page(const char* huge_page) {
+        HUGE_PAGE = huge_page;
+        LOG_INFO("Set buffer pool huge page as %s", huge_page);
+    }
+
+    static const std::string& get_huge_page() { return HUGE_PAGE; }
+
+    /**
+     * 设置之后创建和打开的文件是否使用O_DIRECT，绕过内核的页缓存，
+     * 页面只在缓冲池中缓存一份。文件系统不支持时退回缓冲I/O
+     */
+    static void      set_direct_io(bool direct_io) {
+        DIRECT_IO = direct_io;
+        LOG_INFO("Set buffer pool direct io as %d", direct_io);
+    }
+
+    static const bool get_direct_io() { return DIRECT_IO; }
+
+    /**
+     * 设置预热快照文件的路径，空字符串表示不保存快照
+     */
+    static void      set_warmup_file(const char* warmup_file) {
+        WARMUP_FILE = warmup_file;
+        LOG_INFO("Set buffer pool warm-up file as %s", warmup_file);
+    }
+
+    static const std::string& get_warmup_file() { return WARMUP_FILE; }
+
+    /**
+     * 设置顺序扫描时预读的页面数，0表示不预读
+     */
+    static void      set_readahead_pages(int readahead_pages) {
+        if (readahead_pages >= 0) {
+            READAHEAD_PAGES = readahead_pages;
+            LOG_INFO("Successfully set READAHEAD_PAGES as %d", readahead_pages);
+        } else {
+            LOG_INFO("Invalid input argument readahead_pages:%d", readahead_pages);
+        }
+    }
+
+    static const int get_readahead_pages() { return READAHEAD_PAGES; }
+
+    /**
+     * 设置大表扫描私有frame环的大小(页面数)，0表示不使用
+     */
+    static void      set_scan_ring_pages(int scan_ring_pages) {
+        if (scan_ring_pages >= 0) {
+            SCAN_RING_PAGES = scan_ring_pages;
+            LOG_INFO("Successfully set SCAN_RING_PAGES as %d", scan_ring_pages);
+        } else {
+            LOG_INFO("Invalid input argument scan_ring_pages:%d", scan_ring_pages);
+        }
+    }
+
+    static const int get_scan_ring_pages() { return SCAN_RING_PAGES; }
+
+    /**
+     * get_this_page 命中缓存的次数
+     */
+    unsigned long    get_hit_count() const { return pool_stats_->hit_count; }
+
+    /**
+     * get_this_page 需要从磁盘加载页面的次数
+     */
+    unsigned long    get_miss_count() const { return pool_stats_->miss_count; }
+
+    /**
+     * 为了放新页面而淘汰的页面数
+     */
+    unsigned long    get_evict_count() const { return pool_stats_->evict_count; }
+
+    /**
+     * 写回磁盘的脏页数
+     */
+    unsigned long    get_write_count() const { return pool_stats_->write_count; }
+
+    /**
+     * 预读进缓冲池的页面数
+     */
+    unsigned long    get_prefetch_count() const { return prefetch_count_; }
 
     ~DiskBufferPool();
 
+    /**
+     * 在线调整缓冲池的内存预算，平分到各个分片上。
+     * 变小时会淘汰(必要时先写回)未pin的页面，直到不超过新的预算；
+     * 被pin住的页面淘汰不掉时返回NOMEM，预算仍然按新值生效，
+     * 之后分配页面时会继续淘汰
+     */
+    ResultCode resize(unsigned long long pool_size);
+
+    /**
+     * 当前页面缓冲区占用的总字节数
+     */
+    unsigned long long get_used_bytes();
+
+    /**
+     * 按文件统计缓冲池中的页面，file_desc为-1的一项是所有文件的总数
+     */
+    void       count_frames(std::map<int, BPFrameCounts>& counts);
+
+    /**
+     * 缓冲池当前的状态：容量、每个文件缓存的页面数、pin住的页面数、
+     * 命中/未命中/淘汰/写回次数以及读写磁盘的平均耗时。
+     * 供show buffer pool status命令使用
+     */
+    std::string get_status();
+
     /**
      * 创建一个名称为指定文件名的分页文件
+     * @param page_size 文件的页面大小，BP_MIN_PAGE_SIZE到BP_MAX_PAGE_SIZE之间2的幂
+     */
+    ResultCode create_file(const char* file_name,
+                           int         page_size = BP_DEFAULT_PAGE_SIZE);
+
+    /**
+     * 判断page_size是不是支持的页面大小
      */
-    ResultCode create_file(const char* file_name);
+    static bool is_valid_page_size(int page_size) {
+        return page_size >= BP_MIN_PAGE_SIZE && page_size <= BP_MAX_PAGE_SIZE &&
+               (page_size & (page_size - 1)) == 0;
+    }
 
     /**
      * 根据文件名打开一个分页文件，返回文件ID
@@ -131,7 +593,32 @@ class DiskBufferPool {
      * 根据文件ID和页号获取指定页面到缓冲区，返回页面句柄指针。
      * @return
      */
-    ResultCode get_this_page(int file_id, PageNum page_num, BPPageHandle* page_handle);
+    ResultCode get_this_page(int file_id, PageNum page_num, BPPageHandle* page_handle,
+                             BPScanRing* ring = nullptr);
+
+    /**
+     * 文件的页面数超过缓冲池的1/4时，给即将开始的扫描创建一个私有frame环，
+     * 否则返回nullptr。环由调用者delete，环本身不持有任何pin
+     */
+    BPScanRing* create_scan_ring(int file_id);
+
+    /**
+     * 一次获取同一个文件中的多个页面。未命中的页面通过I/O引擎一起提交读请求，
+     * 并等待它们全部完成，而不是一页一页地阻塞读取。读盘期间不持有分片的latch。
+     * 任何一个页面失败时，已经拿到的页面都会被unpin
+     * @param page_nums    要获取的页号
+     * @param num          页面个数
+     * @param page_handles 返回的页面句柄，需要有num个
+     */
+    ResultCode get_pages(int file_id, const PageNum* page_nums, int num,
+                         BPPageHandle* page_handles);
+
+    /**
+     * 预读[start_page, start_page + count)中已经分配、但还没有缓存的页面。
+     * 页号连续的页面用一次向量读请求读到新分配的frame中，读完后不会pin住
+     */
+    ResultCode prefetch_pages(int file_id, PageNum start_page, int count,
+                              BPScanRing* ring = nullptr);
 
     /**
      * 在指定文件中分配一个新的页面，并将其放入缓冲区，返回页面句柄指针。
@@ -155,6 +642,12 @@ class DiskBufferPool {
      */
     ResultCode dispose_page(int file_id, PageNum page_num);
 
+    /**
+     * 去掉文件末尾已经释放的页面，缩小页面数和文件大小，以后扫描文件时不用再经过这些页面
+     * @param page_count 返回截断以后的页面数
+     */
+    ResultCode truncate_file(int file_id, int* page_count);
+
     /**
      * 释放指定文件关联的页的内存， 如果已经脏， 则刷到磁盘，除了pinned page
      * @param file_handle
@@ -181,10 +674,89 @@ class DiskBufferPool {
      */
     ResultCode get_page_count(int file_id, int* page_count);
 
+    /**
+     * 获取文件的页面大小
+     */
+    ResultCode get_page_size(int file_id, int* page_size);
+
     ResultCode purge_all_pages(int file_id);
 
+    /**
+     * 后台刷脏页。当某个分片中可直接复用的干净frame少于clean_reserve
+     * 平摊到该分片的份额时，按(文件, 页号)顺序把未pin的脏页写回磁盘，
+     * 相邻的页面合并成一次写。查询线程淘汰页面时就不用再同步写盘了
+     * @param clean_reserve 整个缓冲池希望保留的干净frame个数
+     * @param max_pages     本轮最多写回的页面数
+     * @param flushed_num   返回本轮实际写回的页面数
+     */
+    ResultCode flush_dirty_pages(int clean_reserve, int max_pages, int* flushed_num);
+
+    /**
+     * 把当前缓存着的页面以(文件名, 页号)的形式写到快照文件中，
+     * 先写临时文件再rename，写到一半崩溃也不会破坏上一次的快照。
+     * 快照中每个文件占两行：第一行是文件名，第二行是排好序的页号
+     */
+    ResultCode dump_resident_pages(const char* path);
+
+    /**
+     * 根据快照把页面重新读进缓冲池。只处理已经打开的文件，
+     * 每个文件的页号排序后按连续的段分给thread_num个线程并行读取，
+     * 缓冲池放满以后就停止，不会为了预热淘汰已经读进来的页面
+     * @param loaded_num 返回实际读进来的页面数
+     */
+    ResultCode load_resident_pages(const char* path, int thread_num, int* loaded_num);
+
     protected:
-    ResultCode allocate_page(Frame** buf);
+    size_t     shard_index(int file_desc, PageNum page_num) const {
+        return ((size_t)file_desc * 31 + page_num) % bp_managers_.size();
+    }
+    BPManager& shard_of(int file_desc, PageNum page_num) {
+        return *bp_managers_[shard_index(file_desc, page_num)];
+    }
+    BPManager& shard_of(Frame* frame) {
+        return shard_of(frame->file_desc, frame->page->page_num);
+    }
+
+    /**
+     * 从指定分片中分配一个能放下page_size大小页面的frame，
+     * 没有空闲frame时由置换策略淘汰一个。
+     * 如果给了ring并且ring在这个分片上已经满了，优先重用ring中最老的frame。
+     * 调用者需要持有分片的latch
+     */
+    ResultCode allocate_page(BPManager& bp_manager, int page_size, Frame** buf,
+                             BPScanRing* ring = nullptr);
+
+    /**
+     * 分片的预算已经用完、置换策略选中的是脏页时，先把它写回磁盘，
+     * 写盘期间释放分片的latch，接下来allocate_page就不用持有latch写盘了。
+     * 调用者通过shard_guard持有分片的latch，返回时仍然持有
+     */
+    ResultCode flush_victim(std::unique_lock<BPManager>& shard_guard, int page_size);
+
+    /**
+     * 读盘结束，清除frame的io_pending并唤醒等待它的线程。调用者持有分片的latch，
+     * 读盘前已经pin住了frame。读盘失败时把frame从页表中摘掉并unpin，
+     * 之后调用者不能再访问它
+     */
+    void       finish_load(BPManager& bp_manager, Frame* frame, PageNum page_num,
+                           bool success);
+
+    /**
+     * frame是别的线程正在读入的页面时，等它读完。
+     * 调用者持有分片的latch并且已经pin住了frame，读盘失败时frame会被unpin
+     */
+    ResultCode wait_for_load(BPManager& bp_manager, Frame* frame);
+
+    /**
+     * 淘汰分片中未pin的页面，直到页面缓冲区的总大小不超过分片的预算。
+     * 调用者需要持有分片的latch
+     */
+    ResultCode evict_to_capacity(BPManager& bp_manager);
+
+    /**
+     * 把刚读入并且已经登记到页表的frame放进ring
+     */
+    void       add_to_ring(BPScanRing* ring, BPManager& bp_manager, Frame* frame);
 
     /**
      * 刷新指定文件关联的所有脏页到磁盘，除了pinned page
@@ -199,15 +771,77 @@ class DiskBufferPool {
     ResultCode load_page(PageNum page_num, BPFileHandle* file_handle, Frame* frame);
     ResultCode flush_page(Frame* frame);
 
+    /**
+     * 把frame的页面写到磁盘上，不修改dirty标记
+     */
+    ResultCode write_page(Frame* frame);
+
+    /**
+     * 把同一个文件中按页号排好序的frames写回磁盘，页号连续的一段是一个向量写请求，
+     * 所有请求一起提交给I/O引擎。某一段写失败时其余段照常写，失败的页面放到failed中。
+     * 不修改dirty标记。调用者不持有分片的latch，并且已经pin住了这些frame
+     */
+    ResultCode flush_pages(const std::vector<Frame*>& frames, std::vector<Frame*>& failed);
+
+    /**
+     * 把frames对应的一批连续页面用一次写请求写回磁盘，
+     * frames已经被pin住，页面内容已经拷贝到buffer中
+     */
+    ResultCode flush_batch(std::vector<Frame*>& frames, const char* buffer);
+
+    /**
+     * 预读：每个run是一段页号连续、已经登记到页表并标记io_pending的frame，
+     * 一个run是一个向量读请求，所有请求一起提交。读完后逐个frame在分片的latch下
+     * 结束读盘并unpin，没有读全的页面直接丢掉。调用者不能持有分片的latch
+     */
+    void       read_runs(std::vector<std::vector<Frame*>>& runs);
+
+    /**
+     * 把一次统计同时记到整个缓冲池和file_desc对应的文件上
+     */
+    template <typename F>
+    void       record(int file_desc, F update);
+
+    /**
+     * 关闭文件时注销并释放文件的统计项
+     */
+    void       remove_file_stats(BPFileHandle* file_handle);
+
     private:
     DiskBufferPool();
 
     private:
-    BPManager                      bp_manager_;
+    std::vector<BPManager*>        bp_managers_;
     BPFileHandle*                  open_list_[MAX_OPEN_FILE] = {nullptr};
     std::map<int, BPDisposedPages> disposed_pages;
-
-    static int                     POOL_NUM;
+    // 保护open_list_、文件头(页面位图)以及disposed_pages
+    pthread_mutex_t                file_mutex_;
+    BPIoEngine*                    io_engine_ = nullptr;
+    std::atomic<unsigned long>     prefetch_count_{0};
+    // 脏页被unpin(变成可以刷盘)时加1。和clean_version_相等说明
+    // 上次后台刷盘检查之后没有出现新的可刷脏页，这一轮什么都不用做
+    std::atomic<unsigned long>     dirty_version_{0};
+    unsigned long                  clean_version_ = 0;
+    // 后台刷盘用的对齐缓冲区，第一次写盘时分配，之后一直复用。
+    // flush_mutex_保护它和clean_version_
+    char*                          flush_buffer_ = nullptr;
+    pthread_mutex_t                flush_mutex_;
+    BPStats*                       pool_stats_ = nullptr;
+    // 按file_desc查找文件的统计项，淘汰和写盘时只知道frame的file_desc。
+    // stats_mutex_在所有锁之后获取
+    std::unordered_map<int, BPStats*> file_stats_;
+    pthread_mutex_t                stats_mutex_;
+
+    static unsigned long long      POOL_SIZE;
+    static int                     SHARD_NUM;
+    static std::string             REPLACER;
+    static int                     LRU_K;
+    static std::string             IO_ENGINE;
+    static std::string             HUGE_PAGE;
+    static bool                    DIRECT_IO;
+    static std::string             WARMUP_FILE;
+    static int                     READAHEAD_PAGES;
+    static int                     SCAN_RING_PAGES;
 };
 
 DiskBufferPool* theGlobalDiskBufferPool();
@@ -0,0 +1,128 @@
+/* Copyright (c) 2021 Xie Meiyi(xiemeiyi@hust.edu.cn) and OceanBase and/or its
+affiliates. All rights reserved. miniob is licensed under Mulan PSL v2. You can
+use this software according to the terms and conditions of the Mulan PSL v2. You
+may obtain a copy of Mulan PSL v2 at: http://license.coscl.org.cn/MulanPSL2 THIS
+SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND, EITHER
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include <string>
+
+#include <storage/default/table_vacuum_stage.h>
+
+#include <common/conf/ini.h>
+#include <common/lang/string.h>
+#include <common/log/log.h>
+#include <common/seda/timer_stage.h>
+#include <storage/default/default_handler.h>
+
+using namespace common;
+
+const char* CONF_VACUUM_INTERVAL  = "VacuumIntervalMs";
+const char* CONF_VACUUM_MAX_PAGES = "VacuumMaxPages";
+
+//! Constructor
+TableVacuumStage::TableVacuumStage(const char* tag) : Stage(tag) {}
+
+//! Destructor
+TableVacuumStage::~TableVacuumStage() {}
+
+//! Parse properties, instantiate a stage object
+Stage* TableVacuumStage::make_stage(const std::string& tag) {
+    TableVacuumStage* stage = new (std::nothrow) TableVacuumStage(tag.c_str());
+    if (stage == nullptr) {
+        LOG_ERROR("new TableVacuumStage failed");
+        return nullptr;
+    }
+    stage->set_properties();
+    return stage;
+}
+
+//! Set properties for this object set in stage specific properties
+bool TableVacuumStage::set_properties() {
+    std::string                        stage_name_str(stage_name_);
+    std::map<std::string, std::string> section =
+        get_properties()->get(stage_name_str);
+
+    auto it = section.find(CONF_VACUUM_INTERVAL);
+    if (it != section.end()) {
+        str_to_val(it->second, vacuum_interval_ms_);
+    }
+    it = section.find(CONF_VACUUM_MAX_PAGES);
+    if (it != section.end()) {
+        str_to_val(it->second, vacuum_max_pages_);
+    }
+
+    if (vacuum_interval_ms_ <= 0) {
+        LOG_WARN("Invalid vacuum interval %d, use 10000ms", vacuum_interval_ms_);
+        vacuum_interval_ms_ = 10000;
+    }
+    LOG_INFO("Table vacuum: interval=%dms, max pages=%d", vacuum_interval_ms_,
+             vacuum_max_pages_);
+    return true;
+}
+
+//! Initialize stage params and validate outputs
+bool TableVacuumStage::initialize() {
+    LOG_TRACE("Enter");
+
+    std::list<Stage*>::iterator stgp = next_stage_list_.begin();
+    timer_stage_                     = *(stgp++);
+
+    TableVacuumEvent* vacuum_event = new TableVacuumEvent();
+    add_event(vacuum_event);
+
+    LOG_TRACE("Exit");
+    return true;
+}
+
+//! Cleanup after disconnection
+void TableVacuumStage::cleanup() {
+    LOG_TRACE("Enter");
+
+    LOG_TRACE("Exit");
+}
+
+void TableVacuumStage::handle_event(StageEvent* event) {
+    LOG_TRACE("Enter\n");
+
+    CompletionCallback* cb = new (std::nothrow) CompletionCallback(this, nullptr);
+    if (cb == nullptr) {
+        LOG_ERROR("Failed to new callback");
+        event->done();
+        return;
+    }
+
+    TimerRegisterEvent* tm_event = new (std::nothrow) TimerRegisterEvent(
+        event, (u64_t)vacuum_interval_ms_ * (USEC_PER_SEC / 1000));
+    if (tm_event == nullptr) {
+        LOG_ERROR("Failed to new TimerRegisterEvent");
+        delete cb;
+        event->done();
+        return;
+    }
+
+    event->push_callback(cb);
+    timer_stage_->add_event(tm_event);
+
+    LOG_TRACE("Exit\n");
+}
+
+void TableVacuumStage::callback_event(StageEvent*      event,
+                                      CallbackContext* context) {
+    LOG_TRACE("Enter\n");
+
+    int        moved_pages = 0;
+    ResultCode rc = DefaultHandler::get_default().vacuum(vacuum_max_pages_, &moved_pages);
+    if (rc != ResultCode::SUCCESS) {
+        LOG_WARN("Failed to vacuum tables in background. rc=%d:%s", rc, strrc(rc));
+    } else if (moved_pages > 0) {
+        LOG_INFO("Vacuumed %d pages in background", moved_pages);
+    }
+
+    // do it again.
+    add_event(event);
+
+    LOG_TRACE("Exit\n");
+}
@@ -0,0 +1,53 @@
+/* Copyright (c) 2021 Xie Meiyi(xiemeiyi@hust.edu.cn) and OceanBase and/or its
+affiliates. All rights reserved. miniob is licensed under Mulan PSL v2. You can
+use this software according to the terms and conditions of the Mulan PSL v2. You
+may obtain a copy of Mulan PSL v2 at: http://license.coscl.org.cn/MulanPSL2 THIS
+SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND, EITHER
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#ifndef __OBSERVER_STORAGE_DEFAULT_TABLE_VACUUM_STAGE_H__
+#define __OBSERVER_STORAGE_DEFAULT_TABLE_VACUUM_STAGE_H__
+
+#include <common/seda/stage.h>
+#include <common/seda/stage_event.h>
+
+/**
+ * 后台整理数据文件的定时事件
+ */
+class TableVacuumEvent : public common::StageEvent {
+    public:
+    TableVacuumEvent() {}
+    ~TableVacuumEvent() {}
+};
+
+/**
+ * 借助TimerStage周期性地整理所有打开的表，把删除记录以后留下的空闲空间集中起来，
+ * 释放空出来的页面。每一轮每个表只搬有限的页面，避免长时间挡住其它操作
+ */
+class TableVacuumStage : public common::Stage {
+    public:
+    ~TableVacuumStage();
+    static Stage* make_stage(const std::string& tag);
+
+    protected:
+    // common function
+    TableVacuumStage(const char* tag);
+    bool set_properties() override;
+
+    bool initialize() override;
+    void cleanup() override;
+    void handle_event(common::StageEvent* event) override;
+    void callback_event(common::StageEvent*      event,
+                        common::CallbackContext* context) override;
+
+    private:
+    Stage* timer_stage_        = nullptr;
+    // 每隔 @vacuum_interval_ms_ 毫秒整理一次
+    int    vacuum_interval_ms_ = 10000;
+    // 每个表每一轮最多搬空的页面数
+    int    vacuum_max_pages_   = 16;
+};
+
+#endif //__OBSERVER_STORAGE_DEFAULT_TABLE_VACUUM_STAGE_H__
@@ -20,7 +20,9 @@ See the Mulan PSL v2 for more details. */
 #include <storage/transaction/transaction.h>
 
 static const uint32_t DELETED_FLAG_BIT_MASK   = 0x80000000;
-static const uint32_t transaction_ID_BIT_MASK = 0x7FFFFFFF;
+// 记录被未提交的事务原地修改过，其它事务仍然能看到
+static const uint32_t UPDATED_FLAG_BIT_MASK   = 0x40000000;
+static const uint32_t transaction_ID_BIT_MASK = 0x3FFFFFFF;
 
 int32_t Transaction::default_transaction_id() { return 0; }
 
@@ -37,7 +39,14 @@ int         Transaction::transaction_field_len() { return sizeof(int32_t); }
 
 Transaction::Transaction() {}
 
-Transaction::~Transaction() {}
+Transaction::~Transaction() {
+    // 会话在事务中途断开时既没有提交也没有回滚。回滚未提交的修改，
+    // 同时释放表上的pending计数，否则这些表以后都不能vacuum了
+    if (!operations_.empty()) {
+        LOG_INFO("Rollback unfinished transaction %d", transaction_id_);
+        rollback();
+    }
+}
 
 ResultCode Transaction::insert_record(Table* table, Record* record) {
     ResultCode rc = ResultCode::SUCCESS;
@@ -64,6 +73,14 @@ ResultCode Transaction::delete_record(Table* table, Record* record) {
         if (old_oper->type() == Operation::Type::INSERT) {
             delete_operation(table, record->rid);
             return ResultCode::SUCCESS;
+        } else if (old_oper->type() == Operation::Type::UPDATE) {
+            // 保留修改前的数据，回滚时先恢复数据再去掉删除标记
+            std::string old_record = old_oper->old_record();
+            delete_operation(table, record->rid);
+            set_record_transaction_id(table, *record, transaction_id_, true);
+            insert_operation(table, Operation::Type::DELETE, record->rid,
+                             std::move(old_record));
+            return ResultCode::SUCCESS;
         } else {
             return ResultCode::GENERIC_ERROR;
         }
@@ -73,6 +90,49 @@ ResultCode Transaction::delete_record(Table* table, Record* record) {
     return rc;
 }
 
+ResultCode Transaction::update_record(Table* table, Record* record) {
+    start_if_not_started();
+    Operation* old_oper = find_operation(table, record->rid);
+    if (old_oper != nullptr) {
+        // 本事务插入的记录回滚时直接删除，修改过的记录已经保存了最早的数据
+        if (old_oper->type() == Operation::Type::INSERT ||
+            old_oper->type() == Operation::Type::UPDATE) {
+            return ResultCode::SUCCESS;
+        }
+        return ResultCode::GENERIC_ERROR;
+    }
+
+    // 别的未提交事务插入、删除或者修改过的记录不能再修改，否则它回滚时会覆盖这次修改
+    int32_t record_transaction_id;
+    bool    record_deleted;
+    bool    record_updated;
+    get_record_transaction_id(table, *record, record_transaction_id, record_deleted,
+                              record_updated);
+    if (record_transaction_id != 0 && record_transaction_id != transaction_id_) {
+        return ResultCode::LOCKED;
+    }
+
+    // 记录上标记本事务的修改，其它事务仍然能看到这条记录
+    insert_operation(table, Operation::Type::UPDATE, record->rid,
+                     std::string(record->data, table->table_meta().record_size()));
+    *record_transaction_field(table, *record) = transaction_id_ | UPDATED_FLAG_BIT_MASK;
+    return ResultCode::SUCCESS;
+}
+
+void Transaction::clear_update_mark(Table* table, Record& record) const {
+    // 提交或回滚之前记录又被删除的话，标记已经被删除标记替换了
+    int32_t* ptransaction_id = record_transaction_field(table, record);
+    if (*ptransaction_id == (int32_t)(transaction_id_ | UPDATED_FLAG_BIT_MASK)) {
+        *ptransaction_id = 0;
+    }
+}
+
+int32_t* Transaction::record_transaction_field(Table* table, const Record& record) {
+    const FieldMeta* transaction_field =
+        table->table_meta().transaction_field();
+    return (int32_t*)(record.data + transaction_field->offset());
+}
+
 void Transaction::set_record_transaction_id(Table* table, Record& record,
                                             int32_t transaction_id,
                                             bool    deleted) const {
@@ -88,13 +148,11 @@ void Transaction::set_record_transaction_id(Table* table, Record& record,
 
 void Transaction::get_record_transaction_id(Table* table, const Record& record,
                                             int32_t& transaction_id,
-                                            bool&    deleted) {
-    const FieldMeta* transaction_field =
-        table->table_meta().transaction_field();
-    int32_t transaction =
-        *(int32_t*)(record.data + transaction_field->offset());
+                                            bool& deleted, bool& updated) {
+    int32_t transaction = *record_transaction_field(table, record);
     transaction_id = transaction & transaction_ID_BIT_MASK;
     deleted        = (transaction & DELETED_FLAG_BIT_MASK) != 0;
+    updated        = (transaction & UPDATED_FLAG_BIT_MASK) != 0;
 }
 
 Operation* Transaction::find_operation(Table* table, const RID& rid) {
@@ -114,9 +172,14 @@ Operation* Transaction::find_operation(Table* table, const RID& rid) {
 }
 
 void Transaction::insert_operation(Table* table, Operation::Type type,
-                                   const RID& rid) {
-    OperationSet& table_operations = operations_[table];
-    table_operations.emplace(type, rid);
+                                   const RID& rid, std::string old_record) {
+    auto iter = operations_.find(table);
+    if (iter == operations_.end()) {
+        // 事务结束前这个表不能整理，否则记着的记录位置会失效
+        table->add_pending_transaction();
+        iter = operations_.emplace(table, OperationSet()).first;
+    }
+    iter->second.emplace(type, rid, std::move(old_record));
 }
 
 void Transaction::delete_operation(Table* table, const RID& rid) {
@@ -161,6 +224,15 @@ ResultCode Transaction::commit() {
                               rid.page_num, rid.slot_num, rc, strrc(rc));
                 }
             } break;
+            case Operation::Type::UPDATE: {
+                // 新的数据已经写在记录上了，去掉修改标记
+                rc = table->commit_update(this, rid);
+                if (rc != ResultCode::SUCCESS) {
+                    LOG_ERROR("Failed to commit update operation. rid=%d.%d, "
+                              "rc=%d:%s",
+                              rid.page_num, rid.slot_num, rc, strrc(rc));
+                }
+            } break;
             default: {
                 LOG_PANIC("Unknown operation. type=%d", (int)operation.type());
             } break;
@@ -168,6 +240,9 @@ ResultCode Transaction::commit() {
         }
     }
 
+    for (const auto& table_operations : operations_) {
+        table_operations.first->remove_pending_transaction();
+    }
     operations_.clear();
     transaction_id_ = 0;
     return rc;
@@ -194,7 +269,26 @@ ResultCode Transaction::rollback() {
                               rid.page_num, rid.slot_num, rc, strrc(rc));
                 }
             } break;
+            case Operation::Type::UPDATE: {
+                rc = table->rollback_update(this, rid,
+                                            operation.old_record().data());
+                if (rc != ResultCode::SUCCESS) {
+                    // handle rc
+                    LOG_ERROR("Failed to rollback update operation. rid=%d.%d, "
+                              "rc=%d:%s",
+                              rid.page_num, rid.slot_num, rc, strrc(rc));
+                }
+            } break;
             case Operation::Type::DELETE: {
+                if (!operation.old_record().empty()) {
+                    rc = table->rollback_update(this, rid,
+                                                operation.old_record().data());
+                    if (rc != ResultCode::SUCCESS) {
+                        LOG_ERROR("Failed to rollback update operation. "
+                                  "rid=%d.%d, rc=%d:%s",
+                                  rid.page_num, rid.slot_num, rc, strrc(rc));
+                    }
+                }
                 rc = table->rollback_delete(this, rid);
                 if (rc != ResultCode::SUCCESS) {
                     // handle rc
@@ -210,6 +304,9 @@ ResultCode Transaction::rollback() {
         }
     }
 
+    for (const auto& table_operations : operations_) {
+        table_operations.first->remove_pending_transaction();
+    }
     operations_.clear();
     transaction_id_ = 0;
     return rc;
@@ -228,14 +325,19 @@ ResultCode Transaction::rollback_delete(Table* table, Record& record) {
 bool Transaction::is_visible(Table* table, const Record* record) {
     int32_t record_transaction_id;
     bool    record_deleted;
+    bool    record_updated;
     get_record_transaction_id(table, *record, record_transaction_id,
-                              record_deleted);
+                              record_deleted, record_updated);
 
     // 0 表示这条数据已经提交
     if (0 == record_transaction_id ||
         record_transaction_id == transaction_id_) {
         return !record_deleted;
     }
+    // 别的事务原地修改过的记录仍然可见
+    if (record_updated) {
+        return true;
+    }
 
     return record_deleted; // 当前记录上面有事务号，说明是未提交数据，那么如果有删除标记的话，就表示是未提交的删除
 }
@@ -17,6 +17,7 @@ See the Mulan PSL v2 for more details. */
 #include <stddef.h>
 
 #include <mutex>
+#include <string>
 #include <unordered_map>
 #include <unordered_set>
 
@@ -38,15 +39,24 @@ class Operation {
     public:
     Operation(Type type, const RID& rid)
         : type_(type), page_num_(rid.page_num), slot_num_(rid.slot_num) {}
+    Operation(Type type, const RID& rid, std::string old_record)
+        : type_(type), page_num_(rid.page_num), slot_num_(rid.slot_num),
+          old_record_(std::move(old_record)) {}
 
-    Type    type() const { return type_; }
-    PageNum page_num() const { return page_num_; }
-    SlotNum slot_num() const { return slot_num_; }
+    Type               type() const { return type_; }
+    PageNum            page_num() const { return page_num_; }
+    SlotNum            slot_num() const { return slot_num_; }
+
+    /**
+     * 记录在本事务中第一次被修改前的数据，回滚时用来恢复。没有修改过时为空
+     */
+    const std::string& old_record() const { return old_record_; }
 
     private:
-    Type    type_;
-    PageNum page_num_;
-    SlotNum slot_num_;
+    Type        type_;
+    PageNum     page_num_;
+    SlotNum     slot_num_;
+    std::string old_record_;
 };
 class OperationHasher {
     public:
@@ -83,12 +93,24 @@ class Transaction {
     ResultCode   insert_record(Table* table, Record* record);
     ResultCode   delete_record(Table* table, Record* record);
 
+    /**
+     * 原地修改记录之前调用，record中还是修改前的数据。
+     * 同一条记录只保留第一次修改前的数据，回滚时恢复。
+     * 记录属于别的未提交事务时返回LOCKED
+     */
+    ResultCode   update_record(Table* table, Record* record);
+
     ResultCode   commit();
     ResultCode   rollback();
 
     ResultCode   commit_insert(Table* table, Record& record);
     ResultCode   rollback_delete(Table* table, Record& record);
 
+    /**
+     * 提交或回滚修改时去掉记录上本事务的修改标记
+     */
+    void         clear_update_mark(Table* table, Record& record) const;
+
     bool is_visible(Table* table, const Record* record);
 
     void init_transaction_info(Table* table, Record& record);
@@ -98,14 +120,16 @@ class Transaction {
                                           int32_t transaction_id, bool deleted) const;
     static void get_record_transaction_id(Table* table, const Record& record,
                                           int32_t& transaction_id,
-                                          bool&    deleted);
+                                          bool& deleted, bool& updated);
+    static int32_t* record_transaction_field(Table* table, const Record& record);
 
     private:
     using OperationSet =
         std::unordered_set<Operation, OperationHasher, OperationEqualer>;
 
     Operation* find_operation(Table* table, const RID& rid);
-    void insert_operation(Table* table, Operation::Type type, const RID& rid);
+    void insert_operation(Table* table, Operation::Type type, const RID& rid,
+                          std::string old_record = std::string());
     void delete_operation(Table* table, const RID& rid);
 
     private:
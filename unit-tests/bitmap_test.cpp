@@ -12,10 +12,17 @@ See the Mulan PSL v2 for more details. */
 //
 
 #include <string.h>
+#include <time.h>
 
 #include <common/lang/bitmap.h>
 #include <gtest/gtest.h>
+#include <iostream>
 #include <sstream>
+#include <vector>
+
+// 压测使用的位图大小，和一个8K页面的slot数量级相当
+#define BENCH_BITMAP_SIZE 8000
+#define BENCH_ROUNDS 2000
 
 using namespace common;
 
@@ -63,6 +70,172 @@ TEST(test_bitmap, test_bitmap) {
     buf3[1] = 0;
     ASSERT_EQ(8, bitmap3.next_unsetted_bit(0));
     ASSERT_EQ(16, bitmap3.next_setted_bit(8));
+
+    // 起始字节里没有要找的位时，后面的字节要从第0位开始找
+    memset(buf3, 0, sizeof(buf3));
+    buf3[1] = 0x01;
+    ASSERT_EQ(8, bitmap3.next_setted_bit(3));
+    memset(buf3, -1, sizeof(buf3));
+    buf3[1] = (char)0xfe;
+    ASSERT_EQ(8, bitmap3.next_unsetted_bit(3));
+}
+
+/**
+ * 逐位判断的参考实现，用来校验结果和对比性能
+ */
+static int naive_next_bit(const char* buf, int size, int start, bool setted) {
+    for (int i = start; i < size; i++) {
+        if (((buf[i / 8] & (1 << (i % 8))) != 0) == setted) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static void fill_random(char* buf, int bytes, unsigned int seed, int density) {
+    for (int i = 0; i < bytes; i++) {
+        char byte = 0;
+        for (int bit = 0; bit < 8; bit++) {
+            if ((int)(rand_r(&seed) % 100) < density) {
+                byte |= 1 << bit;
+            }
+        }
+        buf[i] = byte;
+    }
+}
+
+TEST(test_bitmap, test_word_boundary) {
+    // 130位跨过两个64位字，末尾还剩2位
+    char buf[17];
+    memset(buf, 0, sizeof(buf));
+    Bitmap bitmap(buf, 130);
+    ASSERT_EQ(0, bitmap.count_setted_bits());
+    bitmap.set_bit(63);
+    bitmap.set_bit(64);
+    bitmap.set_bit(129);
+    ASSERT_EQ(3, bitmap.count_setted_bits());
+    ASSERT_EQ(63, bitmap.next_setted_bit(0));
+    ASSERT_EQ(64, bitmap.next_setted_bit(64));
+    ASSERT_EQ(129, bitmap.next_setted_bit(65));
+    ASSERT_EQ(-1, bitmap.next_setted_bit(130));
+
+    std::vector<int> setted;
+    bitmap.for_each_setted_bit([&](int index) { setted.push_back(index); });
+    ASSERT_EQ((std::vector<int>{63, 64, 129}), setted);
+
+    // 位图之外的位不能算进来
+    memset(buf, -1, 16);
+    buf[16] = (char)0xfe;
+    ASSERT_EQ(129, bitmap.count_setted_bits());
+    ASSERT_EQ(128, bitmap.next_unsetted_bit(0));
+    bitmap.set_bit(128);
+    ASSERT_EQ(130, bitmap.count_setted_bits());
+    ASSERT_EQ(-1, bitmap.next_unsetted_bit(0));
+
+    memset(buf, 0, 16);
+    buf[16] = (char)0xfe;
+    bitmap.set_bit(61);
+    bitmap.set_bit(63);
+    bitmap.set_bit(64);
+    bitmap.set_bit(128);
+
+    int indexes[4];
+    ASSERT_EQ(4, bitmap.next_unsetted_bits(60, 4, indexes));
+    ASSERT_EQ(60, indexes[0]);
+    ASSERT_EQ(62, indexes[1]);
+    ASSERT_EQ(65, indexes[2]);
+    ASSERT_EQ(66, indexes[3]);
+    ASSERT_EQ(0, bitmap.next_unsetted_bits(128, 4, indexes));
+    ASSERT_EQ(1, bitmap.next_unsetted_bits(127, 4, indexes));
+    ASSERT_EQ(127, indexes[0]);
+}
+
+TEST(test_bitmap, test_random) {
+    const int         size = BENCH_BITMAP_SIZE + 5;
+    std::vector<char> buf((size + 7) / 8);
+    for (int density : {1, 50, 99}) {
+        fill_random(buf.data(), buf.size(), density, density);
+        Bitmap bitmap(buf.data(), size);
+
+        int count = 0;
+        int prev  = -1;
+        bitmap.for_each_setted_bit([&](int index) {
+            ASSERT_EQ(naive_next_bit(buf.data(), size, prev + 1, true), index);
+            prev = index;
+            count++;
+        });
+        ASSERT_EQ(-1, naive_next_bit(buf.data(), size, prev + 1, true));
+        ASSERT_EQ(count, bitmap.count_setted_bits());
+
+        for (int start = 0; start < size; start += 7) {
+            ASSERT_EQ(naive_next_bit(buf.data(), size, start, true),
+                      bitmap.next_setted_bit(start));
+            ASSERT_EQ(naive_next_bit(buf.data(), size, start, false),
+                      bitmap.next_unsetted_bit(start));
+        }
+
+        std::vector<int> indexes(size);
+        int              found = bitmap.next_unsetted_bits(0, size, indexes.data());
+        ASSERT_EQ(size - count, found);
+    }
+}
+
+static unsigned long bench_now() {
+    struct timespec tp;
+    clock_gettime(CLOCK_MONOTONIC, &tp);
+    return tp.tv_sec * 1000 * 1000 * 1000UL + tp.tv_nsec;
+}
+
+/**
+ * 对比逐位查找和按64位字查找遍历整个位图的耗时，
+ * density是置位的百分比，模拟不同填充率的页面
+ */
+static void bench_scan(int density) {
+    const int         size = BENCH_BITMAP_SIZE;
+    std::vector<char> buf((size + 7) / 8);
+    fill_random(buf.data(), buf.size(), 1, density);
+    Bitmap bitmap(buf.data(), size);
+
+    long          naive_sum = 0;
+    unsigned long begin     = bench_now();
+    for (int round = 0; round < BENCH_ROUNDS; round++) {
+        for (int i = naive_next_bit(buf.data(), size, 0, true); i >= 0;
+             i = naive_next_bit(buf.data(), size, i + 1, true)) {
+            naive_sum += i;
+        }
+    }
+    unsigned long naive_ns = bench_now() - begin;
+
+    long word_sum = 0;
+    begin         = bench_now();
+    for (int round = 0; round < BENCH_ROUNDS; round++) {
+        bitmap.for_each_setted_bit([&](int index) { word_sum += index; });
+    }
+    unsigned long word_ns = bench_now() - begin;
+
+    long next_sum = 0;
+    begin         = bench_now();
+    for (int round = 0; round < BENCH_ROUNDS; round++) {
+        for (int i = bitmap.next_setted_bit(0); i >= 0;
+             i = bitmap.next_setted_bit(i + 1)) {
+            next_sum += i;
+        }
+    }
+    unsigned long next_ns = bench_now() - begin;
+
+    ASSERT_EQ(naive_sum, word_sum);
+    ASSERT_EQ(naive_sum, next_sum);
+    std::cout << "bitmap scan: density=" << density << "%"
+              << ", naive=" << naive_ns / BENCH_ROUNDS << "ns"
+              << ", next_setted_bit=" << next_ns / BENCH_ROUNDS << "ns"
+              << ", for_each_setted_bit=" << word_ns / BENCH_ROUNDS << "ns"
+              << std::endl;
+}
+
+TEST(test_bitmap, bench_scan) {
+    bench_scan(1);
+    bench_scan(50);
+    bench_scan(99);
 }
 
 int main(int argc, char** argv) {
@@ -0,0 +1,126 @@
+/* Copyright (c) 2021 Xie Meiyi(xiemeiyi@hust.edu.cn) and OceanBase and/or its
+affiliates. All rights reserved. miniob is licensed under Mulan PSL v2. You can
+use this software according to the terms and conditions of the Mulan PSL v2. You
+may obtain a copy of Mulan PSL v2 at: http://license.coscl.org.cn/MulanPSL2 THIS
+SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND, EITHER
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include <storage/default/bp_io_engine.h>
+#include <gtest/gtest.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <iostream>
+#include <vector>
+
+#define TEST_BLOCK_SIZE 4096
+// 超过一个ring的容量，需要分几次提交
+#define TEST_BLOCK_NUM (BP_IO_URING_ENTRIES * 2 + 5)
+
+static const char* test_file_name = "bp_io_engine_test.data";
+
+static void test_engine(BPIoEngine* engine) {
+    ::remove(test_file_name);
+    int fd = open(test_file_name, O_RDWR | O_CREAT, S_IREAD | S_IWRITE);
+    ASSERT_GE(fd, 0);
+
+    std::vector<char>        data(TEST_BLOCK_SIZE * TEST_BLOCK_NUM);
+    std::vector<BPIoRequest> requests(TEST_BLOCK_NUM);
+    for (int i = 0; i < TEST_BLOCK_NUM; i++) {
+        memset(&data[i * TEST_BLOCK_SIZE], 'a' + i % 26, TEST_BLOCK_SIZE);
+        requests[i] = BPIoRequest{fd, true, &data[i * TEST_BLOCK_SIZE],
+                                  TEST_BLOCK_SIZE, (off_t)i * TEST_BLOCK_SIZE, 0};
+    }
+    engine->submit_and_wait(requests.data(), TEST_BLOCK_NUM);
+    for (int i = 0; i < TEST_BLOCK_NUM; i++) {
+        ASSERT_EQ(TEST_BLOCK_SIZE, requests[i].result);
+    }
+
+    // 倒序读回来
+    std::vector<char> read_data(data.size(), 0);
+    for (int i = 0; i < TEST_BLOCK_NUM; i++) {
+        int block   = TEST_BLOCK_NUM - 1 - i;
+        requests[i] = BPIoRequest{fd, false, &read_data[block * TEST_BLOCK_SIZE],
+                                  TEST_BLOCK_SIZE, (off_t)block * TEST_BLOCK_SIZE, 0};
+    }
+    engine->submit_and_wait(requests.data(), TEST_BLOCK_NUM);
+    for (int i = 0; i < TEST_BLOCK_NUM; i++) {
+        ASSERT_EQ(TEST_BLOCK_SIZE, requests[i].result);
+    }
+    ASSERT_EQ(0, memcmp(data.data(), read_data.data(), data.size()));
+
+    // 向量读写：两个请求各覆盖一段连续的块，每块一个缓冲区
+    struct iovec iov[TEST_BLOCK_NUM];
+    for (int i = 0; i < TEST_BLOCK_NUM; i++) {
+        memset(&data[i * TEST_BLOCK_SIZE], 'A' + i % 26, TEST_BLOCK_SIZE);
+        iov[i].iov_base = &data[i * TEST_BLOCK_SIZE];
+        iov[i].iov_len  = TEST_BLOCK_SIZE;
+    }
+    const int   half = TEST_BLOCK_NUM / 2;
+    BPIoRequest vector_requests[2] = {
+        BPIoRequest{fd, true, nullptr, (size_t)half * TEST_BLOCK_SIZE, 0, 0, iov, half},
+        BPIoRequest{fd, true, nullptr, (size_t)(TEST_BLOCK_NUM - half) * TEST_BLOCK_SIZE,
+                    (off_t)half * TEST_BLOCK_SIZE, 0, iov + half, TEST_BLOCK_NUM - half}};
+    engine->submit_and_wait(vector_requests, 2);
+    ASSERT_EQ((ssize_t)vector_requests[0].size, vector_requests[0].result);
+    ASSERT_EQ((ssize_t)vector_requests[1].size, vector_requests[1].result);
+
+    memset(read_data.data(), 0, read_data.size());
+    for (int i = 0; i < TEST_BLOCK_NUM; i++) {
+        iov[i].iov_base = &read_data[i * TEST_BLOCK_SIZE];
+    }
+    for (BPIoRequest& request : vector_requests) {
+        request.write  = false;
+        request.result = 0;
+    }
+    engine->submit_and_wait(vector_requests, 2);
+    ASSERT_EQ((ssize_t)vector_requests[0].size, vector_requests[0].result);
+    ASSERT_EQ((ssize_t)vector_requests[1].size, vector_requests[1].result);
+    ASSERT_EQ(0, memcmp(data.data(), read_data.data(), data.size()));
+
+    // 读文件末尾之后的数据
+    BPIoRequest eof_request{fd, false, read_data.data(), TEST_BLOCK_SIZE,
+                            (off_t)TEST_BLOCK_NUM * TEST_BLOCK_SIZE, -1};
+    engine->submit_and_wait(&eof_request, 1);
+    ASSERT_EQ(0, eof_request.result);
+
+    // 无效的文件描述符
+    BPIoRequest bad_request{-1, false, read_data.data(), TEST_BLOCK_SIZE, 0, 0};
+    engine->submit_and_wait(&bad_request, 1);
+    ASSERT_EQ(-EBADF, bad_request.result);
+
+    close(fd);
+    ::remove(test_file_name);
+}
+
+TEST(test_bp_io_engine, test_sync) {
+    BPIoEngine* engine = BPIoEngine::create(BP_IO_ENGINE_SYNC);
+    ASSERT_STREQ(BP_IO_ENGINE_SYNC, engine->name());
+    test_engine(engine);
+    delete engine;
+}
+
+TEST(test_bp_io_engine, test_io_uring) {
+    // 当前环境不支持io_uring时会退回到同步引擎
+    BPIoEngine* engine = BPIoEngine::create(BP_IO_ENGINE_URING);
+    std::cout << "io engine: " << engine->name() << std::endl;
+    test_engine(engine);
+    delete engine;
+}
+
+TEST(test_bp_io_engine, test_unknown) {
+    BPIoEngine* engine = BPIoEngine::create("unknown");
+    ASSERT_STREQ(BP_IO_ENGINE_SYNC, engine->name());
+    delete engine;
+}
+
+int main(int argc, char** argv) {
+
+    // 分析gtest程序的命令行参数
+    testing::InitGoogleTest(&argc, argv);
+
+    // 调用RUN_ALL_TESTS()运行所有测试用例
+    // main函数返回RUN_ALL_TESTS()的运行结果
+    return RUN_ALL_TESTS();
+}
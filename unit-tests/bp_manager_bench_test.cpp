@@ -0,0 +1,75 @@
+/* Copyright (c) 2021 Xie Meiyi(xiemeiyi@hust.edu.cn) and OceanBase and/or its
+affiliates. All rights reserved. miniob is licensed under Mulan PSL v2. You can
+use this software according to the terms and conditions of the Mulan PSL v2. You
+may obtain a copy of Mulan PSL v2 at: http://license.coscl.org.cn/MulanPSL2 THIS
+SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND, EITHER
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include <storage/default/disk_buffer_pool.h>
+#include <gtest/gtest.h>
+#include <iostream>
+#include <vector>
+
+// 每个pool_num跑的查找次数
+#define GET_TIMES (1 << 20)
+
+unsigned long bench_now() {
+    struct timespec tp;
+    clock_gettime(CLOCK_MONOTONIC, &tp);
+    return tp.tv_sec * 1000 * 1000 * 1000UL + tp.tv_nsec;
+}
+
+/**
+ * 把所有frame都登记到页表之后，随机命中查找GET_TIMES次，返回平均每次查找的纳秒数
+ */
+double bench_get_hit(int pool_num) {
+    BPManager bp_manager("Bench");
+    bp_manager.init(false, pool_num, BP_BUFFER_SIZE);
+
+    const int size = bp_manager.get_size();
+    for (int i = 0; i < size; i++) {
+        Frame* frame = bp_manager.alloc(i % 4, i / 4);
+        EXPECT_NE(frame, nullptr);
+    }
+
+    std::vector<int> targets(GET_TIMES);
+    unsigned int     seed = 1;
+    for (int i = 0; i < GET_TIMES; i++) {
+        targets[i] = rand_r(&seed) % size;
+    }
+
+    int           missed = 0;
+    unsigned long begin  = bench_now();
+    for (int i = 0; i < GET_TIMES; i++) {
+        int t = targets[i];
+        if (bp_manager.get(t % 4, t / 4) == nullptr) {
+            missed++;
+        }
+    }
+    unsigned long end = bench_now();
+    EXPECT_EQ(0, missed);
+
+    bp_manager.cleanup();
+    return (double)(end - begin) / GET_TIMES;
+}
+
+TEST(test_bp_manager_bench, test_bp_manager_get_hit_latency) {
+    for (int pool_num = 1; pool_num <= 16; pool_num *= 2) {
+        double latency = bench_get_hit(pool_num);
+        std::cout << "POOL_NUM=" << pool_num
+                  << ", frames=" << pool_num * BP_BUFFER_SIZE
+                  << ", get hit latency=" << latency << "ns" << std::endl;
+    }
+}
+
+int main(int argc, char** argv) {
+
+    // 分析gtest程序的命令行参数
+    testing::InitGoogleTest(&argc, argv);
+
+    // 调用RUN_ALL_TESTS()运行所有测试用例
+    // main函数返回RUN_ALL_TESTS()的运行结果
+    return RUN_ALL_TESTS();
+}
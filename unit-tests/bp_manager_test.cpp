@@ -11,36 +11,28 @@ See the Mulan PSL v2 for more details. */
 // Created by wangyunlai.wyl on 2021
 //
 
+#include <storage/default/bp_replacer.h>
 #include <storage/default/disk_buffer_pool.h>
 #include <gtest/gtest.h>
 
 void test_get(BPManager& bp_manager) {
-    Frame* frame1 = bp_manager.alloc();
+    Frame* frame1 = bp_manager.alloc(0, 1);
     ASSERT_NE(frame1, nullptr);
 
-    frame1->file_desc     = 0;
-    frame1->page.page_num = 1;
-
     ASSERT_EQ(frame1, bp_manager.get(0, 1));
 
-    Frame* frame2 = bp_manager.alloc();
+    Frame* frame2 = bp_manager.alloc(0, 2);
     ASSERT_NE(frame2, nullptr);
-    frame2->file_desc     = 0;
-    frame2->page.page_num = 2;
 
     ASSERT_EQ(frame1, bp_manager.get(0, 1));
 
-    Frame* frame3 = bp_manager.alloc();
+    Frame* frame3 = bp_manager.alloc(0, 3);
     ASSERT_NE(frame3, nullptr);
-    frame3->file_desc     = 0;
-    frame3->page.page_num = 3;
 
     frame2                = bp_manager.get(0, 2);
     ASSERT_NE(frame2, nullptr);
 
-    Frame* frame4         = bp_manager.alloc();
-    frame4->file_desc     = 0;
-    frame4->page.page_num = 4;
+    Frame* frame4 = bp_manager.alloc(0, 4);
 
     bp_manager.free(frame1);
     frame1 = bp_manager.get(0, 1);
@@ -59,6 +51,21 @@ void test_get(BPManager& bp_manager) {
     ASSERT_EQ(nullptr, bp_manager.get(0, 4));
 }
 
+void test_bind(BPManager& bp_manager) {
+    Frame* frame = bp_manager.alloc(0, 1);
+    ASSERT_NE(frame, nullptr);
+    ASSERT_EQ(frame, bp_manager.get(0, 1));
+
+    bp_manager.bind(frame, 1, 5);
+    ASSERT_EQ(nullptr, bp_manager.get(0, 1));
+    ASSERT_EQ(frame, bp_manager.get(1, 5));
+
+    bp_manager.unbind(frame);
+    ASSERT_EQ(nullptr, bp_manager.get(1, 5));
+
+    bp_manager.free(frame);
+}
+
 void test_alloc(BPManager& bp_manager) {
     int               size = bp_manager.get_size();
 
@@ -99,11 +106,48 @@ TEST(test_bp_manager, test_bp_manager_simple_lru) {
 
     test_get(bp_manager);
 
+    test_bind(bp_manager);
+
     test_alloc(bp_manager);
 
     bp_manager.cleanup();
 }
 
+TEST(test_bp_manager, test_bp_manager_pin) {
+    BPManager bp_manager("Test");
+    bp_manager.init(false, 2);
+    bp_manager.set_replacer(new BPLruKReplacer(2));
+
+    Frame* frame1 = bp_manager.alloc(0, 1);
+    Frame* frame2 = bp_manager.alloc(0, 2);
+    ASSERT_NE(frame1, nullptr);
+    ASSERT_NE(frame2, nullptr);
+    ASSERT_EQ(frame1, bp_manager.begin_purge());
+
+    // pin住的frame不会被选中，同一个frame可以pin多次
+    bp_manager.pin(frame1);
+    bp_manager.pin(frame1);
+    ASSERT_EQ(2u, frame1->pin_count);
+    ASSERT_EQ(frame2, bp_manager.begin_purge());
+
+    bp_manager.pin(frame2);
+    ASSERT_EQ(nullptr, bp_manager.begin_purge());
+
+    // pin_count降到0以后才能被淘汰
+    ASSERT_FALSE(bp_manager.unpin(frame1));
+    ASSERT_EQ(nullptr, bp_manager.begin_purge());
+    ASSERT_TRUE(bp_manager.unpin(frame1));
+    ASSERT_EQ(frame1, bp_manager.begin_purge());
+
+    ASSERT_TRUE(bp_manager.unpin(frame2));
+    bp_manager.free(frame1);
+    ASSERT_EQ(frame2, bp_manager.begin_purge());
+    bp_manager.free(frame2);
+    ASSERT_EQ(nullptr, bp_manager.begin_purge());
+
+    bp_manager.cleanup();
+}
+
 int main(int argc, char** argv) {
 
     // 分析gtest程序的命令行参数
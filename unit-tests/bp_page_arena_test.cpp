@@ -0,0 +1,127 @@
+/* Copyright (c) 2021 Xie Meiyi(xiemeiyi@hust.edu.cn) and OceanBase and/or its
+affiliates. All rights reserved. miniob is licensed under Mulan PSL v2. You can
+use this software according to the terms and conditions of the Mulan PSL v2. You
+may obtain a copy of Mulan PSL v2 at: http://license.coscl.org.cn/MulanPSL2 THIS
+SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND, EITHER
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include <storage/default/bp_page_arena.h>
+#include <storage/default/disk_buffer_pool.h>
+#include <gtest/gtest.h>
+#include <string.h>
+#include <vector>
+
+static void test_arena(const char* huge_page) {
+    BPPageArena* arena = BPPageArena::create(BP_HUGE_PAGE_SIZE, huge_page,
+                                             BP_MIN_PAGE_SIZE, BP_MAX_PAGE_SIZE);
+    ASSERT_NE(nullptr, arena);
+    ASSERT_EQ(BP_HUGE_PAGE_SIZE, arena->size());
+
+    // 全部分成最小的块，每个块都按自己的大小对齐
+    std::vector<void*> blocks;
+    void*              block = nullptr;
+    while ((block = arena->alloc(BP_MIN_PAGE_SIZE)) != nullptr) {
+        ASSERT_TRUE(arena->contains(block));
+        ASSERT_EQ(0UL, (unsigned long)block % BP_MIN_PAGE_SIZE);
+        memset(block, 0xab, BP_MIN_PAGE_SIZE);
+        blocks.push_back(block);
+    }
+    ASSERT_EQ(BP_HUGE_PAGE_SIZE / BP_MIN_PAGE_SIZE, blocks.size());
+    ASSERT_EQ(nullptr, arena->alloc(BP_MAX_PAGE_SIZE));
+
+    // 全部归还以后伙伴块合并，又能分配出最大的块
+    for (void* item : blocks) {
+        arena->free(item, BP_MIN_PAGE_SIZE);
+    }
+    blocks.clear();
+    while ((block = arena->alloc(BP_MAX_PAGE_SIZE)) != nullptr) {
+        ASSERT_EQ(0UL, (unsigned long)block % BP_MAX_PAGE_SIZE);
+        blocks.push_back(block);
+    }
+    ASSERT_EQ(BP_HUGE_PAGE_SIZE / BP_MAX_PAGE_SIZE, blocks.size());
+    for (void* item : blocks) {
+        arena->free(item, BP_MAX_PAGE_SIZE);
+    }
+
+    // 大小混合分配，块之间不能重叠
+    void* small  = arena->alloc(BP_MIN_PAGE_SIZE);
+    void* middle = arena->alloc(BP_DEFAULT_PAGE_SIZE);
+    void* large  = arena->alloc(BP_MAX_PAGE_SIZE);
+    ASSERT_NE(nullptr, small);
+    ASSERT_NE(nullptr, middle);
+    ASSERT_NE(nullptr, large);
+    ASSERT_EQ(0UL, (unsigned long)middle % BP_DEFAULT_PAGE_SIZE);
+    ASSERT_TRUE((char*)small + BP_MIN_PAGE_SIZE <= (char*)middle ||
+                (char*)middle + BP_DEFAULT_PAGE_SIZE <= (char*)small);
+    ASSERT_TRUE((char*)large + BP_MAX_PAGE_SIZE <= (char*)small ||
+                (char*)small + BP_MIN_PAGE_SIZE <= (char*)large);
+    arena->free(small, BP_MIN_PAGE_SIZE);
+    arena->free(middle, BP_DEFAULT_PAGE_SIZE);
+    arena->free(large, BP_MAX_PAGE_SIZE);
+
+    int dummy = 0;
+    ASSERT_FALSE(arena->contains(&dummy));
+    delete arena;
+}
+
+TEST(test_bp_page_arena, test_off) {
+    ASSERT_EQ(nullptr, BPPageArena::create(BP_HUGE_PAGE_SIZE, BP_HUGE_PAGE_OFF,
+                                           BP_MIN_PAGE_SIZE, BP_MAX_PAGE_SIZE));
+}
+
+TEST(test_bp_page_arena, test_thp) { test_arena(BP_HUGE_PAGE_THP); }
+
+TEST(test_bp_page_arena, test_hugetlb) {
+    // 没有预留大页时退回透明大页，行为是一样的
+    test_arena(BP_HUGE_PAGE_HUGETLB);
+}
+
+TEST(test_bp_page_arena, test_buffer_pool) {
+    const std::string origin_huge_page = DiskBufferPool::get_huge_page();
+    const char*       file_name        = "bp_page_arena_test.data";
+    DiskBufferPool::set_huge_page(BP_HUGE_PAGE_THP);
+    DiskBufferPool* bp = DiskBufferPool::mk_instance();
+
+    ::remove(file_name);
+    ASSERT_EQ(ResultCode::SUCCESS, bp->create_file(file_name));
+    int file_id = -1;
+    ASSERT_EQ(ResultCode::SUCCESS, bp->open_file(file_name, &file_id));
+    for (int i = 0; i < 100; i++) {
+        BPPageHandle page_handle;
+        ASSERT_EQ(ResultCode::SUCCESS, bp->allocate_page(file_id, &page_handle));
+        ASSERT_EQ(0UL, (unsigned long)page_handle.frame->page % BP_DEFAULT_PAGE_SIZE);
+        char* data = nullptr;
+        bp->get_data(&page_handle, &data);
+        memset(data, 'a' + i % 26, BP_PAGE_DATA_SIZE(BP_DEFAULT_PAGE_SIZE));
+        bp->mark_dirty(&page_handle);
+        bp->unpin_page(&page_handle);
+    }
+    ASSERT_EQ(ResultCode::SUCCESS, bp->close_file(file_id));
+
+    ASSERT_EQ(ResultCode::SUCCESS, bp->open_file(file_name, &file_id));
+    for (PageNum i = 1; i <= 100; i++) {
+        BPPageHandle page_handle;
+        ASSERT_EQ(ResultCode::SUCCESS, bp->get_this_page(file_id, i, &page_handle));
+        char* data = nullptr;
+        bp->get_data(&page_handle, &data);
+        ASSERT_EQ('a' + (i - 1) % 26, data[0]);
+        bp->unpin_page(&page_handle);
+    }
+    ASSERT_EQ(ResultCode::SUCCESS, bp->close_file(file_id));
+
+    delete bp;
+    DiskBufferPool::set_huge_page(origin_huge_page.c_str());
+    ::remove(file_name);
+}
+
+int main(int argc, char** argv) {
+
+    // 分析gtest程序的命令行参数
+    testing::InitGoogleTest(&argc, argv);
+
+    // 调用RUN_ALL_TESTS()运行所有测试用例
+    // main函数返回RUN_ALL_TESTS()的运行结果
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,114 @@
+/* Copyright (c) 2021 Xie Meiyi(xiemeiyi@hust.edu.cn) and OceanBase and/or its
+affiliates. All rights reserved. miniob is licensed under Mulan PSL v2. You can
+use this software according to the terms and conditions of the Mulan PSL v2. You
+may obtain a copy of Mulan PSL v2 at: http://license.coscl.org.cn/MulanPSL2 THIS
+SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND, EITHER
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include <storage/default/bp_replacer.h>
+#include <gtest/gtest.h>
+
+TEST(test_bp_replacer, test_clock) {
+    Frame frames[3];
+    for (Frame& frame : frames) {
+        frame.pin_count = 0;
+    }
+
+    BPClockReplacer replacer;
+    for (Frame& frame : frames) {
+        replacer.insert(&frame);
+    }
+
+    // 所有frame都有引用位，第一圈清除引用位，第二圈淘汰第一个
+    ASSERT_EQ(&frames[0], replacer.victim());
+
+    // 再次访问frames[1]，它会获得第二次机会
+    replacer.access(&frames[1]);
+    ASSERT_EQ(&frames[2], replacer.victim());
+
+    // pin住的frame不会被淘汰
+    frames[0].pin_count = 1;
+    frames[2].pin_count = 1;
+    ASSERT_EQ(&frames[1], replacer.victim());
+
+    frames[1].pin_count = 1;
+    ASSERT_EQ(nullptr, replacer.victim());
+
+    frames[2].pin_count = 0;
+    replacer.remove(&frames[2]);
+    ASSERT_EQ(nullptr, replacer.victim());
+}
+
+TEST(test_bp_replacer, test_lru_k) {
+    Frame frames[3];
+    for (Frame& frame : frames) {
+        frame.pin_count = 0;
+    }
+
+    BPLruKReplacer replacer(2);
+    for (Frame& frame : frames) {
+        replacer.insert(&frame);
+    }
+
+    // frames[0]、frames[2] 访问了两次，frames[1] 只访问了一次，最先被淘汰
+    replacer.access(&frames[0]);
+    replacer.access(&frames[2]);
+    ASSERT_EQ(&frames[1], replacer.victim());
+
+    // 都访问了两次时，淘汰倒数第二次访问最早的
+    replacer.access(&frames[1]);
+    ASSERT_EQ(&frames[0], replacer.victim());
+
+    // pin住的frame不会被淘汰，unpin以后按原来的访问时间重新参与淘汰
+    frames[0].pin_count = 1;
+    replacer.pin(&frames[0]);
+    ASSERT_EQ(&frames[1], replacer.victim());
+
+    replacer.access(&frames[0]);
+    frames[0].pin_count = 0;
+    replacer.unpin(&frames[0]);
+    ASSERT_EQ(&frames[1], replacer.victim());
+
+    replacer.remove(&frames[1]);
+    ASSERT_EQ(&frames[2], replacer.victim());
+
+    replacer.remove(&frames[2]);
+    ASSERT_EQ(&frames[0], replacer.victim());
+
+    // 插入时已经被pin住的frame，unpin以后才能被淘汰
+    frames[1].pin_count = 1;
+    replacer.insert(&frames[1]);
+    ASSERT_EQ(&frames[0], replacer.victim());
+    replacer.remove(&frames[0]);
+    ASSERT_EQ(nullptr, replacer.victim());
+
+    frames[1].pin_count = 0;
+    replacer.unpin(&frames[1]);
+    ASSERT_EQ(&frames[1], replacer.victim());
+}
+
+TEST(test_bp_replacer, test_create) {
+    BPReplacer* replacer = BPReplacer::create(BP_REPLACER_CLOCK, 0);
+    ASSERT_NE(nullptr, replacer);
+    ASSERT_STREQ(BP_REPLACER_CLOCK, replacer->name());
+    delete replacer;
+
+    replacer = BPReplacer::create(BP_REPLACER_LRU_K, 3);
+    ASSERT_NE(nullptr, replacer);
+    ASSERT_EQ(3, ((BPLruKReplacer*)replacer)->k());
+    delete replacer;
+
+    ASSERT_EQ(nullptr, BPReplacer::create("fifo", 0));
+}
+
+int main(int argc, char** argv) {
+
+    // 分析gtest程序的命令行参数
+    testing::InitGoogleTest(&argc, argv);
+
+    // 调用RUN_ALL_TESTS()运行所有测试用例
+    // main函数返回RUN_ALL_TESTS()的运行结果
+    return RUN_ALL_TESTS();
+}
@@ -13,6 +13,7 @@ See the Mulan PSL v2 for more details. */
 
 #include <iostream>
 #include <list>
+#include <vector>
 
 #include <common/log/log.h>
 #include <result_code.h>
@@ -331,6 +332,256 @@ TEST(test_bplus_tree, test_bplus_tree_insert) {
     handler = nullptr;
 }
 
+TEST(test_bplus_tree, test_bplus_tree_page_size) {
+    // 短key使用默认页面大小，长key自动换成更大的页面
+    for (int attr_length : {(int)sizeof(int), 512}) {
+        ::remove(index_name);
+        BplusTreeHandler index_handler;
+        ASSERT_EQ(ResultCode::SUCCESS,
+                  index_handler.create(index_name, CHARS, attr_length));
+
+        int page_size = 0;
+        ASSERT_EQ(ResultCode::SUCCESS,
+                  theGlobalDiskBufferPool()->get_page_size(
+                      index_handler.get_file_id(), &page_size));
+        if (attr_length == (int)sizeof(int)) {
+            ASSERT_EQ(BP_DEFAULT_PAGE_SIZE, page_size);
+        } else {
+            ASSERT_LT(BP_DEFAULT_PAGE_SIZE, page_size);
+        }
+        index_handler.close();
+    }
+    ::remove(index_name);
+}
+
+TEST(test_bplus_tree, test_bplus_tree_insert_entries) {
+    ::remove(index_name);
+    BplusTreeHandler index_handler;
+    ASSERT_EQ(ResultCode::SUCCESS, index_handler.create(index_name, INTS, sizeof(int)));
+
+    // 乱序的一批key，排序后插入，结果和逐个插入一样
+    const int          num = 1000;
+    std::vector<int>   keys(num);
+    std::vector<RID>   rids(num);
+    std::vector<const char*> pkeys(num);
+    for (int i = 0; i < num; i++) {
+        keys[i]          = (i * 7919) % num;
+        rids[i].page_num = keys[i] / 10 + 1;
+        rids[i].slot_num = keys[i] % 10;
+    }
+    for (int i = 0; i < num; i++) {
+        pkeys[i] = (const char*)&keys[i];
+    }
+    ASSERT_EQ(ResultCode::SUCCESS,
+              index_handler.insert_entries(pkeys.data(), rids.data(), num));
+    ASSERT_TRUE(index_handler.validate_tree());
+
+    for (int i = 0; i < num; i++) {
+        std::list<RID> found;
+        ASSERT_EQ(ResultCode::SUCCESS, index_handler.get_entry((const char*)&i, found));
+        ASSERT_EQ(1UL, found.size());
+        ASSERT_EQ(i / 10 + 1, found.front().page_num);
+        ASSERT_EQ(i % 10, found.front().slot_num);
+    }
+
+    // 重复的key插入失败
+    ASSERT_EQ(ResultCode::RECORD_DUPLICATE_KEY,
+              index_handler.insert_entries(pkeys.data(), rids.data(), 1));
+    index_handler.close();
+    ::remove(index_name);
+}
+
+/**
+ * 批量构建num个乱序的key，检查树的结构和每个key都能找到
+ */
+static void test_bulk_load(BplusTreeHandler& index_handler, int num) {
+    std::vector<int>         keys(num);
+    std::vector<RID>         rids(num);
+    std::vector<const char*> pkeys(num);
+    for (int i = 0; i < num; i++) {
+        keys[i]          = (int)(((long long)i * 7919) % num);
+        rids[i].page_num = keys[i] / 10 + 1;
+        rids[i].slot_num = keys[i] % 10;
+        pkeys[i]         = (const char*)&keys[i];
+    }
+    ASSERT_EQ(ResultCode::SUCCESS,
+              index_handler.bulk_load(pkeys.data(), rids.data(), num));
+    ASSERT_TRUE(index_handler.validate_tree());
+
+    for (int i = 0; i < num; i++) {
+        std::list<RID> found;
+        ASSERT_EQ(ResultCode::SUCCESS, index_handler.get_entry((const char*)&i, found));
+        ASSERT_EQ(1UL, found.size());
+        ASSERT_EQ(i / 10 + 1, found.front().page_num);
+        ASSERT_EQ(i % 10, found.front().slot_num);
+    }
+}
+
+TEST(test_bplus_tree, test_bplus_tree_bulk_load) {
+    // 阶数很小时树有很多层，各种个数的key都要构建出合法的树
+    for (int num : {1, 2, 3, 4, 5, 7, 9, 17, 40, 123, 1000}) {
+        ::remove(index_name);
+        BplusTreeHandler index_handler;
+        ASSERT_EQ(ResultCode::SUCCESS, index_handler.create(index_name, INTS, sizeof(int)));
+        BplusTreeTester bplus_tree_tester(index_handler);
+        bplus_tree_tester.set_order(ORDER);
+        test_bulk_load(index_handler, num);
+
+        // 构建以后还可以继续插入和删除
+        RID rid{num, 0};
+        ASSERT_EQ(ResultCode::SUCCESS, index_handler.insert_entry((const char*)&num, &rid));
+        ASSERT_EQ(ResultCode::SUCCESS, index_handler.delete_entry((const char*)&num, &rid));
+        ASSERT_TRUE(index_handler.validate_tree());
+        index_handler.close();
+    }
+
+    // 节点写满时用到的页面比逐个插入少，重新打开以后使用新的根节点
+    const int num = 20000;
+    BplusTreeHandler::set_bulk_load_fill_factor(100);
+    ::remove(index_name);
+    BplusTreeHandler index_handler;
+    ASSERT_EQ(ResultCode::SUCCESS, index_handler.create(index_name, INTS, sizeof(int)));
+    test_bulk_load(index_handler, num);
+    BplusTreeHandler::set_bulk_load_fill_factor(BPLUS_TREE_DEFAULT_FILL_FACTOR);
+    int bulk_load_pages = 0;
+    ASSERT_EQ(ResultCode::SUCCESS, theGlobalDiskBufferPool()->get_page_count(
+                                       index_handler.get_file_id(), &bulk_load_pages));
+    index_handler.close();
+    ASSERT_EQ(ResultCode::SUCCESS, index_handler.open(index_name));
+    ASSERT_TRUE(index_handler.validate_tree());
+    int            key = num - 1;
+    std::list<RID> found;
+    ASSERT_EQ(ResultCode::SUCCESS, index_handler.get_entry((const char*)&key, found));
+    ASSERT_EQ(1UL, found.size());
+
+    // 不是空的索引时逐个插入，重复的key插入失败
+    RID rid{1, 0};
+    key = 0;
+    const char* pkey = (const char*)&key;
+    ASSERT_EQ(ResultCode::RECORD_DUPLICATE_KEY, index_handler.bulk_load(&pkey, &rid, 1));
+    index_handler.close();
+
+    ::remove(index_name);
+    ASSERT_EQ(ResultCode::SUCCESS, index_handler.create(index_name, INTS, sizeof(int)));
+    std::vector<int>         keys(num);
+    std::vector<RID>         rids(num);
+    std::vector<const char*> pkeys(num);
+    for (int i = 0; i < num; i++) {
+        keys[i]          = i;
+        rids[i].page_num = i / 10 + 1;
+        rids[i].slot_num = i % 10;
+        pkeys[i]         = (const char*)&keys[i];
+    }
+    ASSERT_EQ(ResultCode::SUCCESS,
+              index_handler.insert_entries(pkeys.data(), rids.data(), num));
+    int insert_pages = 0;
+    ASSERT_EQ(ResultCode::SUCCESS, theGlobalDiskBufferPool()->get_page_count(
+                                       index_handler.get_file_id(), &insert_pages));
+    ASSERT_LT(bulk_load_pages, insert_pages);
+    index_handler.close();
+
+    // 有重复的索引项时什么都不插入
+    ::remove(index_name);
+    ASSERT_EQ(ResultCode::SUCCESS, index_handler.create(index_name, INTS, sizeof(int)));
+    rids[1] = rids[0];
+    keys[1] = keys[0];
+    ASSERT_EQ(ResultCode::RECORD_DUPLICATE_KEY,
+              index_handler.bulk_load(pkeys.data(), rids.data(), num));
+    found.clear();
+    ASSERT_EQ(ResultCode::SUCCESS, index_handler.get_entry(pkeys[2], found));
+    ASSERT_EQ(0UL, found.size());
+    index_handler.close();
+    ::remove(index_name);
+}
+
+TEST(test_bplus_tree, test_bplus_tree_sorter) {
+    // 内存上限很小时排好序的段写到临时文件中，归并以后还是有序的
+    const int num = 5000;
+    BplusTreeSorter::set_memory_limit(4096);
+    BplusTreeSorter sorter(INTS, sizeof(int));
+    for (int i = 0; i < num; i++) {
+        int key = (int)(((long long)i * 7919) % num);
+        RID rid{key / 10 + 1, key % 10};
+        ASSERT_EQ(ResultCode::SUCCESS, sorter.add((const char*)&key, &rid));
+    }
+    ASSERT_EQ(ResultCode::SUCCESS, sorter.finish());
+    ASSERT_EQ(num, sorter.count());
+    ASSERT_GT(sorter.run_count(), 1);
+    for (int i = 0; i < num; i++) {
+        const char* entry;
+        int         key;
+        RID         rid;
+        ASSERT_EQ(ResultCode::SUCCESS, sorter.next(entry));
+        memcpy(&key, entry, sizeof(key));
+        memcpy(&rid, entry + sizeof(key), sizeof(rid));
+        ASSERT_EQ(i, key);
+        ASSERT_EQ(i / 10 + 1, rid.page_num);
+    }
+    const char* entry;
+    ASSERT_EQ(ResultCode::RECORD_EOF, sorter.next(entry));
+
+    // 有序段写到临时文件时批量构建的树也是一样的
+    ::remove(index_name);
+    BplusTreeHandler index_handler;
+    ASSERT_EQ(ResultCode::SUCCESS, index_handler.create(index_name, INTS, sizeof(int)));
+    BplusTreeTester bplus_tree_tester(index_handler);
+    bplus_tree_tester.set_order(ORDER);
+    test_bulk_load(index_handler, num);
+    index_handler.close();
+    BplusTreeSorter::set_memory_limit(BPLUS_TREE_DEFAULT_SORT_MEMORY);
+    ::remove(index_name);
+}
+
+/**
+ * 用comp_op value扫描索引，返回扫描到的索引项个数，扫描要以RECORD_EOF结束
+ */
+static int scan_count(BplusTreeHandler& index_handler, CompOp comp_op, int value) {
+    BplusTreeScanner scanner(index_handler);
+    EXPECT_EQ(ResultCode::SUCCESS, scanner.open(comp_op, (const char*)&value));
+    int        count = 0;
+    RID        rid;
+    ResultCode rc;
+    while ((rc = scanner.next_entry(&rid)) == ResultCode::SUCCESS) {
+        count++;
+    }
+    EXPECT_EQ(ResultCode::RECORD_EOF, rc);
+    scanner.close();
+    return count;
+}
+
+TEST(test_bplus_tree, test_bplus_tree_scanner) {
+    ::remove(index_name);
+    BplusTreeHandler index_handler;
+    ASSERT_EQ(ResultCode::SUCCESS, index_handler.create(index_name, INTS, sizeof(int)));
+    BplusTreeTester bplus_tree_tester(index_handler);
+    bplus_tree_tester.set_order(ORDER);
+
+    const int                num = 100;
+    std::vector<int>         keys(num);
+    std::vector<RID>         rids(num);
+    std::vector<const char*> pkeys(num);
+    for (int i = 0; i < num; i++) {
+        keys[i]          = i;
+        rids[i].page_num = i / 10 + 1;
+        rids[i].slot_num = i % 10;
+        pkeys[i]         = (const char*)&keys[i];
+    }
+    ASSERT_EQ(ResultCode::SUCCESS,
+              index_handler.insert_entries(pkeys.data(), rids.data(), num));
+
+    // 满足条件的索引项在前面几个叶子页面上，后面的页面都没有满足条件的key，
+    // 扫描要一直读到最后一个页面，而不是在中途返回错误
+    ASSERT_EQ(1, scan_count(index_handler, EQUAL_TO, 5));
+    ASSERT_EQ(0, scan_count(index_handler, EQUAL_TO, num));
+    ASSERT_EQ(10, scan_count(index_handler, LESS_THAN, 10));
+    ASSERT_EQ(11, scan_count(index_handler, LESS_EQUAL, 10));
+    ASSERT_EQ(num - 1, scan_count(index_handler, NOT_EQUAL, 5));
+    ASSERT_EQ(10, scan_count(index_handler, GREAT_THAN, num - 11));
+    ASSERT_EQ(10, scan_count(index_handler, GREAT_EQUAL, num - 10));
+    index_handler.close();
+    ::remove(index_name);
+}
+
 int main(int argc, char** argv) {
 
     // 分析gtest程序的命令行参数
@@ -0,0 +1,250 @@
+/* Copyright (c) 2021 Xie Meiyi(xiemeiyi@hust.edu.cn) and OceanBase and/or its
+affiliates. All rights reserved. miniob is licensed under Mulan PSL v2. You can
+use this software according to the terms and conditions of the Mulan PSL v2. You
+may obtain a copy of Mulan PSL v2 at: http://license.coscl.org.cn/MulanPSL2 THIS
+SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND, EITHER
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include <storage/default/disk_buffer_pool.h>
+#include <gtest/gtest.h>
+#include <atomic>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+// 测试文件中的页面数，全部能放进缓冲池，压测的是命中路径上的latch竞争
+#define BENCH_PAGE_NUM 512
+// 每个线程执行的pin/unpin次数
+#define BENCH_OPS_PER_THREAD (1 << 17)
+// 比较O_DIRECT和缓冲I/O时的文件页面数和缓冲池大小，缓冲池只能放下一小部分页面
+#define DIRECT_IO_BENCH_PAGE_NUM 4096
+#define DIRECT_IO_BENCH_POOL_SIZE (4 << 20)
+// 点查的次数
+#define DIRECT_IO_BENCH_LOOKUPS 20000
+// 未命中为主的压测中文件的页面数和缓冲池大小，大部分访问都要读盘，还要淘汰脏页
+#define MISS_BENCH_PAGE_NUM 4096
+#define MISS_BENCH_POOL_SIZE (4 << 20)
+#define MISS_BENCH_OPS_PER_THREAD (1 << 13)
+
+static const char* bench_file_name = "disk_buffer_pool_bench.data";
+
+static unsigned long bench_now() {
+    struct timespec tp;
+    clock_gettime(CLOCK_MONOTONIC, &tp);
+    return tp.tv_sec * 1000 * 1000 * 1000UL + tp.tv_nsec;
+}
+
+/**
+ * 在shard_num个分片的缓冲池上，用thread_num个线程随机pin/unpin页面，
+ * 返回每秒完成的操作数
+ */
+static double bench_pin_unpin(int shard_num, int thread_num) {
+    DiskBufferPool::set_shard_num(shard_num);
+    DiskBufferPool* bp = DiskBufferPool::mk_instance();
+
+    ::remove(bench_file_name);
+    EXPECT_EQ(ResultCode::SUCCESS, bp->create_file(bench_file_name));
+    int file_id = -1;
+    EXPECT_EQ(ResultCode::SUCCESS, bp->open_file(bench_file_name, &file_id));
+
+    for (int i = 1; i < BENCH_PAGE_NUM; i++) {
+        BPPageHandle page_handle;
+        EXPECT_EQ(ResultCode::SUCCESS, bp->allocate_page(file_id, &page_handle));
+        bp->mark_dirty(&page_handle);
+        bp->unpin_page(&page_handle);
+    }
+
+    std::atomic<int>         failed(0);
+    std::vector<std::thread> threads;
+    unsigned long            begin = bench_now();
+    for (int t = 0; t < thread_num; t++) {
+        threads.emplace_back([bp, file_id, t, &failed]() {
+            unsigned int seed = t + 1;
+            for (int i = 0; i < BENCH_OPS_PER_THREAD; i++) {
+                BPPageHandle page_handle;
+                PageNum      page_num = 1 + rand_r(&seed) % (BENCH_PAGE_NUM - 1);
+                if (bp->get_this_page(file_id, page_num, &page_handle) != ResultCode::SUCCESS) {
+                    failed++;
+                    continue;
+                }
+                bp->unpin_page(&page_handle);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    unsigned long end = bench_now();
+    EXPECT_EQ(0, failed.load());
+
+    bp->close_file(file_id);
+    delete bp;
+    ::remove(bench_file_name);
+
+    return (double)thread_num * BENCH_OPS_PER_THREAD * 1000 * 1000 * 1000 / (end - begin);
+}
+
+/**
+ * 在一个放不下整个文件的缓冲池上分别做顺序扫描和随机点查，
+ * 返回每秒读取的页面数。缓冲I/O未命中时可能还能命中内核的页缓存，
+ * O_DIRECT则每次都要读设备
+ */
+static void bench_direct_io(bool direct_io, double* scan_pages, double* lookup_pages) {
+    DiskBufferPool::set_direct_io(direct_io);
+    DiskBufferPool* bp = DiskBufferPool::mk_instance();
+
+    ::remove(bench_file_name);
+    ASSERT_EQ(ResultCode::SUCCESS, bp->create_file(bench_file_name));
+    int file_id = -1;
+    ASSERT_EQ(ResultCode::SUCCESS, bp->open_file(bench_file_name, &file_id));
+    for (int i = 1; i < DIRECT_IO_BENCH_PAGE_NUM; i++) {
+        BPPageHandle page_handle;
+        ASSERT_EQ(ResultCode::SUCCESS, bp->allocate_page(file_id, &page_handle));
+        bp->mark_dirty(&page_handle);
+        bp->unpin_page(&page_handle);
+    }
+    ASSERT_EQ(ResultCode::SUCCESS, bp->close_file(file_id));
+    ASSERT_EQ(ResultCode::SUCCESS, bp->open_file(bench_file_name, &file_id));
+
+    unsigned long begin = bench_now();
+    for (PageNum page_num = 1; page_num < DIRECT_IO_BENCH_PAGE_NUM; page_num++) {
+        BPPageHandle page_handle;
+        ASSERT_EQ(ResultCode::SUCCESS, bp->get_this_page(file_id, page_num, &page_handle));
+        bp->unpin_page(&page_handle);
+    }
+    unsigned long end = bench_now();
+    *scan_pages = (double)(DIRECT_IO_BENCH_PAGE_NUM - 1) * 1000 * 1000 * 1000 / (end - begin);
+
+    unsigned int seed = 1;
+    begin             = bench_now();
+    for (int i = 0; i < DIRECT_IO_BENCH_LOOKUPS; i++) {
+        BPPageHandle page_handle;
+        PageNum      page_num = 1 + rand_r(&seed) % (DIRECT_IO_BENCH_PAGE_NUM - 1);
+        ASSERT_EQ(ResultCode::SUCCESS, bp->get_this_page(file_id, page_num, &page_handle));
+        bp->unpin_page(&page_handle);
+    }
+    end           = bench_now();
+    *lookup_pages = (double)DIRECT_IO_BENCH_LOOKUPS * 1000 * 1000 * 1000 / (end - begin);
+
+    bp->close_file(file_id);
+    delete bp;
+    ::remove(bench_file_name);
+}
+
+/**
+ * 在一个放不下整个文件的缓冲池上，用thread_num个线程随机读写页面，
+ * 返回每秒完成的操作数。每个页面开头写着自己的页号，读到的不对说明拿到了还没读完的页面
+ */
+static double bench_miss(int shard_num, int thread_num) {
+    DiskBufferPool::set_shard_num(shard_num);
+    DiskBufferPool* bp = DiskBufferPool::mk_instance();
+
+    ::remove(bench_file_name);
+    EXPECT_EQ(ResultCode::SUCCESS, bp->create_file(bench_file_name));
+    int file_id = -1;
+    EXPECT_EQ(ResultCode::SUCCESS, bp->open_file(bench_file_name, &file_id));
+    for (int i = 1; i < MISS_BENCH_PAGE_NUM; i++) {
+        BPPageHandle page_handle;
+        EXPECT_EQ(ResultCode::SUCCESS, bp->allocate_page(file_id, &page_handle));
+        char* data = nullptr;
+        bp->get_data(&page_handle, &data);
+        *(int*)data = i;
+        bp->mark_dirty(&page_handle);
+        bp->unpin_page(&page_handle);
+    }
+
+    std::atomic<int>         failed(0);
+    std::vector<std::thread> threads;
+    unsigned long            begin = bench_now();
+    for (int t = 0; t < thread_num; t++) {
+        threads.emplace_back([bp, file_id, t, &failed]() {
+            unsigned int seed = t + 1;
+            for (int i = 0; i < MISS_BENCH_OPS_PER_THREAD; i++) {
+                BPPageHandle page_handle;
+                PageNum      page_num = 1 + rand_r(&seed) % (MISS_BENCH_PAGE_NUM - 1);
+                if (bp->get_this_page(file_id, page_num, &page_handle) != ResultCode::SUCCESS) {
+                    failed++;
+                    continue;
+                }
+                char* data = nullptr;
+                bp->get_data(&page_handle, &data);
+                if (*(int*)data != page_num) {
+                    failed++;
+                }
+                // 四分之一的访问是写，被淘汰的页面中有不少脏页
+                if (i % 4 == 0) {
+                    bp->mark_dirty(&page_handle);
+                }
+                bp->unpin_page(&page_handle);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    unsigned long end = bench_now();
+    EXPECT_EQ(0, failed.load());
+
+    bp->close_file(file_id);
+    delete bp;
+    ::remove(bench_file_name);
+
+    return (double)thread_num * MISS_BENCH_OPS_PER_THREAD * 1000 * 1000 * 1000 / (end - begin);
+}
+
+TEST(test_disk_buffer_pool_bench, test_direct_io) {
+    const bool               origin_direct_io = DiskBufferPool::get_direct_io();
+    const unsigned long long origin_pool_size = DiskBufferPool::get_pool_size();
+    DiskBufferPool::set_pool_size(DIRECT_IO_BENCH_POOL_SIZE);
+    for (bool direct_io : {false, true}) {
+        double scan_pages   = 0;
+        double lookup_pages = 0;
+        bench_direct_io(direct_io, &scan_pages, &lookup_pages);
+        std::cout << "direct_io=" << direct_io
+                  << ", scan=" << (long)scan_pages << "pages/s"
+                  << ", point lookup=" << (long)lookup_pages << "pages/s" << std::endl;
+    }
+    DiskBufferPool::set_pool_size(origin_pool_size);
+    DiskBufferPool::set_direct_io(origin_direct_io);
+}
+
+TEST(test_disk_buffer_pool_bench, test_pin_unpin_throughput) {
+    const int origin_shard_num = DiskBufferPool::get_shard_num();
+    for (int shard_num : {1, BP_DEFAULT_SHARD_NUM}) {
+        for (int thread_num = 1; thread_num <= 8; thread_num *= 2) {
+            double ops = bench_pin_unpin(shard_num, thread_num);
+            std::cout << "SHARD_NUM=" << shard_num
+                      << ", threads=" << thread_num
+                      << ", pin/unpin throughput=" << (long)ops << "ops/s" << std::endl;
+        }
+    }
+    DiskBufferPool::set_shard_num(origin_shard_num);
+}
+
+TEST(test_disk_buffer_pool_bench, test_miss_throughput) {
+    const int                origin_shard_num = DiskBufferPool::get_shard_num();
+    const unsigned long long origin_pool_size = DiskBufferPool::get_pool_size();
+    DiskBufferPool::set_pool_size(MISS_BENCH_POOL_SIZE);
+    for (int shard_num : {1, BP_DEFAULT_SHARD_NUM}) {
+        for (int thread_num = 1; thread_num <= 8; thread_num *= 2) {
+            double ops = bench_miss(shard_num, thread_num);
+            std::cout << "SHARD_NUM=" << shard_num
+                      << ", threads=" << thread_num
+                      << ", miss-heavy throughput=" << (long)ops << "ops/s" << std::endl;
+        }
+    }
+    DiskBufferPool::set_pool_size(origin_pool_size);
+    DiskBufferPool::set_shard_num(origin_shard_num);
+}
+
+int main(int argc, char** argv) {
+
+    // 分析gtest程序的命令行参数
+    testing::InitGoogleTest(&argc, argv);
+
+    // 调用RUN_ALL_TESTS()运行所有测试用例
+    // main函数返回RUN_ALL_TESTS()的运行结果
+    return RUN_ALL_TESTS();
+}
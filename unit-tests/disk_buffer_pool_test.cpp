@@ -0,0 +1,545 @@
+/* Copyright (c) 2021 Xie Meiyi(xiemeiyi@hust.edu.cn) and OceanBase and/or its
+affiliates. All rights reserved. miniob is licensed under Mulan PSL v2. You can
+use this software according to the terms and conditions of the Mulan PSL v2. You
+may obtain a copy of Mulan PSL v2 at: http://license.coscl.org.cn/MulanPSL2 THIS
+SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND, EITHER
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include <storage/default/disk_buffer_pool.h>
+#include <storage/default/bp_io_engine.h>
+#include <common/metrics/metrics_registry.h>
+#include <gtest/gtest.h>
+#include <unistd.h>
+#include <thread>
+#include <vector>
+
+static const char* test_file_name = "disk_buffer_pool_test.data";
+
+/**
+ * 分配page_num个页面，每个页面的数据区写上自己的页号后unpin
+ */
+static void fill_pages(DiskBufferPool* bp, int file_id, int page_num) {
+    for (int i = 0; i < page_num; i++) {
+        BPPageHandle page_handle;
+        ASSERT_EQ(ResultCode::SUCCESS, bp->allocate_page(file_id, &page_handle));
+        char*   data = nullptr;
+        PageNum num  = 0;
+        bp->get_data(&page_handle, &data);
+        bp->get_page_num(&page_handle, &num);
+        memcpy(data, &num, sizeof(num));
+        bp->mark_dirty(&page_handle);
+        bp->unpin_page(&page_handle);
+    }
+}
+
+/**
+ * 直接读文件，检查前page_num个数据页面都已经写到磁盘上了
+ */
+static void check_pages_on_disk(int page_size, int page_num) {
+    int fd = open(test_file_name, O_RDONLY);
+    ASSERT_GE(fd, 0);
+    std::vector<char> buffer(page_size);
+    Page*             page = (Page*)buffer.data();
+    for (PageNum i = 1; i <= page_num; i++) {
+        ASSERT_EQ((ssize_t)page_size,
+                  pread(fd, page, page_size, (off_t)i * page_size));
+        PageNum num = 0;
+        memcpy(&num, page->data, sizeof(num));
+        ASSERT_EQ(i, page->page_num);
+        ASSERT_EQ(i, num);
+    }
+    close(fd);
+}
+
+TEST(test_disk_buffer_pool, test_flush_dirty_pages) {
+    ::remove(test_file_name);
+    DiskBufferPool* bp = DiskBufferPool::mk_instance();
+    ASSERT_EQ(ResultCode::SUCCESS, bp->create_file(test_file_name));
+    int file_id = -1;
+    ASSERT_EQ(ResultCode::SUCCESS, bp->open_file(test_file_name, &file_id));
+
+    fill_pages(bp, file_id, 20);
+
+    // 干净frame已经足够时什么都不做
+    int flushed_num = -1;
+    ASSERT_EQ(ResultCode::SUCCESS, bp->flush_dirty_pages(0, 1000, &flushed_num));
+    ASSERT_EQ(0, flushed_num);
+
+    // 保留量要求所有frame都是干净的，受max_pages限制
+    const int frame_num = DiskBufferPool::get_pool_num() * BP_BUFFER_SIZE;
+    ASSERT_EQ(ResultCode::SUCCESS,
+              bp->flush_dirty_pages(frame_num, 5, &flushed_num));
+    ASSERT_EQ(5, flushed_num);
+    ASSERT_EQ(ResultCode::SUCCESS,
+              bp->flush_dirty_pages(frame_num, 1000, &flushed_num));
+    ASSERT_EQ(15, flushed_num);
+    ASSERT_EQ(ResultCode::SUCCESS,
+              bp->flush_dirty_pages(frame_num, 1000, &flushed_num));
+    ASSERT_EQ(0, flushed_num);
+
+    // 页面已经在磁盘上了
+    check_pages_on_disk(BP_DEFAULT_PAGE_SIZE, 20);
+
+    // 被pin住的页面不会被写回
+    BPPageHandle page_handle;
+    ASSERT_EQ(ResultCode::SUCCESS, bp->get_this_page(file_id, 3, &page_handle));
+    bp->mark_dirty(&page_handle);
+    ASSERT_EQ(ResultCode::SUCCESS,
+              bp->flush_dirty_pages(frame_num, 1000, &flushed_num));
+    ASSERT_EQ(0, flushed_num);
+    bp->unpin_page(&page_handle);
+    ASSERT_EQ(ResultCode::SUCCESS,
+              bp->flush_dirty_pages(frame_num, 1000, &flushed_num));
+    ASSERT_EQ(1, flushed_num);
+
+    bp->close_file(file_id);
+    delete bp;
+    ::remove(test_file_name);
+}
+
+TEST(test_disk_buffer_pool, test_purge_all_pages) {
+    ::remove(test_file_name);
+    DiskBufferPool* bp = DiskBufferPool::mk_instance();
+    ASSERT_EQ(ResultCode::SUCCESS, bp->create_file(test_file_name));
+    int file_id = -1;
+    ASSERT_EQ(ResultCode::SUCCESS, bp->open_file(test_file_name, &file_id));
+
+    // 超过一次pwritev能合并的页面数，中间再空出一个页面
+    const int page_num = BP_FLUSH_MAX_BATCH * 2 + 3;
+    fill_pages(bp, file_id, page_num);
+    ASSERT_EQ(ResultCode::SUCCESS, bp->purge_page(file_id, 10));
+    ASSERT_EQ(ResultCode::SUCCESS, bp->purge_all_pages(file_id));
+
+    check_pages_on_disk(BP_DEFAULT_PAGE_SIZE, page_num);
+
+    // 页面已经被释放，可以重新从磁盘读回来
+    BPPageHandle page_handle;
+    ASSERT_EQ(ResultCode::SUCCESS,
+              bp->get_this_page(file_id, page_num, &page_handle));
+    char* data = nullptr;
+    bp->get_data(&page_handle, &data);
+    PageNum num = 0;
+    memcpy(&num, data, sizeof(num));
+    ASSERT_EQ(page_num, num);
+    bp->unpin_page(&page_handle);
+
+    bp->close_file(file_id);
+    delete bp;
+    ::remove(test_file_name);
+}
+
+TEST(test_disk_buffer_pool, test_get_pages) {
+    const std::string origin_io_engine = DiskBufferPool::get_io_engine();
+    for (const char* io_engine : {BP_IO_ENGINE_SYNC, BP_IO_ENGINE_URING}) {
+        DiskBufferPool::set_io_engine(io_engine);
+
+        ::remove(test_file_name);
+        DiskBufferPool* bp = DiskBufferPool::mk_instance();
+        ASSERT_EQ(ResultCode::SUCCESS, bp->create_file(test_file_name));
+        int file_id = -1;
+        ASSERT_EQ(ResultCode::SUCCESS, bp->open_file(test_file_name, &file_id));
+
+        fill_pages(bp, file_id, 30);
+        ASSERT_EQ(ResultCode::SUCCESS, bp->purge_all_pages(file_id));
+
+        // 先把其中一个页面读进来，混合命中和未命中的页面，还有重复的页面
+        BPPageHandle cached;
+        ASSERT_EQ(ResultCode::SUCCESS, bp->get_this_page(file_id, 7, &cached));
+
+        std::vector<PageNum>      page_nums = {3, 7, 30, 1, 12, 3, 25};
+        std::vector<BPPageHandle> page_handles(page_nums.size());
+        ASSERT_EQ(ResultCode::SUCCESS,
+                  bp->get_pages(file_id, page_nums.data(), (int)page_nums.size(),
+                                page_handles.data()));
+        for (size_t i = 0; i < page_nums.size(); i++) {
+            char*   data = nullptr;
+            PageNum num  = 0;
+            ASSERT_TRUE(page_handles[i].open);
+            bp->get_data(&page_handles[i], &data);
+            memcpy(&num, data, sizeof(num));
+            ASSERT_EQ(page_nums[i], num);
+        }
+        ASSERT_EQ(page_handles[0].frame, page_handles[5].frame);
+        ASSERT_EQ(cached.frame, page_handles[1].frame);
+        ASSERT_EQ(2u, cached.frame->pin_count);
+        for (BPPageHandle& page_handle : page_handles) {
+            bp->unpin_page(&page_handle);
+        }
+        bp->unpin_page(&cached);
+
+        // 有一个无效页面时整体失败
+        page_nums.push_back(100);
+        page_handles.resize(page_nums.size());
+        ASSERT_NE(ResultCode::SUCCESS,
+                  bp->get_pages(file_id, page_nums.data(), (int)page_nums.size(),
+                                page_handles.data()));
+
+        bp->close_file(file_id);
+        delete bp;
+        ::remove(test_file_name);
+    }
+    DiskBufferPool::set_io_engine(origin_io_engine.c_str());
+}
+
+TEST(test_disk_buffer_pool, test_get_pages_concurrent) {
+    // 缓冲池只放得下一部分页面，几个线程获取有重叠的页面，一直有未命中和淘汰
+    const unsigned long long origin_pool_size = DiskBufferPool::get_pool_size();
+    DiskBufferPool::set_pool_size(32 * BP_DEFAULT_PAGE_SIZE);
+
+    ::remove(test_file_name);
+    DiskBufferPool* bp = DiskBufferPool::mk_instance();
+    ASSERT_EQ(ResultCode::SUCCESS, bp->create_file(test_file_name));
+    int file_id = -1;
+    ASSERT_EQ(ResultCode::SUCCESS, bp->open_file(test_file_name, &file_id));
+    fill_pages(bp, file_id, 100);
+
+    std::vector<std::thread> threads;
+    std::vector<int>         errors(4, 0);
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([bp, file_id, t, &errors]() {
+            for (int round = 0; round < 200; round++) {
+                PageNum      page_nums[4];
+                BPPageHandle page_handles[4];
+                for (int i = 0; i < 4; i++) {
+                    page_nums[i] = 1 + (round * 7 + t * 13 + i * 3) % 100;
+                }
+                if (bp->get_pages(file_id, page_nums, 4, page_handles) !=
+                    ResultCode::SUCCESS) {
+                    errors[t]++;
+                    continue;
+                }
+                for (int i = 0; i < 4; i++) {
+                    char*   data = nullptr;
+                    PageNum num  = 0;
+                    bp->get_data(&page_handles[i], &data);
+                    memcpy(&num, data, sizeof(num));
+                    if (num != page_nums[i]) {
+                        errors[t]++;
+                    }
+                    bp->unpin_page(&page_handles[i]);
+                }
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    for (int error : errors) {
+        ASSERT_EQ(0, error);
+    }
+
+    // 所有页面都已经unpin
+    std::map<int, BPFrameCounts> counts;
+    bp->count_frames(counts);
+    ASSERT_EQ(1, counts[-1].pinned); // 文件头页面
+
+    bp->close_file(file_id);
+    delete bp;
+    ::remove(test_file_name);
+    DiskBufferPool::set_pool_size(origin_pool_size);
+}
+
+TEST(test_disk_buffer_pool, test_prefetch_concurrent) {
+    ::remove(test_file_name);
+    DiskBufferPool* bp = DiskBufferPool::mk_instance();
+    ASSERT_EQ(ResultCode::SUCCESS, bp->create_file(test_file_name));
+    int file_id = -1;
+    ASSERT_EQ(ResultCode::SUCCESS, bp->open_file(test_file_name, &file_id));
+    fill_pages(bp, file_id, 64);
+
+    // 预读和按需读取同时进行，读到的页面正在预读时等它读完
+    for (int round = 0; round < 20; round++) {
+        ASSERT_EQ(ResultCode::SUCCESS, bp->purge_all_pages(file_id));
+        const unsigned long prefetch_count = bp->get_prefetch_count();
+        int                 errors         = 0;
+        std::thread         reader([bp, file_id, &errors]() {
+            for (PageNum page_num = 64; page_num >= 1; page_num--) {
+                BPPageHandle page_handle;
+                char*        data = nullptr;
+                PageNum      num  = 0;
+                if (bp->get_this_page(file_id, page_num, &page_handle) !=
+                    ResultCode::SUCCESS) {
+                    errors++;
+                    continue;
+                }
+                bp->get_data(&page_handle, &data);
+                memcpy(&num, data, sizeof(num));
+                if (num != page_num) {
+                    errors++;
+                }
+                bp->unpin_page(&page_handle);
+            }
+        });
+        ASSERT_EQ(ResultCode::SUCCESS, bp->prefetch_pages(file_id, 1, 64));
+        reader.join();
+        ASSERT_EQ(0, errors);
+        ASSERT_LE(bp->get_prefetch_count() - prefetch_count, 64u);
+
+        std::map<int, BPFrameCounts> counts;
+        bp->count_frames(counts);
+        ASSERT_EQ(1, counts[-1].pinned);
+    }
+
+    bp->close_file(file_id);
+    delete bp;
+    ::remove(test_file_name);
+}
+
+TEST(test_disk_buffer_pool, test_page_size) {
+    ::remove(test_file_name);
+    DiskBufferPool* bp = DiskBufferPool::mk_instance();
+    ASSERT_EQ(ResultCode::INVALID_ARGUMENT, bp->create_file(test_file_name, 3000));
+    ASSERT_EQ(ResultCode::INVALID_ARGUMENT,
+              bp->create_file(test_file_name, BP_MAX_PAGE_SIZE * 2));
+
+    for (int page_size : {BP_MIN_PAGE_SIZE, BP_DEFAULT_PAGE_SIZE, BP_MAX_PAGE_SIZE}) {
+        ::remove(test_file_name);
+        ASSERT_EQ(ResultCode::SUCCESS, bp->create_file(test_file_name, page_size));
+        int file_id = -1;
+        ASSERT_EQ(ResultCode::SUCCESS, bp->open_file(test_file_name, &file_id));
+        int file_page_size = 0;
+        ASSERT_EQ(ResultCode::SUCCESS, bp->get_page_size(file_id, &file_page_size));
+        ASSERT_EQ(page_size, file_page_size);
+
+        fill_pages(bp, file_id, 10);
+        ASSERT_EQ(ResultCode::SUCCESS, bp->close_file(file_id));
+        check_pages_on_disk(page_size, 10);
+
+        // 重新打开后页面大小来自文件头
+        ASSERT_EQ(ResultCode::SUCCESS, bp->open_file(test_file_name, &file_id));
+        ASSERT_EQ(ResultCode::SUCCESS, bp->get_page_size(file_id, &file_page_size));
+        ASSERT_EQ(page_size, file_page_size);
+        int page_count = 0;
+        ASSERT_EQ(ResultCode::SUCCESS, bp->get_page_count(file_id, &page_count));
+        ASSERT_EQ(11, page_count);
+
+        BPPageHandle page_handle;
+        ASSERT_EQ(ResultCode::SUCCESS, bp->get_this_page(file_id, 10, &page_handle));
+        ASSERT_EQ(page_size, page_handle.frame->page_size);
+        char* data = nullptr;
+        bp->get_data(&page_handle, &data);
+        PageNum num = 0;
+        memcpy(&num, data, sizeof(num));
+        ASSERT_EQ(10, num);
+        bp->unpin_page(&page_handle);
+        ASSERT_EQ(ResultCode::SUCCESS, bp->close_file(file_id));
+    }
+
+    delete bp;
+    ::remove(test_file_name);
+}
+
+TEST(test_disk_buffer_pool, test_direct_io) {
+    const bool origin_direct_io = DiskBufferPool::get_direct_io();
+    DiskBufferPool::set_direct_io(true);
+    for (int page_size : {BP_MIN_PAGE_SIZE, BP_MAX_PAGE_SIZE}) {
+        ::remove(test_file_name);
+        DiskBufferPool* bp = DiskBufferPool::mk_instance();
+        ASSERT_EQ(ResultCode::SUCCESS, bp->create_file(test_file_name, page_size));
+        int file_id = -1;
+        ASSERT_EQ(ResultCode::SUCCESS, bp->open_file(test_file_name, &file_id));
+        fill_pages(bp, file_id, 40);
+
+        // 后台刷脏页、逐页刷盘和关闭时的批量刷盘都要满足O_DIRECT的对齐要求
+        int flushed_num = 0;
+        ASSERT_EQ(ResultCode::SUCCESS,
+                  bp->flush_dirty_pages(1 << 20, 10, &flushed_num));
+        ASSERT_EQ(10, flushed_num);
+        ASSERT_EQ(ResultCode::SUCCESS, bp->purge_page(file_id, 20));
+        ASSERT_EQ(ResultCode::SUCCESS, bp->close_file(file_id));
+        check_pages_on_disk(page_size, 40);
+
+        ASSERT_EQ(ResultCode::SUCCESS, bp->open_file(test_file_name, &file_id));
+        PageNum page_nums[] = {3, 4, 5, 30};
+        BPPageHandle page_handles[4];
+        ASSERT_EQ(ResultCode::SUCCESS, bp->get_pages(file_id, page_nums, 4, page_handles));
+        for (int i = 0; i < 4; i++) {
+            char*   data = nullptr;
+            PageNum num  = 0;
+            bp->get_data(&page_handles[i], &data);
+            memcpy(&num, data, sizeof(num));
+            ASSERT_EQ(page_nums[i], num);
+            bp->unpin_page(&page_handles[i]);
+        }
+        ASSERT_EQ(ResultCode::SUCCESS, bp->close_file(file_id));
+        delete bp;
+    }
+    DiskBufferPool::set_direct_io(origin_direct_io);
+    ::remove(test_file_name);
+}
+
+TEST(test_disk_buffer_pool, test_warmup) {
+    const char* warmup_file = "disk_buffer_pool_test.warmup";
+    ::remove(test_file_name);
+    ::remove(warmup_file);
+    DiskBufferPool* bp = DiskBufferPool::mk_instance();
+    ASSERT_EQ(ResultCode::SUCCESS, bp->create_file(test_file_name));
+    int file_id = -1;
+    ASSERT_EQ(ResultCode::SUCCESS, bp->open_file(test_file_name, &file_id));
+    fill_pages(bp, file_id, 100);
+    ASSERT_EQ(ResultCode::SUCCESS, bp->close_file(file_id));
+
+    // 只访问一部分页面，快照里应该正好是这些页面
+    ASSERT_EQ(ResultCode::SUCCESS, bp->open_file(test_file_name, &file_id));
+    std::vector<PageNum> hot_pages = {3, 4, 5, 6, 50, 51, 97};
+    for (PageNum page_num : hot_pages) {
+        BPPageHandle page_handle;
+        ASSERT_EQ(ResultCode::SUCCESS, bp->get_this_page(file_id, page_num, &page_handle));
+        bp->unpin_page(&page_handle);
+    }
+    ASSERT_EQ(ResultCode::SUCCESS, bp->dump_resident_pages(warmup_file));
+    ASSERT_EQ(ResultCode::SUCCESS, bp->close_file(file_id));
+    delete bp;
+
+    // 模拟重启：新的缓冲池打开文件后按快照预热，之后访问这些页面都能命中
+    bp = DiskBufferPool::mk_instance();
+    ASSERT_EQ(ResultCode::SUCCESS, bp->open_file(test_file_name, &file_id));
+    int loaded_num = 0;
+    ASSERT_EQ(ResultCode::SUCCESS, bp->load_resident_pages(warmup_file, 4, &loaded_num));
+    ASSERT_EQ((int)hot_pages.size(), loaded_num);
+    for (PageNum page_num : hot_pages) {
+        BPPageHandle page_handle;
+        ASSERT_EQ(ResultCode::SUCCESS, bp->get_this_page(file_id, page_num, &page_handle));
+        char*   data = nullptr;
+        PageNum num  = 0;
+        bp->get_data(&page_handle, &data);
+        memcpy(&num, data, sizeof(num));
+        ASSERT_EQ(page_num, num);
+        bp->unpin_page(&page_handle);
+    }
+    ASSERT_EQ(hot_pages.size(), bp->get_hit_count());
+    ASSERT_EQ(0UL, bp->get_miss_count());
+
+    // 没有快照或者快照中的文件没有打开时什么都不做
+    ASSERT_EQ(ResultCode::SUCCESS, bp->close_file(file_id));
+    ASSERT_EQ(ResultCode::SUCCESS, bp->load_resident_pages(warmup_file, 4, &loaded_num));
+    ASSERT_EQ(0, loaded_num);
+    ::remove(warmup_file);
+    ASSERT_EQ(ResultCode::SUCCESS, bp->load_resident_pages(warmup_file, 4, &loaded_num));
+    ASSERT_EQ(0, loaded_num);
+    delete bp;
+    ::remove(test_file_name);
+}
+
+TEST(test_disk_buffer_pool, test_resize) {
+    const unsigned long long origin_pool_size = DiskBufferPool::get_pool_size();
+    ::remove(test_file_name);
+    DiskBufferPool* bp = DiskBufferPool::mk_instance();
+    ASSERT_EQ(ResultCode::SUCCESS, bp->create_file(test_file_name));
+    int file_id = -1;
+    ASSERT_EQ(ResultCode::SUCCESS, bp->open_file(test_file_name, &file_id));
+
+    const int page_num = 200;
+    fill_pages(bp, file_id, page_num);
+    ASSERT_EQ((unsigned long long)(page_num + 1) * BP_DEFAULT_PAGE_SIZE,
+              bp->get_used_bytes());
+
+    // 每个分片至少要能放下一个最大的页面
+    ASSERT_EQ(ResultCode::INVALID_ARGUMENT, bp->resize(BP_MAX_PAGE_SIZE));
+
+    // 缩小时把多出来的页面写回磁盘后淘汰掉
+    const unsigned long long small_size = 1 << 20;
+    ASSERT_EQ(ResultCode::SUCCESS, bp->resize(small_size));
+    ASSERT_EQ(small_size, DiskBufferPool::get_pool_size());
+    ASSERT_LE(bp->get_used_bytes(), small_size);
+
+    for (PageNum i = 1; i <= page_num; i++) {
+        BPPageHandle page_handle;
+        ASSERT_EQ(ResultCode::SUCCESS, bp->get_this_page(file_id, i, &page_handle));
+        char*   data = nullptr;
+        PageNum num  = 0;
+        bp->get_data(&page_handle, &data);
+        memcpy(&num, data, sizeof(num));
+        ASSERT_EQ(i, num);
+        bp->unpin_page(&page_handle);
+        ASSERT_LE(bp->get_used_bytes(), small_size);
+    }
+
+    // 变大以后所有页面又能同时留在缓冲池中
+    ASSERT_EQ(ResultCode::SUCCESS, bp->resize(origin_pool_size));
+    for (PageNum i = 1; i <= page_num; i++) {
+        BPPageHandle page_handle;
+        ASSERT_EQ(ResultCode::SUCCESS, bp->get_this_page(file_id, i, &page_handle));
+        bp->unpin_page(&page_handle);
+    }
+    ASSERT_EQ((unsigned long long)(page_num + 1) * BP_DEFAULT_PAGE_SIZE,
+              bp->get_used_bytes());
+
+    ASSERT_EQ(ResultCode::SUCCESS, bp->close_file(file_id));
+    check_pages_on_disk(BP_DEFAULT_PAGE_SIZE, page_num);
+    delete bp;
+    DiskBufferPool::set_pool_size(origin_pool_size);
+    ::remove(test_file_name);
+}
+
+TEST(test_disk_buffer_pool, test_metrics) {
+    const unsigned long long origin_pool_size = DiskBufferPool::get_pool_size();
+    ::remove(test_file_name);
+    DiskBufferPool* bp = DiskBufferPool::mk_instance();
+    ASSERT_EQ(ResultCode::SUCCESS, bp->create_file(test_file_name));
+    int file_id = -1;
+    ASSERT_EQ(ResultCode::SUCCESS, bp->open_file(test_file_name, &file_id));
+
+    // 整个缓冲池和打开的文件都注册了统计项，tag已经被占用
+    common::MetricsRegistry& metrics_registry = common::get_metrics_registry();
+    const std::string        file_tag =
+        std::string(BP_METRIC_TAG) + ".file" + std::to_string(file_id) + ".hit";
+    common::Meter meter;
+    ASSERT_FALSE(metrics_registry.register_metric(BP_METRIC_TAG ".hit", &meter));
+    ASSERT_FALSE(metrics_registry.register_metric(file_tag, &meter));
+    metrics_registry.snapshot();
+
+    const int page_num = 200;
+    fill_pages(bp, file_id, page_num);
+    ASSERT_EQ(0UL, bp->get_hit_count());
+    ASSERT_EQ(0UL, bp->get_miss_count());
+
+    // 缩小后的缓冲池放不下所有页面，脏页要写回后淘汰
+    ASSERT_EQ(ResultCode::SUCCESS, bp->resize(1 << 20));
+    ASSERT_GT(bp->get_evict_count(), 0UL);
+    ASSERT_GE(bp->get_write_count(), bp->get_evict_count());
+
+    // 第二次访问一定命中
+    BPPageHandle pinned_handle;
+    ASSERT_EQ(ResultCode::SUCCESS, bp->get_this_page(file_id, 1, &pinned_handle));
+    BPPageHandle page_handle;
+    ASSERT_EQ(ResultCode::SUCCESS, bp->get_this_page(file_id, 1, &page_handle));
+    bp->unpin_page(&page_handle);
+    ASSERT_EQ(2UL, bp->get_hit_count() + bp->get_miss_count());
+    ASSERT_GE(bp->get_hit_count(), 1UL);
+
+    // 文件头页面和第1页被pin着
+    std::map<int, BPFrameCounts> counts;
+    bp->count_frames(counts);
+    ASSERT_EQ(2, counts[-1].pinned);
+    ASSERT_EQ((int)(bp->get_used_bytes() / BP_DEFAULT_PAGE_SIZE), counts[-1].resident);
+
+    std::string status = bp->get_status();
+    ASSERT_NE(std::string::npos, status.find("total | "));
+    ASSERT_NE(std::string::npos,
+              status.find(std::to_string(file_id) + ":" + test_file_name + " | "));
+    bp->unpin_page(&pinned_handle);
+
+    // 关闭文件、释放缓冲池时注销统计项
+    ASSERT_EQ(ResultCode::SUCCESS, bp->close_file(file_id));
+    ASSERT_TRUE(metrics_registry.register_metric(file_tag, &meter));
+    metrics_registry.unregister(file_tag);
+    delete bp;
+    ASSERT_TRUE(metrics_registry.register_metric(BP_METRIC_TAG ".hit", &meter));
+    metrics_registry.unregister(BP_METRIC_TAG ".hit");
+
+    DiskBufferPool::set_pool_size(origin_pool_size);
+    ::remove(test_file_name);
+}
+
+int main(int argc, char** argv) {
+
+    // 分析gtest程序的命令行参数
+    testing::InitGoogleTest(&argc, argv);
+
+    // 调用RUN_ALL_TESTS()运行所有测试用例
+    // main函数返回RUN_ALL_TESTS()的运行结果
+    return RUN_ALL_TESTS();
+}
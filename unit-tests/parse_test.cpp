@@ -0,0 +1,98 @@
+/* Copyright (c) 2021 Xie Meiyi(xiemeiyi@hust.edu.cn) and OceanBase and/or its
+affiliates. All rights reserved. miniob is licensed under Mulan PSL v2. You can
+use this software according to the terms and conditions of the Mulan PSL v2. You
+may obtain a copy of Mulan PSL v2 at: http://license.coscl.org.cn/MulanPSL2 THIS
+SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND, EITHER
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include <sql/parser/parse.h>
+#include <gtest/gtest.h>
+#include <string>
+
+// 比bison默认的解析栈深度(10000)多得多的行数，右递归的文法会在这里失败
+#define TEST_INSERT_RECORD_NUM 100000
+
+TEST(test_parse, test_insert_many_records) {
+    std::string sql = "insert into t values ";
+    for (int i = 0; i < TEST_INSERT_RECORD_NUM; i++) {
+        if (i > 0) {
+            sql += ",";
+        }
+        sql += "(" + std::to_string(i) + ", 'n" + std::to_string(i) + "')";
+    }
+    sql += ";";
+
+    Query* query = query_create();
+    ASSERT_EQ(ResultCode::SUCCESS, parse(sql.c_str(), query));
+    ASSERT_EQ(SCF_INSERT, query->flag);
+
+    const Inserts& inserts = query->sstr.insertion;
+    ASSERT_STREQ("t", inserts.relation_name);
+    ASSERT_EQ((size_t)TEST_INSERT_RECORD_NUM, inserts.record_num);
+    ASSERT_EQ(2u, inserts.value_num);
+    // 行按出现的顺序存放
+    for (int i = 0; i < TEST_INSERT_RECORD_NUM; i++) {
+        const Value* record = inserts.values + i * inserts.value_num;
+        ASSERT_EQ(INTS, record[0].type);
+        ASSERT_EQ(i, *(int*)record[0].data);
+        ASSERT_EQ(CHARS, record[1].type);
+        ASSERT_EQ("n" + std::to_string(i), (const char*)record[1].data);
+    }
+    query_destroy(query);
+}
+
+TEST(test_parse, test_insert_mismatched_records) {
+    Query* query = query_create();
+    ASSERT_EQ(ResultCode::SQL_SYNTAX,
+              parse("insert into t values (1, 'a'), (2);", query));
+    ASSERT_EQ(SCF_ERROR, query->flag);
+
+    // 出错时已经解析的行都释放了，同一个Query还能继续使用
+    query_reset(query);
+    ASSERT_EQ(ResultCode::SUCCESS, parse("insert into t values (1), (2);", query));
+    ASSERT_EQ(2u, query->sstr.insertion.record_num);
+    ASSERT_EQ(1u, query->sstr.insertion.value_num);
+    query_destroy(query);
+}
+
+TEST(test_parse, test_inserts_append_record) {
+    Inserts inserts;
+    memset(&inserts, 0, sizeof(inserts));
+    inserts_init(&inserts, "t");
+
+    Value values[3];
+    value_init_integer(&values[0], 1);
+    value_init_string(&values[1], "a");
+    ASSERT_EQ(0, inserts_append_record(&inserts, values, 2));
+
+    // 值的个数和第一行不同，values被释放，已经追加的行不受影响
+    value_init_integer(&values[0], 2);
+    value_init_string(&values[1], "b");
+    value_init_integer(&values[2], 3);
+    ASSERT_EQ(-1, inserts_append_record(&inserts, values, 3));
+    ASSERT_EQ(1u, inserts.record_num);
+    ASSERT_EQ(2u, inserts.value_num);
+    ASSERT_EQ(1, *(int*)inserts.values[0].data);
+    ASSERT_STREQ("a", (const char*)inserts.values[1].data);
+
+    // 个数相同的行可以继续追加，超过初始容量时会扩容
+    for (int i = 0; i < 100; i++) {
+        value_init_integer(&values[0], i);
+        value_init_string(&values[1], "c");
+        ASSERT_EQ(0, inserts_append_record(&inserts, values, 2));
+    }
+    ASSERT_EQ(101u, inserts.record_num);
+    ASSERT_EQ(99, *(int*)inserts.values[100 * 2].data);
+    inserts_destroy(&inserts);
+}
+
+int main(int argc, char** argv) {
+    // 分析gtest程序的命令行参数
+    testing::InitGoogleTest(&argc, argv);
+
+    // 调用RUN_ALL_TESTS()运行所有测试用例
+    // main函数返回RUN_ALL_TESTS()的运行结果
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,703 @@
+/* Copyright (c) 2021 Xie Meiyi(xiemeiyi@hust.edu.cn) and OceanBase and/or its
+affiliates. All rights reserved. miniob is licensed under Mulan PSL v2. You can
+use this software according to the terms and conditions of the Mulan PSL v2. You
+may obtain a copy of Mulan PSL v2 at: http://license.coscl.org.cn/MulanPSL2 THIS
+SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND, EITHER
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include <storage/common/condition_filter.h>
+#include <storage/common/record_manager.h>
+#include <storage/default/disk_buffer_pool.h>
+#include <common/lang/bitmap.h>
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#define TEST_RECORD_SIZE 1000
+#define TEST_RECORD_NUM 2000
+
+static const char* test_file_name = "record_manager_test.data";
+
+/**
+ * 每条记录的前4个字节存放它的序号
+ */
+static void insert_records(RecordFileHandler& file_handler, int record_num) {
+    char record[TEST_RECORD_SIZE];
+    memset(record, 0, sizeof(record));
+    for (int i = 0; i < record_num; i++) {
+        RID rid;
+        memcpy(record, &i, sizeof(i));
+        ASSERT_EQ(ResultCode::SUCCESS,
+                  file_handler.insert_record(record, TEST_RECORD_SIZE, &rid));
+    }
+}
+
+TEST(test_record_manager, test_scan_readahead) {
+    ::remove(test_file_name);
+    DiskBufferPool* bp = DiskBufferPool::mk_instance();
+    ASSERT_EQ(ResultCode::SUCCESS, bp->create_file(test_file_name));
+    int file_id = -1;
+    ASSERT_EQ(ResultCode::SUCCESS, bp->open_file(test_file_name, &file_id));
+
+    RecordFileHandler file_handler;
+    ASSERT_EQ(ResultCode::SUCCESS, file_handler.init(bp, file_id));
+    insert_records(file_handler, TEST_RECORD_NUM);
+    file_handler.close();
+
+    // 把页面都赶出缓冲池，扫描时只能从磁盘读
+    ASSERT_EQ(ResultCode::SUCCESS, bp->purge_all_pages(file_id));
+
+    unsigned long miss_count     = bp->get_miss_count();
+    unsigned long prefetch_count = bp->get_prefetch_count();
+
+    RecordFileScanner scanner;
+    ASSERT_EQ(ResultCode::SUCCESS, scanner.open_scan(*bp, file_id, nullptr));
+    Record     record;
+    int        count = 0;
+    ResultCode rc    = scanner.get_first_record(&record);
+    for (; rc == ResultCode::SUCCESS; rc = scanner.get_next_record(&record)) {
+        int value = -1;
+        memcpy(&value, record.data, sizeof(value));
+        ASSERT_EQ(count, value);
+        count++;
+    }
+    ASSERT_EQ(ResultCode::RECORD_EOF, rc);
+    ASSERT_EQ(TEST_RECORD_NUM, count);
+    scanner.close_scan();
+
+    if (DiskBufferPool::get_readahead_pages() > 0) {
+        // 所有数据页面都是预读上来的
+        ASSERT_EQ(miss_count, bp->get_miss_count());
+        ASSERT_LT(prefetch_count, bp->get_prefetch_count());
+    }
+
+    bp->close_file(file_id);
+    delete bp;
+    ::remove(test_file_name);
+}
+
+TEST(test_record_manager, test_scan_without_readahead) {
+    const int origin_readahead_pages = DiskBufferPool::get_readahead_pages();
+    DiskBufferPool::set_readahead_pages(0);
+
+    ::remove(test_file_name);
+    DiskBufferPool* bp = DiskBufferPool::mk_instance();
+    ASSERT_EQ(ResultCode::SUCCESS, bp->create_file(test_file_name));
+    int file_id = -1;
+    ASSERT_EQ(ResultCode::SUCCESS, bp->open_file(test_file_name, &file_id));
+
+    RecordFileHandler file_handler;
+    ASSERT_EQ(ResultCode::SUCCESS, file_handler.init(bp, file_id));
+    insert_records(file_handler, TEST_RECORD_NUM);
+    file_handler.close();
+    ASSERT_EQ(ResultCode::SUCCESS, bp->purge_all_pages(file_id));
+
+    RecordFileScanner scanner;
+    ASSERT_EQ(ResultCode::SUCCESS, scanner.open_scan(*bp, file_id, nullptr));
+    Record     record;
+    int        count = 0;
+    ResultCode rc    = scanner.get_first_record(&record);
+    for (; rc == ResultCode::SUCCESS; rc = scanner.get_next_record(&record)) {
+        count++;
+    }
+    ASSERT_EQ(TEST_RECORD_NUM, count);
+    ASSERT_EQ(0u, bp->get_prefetch_count());
+    scanner.close_scan();
+
+    bp->close_file(file_id);
+    delete bp;
+    ::remove(test_file_name);
+    DiskBufferPool::set_readahead_pages(origin_readahead_pages);
+}
+
+/**
+ * 在只有BP_BUFFER_SIZE个frame的缓冲池上扫描一张比缓冲池还大的表，
+ * 返回扫描之前缓存的另一个文件的页面是否被挤出了缓冲池
+ */
+static bool scan_evicts_hot_page(int scan_ring_pages) {
+    const int origin_pool_num        = DiskBufferPool::get_pool_num();
+    const int origin_scan_ring_pages = DiskBufferPool::get_scan_ring_pages();
+    DiskBufferPool::set_pool_num(1);
+    DiskBufferPool::set_scan_ring_pages(scan_ring_pages);
+
+    static const char* hot_file_name = "record_manager_test_hot.data";
+    ::remove(test_file_name);
+    ::remove(hot_file_name);
+    DiskBufferPool* bp          = DiskBufferPool::mk_instance();
+    int             file_id     = -1;
+    int             hot_file_id = -1;
+    EXPECT_EQ(ResultCode::SUCCESS, bp->create_file(test_file_name));
+    EXPECT_EQ(ResultCode::SUCCESS, bp->open_file(test_file_name, &file_id));
+    EXPECT_EQ(ResultCode::SUCCESS, bp->create_file(hot_file_name));
+    EXPECT_EQ(ResultCode::SUCCESS, bp->open_file(hot_file_name, &hot_file_id));
+
+    RecordFileHandler file_handler;
+    EXPECT_EQ(ResultCode::SUCCESS, file_handler.init(bp, file_id));
+    insert_records(file_handler, BP_BUFFER_SIZE * 16);
+    file_handler.close();
+    EXPECT_EQ(ResultCode::SUCCESS, bp->purge_all_pages(file_id));
+
+    BPPageHandle page_handle;
+    EXPECT_EQ(ResultCode::SUCCESS, bp->allocate_page(hot_file_id, &page_handle));
+    PageNum hot_page_num = page_handle.frame->page->page_num;
+    bp->unpin_page(&page_handle);
+
+    RecordFileScanner scanner;
+    EXPECT_EQ(ResultCode::SUCCESS, scanner.open_scan(*bp, file_id, nullptr));
+    Record     record;
+    int        count = 0;
+    ResultCode rc    = scanner.get_first_record(&record);
+    for (; rc == ResultCode::SUCCESS; rc = scanner.get_next_record(&record)) {
+        count++;
+    }
+    EXPECT_EQ(BP_BUFFER_SIZE * 16, count);
+    scanner.close_scan();
+
+    unsigned long miss_count = bp->get_miss_count();
+    EXPECT_EQ(ResultCode::SUCCESS,
+              bp->get_this_page(hot_file_id, hot_page_num, &page_handle));
+    bp->unpin_page(&page_handle);
+    bool evicted = bp->get_miss_count() != miss_count;
+
+    bp->close_file(hot_file_id);
+    bp->close_file(file_id);
+    delete bp;
+    ::remove(hot_file_name);
+    ::remove(test_file_name);
+    DiskBufferPool::set_scan_ring_pages(origin_scan_ring_pages);
+    DiskBufferPool::set_pool_num(origin_pool_num);
+    return evicted;
+}
+
+TEST(test_record_manager, test_scan_ring) {
+    ASSERT_TRUE(scan_evicts_hot_page(0));
+    ASSERT_FALSE(scan_evicts_hot_page(BP_DEFAULT_SCAN_RING_PAGES));
+}
+
+TEST(test_record_manager, test_free_space_map) {
+    ::remove(test_file_name);
+    DiskBufferPool* bp = DiskBufferPool::mk_instance();
+    ASSERT_EQ(ResultCode::SUCCESS, bp->create_file(test_file_name));
+    int file_id = -1;
+    ASSERT_EQ(ResultCode::SUCCESS, bp->open_file(test_file_name, &file_id));
+
+    RecordFileHandler file_handler;
+    ASSERT_EQ(ResultCode::SUCCESS, file_handler.init(bp, file_id));
+    ASSERT_TRUE(file_handler.has_free_space_map());
+    insert_records(file_handler, TEST_RECORD_NUM);
+
+    // 在第2页和倒数第2页各删除一条记录，第3页的记录全部删除
+    int page_count = 0;
+    ASSERT_EQ(ResultCode::SUCCESS, bp->get_page_count(file_id, &page_count));
+    const PageNum last_page = page_count - 1;
+    RID           rid{2, 3};
+    ASSERT_EQ(ResultCode::SUCCESS, file_handler.delete_record(&rid));
+    rid = RID{last_page - 1, 0};
+    ASSERT_EQ(ResultCode::SUCCESS, file_handler.delete_record(&rid));
+    Record record;
+    for (rid = RID{3, 0}; file_handler.get_record(&rid, &record) == ResultCode::SUCCESS;
+         rid.slot_num++) {
+        ASSERT_EQ(ResultCode::SUCCESS, file_handler.delete_record(&rid));
+    }
+    file_handler.close();
+
+    // 重新打开以后按空闲空间表直接找到有空位的页面，不用逐页查找
+    ASSERT_EQ(ResultCode::SUCCESS, file_handler.init(bp, file_id));
+    ASSERT_TRUE(file_handler.has_free_space_map());
+    char record_data[TEST_RECORD_SIZE];
+    memset(record_data, 0, sizeof(record_data));
+    std::vector<PageNum> page_nums;
+    for (int i = 0; i < 3; i++) {
+        const unsigned long accessed = bp->get_hit_count() + bp->get_miss_count();
+        ASSERT_EQ(ResultCode::SUCCESS,
+                  file_handler.insert_record(record_data, TEST_RECORD_SIZE, &rid));
+        ASSERT_GE(2UL, bp->get_hit_count() + bp->get_miss_count() - accessed);
+        page_nums.push_back(rid.page_num);
+    }
+    ASSERT_EQ(2, page_nums[0]);
+    ASSERT_EQ(last_page - 1, page_nums[1]);
+    // 第3页被释放后重新分配
+    ASSERT_EQ(3, page_nums[2]);
+
+    // 文件里的空位都用完了，再插入就要分配新的页面
+    while (rid.page_num <= last_page) {
+        ASSERT_EQ(ResultCode::SUCCESS,
+                  file_handler.insert_record(record_data, TEST_RECORD_SIZE, &rid));
+    }
+    ASSERT_EQ(last_page + 1, rid.page_num);
+    file_handler.close();
+
+    // 扫描时空闲空间表的页面整页跳过，不当作记录页面
+    RecordPageHandler page_handler;
+    ASSERT_EQ(ResultCode::SUCCESS,
+              page_handler.init(*bp, file_id, RECORD_FSM_PAGE_NUM));
+    ASSERT_TRUE(page_handler.is_free_space_map());
+    page_handler.cleanup();
+    ASSERT_EQ(ResultCode::SUCCESS, page_handler.init(*bp, file_id, 2));
+    ASSERT_FALSE(page_handler.is_free_space_map());
+    page_handler.cleanup();
+
+    bp->close_file(file_id);
+    delete bp;
+    ::remove(test_file_name);
+}
+
+TEST(test_record_manager, test_free_space_map_rebuild) {
+    ::remove(test_file_name);
+    DiskBufferPool* bp = DiskBufferPool::mk_instance();
+    ASSERT_EQ(ResultCode::SUCCESS, bp->create_file(test_file_name));
+    int file_id = -1;
+    ASSERT_EQ(ResultCode::SUCCESS, bp->open_file(test_file_name, &file_id));
+
+    RecordFileHandler file_handler;
+    ASSERT_EQ(ResultCode::SUCCESS, file_handler.init(bp, file_id));
+    insert_records(file_handler, TEST_RECORD_NUM);
+
+    int page_count = 0;
+    ASSERT_EQ(ResultCode::SUCCESS, bp->get_page_count(file_id, &page_count));
+    const PageNum last_page = page_count - 1;
+    RID           rid{2, 3};
+    ASSERT_EQ(ResultCode::SUCCESS, file_handler.delete_record(&rid));
+    rid = RID{last_page - 1, 0};
+    ASSERT_EQ(ResultCode::SUCCESS, file_handler.delete_record(&rid));
+    file_handler.close();
+
+    // 释放掉空闲空间表的页面，重新打开时会在已有记录的文件上新建空闲空间表
+    ASSERT_EQ(ResultCode::SUCCESS, bp->dispose_page(file_id, RECORD_FSM_PAGE_NUM));
+    ASSERT_EQ(ResultCode::SUCCESS, file_handler.init(bp, file_id));
+    ASSERT_TRUE(file_handler.has_free_space_map());
+    ASSERT_LE(2, file_handler.free_page_count());
+
+    // 新建的空闲空间表里要有已有页面的空位，插入时先用它们
+    char record_data[TEST_RECORD_SIZE];
+    memset(record_data, 0, sizeof(record_data));
+    ASSERT_EQ(ResultCode::SUCCESS,
+              file_handler.insert_record(record_data, TEST_RECORD_SIZE, &rid));
+    ASSERT_EQ(2, rid.page_num);
+    ASSERT_EQ(ResultCode::SUCCESS,
+              file_handler.insert_record(record_data, TEST_RECORD_SIZE, &rid));
+    ASSERT_EQ(last_page - 1, rid.page_num);
+    file_handler.close();
+
+    bp->close_file(file_id);
+    delete bp;
+    ::remove(test_file_name);
+}
+
+TEST(test_record_manager, test_insert_records) {
+    ::remove(test_file_name);
+    DiskBufferPool* bp = DiskBufferPool::mk_instance();
+    ASSERT_EQ(ResultCode::SUCCESS, bp->create_file(test_file_name));
+    int file_id = -1;
+    ASSERT_EQ(ResultCode::SUCCESS, bp->open_file(test_file_name, &file_id));
+
+    RecordFileHandler file_handler;
+    ASSERT_EQ(ResultCode::SUCCESS, file_handler.init(bp, file_id));
+    insert_records(file_handler, 3);
+
+    std::vector<char> records((size_t)TEST_RECORD_NUM * TEST_RECORD_SIZE);
+    for (int i = 0; i < TEST_RECORD_NUM; i++) {
+        int value = i + 3;
+        memcpy(records.data() + (size_t)i * TEST_RECORD_SIZE, &value, sizeof(value));
+    }
+    std::vector<RID>    rids(TEST_RECORD_NUM);
+    const unsigned long accessed = bp->get_hit_count() + bp->get_miss_count();
+    ASSERT_EQ(ResultCode::SUCCESS,
+              file_handler.insert_records(records.data(), TEST_RECORD_NUM,
+                                          TEST_RECORD_SIZE, rids.data()));
+
+    // 每个页面只pin一次，先填满之前插入时没有填满的页面
+    int page_count = 0;
+    ASSERT_EQ(ResultCode::SUCCESS, bp->get_page_count(file_id, &page_count));
+    ASSERT_GE((unsigned long)page_count,
+              bp->get_hit_count() + bp->get_miss_count() - accessed);
+    ASSERT_EQ(2, rids[0].page_num);
+    ASSERT_EQ(3, rids[0].slot_num);
+    for (int i = 0; i < TEST_RECORD_NUM; i++) {
+        Record record;
+        ASSERT_EQ(ResultCode::SUCCESS, file_handler.get_record(&rids[i], &record));
+        int value = -1;
+        memcpy(&value, record.data, sizeof(value));
+        ASSERT_EQ(i + 3, value);
+    }
+    file_handler.close();
+
+    bp->close_file(file_id);
+    delete bp;
+    ::remove(test_file_name);
+}
+
+TEST(test_record_manager, test_get_records) {
+    ::remove(test_file_name);
+    DiskBufferPool* bp = DiskBufferPool::mk_instance();
+    ASSERT_EQ(ResultCode::SUCCESS, bp->create_file(test_file_name));
+    int file_id = -1;
+    ASSERT_EQ(ResultCode::SUCCESS, bp->open_file(test_file_name, &file_id));
+
+    RecordFileHandler file_handler;
+    ASSERT_EQ(ResultCode::SUCCESS, file_handler.init(bp, file_id));
+    std::vector<char> records((size_t)TEST_RECORD_NUM * TEST_RECORD_SIZE);
+    for (int i = 0; i < TEST_RECORD_NUM; i++) {
+        memcpy(records.data() + (size_t)i * TEST_RECORD_SIZE, &i, sizeof(i));
+    }
+    std::vector<RID> rids(TEST_RECORD_NUM);
+    ASSERT_EQ(ResultCode::SUCCESS,
+              file_handler.insert_records(records.data(), TEST_RECORD_NUM,
+                                          TEST_RECORD_SIZE, rids.data()));
+
+    // 每3条记录取1条，像索引扫描一样按页面排好序以后读取
+    std::vector<RID> selected;
+    for (int i = 0; i < TEST_RECORD_NUM; i += 3) {
+        selected.push_back(rids[i]);
+    }
+    std::sort(selected.begin(), selected.end(), [](const RID& rid1, const RID& rid2) {
+        return RID::compare(&rid1, &rid2) < 0;
+    });
+    int pages = 1;
+    for (size_t i = 1; i < selected.size(); i++) {
+        pages += selected[i].page_num != selected[i - 1].page_num;
+    }
+
+    std::vector<int>    values;
+    const unsigned long accessed = bp->get_hit_count() + bp->get_miss_count();
+    ASSERT_EQ(ResultCode::SUCCESS,
+              file_handler.get_records(selected.data(), (int)selected.size(),
+                                       [&](Record* record) {
+                                           int value = -1;
+                                           memcpy(&value, record->data, sizeof(value));
+                                           values.push_back(value);
+                                           return ResultCode::SUCCESS;
+                                       }));
+    // 每个页面只pin一次
+    ASSERT_EQ((unsigned long)pages, bp->get_hit_count() + bp->get_miss_count() - accessed);
+    ASSERT_EQ(selected.size(), values.size());
+    for (size_t i = 0; i < values.size(); i++) {
+        ASSERT_EQ((int)i * 3, values[i]);
+    }
+
+    // reader返回失败时停止
+    int count = 0;
+    ASSERT_EQ(ResultCode::RECORD_EOF,
+              file_handler.get_records(selected.data(), (int)selected.size(),
+                                       [&](Record* record) {
+                                           return ++count < 10 ? ResultCode::SUCCESS
+                                                               : ResultCode::RECORD_EOF;
+                                       }));
+    ASSERT_EQ(10, count);
+    file_handler.close();
+
+    bp->close_file(file_id);
+    delete bp;
+    ::remove(test_file_name);
+}
+
+/**
+ * 记下compact搬动的记录，fail_at次(从1开始)搬动时返回失败。
+ * 搬动时记录已经复制到新的位置，数据要和旧记录相同
+ */
+struct TestRecordMover {
+    std::vector<std::pair<RID, RID>> moves;
+    int                              fail_at = 0;
+
+    static ResultCode move(const Record* old_record, const RID& new_rid,
+                           void* context) {
+        TestRecordMover* mover = (TestRecordMover*)context;
+        if ((int)mover->moves.size() + 1 == mover->fail_at) {
+            return ResultCode::RECORD_DUPLICATE_KEY;
+        }
+        EXPECT_LT(RID::compare(&new_rid, &old_record->rid), 0);
+        mover->moves.emplace_back(old_record->rid, new_rid);
+        return ResultCode::SUCCESS;
+    }
+};
+
+/**
+ * 扫描整个文件，检查每个序号正好出现一次，返回记录数
+ */
+static int check_records(DiskBufferPool* bp, int file_id, std::vector<RID>& rids) {
+    RecordFileScanner scanner;
+    EXPECT_EQ(ResultCode::SUCCESS, scanner.open_scan(*bp, file_id, nullptr));
+    std::vector<bool> seen(TEST_RECORD_NUM, false);
+    int               count = 0;
+    Record            record;
+    ResultCode        rc = scanner.get_first_record(&record);
+    for (; rc == ResultCode::SUCCESS; rc = scanner.get_next_record(&record)) {
+        int value = -1;
+        memcpy(&value, record.data, sizeof(value));
+        EXPECT_FALSE(seen[value]);
+        seen[value] = true;
+        rids[value] = record.rid;
+        count++;
+    }
+    EXPECT_EQ(ResultCode::RECORD_EOF, rc);
+    scanner.close_scan();
+    return count;
+}
+
+TEST(test_record_manager, test_compact) {
+    ::remove(test_file_name);
+    DiskBufferPool* bp = DiskBufferPool::mk_instance();
+    ASSERT_EQ(ResultCode::SUCCESS, bp->create_file(test_file_name));
+    int file_id = -1;
+    ASSERT_EQ(ResultCode::SUCCESS, bp->open_file(test_file_name, &file_id));
+
+    RecordFileHandler file_handler;
+    ASSERT_EQ(ResultCode::SUCCESS, file_handler.init(bp, file_id));
+    std::vector<char> records((size_t)TEST_RECORD_NUM * TEST_RECORD_SIZE, 0);
+    for (int i = 0; i < TEST_RECORD_NUM; i++) {
+        memcpy(records.data() + (size_t)i * TEST_RECORD_SIZE, &i, sizeof(i));
+    }
+    std::vector<RID> rids(TEST_RECORD_NUM);
+    ASSERT_EQ(ResultCode::SUCCESS,
+              file_handler.insert_records(records.data(), TEST_RECORD_NUM,
+                                          TEST_RECORD_SIZE, rids.data()));
+
+    // 每10条记录只留下1条
+    int left = 0;
+    for (int i = 0; i < TEST_RECORD_NUM; i++) {
+        if (i % 10 != 0) {
+            ASSERT_EQ(ResultCode::SUCCESS, file_handler.delete_record(&rids[i]));
+        } else {
+            left++;
+        }
+    }
+    int page_count = 0;
+    ASSERT_EQ(ResultCode::SUCCESS, bp->get_page_count(file_id, &page_count));
+
+    TestRecordMover mover;
+    int             moved_pages = 0;
+    ASSERT_EQ(ResultCode::SUCCESS,
+              file_handler.compact(0, TestRecordMover::move, &mover, &moved_pages));
+    ASSERT_LT(0, moved_pages);
+    int compacted_page_count = 0;
+    ASSERT_EQ(ResultCode::SUCCESS, bp->get_page_count(file_id, &compacted_page_count));
+    ASSERT_GE(page_count - moved_pages, compacted_page_count);
+
+    // 所有记录都还在，搬动过的记录在新的位置上
+    std::vector<RID> new_rids(TEST_RECORD_NUM);
+    ASSERT_EQ(left, check_records(bp, file_id, new_rids));
+    for (const auto& move : mover.moves) {
+        Record record;
+        RID    rid = move.second;
+        ASSERT_EQ(ResultCode::SUCCESS, file_handler.get_record(&rid, &record));
+        int value = -1;
+        memcpy(&value, record.data, sizeof(value));
+        ASSERT_EQ(0, RID::compare(&rids[value], &move.first));
+        ASSERT_EQ(0, RID::compare(&new_rids[value], &move.second));
+    }
+    file_handler.close();
+
+    bp->close_file(file_id);
+    delete bp;
+    ::remove(test_file_name);
+}
+
+TEST(test_record_manager, test_compact_mover_failure) {
+    ::remove(test_file_name);
+    DiskBufferPool* bp = DiskBufferPool::mk_instance();
+    ASSERT_EQ(ResultCode::SUCCESS, bp->create_file(test_file_name));
+    int file_id = -1;
+    ASSERT_EQ(ResultCode::SUCCESS, bp->open_file(test_file_name, &file_id));
+
+    RecordFileHandler file_handler;
+    ASSERT_EQ(ResultCode::SUCCESS, file_handler.init(bp, file_id));
+    std::vector<RID> rids(TEST_RECORD_NUM);
+    char             record[TEST_RECORD_SIZE];
+    memset(record, 0, sizeof(record));
+    for (int i = 0; i < TEST_RECORD_NUM; i++) {
+        memcpy(record, &i, sizeof(i));
+        ASSERT_EQ(ResultCode::SUCCESS,
+                  file_handler.insert_record(record, TEST_RECORD_SIZE, &rids[i]));
+    }
+    int left = 0;
+    for (int i = 0; i < TEST_RECORD_NUM; i++) {
+        if (i % 10 != 0) {
+            ASSERT_EQ(ResultCode::SUCCESS, file_handler.delete_record(&rids[i]));
+        } else {
+            left++;
+        }
+    }
+    int page_count = 0;
+    ASSERT_EQ(ResultCode::SUCCESS, bp->get_page_count(file_id, &page_count));
+
+    // 搬到一半失败：已经搬好的记录留在新位置，失败的那条还在原来的位置，
+    // 复制出来的那一份被删掉，没有哪条记录出现两次
+    TestRecordMover failed_mover;
+    failed_mover.fail_at = 5;
+    int moved_pages      = 0;
+    ASSERT_EQ(ResultCode::RECORD_DUPLICATE_KEY,
+              file_handler.compact(0, TestRecordMover::move, &failed_mover,
+                                   &moved_pages));
+    ASSERT_EQ(4u, failed_mover.moves.size());
+    std::vector<RID> new_rids(TEST_RECORD_NUM);
+    ASSERT_EQ(left, check_records(bp, file_id, new_rids));
+    for (const auto& move : failed_mover.moves) {
+        Record record;
+        RID    rid = move.second;
+        ASSERT_EQ(ResultCode::SUCCESS, file_handler.get_record(&rid, &record));
+        rid = move.first;
+        ASSERT_NE(ResultCode::SUCCESS, file_handler.get_record(&rid, &record));
+    }
+
+    // 文件还是一致的，再整理一次可以完成
+    TestRecordMover mover;
+    ASSERT_EQ(ResultCode::SUCCESS,
+              file_handler.compact(0, TestRecordMover::move, &mover, &moved_pages));
+    ASSERT_LT(0, moved_pages);
+    int compacted_page_count = 0;
+    ASSERT_EQ(ResultCode::SUCCESS, bp->get_page_count(file_id, &compacted_page_count));
+    ASSERT_GT(page_count, compacted_page_count);
+    ASSERT_EQ(left, check_records(bp, file_id, new_rids));
+    file_handler.close();
+
+    bp->close_file(file_id);
+    delete bp;
+    ::remove(test_file_name);
+}
+
+/**
+ * 只保留序号是偶数的记录
+ */
+class EvenRecordFilter : public ConditionFilter {
+    public:
+    bool filter(const Record& rec) const override {
+        int value = -1;
+        memcpy(&value, rec.data, sizeof(value));
+        return value % 2 == 0;
+    }
+};
+
+static int scan_batches(DiskBufferPool* bp, int file_id, ConditionFilter* filter,
+                        std::vector<bool>& seen) {
+    RecordFileScanner scanner;
+    EXPECT_EQ(ResultCode::SUCCESS, scanner.open_scan(*bp, file_id, filter));
+    int         count = 0;
+    RecordBatch batch;
+    ResultCode  rc;
+    while ((rc = scanner.get_next_batch(&batch)) == ResultCode::SUCCESS) {
+        common::Bitmap bitmap(batch.bitmap, batch.slot_num);
+        for (int slot = bitmap.next_setted_bit(0); slot >= 0;
+             slot = bitmap.next_setted_bit(slot + 1)) {
+            int value = -1;
+            memcpy(&value, batch.record(slot), sizeof(value));
+            EXPECT_FALSE(seen[value]);
+            seen[value] = true;
+            count++;
+        }
+    }
+    EXPECT_EQ(ResultCode::RECORD_EOF, rc);
+    scanner.close_scan();
+    return count;
+}
+
+TEST(test_record_manager, test_scan_batch) {
+    ::remove(test_file_name);
+    DiskBufferPool* bp = DiskBufferPool::mk_instance();
+    ASSERT_EQ(ResultCode::SUCCESS, bp->create_file(test_file_name));
+    int file_id = -1;
+    ASSERT_EQ(ResultCode::SUCCESS, bp->open_file(test_file_name, &file_id));
+
+    RecordFileHandler file_handler;
+    ASSERT_EQ(ResultCode::SUCCESS, file_handler.init(bp, file_id));
+    insert_records(file_handler, TEST_RECORD_NUM);
+
+    // 删掉序号是3的倍数的记录
+    RecordFileScanner scanner;
+    ASSERT_EQ(ResultCode::SUCCESS, scanner.open_scan(*bp, file_id, nullptr));
+    Record     record;
+    ResultCode rc = scanner.get_first_record(&record);
+    for (; rc == ResultCode::SUCCESS; rc = scanner.get_next_record(&record)) {
+        int value = -1;
+        memcpy(&value, record.data, sizeof(value));
+        if (value % 3 == 0) {
+            ASSERT_EQ(ResultCode::SUCCESS, file_handler.delete_record(&record.rid));
+        }
+    }
+    scanner.close_scan();
+
+    std::vector<bool> seen(TEST_RECORD_NUM, false);
+    int count = scan_batches(bp, file_id, nullptr, seen);
+    ASSERT_EQ(TEST_RECORD_NUM - (TEST_RECORD_NUM + 2) / 3, count);
+    for (int i = 0; i < TEST_RECORD_NUM; i++) {
+        ASSERT_EQ(i % 3 != 0, (bool)seen[i]);
+    }
+
+    EvenRecordFilter filter;
+    seen.assign(TEST_RECORD_NUM, false);
+    count = scan_batches(bp, file_id, &filter, seen);
+    for (int i = 0; i < TEST_RECORD_NUM; i++) {
+        ASSERT_EQ(i % 3 != 0 && i % 2 == 0, (bool)seen[i]);
+    }
+    ASSERT_EQ(TEST_RECORD_NUM / 2 - (TEST_RECORD_NUM + 5) / 6, count);
+    file_handler.close();
+
+    bp->close_file(file_id);
+    delete bp;
+    ::remove(test_file_name);
+}
+
+TEST(test_record_manager, test_scan_batch_range) {
+    ::remove(test_file_name);
+    DiskBufferPool* bp = DiskBufferPool::mk_instance();
+    ASSERT_EQ(ResultCode::SUCCESS, bp->create_file(test_file_name));
+    int file_id = -1;
+    ASSERT_EQ(ResultCode::SUCCESS, bp->open_file(test_file_name, &file_id));
+
+    RecordFileHandler file_handler;
+    ASSERT_EQ(ResultCode::SUCCESS, file_handler.init(bp, file_id));
+    insert_records(file_handler, TEST_RECORD_NUM);
+    int page_count = 0;
+    ASSERT_EQ(ResultCode::SUCCESS, bp->get_page_count(file_id, &page_count));
+
+    // 像并行扫描一样，几个线程各自领取一段页面扫描
+    const int                morsel_pages = 5;
+    std::atomic<PageNum>     next_page(1);
+    std::vector<int>         counts(4, 0);
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < counts.size(); t++) {
+        threads.emplace_back([&, t]() {
+            RecordFileScanner scanner;
+            EXPECT_EQ(ResultCode::SUCCESS, scanner.open_scan(*bp, file_id, nullptr));
+            for (PageNum start = next_page.fetch_add(morsel_pages); start < page_count;
+                 start = next_page.fetch_add(morsel_pages)) {
+                scanner.set_batch_range(start, start + morsel_pages);
+                RecordBatch batch;
+                while (scanner.get_next_batch(&batch) == ResultCode::SUCCESS) {
+                    EXPECT_GE(batch.page_num, start);
+                    EXPECT_LT(batch.page_num, start + morsel_pages);
+                    counts[t] += common::Bitmap(batch.bitmap, batch.slot_num)
+                                     .count_setted_bits();
+                }
+            }
+            scanner.close_scan();
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    int total = 0;
+    for (int count : counts) {
+        total += count;
+    }
+    ASSERT_EQ(TEST_RECORD_NUM, total);
+    file_handler.close();
+
+    bp->close_file(file_id);
+    delete bp;
+    ::remove(test_file_name);
+}
+
+int main(int argc, char** argv) {
+
+    // 分析gtest程序的命令行参数
+    testing::InitGoogleTest(&argc, argv);
+
+    // 调用RUN_ALL_TESTS()运行所有测试用例
+    // main函数返回RUN_ALL_TESTS()的运行结果
+    return RUN_ALL_TESTS();
+}
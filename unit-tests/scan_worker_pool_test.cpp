@@ -0,0 +1,87 @@
+/* Copyright (c) 2021 Xie Meiyi(xiemeiyi@hust.edu.cn) and OceanBase and/or its
+affiliates. All rights reserved. miniob is licensed under Mulan PSL v2. You can
+use this software according to the terms and conditions of the Mulan PSL v2. You
+may obtain a copy of Mulan PSL v2 at: http://license.coscl.org.cn/MulanPSL2 THIS
+SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND, EITHER
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include <storage/common/scan_worker_pool.h>
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#define TEST_ITEMS 10000
+
+/**
+ * parallelism个worker从共享的计数器领取工作，返回每个worker领到的个数
+ */
+static std::vector<int> share_work(ScanWorkerPool& pool, int parallelism) {
+    std::atomic<int> next(0);
+    std::vector<int> done(parallelism, 0);
+    pool.run(parallelism, [&](int index) {
+        while (next.fetch_add(1) < TEST_ITEMS) {
+            done[index]++;
+        }
+    });
+    return done;
+}
+
+TEST(test_scan_worker_pool, test_run) {
+    ScanWorkerPool pool(3);
+    ASSERT_EQ(3, pool.worker_num());
+
+    // 每个工作都被领取一次，超过线程个数的worker不会执行
+    std::vector<int> done = share_work(pool, 8);
+    int              total = 0;
+    for (int i = 0; i < 8; i++) {
+        total += done[i];
+        if (i > 3) {
+            ASSERT_EQ(0, done[i]);
+        }
+    }
+    ASSERT_EQ(TEST_ITEMS, total);
+
+    // 没有线程时调用者自己完成所有工作
+    ScanWorkerPool empty_pool(0);
+    done = share_work(empty_pool, 4);
+    ASSERT_EQ(TEST_ITEMS, done[0]);
+}
+
+TEST(test_scan_worker_pool, test_concurrent_run) {
+    // 调用者比线程多，排队的任务被撤回以后工作仍然都能完成
+    ScanWorkerPool   pool(2);
+    std::atomic<int> failed(0);
+    std::vector<std::thread> callers;
+    for (int i = 0; i < 6; i++) {
+        callers.emplace_back([&]() {
+            for (int round = 0; round < 50; round++) {
+                std::vector<int> done  = share_work(pool, 4);
+                int              total = 0;
+                for (int count : done) {
+                    total += count;
+                }
+                if (total != TEST_ITEMS) {
+                    failed++;
+                }
+            }
+        });
+    }
+    for (std::thread& caller : callers) {
+        caller.join();
+    }
+    ASSERT_EQ(0, failed.load());
+}
+
+int main(int argc, char** argv) {
+
+    // 分析gtest程序的命令行参数
+    testing::InitGoogleTest(&argc, argv);
+
+    // 调用RUN_ALL_TESTS()运行所有测试用例
+    // main函数返回RUN_ALL_TESTS()的运行结果
+    return RUN_ALL_TESTS();
+}
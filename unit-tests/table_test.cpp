@@ -0,0 +1,386 @@
+/* Copyright (c) 2021 Xie Meiyi(xiemeiyi@hust.edu.cn) and OceanBase and/or its
+affiliates. All rights reserved. miniob is licensed under Mulan PSL v2. You can
+use this software according to the terms and conditions of the Mulan PSL v2. You
+may obtain a copy of Mulan PSL v2 at: http://license.coscl.org.cn/MulanPSL2 THIS
+SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND, EITHER
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include <storage/common/condition_filter.h>
+#include <storage/common/meta_util.h>
+#include <storage/common/table.h>
+#include <storage/transaction/transaction.h>
+#include <gtest/gtest.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <sys/stat.h>
+
+#define TEST_RECORD_NUM 10000
+
+static const char* test_table_name = "table_test";
+static const char* test_base_dir   = ".";
+
+/**
+ * 两个INTS字段的表，id上有索引i_id
+ */
+class TableTest : public testing::Test {
+    protected:
+    void SetUp() override {
+        remove_files();
+        AttrInfo attributes[] = {{(char*)"id", INTS, 4}, {(char*)"age", INTS, 4}};
+        table_ = new Table();
+        ASSERT_EQ(ResultCode::SUCCESS,
+                  table_->create(meta_file().c_str(), test_table_name,
+                                 test_base_dir, 2, attributes));
+        ASSERT_EQ(ResultCode::SUCCESS, table_->create_index(nullptr, "i_id", "id"));
+    }
+
+    void TearDown() override {
+        delete table_;
+        table_ = nullptr;
+        remove_files();
+    }
+
+    std::string meta_file() const {
+        return table_meta_file(test_base_dir, test_table_name);
+    }
+
+    void remove_files() {
+        ::remove(meta_file().c_str());
+        ::remove(table_data_file(test_base_dir, test_table_name).c_str());
+        ::remove(table_zone_map_file(test_base_dir, test_table_name).c_str());
+        ::remove(table_index_file(test_base_dir, test_table_name, "i_id").c_str());
+        ::remove(table_index_file(test_base_dir, test_table_name, "i_age").c_str());
+    }
+
+    off_t data_file_size() {
+        struct stat st;
+        EXPECT_EQ(0, stat(table_data_file(test_base_dir, test_table_name).c_str(), &st));
+        return st.st_size;
+    }
+
+    ResultCode insert(Transaction* transaction, int id, int age) {
+        Value values[2];
+        values[0].type = INTS;
+        values[0].data = &id;
+        values[1].type = INTS;
+        values[1].data = &age;
+        return table_->insert_record(transaction, 2, values);
+    }
+
+    /**
+     * field op *value的过滤条件，value在使用filter期间要一直有效
+     */
+    void init_filter(DefaultConditionFilter& filter, const char* field, CompOp op,
+                     int* value) {
+        const FieldMeta* field_meta = table_->table_meta().field(field);
+        ConDesc          left;
+        left.is_attr     = true;
+        left.attr_length = field_meta->len();
+        left.attr_offset = field_meta->offset();
+        left.value       = nullptr;
+        ConDesc right;
+        right.is_attr     = false;
+        right.attr_length = 0;
+        right.attr_offset = 0;
+        right.value       = value;
+        ASSERT_EQ(ResultCode::SUCCESS, filter.init(left, right, INTS, op));
+    }
+
+    /**
+     * 满足field = value的记录数。field上有索引时走索引扫描
+     */
+    int count(Transaction* transaction, const char* field, int value) {
+        DefaultConditionFilter filter;
+        init_filter(filter, field, EQUAL_TO, &value);
+        int record_count = 0;
+        EXPECT_EQ(ResultCode::SUCCESS,
+                  table_->scan_record(transaction, &filter, -1, &record_count,
+                                      count_record));
+        return record_count;
+    }
+
+    /**
+     * 删除满足field op value的记录，返回删除的记录数
+     */
+    int delete_where(Transaction* transaction, const char* field, CompOp op,
+                     int value) {
+        DefaultConditionFilter filter;
+        init_filter(filter, field, op, &value);
+        int deleted_count = 0;
+        EXPECT_EQ(ResultCode::SUCCESS,
+                  table_->delete_record(transaction, &filter, &deleted_count));
+        return deleted_count;
+    }
+
+    /**
+     * 把id = where_id的记录的field改成value，返回修改的记录数
+     */
+    int update(Transaction* transaction, const char* field, int value,
+               int where_id, ResultCode expected = ResultCode::SUCCESS) {
+        Value new_value;
+        new_value.type = INTS;
+        new_value.data = &value;
+
+        Condition condition;
+        memset(&condition, 0, sizeof(condition));
+        condition.left_is_attr             = 1;
+        condition.left_attr.attribute_name = (char*)"id";
+        condition.comp                     = EQUAL_TO;
+        condition.right_is_attr            = 0;
+        condition.right_value.type         = INTS;
+        condition.right_value.data         = &where_id;
+
+        int updated_count = 0;
+        EXPECT_EQ(expected,
+                  table_->update_record(transaction, field, &new_value, 1,
+                                        &condition, &updated_count));
+        return updated_count;
+    }
+
+    /**
+     * 通过id上的索引找到唯一的一条记录，返回记录的全部数据
+     */
+    std::string fetch(Transaction* transaction, int id) {
+        DefaultConditionFilter filter;
+        init_filter(filter, "id", EQUAL_TO, &id);
+        FetchContext context{table_->table_meta().record_size()};
+        EXPECT_EQ(ResultCode::SUCCESS,
+                  table_->scan_record(transaction, &filter, -1, &context,
+                                      fetch_record));
+        EXPECT_EQ(1, context.count);
+        return context.data;
+    }
+
+    int age_of(Transaction* transaction, int id) {
+        std::string data = fetch(transaction, id);
+        return *(const int*)(data.data() +
+                             table_->table_meta().field("age")->offset());
+    }
+
+    /**
+     * 表中所有记录数
+     */
+    int count_all(Transaction* transaction) {
+        int record_count = 0;
+        EXPECT_EQ(ResultCode::SUCCESS,
+                  table_->scan_record(transaction, nullptr, -1, &record_count,
+                                      count_record));
+        return record_count;
+    }
+
+    static void count_record(const char* data, void* context) {
+        (*(int*)context)++;
+    }
+
+    struct FetchContext {
+        int         record_size;
+        int         count = 0;
+        std::string data;
+    };
+
+    static void fetch_record(const char* data, void* context) {
+        FetchContext& fetch_context = *(FetchContext*)context;
+        fetch_context.count++;
+        fetch_context.data.assign(data, fetch_context.record_size);
+    }
+
+    protected:
+    Table* table_ = nullptr;
+};
+
+TEST_F(TableTest, test_abort_session_transaction) {
+    Transaction transaction;
+    ASSERT_EQ(ResultCode::SUCCESS, insert(&transaction, 1, 10));
+    ASSERT_EQ(ResultCode::SUCCESS, transaction.commit());
+
+    // 会话在事务中途断开，事务没有提交也没有回滚就被销毁了
+    Transaction* unfinished = new Transaction();
+    ASSERT_EQ(ResultCode::SUCCESS, insert(unfinished, 2, 20));
+    int moved_pages = 0;
+    ASSERT_EQ(ResultCode::LOCKED, table_->vacuum(0, &moved_pages));
+    delete unfinished;
+
+    // 未提交的修改回滚掉了，表也不再被挡住不能整理
+    ASSERT_EQ(1, count_all(nullptr));
+    ASSERT_EQ(0, count(nullptr, "id", 2));
+    ASSERT_EQ(ResultCode::SUCCESS, table_->vacuum(0, &moved_pages));
+}
+
+TEST_F(TableTest, test_vacuum) {
+    ASSERT_EQ(ResultCode::SUCCESS, table_->create_index(nullptr, "i_age", "age"));
+    Transaction transaction;
+    for (int i = 0; i < TEST_RECORD_NUM; i++) {
+        ASSERT_EQ(ResultCode::SUCCESS, insert(&transaction, i, i % 10));
+    }
+    ASSERT_EQ(ResultCode::SUCCESS, transaction.commit());
+
+    // 每10行只留下age为0的那一行，留下的记录分散在所有页面上
+    const int left = TEST_RECORD_NUM / 10;
+    ASSERT_EQ(TEST_RECORD_NUM - left, delete_where(&transaction, "age", NOT_EQUAL, 0));
+    ASSERT_EQ(ResultCode::SUCCESS, transaction.commit());
+    ASSERT_TRUE(table_->need_vacuum());
+
+    const off_t size        = data_file_size();
+    int         moved_pages = 0;
+    ASSERT_EQ(ResultCode::SUCCESS, table_->vacuum(0, &moved_pages));
+    ASSERT_LT(0, moved_pages);
+    ASSERT_GT(size, data_file_size());
+    ASSERT_FALSE(table_->need_vacuum());
+
+    // 全表扫描和每个索引都能找到所有记录。索引扫描会再用条件过滤一次，
+    // 索引项没有指向记录新的位置时就找不到了
+    ASSERT_EQ(left, count_all(nullptr));
+    ASSERT_EQ(left, count(nullptr, "age", 0));
+    ASSERT_EQ(0, count(nullptr, "age", 1));
+    for (int i = 0; i < TEST_RECORD_NUM; i += 10) {
+        ASSERT_EQ(1, count(nullptr, "id", i));
+    }
+    ASSERT_EQ(0, count(nullptr, "id", 1));
+
+    // 整理以后还能正常插入和删除
+    ASSERT_EQ(ResultCode::SUCCESS, insert(&transaction, TEST_RECORD_NUM, 0));
+    ASSERT_EQ(ResultCode::SUCCESS, transaction.commit());
+    ASSERT_EQ(1, count(nullptr, "id", TEST_RECORD_NUM));
+    ASSERT_EQ(left + 1, count(nullptr, "age", 0));
+    ASSERT_EQ(1, delete_where(&transaction, "id", EQUAL_TO, TEST_RECORD_NUM));
+    ASSERT_EQ(ResultCode::SUCCESS, transaction.commit());
+    ASSERT_EQ(left, count_all(nullptr));
+}
+
+TEST_F(TableTest, test_update) {
+    Transaction transaction;
+    for (int i = 0; i < 100; i++) {
+        ASSERT_EQ(ResultCode::SUCCESS, insert(&transaction, i, i % 10));
+    }
+    ASSERT_EQ(ResultCode::SUCCESS, transaction.commit());
+
+    // age上没有索引，通过id上的索引还能找到这条记录
+    ASSERT_EQ(1, update(&transaction, "age", 99, 6));
+    ASSERT_EQ(99, age_of(&transaction, 6));
+    ASSERT_EQ(1, count(&transaction, "age", 99));
+
+    // id上有索引，旧的key找不到了，新的key能找到
+    ASSERT_EQ(1, update(&transaction, "id", 1000, 5));
+    ASSERT_EQ(ResultCode::SUCCESS, transaction.commit());
+    ASSERT_EQ(0, count(nullptr, "id", 5));
+    ASSERT_EQ(1, count(nullptr, "id", 1000));
+    ASSERT_EQ(5, age_of(nullptr, 1000));
+    ASSERT_EQ(99, age_of(nullptr, 6));
+    ASSERT_EQ(100, count_all(nullptr));
+
+    // 没有满足条件的记录
+    ASSERT_EQ(0, update(&transaction, "age", 1, 5));
+    ASSERT_EQ(ResultCode::SUCCESS, transaction.commit());
+}
+
+TEST_F(TableTest, test_update_rollback) {
+    Transaction transaction;
+    for (int i = 0; i < 100; i++) {
+        ASSERT_EQ(ResultCode::SUCCESS, insert(&transaction, i, i % 10));
+    }
+    ASSERT_EQ(ResultCode::SUCCESS, transaction.commit());
+    const std::string old_record = fetch(nullptr, 5);
+
+    // 同一个事务里把一条记录改了两次，回滚以后恢复成最早的数据
+    ASSERT_EQ(1, update(&transaction, "id", 1000, 5));
+    ASSERT_EQ(1, update(&transaction, "age", 77, 1000));
+    ASSERT_EQ(77, age_of(&transaction, 1000));
+    ASSERT_EQ(ResultCode::SUCCESS, transaction.rollback());
+
+    ASSERT_EQ(old_record, fetch(nullptr, 5));
+    ASSERT_EQ(0, count(nullptr, "id", 1000));
+    ASSERT_EQ(0, count(nullptr, "age", 77));
+    ASSERT_EQ(100, count_all(nullptr));
+}
+
+TEST_F(TableTest, test_update_delete_rollback) {
+    Transaction transaction;
+    for (int i = 0; i < 100; i++) {
+        ASSERT_EQ(ResultCode::SUCCESS, insert(&transaction, i, i % 10));
+    }
+    ASSERT_EQ(ResultCode::SUCCESS, transaction.commit());
+    const std::string old_record = fetch(nullptr, 5);
+
+    // 修改以后又删除了，回滚时数据和删除标记都要恢复
+    ASSERT_EQ(1, update(&transaction, "id", 1000, 5));
+    ASSERT_EQ(1, delete_where(&transaction, "id", EQUAL_TO, 1000));
+    ASSERT_EQ(0, count(&transaction, "id", 1000));
+    ASSERT_EQ(ResultCode::SUCCESS, transaction.rollback());
+
+    ASSERT_EQ(old_record, fetch(nullptr, 5));
+    ASSERT_EQ(0, count(nullptr, "id", 1000));
+    ASSERT_EQ(100, count_all(nullptr));
+}
+
+TEST_F(TableTest, test_insert_update_rollback) {
+    Transaction transaction;
+    for (int i = 0; i < 100; i++) {
+        ASSERT_EQ(ResultCode::SUCCESS, insert(&transaction, i, i % 10));
+    }
+    ASSERT_EQ(ResultCode::SUCCESS, transaction.commit());
+
+    // 本事务插入的记录修改以后回滚，记录和新旧两个key都不存在
+    ASSERT_EQ(ResultCode::SUCCESS, insert(&transaction, 200, 1));
+    ASSERT_EQ(1, update(&transaction, "id", 300, 200));
+    ASSERT_EQ(1, count(&transaction, "id", 300));
+    ASSERT_EQ(ResultCode::SUCCESS, transaction.rollback());
+
+    ASSERT_EQ(0, count(nullptr, "id", 200));
+    ASSERT_EQ(0, count(nullptr, "id", 300));
+    ASSERT_EQ(100, count_all(nullptr));
+}
+
+TEST_F(TableTest, test_update_conflict) {
+    Transaction transaction;
+    for (int i = 0; i < 100; i++) {
+        ASSERT_EQ(ResultCode::SUCCESS, insert(&transaction, i, i % 10));
+    }
+    ASSERT_EQ(ResultCode::SUCCESS, transaction.commit());
+
+    // 别的事务还没有提交的修改不能再改，但是记录仍然可见
+    Transaction other;
+    ASSERT_EQ(1, update(&transaction, "age", 50, 5));
+    ASSERT_EQ(0, update(&other, "age", 60, 5, ResultCode::LOCKED));
+    ASSERT_EQ(1, count(&other, "id", 5));
+    ASSERT_EQ(ResultCode::SUCCESS, other.rollback());
+    ASSERT_EQ(50, age_of(&transaction, 5));
+
+    // 提交以后去掉了修改标记，别的事务可以修改了
+    ASSERT_EQ(ResultCode::SUCCESS, transaction.commit());
+    ASSERT_EQ(0, *(const int32_t*)fetch(nullptr, 5).data());
+    ASSERT_EQ(1, update(&other, "age", 60, 5));
+    ASSERT_EQ(ResultCode::SUCCESS, other.commit());
+    ASSERT_EQ(60, age_of(nullptr, 5));
+    ASSERT_EQ(0, *(const int32_t*)fetch(nullptr, 5).data());
+}
+
+TEST_F(TableTest, test_update_rollback_keeps_other_delete) {
+    Transaction transaction;
+    for (int i = 0; i < 100; i++) {
+        ASSERT_EQ(ResultCode::SUCCESS, insert(&transaction, i, i % 10));
+    }
+    ASSERT_EQ(ResultCode::SUCCESS, transaction.commit());
+
+    // 修改以后别的事务删除了这条记录，回滚修改不能把删除标记也恢复掉
+    Transaction other;
+    ASSERT_EQ(1, update(&transaction, "age", 50, 5));
+    ASSERT_EQ(1, delete_where(&other, "id", EQUAL_TO, 5));
+    ASSERT_EQ(ResultCode::SUCCESS, transaction.rollback());
+    ASSERT_EQ(0, count(&other, "id", 5));
+    ASSERT_EQ(ResultCode::SUCCESS, other.commit());
+
+    ASSERT_EQ(0, count(nullptr, "id", 5));
+    ASSERT_EQ(99, count_all(nullptr));
+}
+
+int main(int argc, char** argv) {
+    // 分析gtest程序的命令行参数
+    testing::InitGoogleTest(&argc, argv);
+
+    // 调用RUN_ALL_TESTS()运行所有测试用例
+    // main函数返回RUN_ALL_TESTS()的运行结果
+    return RUN_ALL_TESTS();
+}
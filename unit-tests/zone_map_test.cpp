@@ -0,0 +1,206 @@
+/* Copyright (c) 2021 Xie Meiyi(xiemeiyi@hust.edu.cn) and OceanBase and/or its
+affiliates. All rights reserved. miniob is licensed under Mulan PSL v2. You can
+use this software according to the terms and conditions of the Mulan PSL v2. You
+may obtain a copy of Mulan PSL v2 at: http://license.coscl.org.cn/MulanPSL2 THIS
+SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND, EITHER
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include <storage/common/condition_filter.h>
+#include <storage/common/record_manager.h>
+#include <storage/common/table_meta.h>
+#include <storage/common/zone_map.h>
+#include <storage/default/disk_buffer_pool.h>
+#include <gtest/gtest.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#define TEST_RECORD_NUM 5000
+
+static const char* test_data_file = "zone_map_test.data";
+static const char* test_zone_file = "zone_map_test.zone";
+
+class ZoneMapTest : public testing::Test {
+    protected:
+    void SetUp() override {
+        AttrInfo attributes[] = {{(char*)"id", INTS, 4},
+                                 {(char*)"name", CHARS, 8},
+                                 {(char*)"score", FLOATS, 4}};
+        ASSERT_EQ(ResultCode::SUCCESS, table_meta_.init("t", 3, attributes));
+        zone_map_.init(table_meta_);
+
+        ::remove(test_data_file);
+        ::remove(test_zone_file);
+        bp_ = DiskBufferPool::mk_instance();
+        ASSERT_EQ(ResultCode::SUCCESS, bp_->create_file(test_data_file));
+        ASSERT_EQ(ResultCode::SUCCESS, bp_->open_file(test_data_file, &file_id_));
+        ASSERT_EQ(ResultCode::SUCCESS, file_handler_.init(bp_, file_id_));
+
+        // id按插入的顺序递增，模拟按时间追加的表
+        std::vector<char> record(table_meta_.record_size(), 0);
+        for (int i = 0; i < TEST_RECORD_NUM; i++) {
+            float score = i % 100;
+            memcpy(record.data() + field("id")->offset(), &i, sizeof(i));
+            snprintf(record.data() + field("name")->offset(), 8, "n%05d", i);
+            memcpy(record.data() + field("score")->offset(), &score, sizeof(score));
+            RID rid;
+            ASSERT_EQ(ResultCode::SUCCESS,
+                      file_handler_.insert_record(record.data(),
+                                                  table_meta_.record_size(), &rid));
+            zone_map_.update(rid.page_num, record.data());
+        }
+    }
+
+    void TearDown() override {
+        file_handler_.close();
+        bp_->close_file(file_id_);
+        delete bp_;
+        ::remove(test_data_file);
+        ::remove(test_zone_file);
+    }
+
+    const FieldMeta* field(const char* name) { return table_meta_.field(name); }
+
+    /**
+     * 扫描满足条件的记录数，用zone map跳过页面时顺便统计读了多少个页面
+     */
+    int scan(ConditionFilter* filter, bool skip_pages, int* page_accessed) {
+        ZoneMapFilter     zone_map_filter;
+        const PageFilter* page_filter = nullptr;
+        if (skip_pages && zone_map_filter.init(zone_map_, filter)) {
+            page_filter = &zone_map_filter;
+        }
+
+        const unsigned long accessed = bp_->get_hit_count() + bp_->get_miss_count();
+        RecordFileScanner   scanner;
+        EXPECT_EQ(ResultCode::SUCCESS,
+                  scanner.open_scan(*bp_, file_id_, filter, page_filter));
+        int        count = 0;
+        Record     record;
+        ResultCode rc = scanner.get_first_record(&record);
+        for (; rc == ResultCode::SUCCESS; rc = scanner.get_next_record(&record)) {
+            count++;
+        }
+        EXPECT_EQ(ResultCode::RECORD_EOF, rc);
+        scanner.close_scan();
+        if (page_accessed != nullptr) {
+            *page_accessed =
+                (int)(bp_->get_hit_count() + bp_->get_miss_count() - accessed);
+        }
+        return count;
+    }
+
+    ConDesc attr_desc(const char* name) {
+        ConDesc desc;
+        desc.is_attr     = true;
+        desc.attr_length = field(name)->len();
+        desc.attr_offset = field(name)->offset();
+        desc.value       = nullptr;
+        return desc;
+    }
+
+    ConDesc value_desc(const void* value) {
+        ConDesc desc;
+        desc.is_attr     = false;
+        desc.attr_length = 0;
+        desc.attr_offset = 0;
+        desc.value       = (void*)value;
+        return desc;
+    }
+
+    protected:
+    TableMeta         table_meta_;
+    ZoneMap           zone_map_;
+    DiskBufferPool*   bp_      = nullptr;
+    int               file_id_ = -1;
+    RecordFileHandler file_handler_;
+};
+
+TEST_F(ZoneMapTest, test_range_scan) {
+    int page_count = 0;
+    ASSERT_EQ(ResultCode::SUCCESS, bp_->get_page_count(file_id_, &page_count));
+
+    // id >= 4900，只需要读最后一两个页面
+    int                    value = TEST_RECORD_NUM - 100;
+    DefaultConditionFilter filter;
+    filter.init(attr_desc("id"), value_desc(&value), INTS, GREAT_EQUAL);
+    int accessed = 0;
+    ASSERT_EQ(100, scan(&filter, false, nullptr));
+    ASSERT_EQ(100, scan(&filter, true, &accessed));
+    ASSERT_LE(accessed, 2);
+    ASSERT_LT(accessed, page_count / 4);
+
+    // 值在左边：100 > id
+    int                    left_value = 100;
+    DefaultConditionFilter left_value_filter;
+    left_value_filter.init(value_desc(&left_value), attr_desc("id"), INTS,
+                           GREAT_THAN);
+    ASSERT_EQ(100, scan(&left_value_filter, true, &accessed));
+    ASSERT_LE(accessed, 2);
+
+    // 字符串
+    const char*            name = "n04321";
+    DefaultConditionFilter name_filter;
+    name_filter.init(attr_desc("name"), value_desc(name), CHARS, EQUAL_TO);
+    ASSERT_EQ(1, scan(&name_filter, true, &accessed));
+    ASSERT_EQ(1, accessed);
+
+    // 每个页面上score的范围都是[0, 99]，没有页面可以跳过
+    float                  score = 50;
+    DefaultConditionFilter score_filter;
+    score_filter.init(attr_desc("score"), value_desc(&score), FLOATS, LESS_THAN);
+    ASSERT_EQ(TEST_RECORD_NUM / 2, scan(&score_filter, true, nullptr));
+    score = 200;
+    score_filter.init(attr_desc("score"), value_desc(&score), FLOATS, GREAT_THAN);
+    ASSERT_EQ(0, scan(&score_filter, true, &accessed));
+    ASSERT_EQ(0, accessed);
+
+    // 组合条件中每个条件都要满足
+    const ConditionFilter*   filters[] = {&filter, &left_value_filter};
+    CompositeConditionFilter composite_filter;
+    composite_filter.init(filters, 2);
+    ASSERT_EQ(0, scan(&composite_filter, true, &accessed));
+    ASSERT_EQ(0, accessed);
+}
+
+TEST_F(ZoneMapTest, test_save_load) {
+    int value = 10;
+    for (PageNum page_num = 0; page_num < 4; page_num++) {
+        ASSERT_EQ(page_num == 2, zone_map_.may_match(page_num, 0, EQUAL_TO,
+                                                     (const char*)&value));
+    }
+
+    ASSERT_EQ(ResultCode::SUCCESS, zone_map_.save(test_zone_file));
+    ZoneMap loaded;
+    loaded.init(table_meta_);
+    ASSERT_EQ(ResultCode::SUCCESS, loaded.load(test_zone_file));
+    for (PageNum page_num = 0; page_num < 4; page_num++) {
+        ASSERT_EQ(page_num == 2,
+                  loaded.may_match(page_num, 0, EQUAL_TO, (const char*)&value));
+    }
+
+    // 加载以后文件就删掉了，异常退出时会重新构建
+    ASSERT_NE(0, access(test_zone_file, F_OK));
+    ASSERT_NE(ResultCode::SUCCESS, loaded.load(test_zone_file));
+
+    // 表结构不一样的时候不能使用
+    ASSERT_EQ(ResultCode::SUCCESS, zone_map_.save(test_zone_file));
+    AttrInfo  attributes[] = {{(char*)"id", INTS, 4}};
+    TableMeta other_meta;
+    ASSERT_EQ(ResultCode::SUCCESS, other_meta.init("t", 1, attributes));
+    ZoneMap other;
+    other.init(other_meta);
+    ASSERT_NE(ResultCode::SUCCESS, other.load(test_zone_file));
+}
+
+int main(int argc, char** argv) {
+
+    // 分析gtest程序的命令行参数
+    testing::InitGoogleTest(&argc, argv);
+
+    // 调用RUN_ALL_TESTS()运行所有测试用例
+    // main函数返回RUN_ALL_TESTS()的运行结果
+    return RUN_ALL_TESTS();
+}